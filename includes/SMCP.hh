@@ -58,6 +58,33 @@
  * - SMCPMessageHeader
  * - SMCPMessageData
  *
+ * Utility classes for processing telemetry and command streams:
+ * - SMCPCurrentValueTable (latest Attribute Value per lowerFOID/AttributeID)
+ * - SMCPAttributeSchema (element types of Attribute Values)
+ * - SMCPTelemetryAggregator (per-bucket min/max/mean/last of Value Telemetry)
+ * - SMCPTelemetryMessageView (zero-copy read-only view of a telemetry message)
+ * - SMCPChangeDetectionFilter (suppression of unchanged Attribute Values)
+ * - SMCPTelemetryPredicateFilter (compiled subscriber filter expressions)
+ * - SMCPCommandMessageView (zero-copy read-only view of a command message)
+ * - SMCPCommandValidator (table-driven validation of command batches)
+ * - SMCPFormatter (allocation-free dump and compact single-line formatting)
+ * - SMCPTrafficStatistics (message/byte/error counts per lowerFOID, type and AttributeID)
+ * - SMCPTelemetryColumnExporter (columnar binary/CSV export of telemetry for dataframe tools)
+ * - SMCPCommandTemplate (pre-serialized commands with named slots patched when stamped)
+ * - SMCPSpacePacketEncoder, SMCPSpacePacketView (CCSDS Space Packet encapsulation without intermediate copies)
+ * - SMCPTelemetryHeaderBatch (structure-of-arrays decoding of telemetry header fields for analytics)
+ * - SMCPTelemetryStreamDecoder (incremental decoding of telemetry fed in fragments, with constant memory)
+ * - SMCPMemoryImageDiff (vectorized comparison of memory dumps with a reference image, streamed per dump telemetry)
+ * - SMCPFramePacker, SMCPFrameUnpacker (packing of small messages into MTU-sized frames)
+ * - SMCPInstrumentation (latency histograms of encode/decode, enabled by SMCP_ENABLE_INSTRUMENTATION)
+ *
+ * The following classes depend on threads or POSIX memory mapping, and their
+ * headers are not included by SMCP.hh; include them separately:
+ * - SMCPShardedPipeline.hh: SMCPShardedPipeline (telemetry processing sharded by Lower FOID over pinned worker threads; link with -pthread)
+ * - SMCPStagePipeline.hh: SMCPStagePipeline, SMCPBoundedQueue (processing stages connected by bounded queues with block/drop/spill policies and per-stage metrics; link with -pthread)
+ * - SMCPSharedMemoryBus.hh: SMCPSharedMemoryBusWriter, SMCPSharedMemoryBusReader (single-writer/multi-reader telemetry broadcast over POSIX shared memory; link with -lrt on glibc older than 2.34)
+ * - SMCPTelemetrySnapshotFile.hh: SMCPTelemetrySnapshotFile (memory-mapped persistent copy of the current values for fast restart)
+ *
  * See <a href="annotated.html">Class List</a> for complete API reference.
  *
  * @section usage Example Usages
@@ -85,5 +112,23 @@
 #include "SMCPCommandMessage.hh"
 #include "SMCPTelemetryMessage.hh"
 #include "SMCPUtility.hh"
+#include "SMCPCurrentValueTable.hh"
+#include "SMCPAttributeSchema.hh"
+#include "SMCPTelemetryAggregator.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPChangeDetectionFilter.hh"
+#include "SMCPTelemetryPredicateFilter.hh"
+#include "SMCPCommandMessageView.hh"
+#include "SMCPCommandValidator.hh"
+#include "SMCPInstrumentation.hh"
+#include "SMCPTrafficStatistics.hh"
+#include "SMCPFormatter.hh"
+#include "SMCPTelemetryColumnExporter.hh"
+#include "SMCPCommandTemplate.hh"
+#include "SMCPSpacePacket.hh"
+#include "SMCPFramePacker.hh"
+#include "SMCPMemoryImageDiff.hh"
+#include "SMCPTelemetryStreamDecoder.hh"
+#include "SMCPTelemetryHeaderBatch.hh"
 
 #endif /* SMCP_HH_ */
@@ -0,0 +1,250 @@
+/*
+ * SMCPAttributeSchema.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPATTRIBUTESCHEMA_HH_
+#define SMCPATTRIBUTESCHEMA_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <map>
+#include "SMCPException.hh"
+
+/** A class which collects element types of Attribute Values.
+ * Used by SMCPAttributeSchema.
+ */
+class SMCPAttributeType {
+public:
+	enum {
+		Raw = 0x00, //opaque bytes, not decoded
+		UInt8 = 0x01,
+		Int8 = 0x02,
+		UInt16 = 0x03,
+		Int16 = 0x04,
+		UInt32 = 0x05,
+		Int32 = 0x06,
+		UInt64 = 0x07,
+		Int64 = 0x08,
+		Float32 = 0x09,
+		Float64 = 0x0a
+	};
+
+public:
+	/** Returns the size of a single element in bytes (1 for Raw). */
+	static size_t getElementSize(int type) {
+		switch (type) {
+		case UInt16:
+		case Int16:
+			return 2;
+		case UInt32:
+		case Int32:
+		case Float32:
+			return 4;
+		case UInt64:
+		case Int64:
+		case Float64:
+			return 8;
+		default:
+			return 1;
+		}
+	}
+
+public:
+	/** Returns the name of a type such as "uint16". */
+	static std::string getTypeName(int type) {
+		switch (type) {
+		case UInt8:
+			return "uint8";
+		case Int8:
+			return "int8";
+		case UInt16:
+			return "uint16";
+		case Int16:
+			return "int16";
+		case UInt32:
+			return "uint32";
+		case Int32:
+			return "int32";
+		case UInt64:
+			return "uint64";
+		case Int64:
+			return "int64";
+		case Float32:
+			return "float32";
+		case Float64:
+			return "float64";
+		default:
+			return "raw";
+		}
+	}
+};
+
+/** A class that describes the Attribute Value of one (lowerFOID, AttributeID).
+ * An Attribute Value is an array of elements of the same type; a scalar
+ * attribute is an array with one element.
+ */
+class SMCPAttributeDefinition {
+public:
+	uint8_t lowerFOID;
+	uint16_t attributeID;
+	std::string name;
+	int type;
+	/** True if elements are stored most-significant byte first (SMCP default). */
+	bool bigEndian;
+
+public:
+	SMCPAttributeDefinition() :
+			lowerFOID(0), attributeID(0), type(SMCPAttributeType::Raw), bigEndian(true) {
+	}
+
+public:
+	/** Returns the size of a single element in bytes. */
+	size_t getElementSize() const {
+		return SMCPAttributeType::getElementSize(type);
+	}
+
+public:
+	/** Returns the number of complete elements contained in an Attribute Value of the given length. */
+	size_t getNumberOfElements(size_t length) const {
+		return length / getElementSize();
+	}
+
+public:
+	/** Converts elements of an Attribute Value to double.
+	 * @param[in] value pointer to the first element to be converted.
+	 * @param[in] nElements number of elements to convert.
+	 * @param[out] result array which receives nElements values.
+	 */
+	void decode(const uint8_t* value, size_t nElements, double* result) const {
+		switch (type) {
+		case SMCPAttributeType::UInt8:
+			decodeElements<uint8_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Int8:
+			decodeElements<int8_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::UInt16:
+			decodeElements<uint16_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Int16:
+			decodeElements<int16_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::UInt32:
+			decodeElements<uint32_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Int32:
+			decodeElements<int32_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::UInt64:
+			decodeElements<uint64_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Int64:
+			decodeElements<int64_t>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Float32:
+			decodeElements<float>(value, nElements, result);
+			break;
+		case SMCPAttributeType::Float64:
+			decodeElements<double>(value, nElements, result);
+			break;
+		default:
+			for (size_t i = 0; i < nElements; i++) {
+				result[i] = value[i];
+			}
+			break;
+		}
+	}
+
+private:
+	template<typename T>
+	void decodeElements(const uint8_t* value, size_t nElements, double* result) const {
+		//byte order of the host is detected at run time so that the loop
+		//body stays a plain load/swap/convert sequence
+		const uint16_t probe = 1;
+		bool swap = (*(const uint8_t*) &probe == 1) == bigEndian;
+		uint8_t bytes[sizeof(T)];
+		T element;
+		if (swap) {
+			for (size_t i = 0; i < nElements; i++, value += sizeof(T)) {
+				for (size_t k = 0; k < sizeof(T); k++) {
+					bytes[k] = value[sizeof(T) - 1 - k];
+				}
+				memcpy(&element, bytes, sizeof(T));
+				result[i] = (double) element;
+			}
+		} else {
+			for (size_t i = 0; i < nElements; i++, value += sizeof(T)) {
+				memcpy(&element, value, sizeof(T));
+				result[i] = (double) element;
+			}
+		}
+	}
+};
+
+/** A class that holds SMCPAttributeDefinition instances
+ * keyed by (lowerFOID, AttributeID).
+ *
+ * Example usage:
+ * @code
+ * SMCPAttributeSchema schema;
+ * schema.add(0x12, 0x0100, SMCPAttributeType::Int16, "temperature");
+ * schema.add(0x12, 0x0200, SMCPAttributeType::Float32, "waveform");
+ * @endcode
+ */
+class SMCPAttributeSchema {
+private:
+	std::map<uint32_t, SMCPAttributeDefinition> definitions;
+
+public:
+	/** Adds (or replaces) a definition.
+	 * @param[in] lowerFOID Lower FOID of the attribute.
+	 * @param[in] attributeID Attribute ID of the attribute.
+	 * @param[in] type element type (see SMCPAttributeType).
+	 * @param[in] name human-readable name.
+	 * @param[in] bigEndian byte order of the elements.
+	 */
+	void add(uint8_t lowerFOID, uint16_t attributeID, int type, std::string name = "", bool bigEndian = true) {
+		if (type < SMCPAttributeType::Raw || SMCPAttributeType::Float64 < type) {
+			throw SMCPException("SMCPAttributeSchema: undefined attribute type");
+		}
+		SMCPAttributeDefinition definition;
+		definition.lowerFOID = lowerFOID;
+		definition.attributeID = attributeID;
+		definition.name = name;
+		definition.type = type;
+		definition.bigEndian = bigEndian;
+		definitions[toKey(lowerFOID, attributeID)] = definition;
+	}
+
+public:
+	/** Returns the definition of an attribute, or NULL if it is not defined. */
+	const SMCPAttributeDefinition* find(uint8_t lowerFOID, uint16_t attributeID) const {
+		std::map<uint32_t, SMCPAttributeDefinition>::const_iterator it = definitions.find(
+				toKey(lowerFOID, attributeID));
+		if (it == definitions.end()) {
+			return NULL;
+		}
+		return &(it->second);
+	}
+
+public:
+	/** Returns all definitions ordered by (lowerFOID, AttributeID). */
+	const std::map<uint32_t, SMCPAttributeDefinition>& getDefinitions() const {
+		return definitions;
+	}
+
+public:
+	size_t size() const {
+		return definitions.size();
+	}
+
+public:
+	static uint32_t toKey(uint8_t lowerFOID, uint16_t attributeID) {
+		return ((uint32_t) lowerFOID << 16) | attributeID;
+	}
+};
+
+#endif /* SMCPATTRIBUTESCHEMA_HH_ */
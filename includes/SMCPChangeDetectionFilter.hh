@@ -0,0 +1,245 @@
+/*
+ * SMCPChangeDetectionFilter.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCHANGEDETECTIONFILTER_HH_
+#define SMCPCHANGEDETECTIONFILTER_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <unordered_map>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPUtility.hh"
+#include "SMCPException.hh"
+
+/** A filter which suppresses Value Telemetry whose Attribute Value is
+ * the same as the previous one of the same (lowerFOID, AttributeID).
+ *
+ * For Attribute Values up to the maximum stored length, the previous value is
+ * kept and compared byte by byte (see SMCPUtility::equalBytes()). Longer values
+ * are compared via a 64-bit fingerprint of the whole value.
+ * When a keep-alive interval is set, an unchanged value is still forwarded
+ * if nothing has been forwarded for the attribute during the interval.
+ * Telemetry of other types is always forwarded.
+ *
+ * Example usage:
+ * @code
+ * SMCPChangeDetectionFilter filter(10 * 1000000000ULL); //keep-alive every 10 s
+ * if (filter.accept(view, receiveTime)) {
+ * 	...forward the message...
+ * }
+ * std::cout << filter.getSuppressionRatio() << std::endl;
+ * @endcode
+ */
+class SMCPChangeDetectionFilter {
+public:
+	static const size_t DefaultMaximumStoredLength = 256;
+
+private:
+	class Entry {
+	public:
+		uint64_t fingerprint;
+		uint64_t lastForwardTime;
+		size_t length;
+		size_t offset;
+	};
+
+private:
+	uint64_t keepAliveInterval;
+	size_t maximumStoredLength;
+	std::unordered_map<uint32_t, size_t> indices;
+	std::vector<Entry> entries;
+	std::vector<uint8_t> storedValues;
+
+private:
+	uint64_t nReceived;
+	uint64_t nForwarded;
+	uint64_t nSuppressed;
+	uint64_t nKeepAlives;
+	uint64_t nPassedThrough;
+
+public:
+	/** Constructor.
+	 * @param[in] keepAliveInterval interval of keep-alive forwarding (0 disables keep-alives),
+	 * in the unit of the time stamps given to accept().
+	 * @param[in] maximumStoredLength Attribute Values up to this length are compared byte by byte.
+	 */
+	SMCPChangeDetectionFilter(uint64_t keepAliveInterval = 0, size_t maximumStoredLength = DefaultMaximumStoredLength) :
+			keepAliveInterval(keepAliveInterval), maximumStoredLength(maximumStoredLength) {
+		resetCounters();
+	}
+
+public:
+	/** Decides whether an attribute value should be forwarded.
+	 * @param[in] lowerFOID Lower FOID of the telemetry.
+	 * @param[in] attributeID Attribute ID of the telemetry.
+	 * @param[in] value pointer to the Attribute Value bytes.
+	 * @param[in] length length of the Attribute Value.
+	 * @param[in] time time stamp of the sample.
+	 * @return true if the value changed (or a keep-alive is due).
+	 */
+	bool accept(uint8_t lowerFOID, uint16_t attributeID, const uint8_t* value, size_t length, uint64_t time) {
+		nReceived++;
+		uint32_t key = ((uint32_t) lowerFOID << 16) | attributeID;
+		std::unordered_map<uint32_t, size_t>::iterator it = indices.find(key);
+		if (it == indices.end()) {
+			Entry entry;
+			entry.offset = storedValues.size();
+			storedValues.resize(storedValues.size() + maximumStoredLength);
+			entries.push_back(entry);
+			indices[key] = entries.size() - 1;
+			store(entries.back(), value, length, time);
+			nForwarded++;
+			return true;
+		}
+
+		Entry& entry = entries[it->second];
+		bool changed;
+		if (entry.length != length) {
+			changed = true;
+		} else if (length <= maximumStoredLength) {
+			changed = !SMCPUtility::equalBytes(storedValues.data() + entry.offset, value, length);
+		} else {
+			changed = (entry.fingerprint != fingerprint(value, length));
+		}
+
+		if (changed) {
+			store(entry, value, length, time);
+			nForwarded++;
+			return true;
+		}
+		if (keepAliveInterval != 0 && keepAliveInterval <= time - entry.lastForwardTime) {
+			entry.lastForwardTime = time;
+			nForwarded++;
+			nKeepAlives++;
+			return true;
+		}
+		nSuppressed++;
+		return false;
+	}
+
+public:
+	/** Decides whether a telemetry message should be forwarded.
+	 * @param[in] view telemetry message.
+	 * @param[in] time time stamp of the message.
+	 * @return true if the message should be forwarded.
+	 */
+	bool accept(const SMCPTelemetryMessageView& view, uint64_t time) {
+		if (view.getTelemetryTypeID() != SMCPTelemetryTypeID::ValueTelemetry) {
+			nPassedThrough++;
+			return true;
+		}
+		return accept(view.getLowerFOID(), view.getAttributeID(), view.getAttributeValuesAsPointer(),
+				view.getAttributeValuesLength(), time);
+	}
+
+public:
+	/** Decides whether a telemetry message stored in a byte array should be forwarded.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @param[in] time time stamp of the message.
+	 * @return true if the message should be forwarded.
+	 */
+	bool accept(const uint8_t* data, size_t length, uint64_t time) {
+		SMCPTelemetryMessageView view(data, length);
+		return accept(view, time);
+	}
+
+public:
+	/** Forgets all stored values. Counters are not reset. */
+	void clear() {
+		indices.clear();
+		entries.clear();
+		storedValues.clear();
+	}
+
+public:
+	void resetCounters() {
+		nReceived = 0;
+		nForwarded = 0;
+		nSuppressed = 0;
+		nKeepAlives = 0;
+		nPassedThrough = 0;
+	}
+
+public:
+	/** Returns the number of Value Telemetry samples examined. */
+	uint64_t getNReceived() const {
+		return nReceived;
+	}
+
+public:
+	/** Returns the number of Value Telemetry samples forwarded (including keep-alives). */
+	uint64_t getNForwarded() const {
+		return nForwarded;
+	}
+
+public:
+	uint64_t getNSuppressed() const {
+		return nSuppressed;
+	}
+
+public:
+	uint64_t getNKeepAlives() const {
+		return nKeepAlives;
+	}
+
+public:
+	/** Returns the number of messages of other telemetry types forwarded without examination. */
+	uint64_t getNPassedThrough() const {
+		return nPassedThrough;
+	}
+
+public:
+	/** Returns nSuppressed / nReceived (0 when nothing has been received). */
+	double getSuppressionRatio() const {
+		return (nReceived == 0) ? 0.0 : (double) nSuppressed / nReceived;
+	}
+
+public:
+	uint64_t getKeepAliveInterval() const {
+		return keepAliveInterval;
+	}
+
+public:
+	void setKeepAliveInterval(uint64_t keepAliveInterval) {
+		this->keepAliveInterval = keepAliveInterval;
+	}
+
+private:
+	void store(Entry& entry, const uint8_t* value, size_t length, uint64_t time) {
+		entry.length = length;
+		entry.lastForwardTime = time;
+		if (length <= maximumStoredLength) {
+			if (length != 0) {
+				memcpy(storedValues.data() + entry.offset, value, length);
+			}
+		} else {
+			entry.fingerprint = fingerprint(value, length);
+		}
+	}
+
+private:
+	/** 64-bit fingerprint computed eight bytes at a time. */
+	static uint64_t fingerprint(const uint8_t* value, size_t length) {
+		const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+		uint64_t h = length * multiplier;
+		size_t i = 0;
+		for (; i + 8 <= length; i += 8) {
+			uint64_t word;
+			memcpy(&word, value + i, 8);
+			h = (h ^ word) * multiplier;
+			h ^= h >> 29;
+		}
+		uint64_t tail = 0;
+		memcpy(&tail, value + i, length - i);
+		h = (h ^ tail) * multiplier;
+		return h ^ (h >> 32);
+	}
+};
+
+#endif /* SMCPCHANGEDETECTIONFILTER_HH_ */
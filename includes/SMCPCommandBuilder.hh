@@ -0,0 +1,149 @@
+/*
+ * SMCPCommandBuilder.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCOMMANDBUILDER_HH_
+#define SMCPCOMMANDBUILDER_HH_
+
+#if __cplusplus < 201703L
+#error "SMCPCommandBuilder.hh requires C++17 (constexpr std::array)"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include "SMCPTypeClasses.hh"
+
+/** A class which builds the wire bytes of command messages at compile time.
+ * The bit layout is the same as that of SMCPCommandMessageHeader and
+ * SMCPCommandMessageData::getAsByteArray(); multi-octet fields are big endian.
+ * Since all functions are constexpr, fixed commands can be stored in
+ * read-only tables and sent without constructing SMCPCommandMessage
+ * instances.
+ *
+ * Example usage:
+ * @code
+ * static constexpr auto getTemperature = SMCPCommandBuilder::get(0x12, 0x0100);
+ * static constexpr auto reset = SMCPCommandBuilder::action(0x12, 0x0001,
+ * 		SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry);
+ * static constexpr auto setMode = SMCPCommandBuilder::action(0x12, 0x0002, std::array<uint8_t, 1> { 0x03 });
+ * send(getTemperature.data(), getTemperature.size());
+ * @endcode
+ */
+class SMCPCommandBuilder {
+public:
+	static constexpr size_t HeaderLength = 2;
+	static constexpr uint8_t DefaultSMCPVersion = 0x01;
+
+public:
+	/** Returns the first octet of Command Message Header.
+	 * @param[in] commandTypeID Command Type ID (see SMCPCommandTypeID).
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 * @param[in] smcpVersion SMCP Version.
+	 */
+	static constexpr uint8_t getFirstOctet(uint8_t commandTypeID, uint8_t acknowledgeRequest,
+			uint8_t smcpVersion = DefaultSMCPVersion) {
+		return (uint8_t) (((acknowledgeRequest & 0x03) << 6) | ((smcpVersion & 0x03) << 4) | (commandTypeID & 0x0F));
+	}
+
+public:
+	/** Returns an Action Command without parameters.
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] operationID Operation ID.
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 */
+	static constexpr std::array<uint8_t, HeaderLength + 2> action(uint8_t lowerFOID, uint16_t operationID,
+			uint8_t acknowledgeRequest = SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+		return action(lowerFOID, operationID, std::array<uint8_t, 0> { }, acknowledgeRequest);
+	}
+
+public:
+	/** Returns an Action Command.
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] operationID Operation ID.
+	 * @param[in] parameters parameters of the operation.
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 */
+	template<size_t N>
+	static constexpr std::array<uint8_t, HeaderLength + 2 + N> action(uint8_t lowerFOID, uint16_t operationID,
+			const std::array<uint8_t, N>& parameters,
+			uint8_t acknowledgeRequest = SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+		std::array<uint8_t, HeaderLength + 2 + N> result { };
+		result[0] = getFirstOctet(SMCPCommandTypeID::ActionCommand, acknowledgeRequest);
+		result[1] = lowerFOID;
+		writeBigEndian(result, HeaderLength, operationID, 2);
+		for (size_t i = 0; i < N; i++) {
+			result[HeaderLength + 2 + i] = parameters[i];
+		}
+		return result;
+	}
+
+public:
+	/** Returns a Get Command.
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] attributeID Attribute ID.
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 */
+	static constexpr std::array<uint8_t, HeaderLength + 2> get(uint8_t lowerFOID, uint16_t attributeID,
+			uint8_t acknowledgeRequest = SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+		std::array<uint8_t, HeaderLength + 2> result { };
+		result[0] = getFirstOctet(SMCPCommandTypeID::GetCommand, acknowledgeRequest);
+		result[1] = lowerFOID;
+		writeBigEndian(result, HeaderLength, attributeID, 2);
+		return result;
+	}
+
+public:
+	/** Returns a Memory Load Command.
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] startAddress Start Address.
+	 * @param[in] loadData data to be loaded.
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 */
+	template<size_t N>
+	static constexpr std::array<uint8_t, HeaderLength + 4 + N> memoryLoad(uint8_t lowerFOID, uint32_t startAddress,
+			const std::array<uint8_t, N>& loadData,
+			uint8_t acknowledgeRequest = SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+		std::array<uint8_t, HeaderLength + 4 + N> result { };
+		result[0] = getFirstOctet(SMCPCommandTypeID::MemoryLoadCommand, acknowledgeRequest);
+		result[1] = lowerFOID;
+		writeBigEndian(result, HeaderLength, startAddress, 4);
+		for (size_t i = 0; i < N; i++) {
+			result[HeaderLength + 4 + i] = loadData[i];
+		}
+		return result;
+	}
+
+public:
+	/** Returns a Memory Dump Command.
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] startAddress Start Address.
+	 * @param[in] dumpLength Dump Length (24 bits).
+	 * @param[in] nOfDumps value of the nOfDumps field (00 = 1time, 01 = 2times, 10 = 3times, 11 = 4times).
+	 * @param[in] acknowledgeRequest Acknowledge Request (see SMCPAcknowledgeRequest).
+	 */
+	static constexpr std::array<uint8_t, HeaderLength + 8> memoryDump(uint8_t lowerFOID, uint32_t startAddress,
+			uint32_t dumpLength, uint8_t nOfDumps = 0x00,
+			uint8_t acknowledgeRequest = SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+		std::array<uint8_t, HeaderLength + 8> result { };
+		result[0] = getFirstOctet(SMCPCommandTypeID::MemoryDumpCommand, acknowledgeRequest);
+		result[1] = lowerFOID;
+		result[HeaderLength] = nOfDumps & 0x03;
+		writeBigEndian(result, HeaderLength + 1, startAddress, 4);
+		writeBigEndian(result, HeaderLength + 5, dumpLength, 3);
+		return result;
+	}
+
+private:
+	template<size_t N>
+	static constexpr void writeBigEndian(std::array<uint8_t, N>& result, size_t offset, uint32_t value,
+			size_t nOctets) {
+		for (size_t i = 0; i < nOctets; i++) {
+			result[offset + i] = (uint8_t) (value >> (8 * (nOctets - 1 - i)));
+		}
+	}
+};
+
+#endif /* SMCPCOMMANDBUILDER_HH_ */
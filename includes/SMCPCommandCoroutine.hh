@@ -0,0 +1,627 @@
+/*
+ * SMCPCommandCoroutine.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCOMMANDCOROUTINE_HH_
+#define SMCPCOMMANDCOROUTINE_HH_
+
+#if __cplusplus < 202002L
+#error "SMCPCommandCoroutine.hh requires C++20 (coroutines)"
+#endif
+
+#include <stdint.h>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPCommandMessage.hh"
+#include "SMCPCommandMessageView.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+class SMCPCommandEventLoop;
+
+/** An interface through which SMCPCommandEventLoop sends command messages. */
+class SMCPCommandTransport {
+public:
+	virtual ~SMCPCommandTransport() {
+	}
+
+public:
+	/** Sends a serialized command message.
+	 * @param[in] data wire bytes (valid only during the call).
+	 * @param[in] length length of the message.
+	 */
+	virtual void send(const uint8_t* data, size_t length) = 0;
+};
+
+/** The outcome of a command sent with SMCPCommandEventLoop::sendCommand(). */
+class SMCPAcknowledgeResult {
+public:
+	/** False if the command did not request an acknowledge (the await completes on sending). */
+	bool acknowledgeRequested;
+	/** True if Acknowledge Telemetry arrived before the timeout. */
+	bool acknowledged;
+	/** Wire bytes of the Acknowledge Telemetry (empty on timeout). */
+	std::vector<uint8_t> acknowledgeTelemetry;
+	/** Time from sending to acknowledge or timeout in nanoseconds. */
+	uint64_t roundTripTime;
+
+public:
+	SMCPAcknowledgeResult() :
+			acknowledgeRequested(false), acknowledged(false), roundTripTime(0) {
+	}
+
+public:
+	bool isTimedOut() const {
+		return acknowledgeRequested && !acknowledged;
+	}
+};
+
+/** A coroutine which runs a command procedure on SMCPCommandEventLoop.
+ * A function returning SMCPProcedure can use co_await on
+ * SMCPCommandEventLoop::sendCommand(), SMCPCommandEventLoop::sleep(), and
+ * other SMCPProcedure instances (sub-procedures). Top-level procedures are
+ * started with SMCPCommandEventLoop::spawn().
+ */
+class SMCPProcedure {
+public:
+	class promise_type {
+	public:
+		std::coroutine_handle<> continuation;
+		std::exception_ptr exception;
+		SMCPCommandEventLoop* loop;
+
+	public:
+		promise_type() :
+				loop(NULL) {
+		}
+
+	public:
+		SMCPProcedure get_return_object() {
+			return SMCPProcedure(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+	public:
+		std::suspend_always initial_suspend() noexcept {
+			return std::suspend_always();
+		}
+
+	public:
+		class FinalAwaiter {
+		public:
+			bool await_ready() noexcept {
+				return false;
+			}
+
+		public:
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+
+		public:
+			void await_resume() noexcept {
+			}
+		};
+
+	public:
+		FinalAwaiter final_suspend() noexcept {
+			return FinalAwaiter();
+		}
+
+	public:
+		void return_void() {
+		}
+
+	public:
+		void unhandled_exception() {
+			exception = std::current_exception();
+		}
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+public:
+	explicit SMCPProcedure(std::coroutine_handle<promise_type> handle) :
+			handle(handle) {
+	}
+
+public:
+	SMCPProcedure(SMCPProcedure&& other) noexcept :
+			handle(other.handle) {
+		other.handle = NULL;
+	}
+
+public:
+	SMCPProcedure(const SMCPProcedure&) = delete;
+	SMCPProcedure& operator=(const SMCPProcedure&) = delete;
+
+public:
+	~SMCPProcedure() {
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+public:
+	/** Releases the ownership of the coroutine (used by SMCPCommandEventLoop::spawn()). */
+	std::coroutine_handle<promise_type> release() {
+		std::coroutine_handle<promise_type> result = handle;
+		handle = NULL;
+		return result;
+	}
+
+public:
+	//awaiting a sub-procedure
+	bool await_ready() const noexcept {
+		return !handle || handle.done();
+	}
+
+public:
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+
+public:
+	void await_resume() {
+		if (handle && handle.promise().exception) {
+			std::rethrow_exception(handle.promise().exception);
+		}
+	}
+};
+
+/** A single-threaded event loop which resumes command procedures on Acknowledge Telemetry and timeouts.
+ *
+ * sendCommand() serializes a command, sends it through the transport, and,
+ * if the command requests an acknowledge, suspends the procedure until
+ * receive() is given an Acknowledge Telemetry message of the same Lower FOID
+ * or until the timeout expires. Acknowledges of one Lower FOID are matched
+ * to outstanding commands in the order the commands were sent. A suspended
+ * procedure costs only its coroutine frame, so thousands of procedures can
+ * wait at the same time.
+ *
+ * The loop does not own a thread or a socket: the application calls
+ * receive() for incoming telemetry and poll() to expire timeouts (e.g. with
+ * getNextDeadline() as the timeout of select/epoll). All methods must be
+ * called from the same thread. Procedures which have not finished when the
+ * loop is destroyed are destroyed with it without being resumed.
+ * Time is in nanoseconds of a monotonic clock (see getCurrentTime()); send
+ * times, timeouts, and sleeps are measured from the time given to the last
+ * receive() or poll() call.
+ *
+ * Example usage:
+ * @code
+ * SMCPProcedure powerOn(SMCPCommandEventLoop& loop, uint8_t foid) {
+ * 	SMCPActionCommandMessage command;
+ * 	...set Lower FOID, Operation ID, and the acknowledge request...
+ * 	SMCPAcknowledgeResult result = co_await loop.sendCommand(command, 1000000000ULL); //1-s timeout
+ * 	if (result.isTimedOut()) {
+ * 		co_return;
+ * 	}
+ * 	co_await loop.sleep(100000000ULL);
+ * 	co_await loop.sendCommand(nextCommand, 1000000000ULL);
+ * }
+ *
+ * SMCPCommandEventLoop loop(&transport);
+ * for (uint8_t foid = 0; foid < 100; foid++) {
+ * 	loop.spawn(powerOn(loop, foid));
+ * }
+ * while (loop.getNProcedures() != 0) {
+ * 	...wait for a datagram until loop.getNextDeadline()...
+ * 	loop.receive(datagram, length);
+ * 	loop.poll();
+ * }
+ * @endcode
+ */
+class SMCPCommandEventLoop {
+public:
+	/** An awaitable returned by sendCommand(); also an entry of the pending-acknowledge lists. */
+	class AcknowledgeAwaiter {
+	private:
+		friend class SMCPCommandEventLoop;
+		SMCPCommandEventLoop* loop;
+		std::vector<uint8_t> command;
+		uint64_t timeout;
+		uint64_t sendTime;
+		uint8_t lowerFOID;
+		std::coroutine_handle<> handle;
+		std::multimap<uint64_t, AcknowledgeAwaiter*>::iterator timer;
+		AcknowledgeAwaiter* next;
+		AcknowledgeAwaiter* previous;
+		SMCPAcknowledgeResult result;
+
+	public:
+		AcknowledgeAwaiter(SMCPCommandEventLoop* loop, std::vector<uint8_t>&& command, uint64_t timeout) :
+				loop(loop), command(std::move(command)), timeout(timeout), sendTime(0), lowerFOID(0), next(NULL),
+				previous(NULL) {
+		}
+
+	public:
+		bool await_ready() {
+			SMCPCommandMessageView view;
+			view.interpretAsCommandMessage(&(command[0]), command.size());
+			lowerFOID = view.getLowerFOID();
+			result.acknowledgeRequested = (view.getAcknowledgeRequest() != SMCPAcknowledgeRequest::NoAcknowledgeTelemetry);
+			if (!result.acknowledgeRequested) {
+				loop->transmit(command);
+				return true;
+			}
+			return false;
+		}
+
+	public:
+		void await_suspend(std::coroutine_handle<> handle) {
+			this->handle = handle;
+			//registered before sending, in case the transport delivers the acknowledge synchronously
+			loop->addPending(this);
+			try {
+				loop->transmit(command);
+			} catch (...) {
+				loop->removePending(this);
+				throw;
+			}
+		}
+
+	public:
+		SMCPAcknowledgeResult await_resume() {
+			return std::move(result);
+		}
+	};
+
+public:
+	/** An awaitable returned by sleep(). */
+	class SleepAwaiter {
+	private:
+		friend class SMCPCommandEventLoop;
+		SMCPCommandEventLoop* loop;
+		uint64_t duration;
+
+	public:
+		SleepAwaiter(SMCPCommandEventLoop* loop, uint64_t duration) :
+				loop(loop), duration(duration) {
+		}
+
+	public:
+		bool await_ready() const {
+			return duration == 0;
+		}
+
+	public:
+		void await_suspend(std::coroutine_handle<> handle) {
+			loop->sleepers.insert(std::make_pair(loop->getTime() + duration, handle));
+		}
+
+	public:
+		void await_resume() {
+		}
+	};
+
+private:
+	SMCPCommandTransport* transport;
+	AcknowledgeAwaiter* pendingHeads[256];
+	AcknowledgeAwaiter* pendingTails[256];
+	std::multimap<uint64_t, AcknowledgeAwaiter*> timeouts;
+	std::multimap<uint64_t, std::coroutine_handle<> > sleepers;
+	std::deque<std::coroutine_handle<> > ready;
+	std::vector<std::coroutine_handle<SMCPProcedure::promise_type> > finished;
+	std::set<void*> procedures; //addresses of the unfinished top-level coroutines
+	bool dispatching;
+	uint64_t currentTime;
+
+private:
+	size_t nProcedures;
+	uint64_t nCommands;
+	uint64_t nAcknowledged;
+	uint64_t nTimeouts;
+	uint64_t nUnmatchedAcknowledges;
+	uint64_t nFailedProcedures;
+	std::string lastFailure;
+
+public:
+	/** Constructor.
+	 * @param[in] transport sender of command messages.
+	 */
+	SMCPCommandEventLoop(SMCPCommandTransport* transport) :
+			transport(transport), dispatching(false), currentTime(getCurrentTime()), nProcedures(0), nCommands(0),
+			nAcknowledged(0), nTimeouts(0), nUnmatchedAcknowledges(0), nFailedProcedures(0) {
+		for (size_t i = 0; i < 256; i++) {
+			pendingHeads[i] = NULL;
+			pendingTails[i] = NULL;
+		}
+	}
+
+public:
+	/** Destructor. Destroys the procedures which are waiting for an acknowledge, a
+	 * sleep, or a sub-procedure; sub-procedures are destroyed by their callers.
+	 */
+	~SMCPCommandEventLoop() {
+		timeouts.clear();
+		sleepers.clear();
+		ready.clear();
+		for (size_t i = 0; i < 256; i++) {
+			pendingHeads[i] = NULL;
+			pendingTails[i] = NULL;
+		}
+		std::set<void*> outstanding;
+		outstanding.swap(procedures);
+		for (std::set<void*>::iterator i = outstanding.begin(); i != outstanding.end(); i++) {
+			std::coroutine_handle<SMCPProcedure::promise_type>::from_address(*i).destroy();
+		}
+	}
+
+public:
+	SMCPCommandEventLoop(const SMCPCommandEventLoop&) = delete;
+	SMCPCommandEventLoop& operator=(const SMCPCommandEventLoop&) = delete;
+
+public:
+	/** Starts a top-level procedure; it runs until its first suspension before spawn() returns. */
+	void spawn(SMCPProcedure&& procedure) {
+		std::coroutine_handle<SMCPProcedure::promise_type> handle = procedure.release();
+		handle.promise().loop = this;
+		procedures.insert(handle.address());
+		nProcedures++;
+		ready.push_back(handle);
+		dispatch();
+	}
+
+public:
+	/** Returns an awaitable which sends a command and completes on its acknowledge or timeout.
+	 * @param[in] command command message.
+	 * @param[in] timeout timeout in nanoseconds.
+	 */
+	AcknowledgeAwaiter sendCommand(SMCPCommandMessage& command, uint64_t timeout) {
+		std::vector<uint8_t> bytes(command.getLength());
+		command.getAsByteArray(&(bytes[0]), bytes.size());
+		return AcknowledgeAwaiter(this, std::move(bytes), timeout);
+	}
+
+public:
+	/** Returns an awaitable which sends a serialized command (e.g. from SMCPCommandBuilder).
+	 * @param[in] data wire bytes of a command message.
+	 * @param[in] length length of the message.
+	 * @param[in] timeout timeout in nanoseconds.
+	 */
+	AcknowledgeAwaiter sendCommand(const uint8_t* data, size_t length, uint64_t timeout) {
+		return AcknowledgeAwaiter(this, std::vector<uint8_t>(data, data + length), timeout);
+	}
+
+public:
+	/** Returns an awaitable which completes after a duration (ns) has elapsed. */
+	SleepAwaiter sleep(uint64_t duration) {
+		return SleepAwaiter(this, duration);
+	}
+
+public:
+	/** Passes received telemetry to the loop.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @param[in] now current time.
+	 * @return true if the message was an Acknowledge Telemetry matched to a pending command.
+	 */
+	bool receive(const uint8_t* data, size_t length, uint64_t now) {
+		currentTime = now;
+		SMCPTelemetryMessageView view;
+		if (!view.tryInterpretAsTelemetryMessage(data, length)
+				|| view.getTelemetryTypeID() != SMCPTelemetryTypeID::AcknowledgeTelemetry) {
+			return false;
+		}
+		AcknowledgeAwaiter* awaiter = pendingHeads[view.getLowerFOID()];
+		if (awaiter == NULL) {
+			nUnmatchedAcknowledges++;
+			return false;
+		}
+		removePending(awaiter);
+		awaiter->result.acknowledged = true;
+		awaiter->result.acknowledgeTelemetry.assign(data, data + view.getLength());
+		awaiter->result.roundTripTime = now - awaiter->sendTime;
+		nAcknowledged++;
+		ready.push_back(awaiter->handle);
+		dispatch();
+		return true;
+	}
+
+public:
+	/** Passes received telemetry to the loop using the current time. */
+	bool receive(const uint8_t* data, size_t length) {
+		return receive(data, length, getCurrentTime());
+	}
+
+public:
+	/** Completes timed-out commands and elapsed sleeps.
+	 * @param[in] now current time.
+	 * @return the number of procedures resumed.
+	 */
+	size_t poll(uint64_t now) {
+		currentTime = now;
+		size_t nResumed = 0;
+		while (!timeouts.empty() && timeouts.begin()->first <= now) {
+			AcknowledgeAwaiter* awaiter = timeouts.begin()->second;
+			removePending(awaiter);
+			awaiter->result.roundTripTime = now - awaiter->sendTime;
+			nTimeouts++;
+			ready.push_back(awaiter->handle);
+			nResumed++;
+		}
+		while (!sleepers.empty() && sleepers.begin()->first <= now) {
+			ready.push_back(sleepers.begin()->second);
+			sleepers.erase(sleepers.begin());
+			nResumed++;
+		}
+		dispatch();
+		return nResumed;
+	}
+
+public:
+	/** Completes timed-out commands and elapsed sleeps using the current time. */
+	size_t poll() {
+		return poll(getCurrentTime());
+	}
+
+public:
+	/** Returns the earliest timeout or wake-up time, or UINT64_MAX if nothing is waiting for time. */
+	uint64_t getNextDeadline() const {
+		uint64_t deadline = UINT64_MAX;
+		if (!timeouts.empty()) {
+			deadline = timeouts.begin()->first;
+		}
+		if (!sleepers.empty() && sleepers.begin()->first < deadline) {
+			deadline = sleepers.begin()->first;
+		}
+		return deadline;
+	}
+
+public:
+	/** Returns the number of spawned procedures which have not finished. */
+	size_t getNProcedures() const {
+		return nProcedures;
+	}
+
+public:
+	/** Returns the number of commands waiting for acknowledge. */
+	size_t getNPendingCommands() const {
+		return timeouts.size();
+	}
+
+public:
+	uint64_t getNCommands() const {
+		return nCommands;
+	}
+
+public:
+	uint64_t getNAcknowledged() const {
+		return nAcknowledged;
+	}
+
+public:
+	uint64_t getNTimeouts() const {
+		return nTimeouts;
+	}
+
+public:
+	/** Returns the number of Acknowledge Telemetry messages with no pending command of their Lower FOID. */
+	uint64_t getNUnmatchedAcknowledges() const {
+		return nUnmatchedAcknowledges;
+	}
+
+public:
+	/** Returns the number of top-level procedures which ended with an exception. */
+	uint64_t getNFailedProcedures() const {
+		return nFailedProcedures;
+	}
+
+public:
+	/** Returns the message of the last exception which ended a top-level procedure. */
+	const std::string& getLastFailure() const {
+		return lastFailure;
+	}
+
+public:
+	/** Returns current time in nanoseconds (monotonic clock). */
+	static uint64_t getCurrentTime() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	friend class SMCPProcedure::promise_type::FinalAwaiter;
+
+private:
+	uint64_t getTime() const {
+		return currentTime;
+	}
+
+private:
+	void transmit(const std::vector<uint8_t>& command) {
+		nCommands++;
+		transport->send(&(command[0]), command.size());
+	}
+
+private:
+	void addPending(AcknowledgeAwaiter* awaiter) {
+		awaiter->sendTime = currentTime;
+		awaiter->timer = timeouts.insert(std::make_pair(currentTime + awaiter->timeout, awaiter));
+		awaiter->previous = pendingTails[awaiter->lowerFOID];
+		awaiter->next = NULL;
+		if (awaiter->previous != NULL) {
+			awaiter->previous->next = awaiter;
+		} else {
+			pendingHeads[awaiter->lowerFOID] = awaiter;
+		}
+		pendingTails[awaiter->lowerFOID] = awaiter;
+	}
+
+private:
+	void removePending(AcknowledgeAwaiter* awaiter) {
+		timeouts.erase(awaiter->timer);
+		if (awaiter->previous != NULL) {
+			awaiter->previous->next = awaiter->next;
+		} else {
+			pendingHeads[awaiter->lowerFOID] = awaiter->next;
+		}
+		if (awaiter->next != NULL) {
+			awaiter->next->previous = awaiter->previous;
+		} else {
+			pendingTails[awaiter->lowerFOID] = awaiter->previous;
+		}
+	}
+
+private:
+	void procedureFinished(std::coroutine_handle<SMCPProcedure::promise_type> handle) {
+		finished.push_back(handle);
+	}
+
+private:
+	/** Resumes ready procedures; re-entrant calls (e.g. a transport which delivers
+	 * an acknowledge synchronously) only queue them.
+	 */
+	void dispatch() {
+		if (dispatching) {
+			return;
+		}
+		dispatching = true;
+		while (!ready.empty()) {
+			std::coroutine_handle<> handle = ready.front();
+			ready.pop_front();
+			handle.resume();
+			for (size_t i = 0; i < finished.size(); i++) {
+				if (finished[i].promise().exception) {
+					nFailedProcedures++;
+					try {
+						std::rethrow_exception(finished[i].promise().exception);
+					} catch (std::exception& e) {
+						lastFailure = e.what();
+					} catch (...) {
+						lastFailure = "unknown exception";
+					}
+				}
+				procedures.erase(finished[i].address());
+				finished[i].destroy();
+				nProcedures--;
+			}
+			finished.clear();
+		}
+		dispatching = false;
+	}
+};
+
+inline std::coroutine_handle<> SMCPProcedure::promise_type::FinalAwaiter::await_suspend(
+		std::coroutine_handle<SMCPProcedure::promise_type> handle) noexcept {
+	promise_type& promise = handle.promise();
+	if (promise.continuation) {
+		return promise.continuation;
+	}
+	if (promise.loop != NULL) {
+		promise.loop->procedureFinished(handle);
+	}
+	return std::noop_coroutine();
+}
+
+#endif /* SMCPCOMMANDCOROUTINE_HH_ */
@@ -11,6 +11,7 @@
 #include "SMCPMessage.hh"
 #include "SMCPCommandMessageHeader.hh"
 #include "SMCPCommandMessageData.hh"
+#include "SMCPInstrumentation.hh"
 
 /** A class that represents SMCP Command Message.
  * Comprises from SMCPCommandMessageHeader and SMCPCommandMessageData.
@@ -37,15 +38,20 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
-		std::stringstream ss;
-		using std::endl;
-		ss << "---------------------------------" << endl;
-		ss << "SMCPCommandMessage" << endl;
-		ss << "---------------------------------" << endl;
-		ss << header->toString();
-		ss << data->toString();
-		ss << endl;
-		return ss.str();
+		std::string result;
+		appendString(result);
+		return result;
+	}
+
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
+		SMCPFormatter::appendMessageBanner(out, "SMCPCommandMessage");
+		header->appendString(out);
+		data->appendString(out);
+		out += '\n';
 	}
 
 public:
@@ -54,6 +60,10 @@ public:
 	 * @param[in] length of the input data.
 	 */
 	void interpretAsCommandMessage(uint8_t* data, size_t length) {
+		SMCP_INSTRUMENT_SCOPE(SMCPInstrumentedType::Undefined, SMCPInstrumentedOperation::Decode);
+		if (length != 0) {
+			SMCP_INSTRUMENT_SET_TYPE(SMCPInstrumentedType::fromCommandTypeID(data[0] & 0x0F));
+		}
 		if (length < SMCPCommandMessageHeader::HeaderLength) {
 			throw SMCPException("size error");
 		}
@@ -12,6 +12,7 @@
 #include <vector>
 #include "SMCPMessageData.hh"
 #include "SMCPException.hh"
+#include "SMCPFormatter.hh"
 
 /** A class that represents SMCP Command Message Data.
  * Extends SMCPMessageData.
@@ -83,116 +84,37 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
+		std::string result;
+		appendString(result);
+		return result;
+	}
+
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * The format depends on Command Type ID; nothing is appended for
+	 * an undefined Command Type ID.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
 		switch (commandTypeID.to_ulong()) {
 		case SMCPCommandTypeID::ActionCommand:
-			return toStringActionCommand();
+			SMCPFormatter::appendActionCommandData(out, (uint16_t) (operationID[0] * 0x100 + operationID[1]),
+					parameters.empty() ? NULL : &(parameters[0]), parameters.size(), this->getMaximumDumpLength());
 			break;
 		case SMCPCommandTypeID::GetCommand:
-			return toStringGetCommand();
+			SMCPFormatter::appendGetCommandData(out, getAttributeID());
 			break;
 		case SMCPCommandTypeID::MemoryDumpCommand:
-			return toStringMemoryDumpCommand();
+			SMCPFormatter::appendMemoryDumpCommandData(out, getAttributeID(), (uint8_t) nOfDumps.to_ulong(),
+					getStartAddress(), getDumpLength());
 			break;
 		case SMCPCommandTypeID::MemoryLoadCommand:
-			return toStringMemoryLoadCommand();
+			SMCPFormatter::appendMemoryLoadCommandData(out, getStartAddress(),
+					loadData.empty() ? NULL : &(loadData[0]), loadData.size(), this->getMaximumDumpLength());
 			break;
 		default:
-			return "";
 			break;
 		}
-		return "";
-	}
-
-private:
-	std::string toStringActionCommand() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::setfill;
-		ss << dec;
-		ss << "=== Command Message Data ===" << endl;
-		ss << "OperationID        = 0x" << hex << setw(4) << setfill('0')
-				<< (uint32_t) ((operationID[0] * 0x100 + operationID[1])) << dec << endl;
-		ss << "Parameter Length   = " << dec << parameters.size() << " bytes (decimal)" << endl;
-		for (size_t i = 0; i < this->getMaximumDumpLength(); i++) {
-			if (i < parameters.size()) {
-				ss << "Parameter[" << setw(4) << setfill('0') << i << "]    = 0x" << hex << setw(2) << setfill('0')
-						<< (uint32_t) (parameters[i]) << dec << endl;
-			} else {
-				break;
-			}
-		}
-
-		if (this->getMaximumDumpLength() < parameters.size()) {
-			ss << "Parameter continues... (total size = " << parameters.size() << " bytes)" << endl;
-		}
-		return ss.str();
-	}
-
-private:
-	std::string toStringGetCommand() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::setfill;
-		ss << dec;
-		ss << "=== Command Message Data ===" << endl;
-		ss << "AttributeID        = 0x" << hex << setw(4) << setfill('0') << getAttributeID() << dec << endl;
-		return ss.str();
-	}
-
-private:
-	std::string toStringMemoryDumpCommand() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::right;
-		using std::setfill;
-		ss << dec;
-		ss << "=== Command Message Data ===" << endl;
-		ss << "AttributeID        = 0x" << hex << setw(4) << setfill('0') << getAttributeID() << dec << endl;
-		ss << "Number of dumps    = " << dec << getNOfDumps().to_ulong() + 1 << "(" << getNOfDumps().to_string() << ")"
-				<< endl;
-		ss << "Start Address      = 0x" << hex << right << setw(8) << setfill('0') << (uint32_t) getStartAddress()
-				<< endl;
-		ss << "Dump Length        = 0x" << hex << right << setw(6) << setfill('0') << (uint32_t) getDumpLength()
-				<< endl;
-		return ss.str();
-	}
-
-private:
-	std::string toStringMemoryLoadCommand() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::right;
-		using std::setfill;
-		ss << dec;
-		ss << "=== Command Message Data ===" << endl;
-		ss << "Start Address      = 0x" << hex << right << setw(8) << setfill('0') << (uint32_t) getStartAddress()
-				<< endl;
-		ss << "Load Data Length   = " << dec << loadData.size() << " bytes (decimal)" << endl;
-		for (size_t i = 0; i < this->getMaximumDumpLength(); i++) {
-			if (i < loadData.size()) {
-				ss << "Load Data[" << setw(4) << setfill('0') << i << "]    = 0x" << hex << setw(2) << setfill('0')
-						<< (uint32_t) (loadData[i]) << dec << endl;
-			} else {
-				break;
-			}
-		}
-
-		if (this->getMaximumDumpLength() < loadData.size()) {
-			ss << "Load Data continues... (total size = " << loadData.size() << " bytes)" << endl;
-		}
-		return ss.str();
 	}
 
 public:
@@ -240,7 +162,7 @@ private:
 	}
 
 private:
-	std::vector<uint8_t> getAsByteVectorMemoryDumpCommand() {
+	std::vector<uint8_t> getAsByteVectorMemoryLoadCommand() {
 		std::vector<uint8_t> result;
 		result.push_back(startAddress[0]);
 		result.push_back(startAddress[1]);
@@ -251,7 +173,7 @@ private:
 	}
 
 private:
-	std::vector<uint8_t> getAsByteVectorMemoryLoadCommand() {
+	std::vector<uint8_t> getAsByteVectorMemoryDumpCommand() {
 		std::vector<uint8_t> result;
 		result.push_back((uint8_t) (nOfDumps.to_ulong()));
 		result.push_back(startAddress[0]);
@@ -264,12 +186,70 @@ private:
 		return result;
 	}
 
+public:
+	/** Writes packet content into a caller-provided buffer without allocating memory.
+	 * The layout depends on Command Type ID, as in getAsByteVector().
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (same as getLength()).
+	 */
+	size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		size_t length = getLength();
+		if (size < length) {
+			throw SMCPException("buffer too small");
+		}
+		switch (commandTypeID.to_ulong()) {
+		case SMCPCommandTypeID::ActionCommand:
+			buffer[0] = operationID[0];
+			buffer[1] = operationID[1];
+			if (!parameters.empty()) {
+				memcpy(buffer + 2, &(parameters[0]), parameters.size());
+			}
+			break;
+		case SMCPCommandTypeID::GetCommand:
+			buffer[0] = attributeID[0];
+			buffer[1] = attributeID[1];
+			break;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			buffer[0] = (uint8_t) (nOfDumps.to_ulong());
+			memcpy(buffer + 1, startAddress, 4);
+			memcpy(buffer + 5, dumpLength, 3);
+			break;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			memcpy(buffer, startAddress, 4);
+			if (!loadData.empty()) {
+				memcpy(buffer + 4, &(loadData[0]), loadData.size());
+			}
+			break;
+		default:
+			break;
+		}
+		return length;
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	size_t getLength() {
+		switch (commandTypeID.to_ulong()) {
+		case SMCPCommandTypeID::ActionCommand:
+			return 2 + parameters.size();
+		case SMCPCommandTypeID::GetCommand:
+			return 2;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return 8;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return 4 + loadData.size();
+		default:
+			return 0;
+		}
+	}
+
 public:
 	/** Sets Message Data based on a provided uint8_t array.
 	 * @param[in] data uint8_t array which contains Message Data.
 	 * @param[in] length the length of the array.
 	 */
-	void setMessageData(uint8_t *data, size_t length) throw (SMCPException) {
+	void setMessageData(uint8_t *data, size_t length) {
 		switch (commandTypeID.to_ulong()) {
 		case SMCPCommandTypeID::ActionCommand:
 			return setMessageDataActionCommand(data, length);
@@ -293,7 +273,7 @@ public:
 	/** Sets Message Data based on a provided uint8_t vector.
 	 * @param[in] data uint8_t vector which contains Message Data.
 	 */
-	void setMessageData(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageData(std::vector<uint8_t>& data) {
 		switch (commandTypeID.to_ulong()) {
 		case SMCPCommandTypeID::ActionCommand:
 			return setMessageDataActionCommand(data);
@@ -314,20 +294,17 @@ public:
 	}
 
 private:
-	void setMessageDataActionCommand(uint8_t *data, size_t length) throw (SMCPException) {
+	void setMessageDataActionCommand(uint8_t *data, size_t length) {
 		if (length < 2) {
 			throw SMCPException("size error");
 		}
 		operationID[0] = data[0];
 		operationID[1] = data[1];
-		parameters.clear();
-		for (size_t i = 2; i < length; i++) {
-			parameters.push_back(data[i]);
-		}
+		parameters.assign(data + 2, data + length);
 	}
 
 private:
-	void setMessageDataGetCommand(uint8_t *data, size_t length) throw (SMCPException) {
+	void setMessageDataGetCommand(uint8_t *data, size_t length) {
 		if (length < 2) {
 			throw SMCPException("size error");
 		}
@@ -336,7 +313,7 @@ private:
 	}
 
 private:
-	void setMessageDataMemoryDumpCommand(uint8_t *data, size_t length) throw (SMCPException) {
+	void setMessageDataMemoryDumpCommand(uint8_t *data, size_t length) {
 		if (length < 8) {
 			throw SMCPException("size error");
 		}
@@ -351,7 +328,7 @@ private:
 	}
 
 private:
-	void setMessageDataMemoryLoadCommand(uint8_t *data, size_t length) throw (SMCPException) {
+	void setMessageDataMemoryLoadCommand(uint8_t *data, size_t length) {
 		if (length < 5) {
 			throw SMCPException("size error");
 		}
@@ -359,14 +336,11 @@ private:
 		startAddress[1] = data[1];
 		startAddress[2] = data[2];
 		startAddress[3] = data[3];
-		loadData.clear();
-		for (size_t i = 4; i < length; i++) {
-			loadData.push_back(data[i]);
-		}
+		loadData.assign(data + 4, data + length);
 	}
 
 private:
-	void setMessageDataActionCommand(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageDataActionCommand(std::vector<uint8_t>& data) {
 		if (data.size() != 0) {
 			setMessageData(&(data[0]), data.size());
 		} else {
@@ -375,7 +349,7 @@ private:
 	}
 
 private:
-	void setMessageDataGetCommand(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageDataGetCommand(std::vector<uint8_t>& data) {
 		if (data.size() != 0) {
 			setMessageDataGetCommand(&(data[0]), data.size());
 		} else {
@@ -384,7 +358,7 @@ private:
 	}
 
 private:
-	void setMessageDataMemoryDumpCommand(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageDataMemoryDumpCommand(std::vector<uint8_t>& data) {
 		if (data.size() != 0) {
 			setMessageDataMemoryDumpCommand(&(data[0]), data.size());
 		} else {
@@ -393,7 +367,7 @@ private:
 	}
 
 private:
-	void setMessageDataMemoryLoadCommand(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageDataMemoryLoadCommand(std::vector<uint8_t>& data) {
 		if (data.size() != 0) {
 			setMessageDataMemoryLoadCommand(&(data[0]), data.size());
 		} else {
@@ -449,6 +423,20 @@ public:
 		return parameters;
 	}
 
+public:
+	/** Returns a pointer to the Parameter field without copying it.
+	 * The pointer is invalidated when the Parameter field is modified.
+	 */
+	const uint8_t* getParametersAsPointer() const {
+		return parameters.empty() ? NULL : &parameters[0];
+	}
+
+public:
+	/** Returns the length of the Parameter field. */
+	size_t getParametersLength() const {
+		return parameters.size();
+	}
+
 public:
 	void setOperationID(std::vector<uint8_t>& operationID) {
 		if (operationID.size() == 2) {
@@ -476,10 +464,7 @@ public:
 
 public:
 	void setParameters(uint8_t* parameters, size_t length) {
-		this->parameters.clear();
-		for (int i = 0; i < length; i++) {
-			this->parameters.push_back(parameters[i]);
-		}
+		this->parameters.assign(parameters, parameters + length);
 	}
 
 public:
@@ -515,6 +500,20 @@ public:
 		return loadData;
 	}
 
+public:
+	/** Returns a pointer to the Load Data field without copying it.
+	 * The pointer is invalidated when the Load Data field is modified.
+	 */
+	const uint8_t* getLoadDataAsPointer() const {
+		return loadData.empty() ? NULL : &loadData[0];
+	}
+
+public:
+	/** Returns the length of the Load Data field. */
+	size_t getLoadDataLength() const {
+		return loadData.size();
+	}
+
 public:
 	std::bitset<2> getNOfDumps() const {
 		return nOfDumps;
@@ -14,6 +14,7 @@
 #include "SMCPMessageHeader.hh"
 #include "SMCPException.hh"
 #include "SMCPUtility.hh"
+#include "SMCPFormatter.hh"
 
 /** A class that represents SMCP Command Message Header.
  * Extends SMCPMessageHeader.
@@ -45,50 +46,18 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::setfill;
-
-		ss << dec;
-
-		ss << "=== Command Message Header ===" << endl;
-
-		ss << "AcknowledgeRequest = " << acknowledgeRequest.to_string() << "b ";
-		if (acknowledgeRequest.to_ulong() == SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
-			ss << "(NoAcknowledgeTelemetry)" << endl;
-		} else if (acknowledgeRequest.to_ulong() == SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry) {
-			ss << "(AcknowledgeTelemetry is requested)" << endl;
-		} else {
-			ss << "(Undefined value)" << endl;
-		}
-
-		ss << "SMCP Version       = " << smcpVersion.to_string() << "b" << endl;
-
-		ss << "CommandTypeID      = " << commandTypeID.to_string() << "b ";
-		switch (commandTypeID.to_ulong()) {
-		case SMCPCommandTypeID::ActionCommand:
-			ss << "(ActionCommand)" << endl;
-			break;
-		case SMCPCommandTypeID::GetCommand:
-			ss << "(GetCommand)" << endl;
-			break;
-		case SMCPCommandTypeID::MemoryLoadCommand:
-			ss << "(MemoryLoadCommand)" << endl;
-			break;
-		case SMCPCommandTypeID::MemoryDumpCommand:
-			ss << "(MemoryDumpCommand)" << endl;
-			break;
-		default:
-			ss << "(Undefined value)" << endl;
-			break;
-		}
-
-		ss << "lowerFOID          = 0x" << hex << setw(2) << setfill('0') << (unsigned int) lowerFOID << dec << endl;
+		std::string result;
+		appendString(result);
+		return result;
+	}
 
-		return ss.str();
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
+		SMCPFormatter::appendCommandMessageHeader(out, (uint8_t) acknowledgeRequest.to_ulong(),
+				(uint8_t) smcpVersion.to_ulong(), (uint8_t) commandTypeID.to_ulong(), lowerFOID);
 	}
 
 public:
@@ -108,6 +77,29 @@ public:
 		return result;
 	}
 
+public:
+	/** Writes packet content into a caller-provided buffer without allocating memory.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (HeaderLength).
+	 */
+	size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		if (size < HeaderLength) {
+			throw SMCPException("buffer too small");
+		}
+		buffer[0] = ((uint8_t) acknowledgeRequest.to_ulong()) * 0x40 //
+				+ ((uint8_t) smcpVersion.to_ulong()) * 0x10 //
+				+ (uint8_t) (commandTypeID.to_ulong());
+		buffer[1] = lowerFOID;
+		return HeaderLength;
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	size_t getLength() {
+		return HeaderLength;
+	}
+
 public:
 	/** Sets header field values based on a provided uint8_t array.
 	 * @param[in] data uint8_t array which contains 2-byte Messaeg Header.
@@ -128,7 +120,7 @@ public:
 	/** Sets header field values based on a provided uint8_t array.
 	 * @param[in] data uint8_t vector which contains 2-byte Messaeg Header.
 	 */
-	void setMessageHeader(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageHeader(std::vector<uint8_t>& data) {
 		if (data.size() == HeaderLength) {
 			setMessageHeader(&(data[0]));
 		} else {
@@ -0,0 +1,219 @@
+/*
+ * SMCPCommandMessageView.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCOMMANDMESSAGEVIEW_HH_
+#define SMCPCOMMANDMESSAGEVIEW_HH_
+
+#include <stdint.h>
+#include "SMCPTypeClasses.hh"
+#include "SMCPCommandMessage.hh"
+#include "SMCPException.hh"
+
+/** A read-only view of an SMCP Command Message stored in a byte array.
+ * Unlike SMCPCommandMessage, the view does not copy the message; field
+ * values are read directly from the byte array, which must outlive the view.
+ * Command Messages do not carry their own length, so the length of the
+ * message must be given by the caller.
+ *
+ * Field accessors of the Command Message Data part are valid only for
+ * the corresponding Command Type ID (e.g. getOperationID() for Action Command).
+ */
+class SMCPCommandMessageView {
+public:
+	static const size_t HeaderLength = SMCPCommandMessageHeader::HeaderLength;
+
+private:
+	const uint8_t* data;
+	size_t length;
+
+public:
+	/** Constructor. Constructs an empty view. */
+	SMCPCommandMessageView() :
+			data(NULL), length(0) {
+	}
+
+public:
+	/** Constructor.
+	 * @param[in] data byte array which contains a command message.
+	 * @param[in] length length of the command message.
+	 */
+	SMCPCommandMessageView(const uint8_t* data, size_t length) :
+			data(NULL), length(0) {
+		interpretAsCommandMessage(data, length);
+	}
+
+public:
+	/** Places the view on a byte array.
+	 * @param[in] data byte array which contains a command message.
+	 * @param[in] length length of the command message.
+	 */
+	void interpretAsCommandMessage(const uint8_t* data, size_t length) {
+		if (!tryInterpretAsCommandMessage(data, length)) {
+			throw SMCPException("size error");
+		}
+	}
+
+public:
+	/** Places the view on a byte array without throwing an exception.
+	 * @param[in] data byte array which contains a command message.
+	 * @param[in] length length of the command message.
+	 * @return false if the length is too short for the Command Type ID
+	 * (the view is left empty in that case).
+	 */
+	bool tryInterpretAsCommandMessage(const uint8_t* data, size_t length) {
+		if (length < HeaderLength || length < HeaderLength + getMinimumDataLength(data[0] & 0x0F)) {
+			this->data = NULL;
+			this->length = 0;
+			return false;
+		}
+		this->data = data;
+		this->length = length;
+		return true;
+	}
+
+public:
+	/** Returns the minimum length of Command Message Data for a Command Type ID.
+	 * The values follow SMCPCommandMessageData::setMessageData().
+	 */
+	static size_t getMinimumDataLength(uint8_t commandTypeID) {
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand:
+			return 2;
+		case SMCPCommandTypeID::GetCommand:
+			return 2;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return 5;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+
+public:
+	/** Returns true if the view has been placed on a message. */
+	bool isValid() const {
+		return data != NULL;
+	}
+
+public:
+	/** Returns a pointer to the first byte of the message. */
+	const uint8_t* getAsPointer() const {
+		return data;
+	}
+
+public:
+	/** Returns the length of the message. */
+	size_t getLength() const {
+		return length;
+	}
+
+public:
+	/** Returns Acknowledge Request.
+	 * @see SMCPAcknowledgeRequest.
+	 */
+	uint8_t getAcknowledgeRequest() const {
+		return data[0] >> 6;
+	}
+
+public:
+	uint8_t getSMCPVersion() const {
+		return (data[0] >> 4) & 0x03;
+	}
+
+public:
+	/** Returns Command Type ID.
+	 * @see SMCPCommandTypeID.
+	 */
+	uint8_t getCommandTypeID() const {
+		return data[0] & 0x0F;
+	}
+
+public:
+	uint8_t getLowerFOID() const {
+		return data[1];
+	}
+
+public:
+	/** Returns a pointer to the Command Message Data part. */
+	const uint8_t* getMessageDataAsPointer() const {
+		return data + HeaderLength;
+	}
+
+public:
+	/** Returns the length of the Command Message Data part. */
+	size_t getMessageDataLength() const {
+		return length - HeaderLength;
+	}
+
+public:
+	/** Returns Operation ID (Action Command). */
+	uint16_t getOperationID() const {
+		return (uint16_t) ((data[2] << 8) | data[3]);
+	}
+
+public:
+	/** Returns a pointer to the Parameter field (Action Command). */
+	const uint8_t* getParametersAsPointer() const {
+		return data + HeaderLength + 2;
+	}
+
+public:
+	/** Returns the length of the Parameter field (Action Command). */
+	size_t getParametersLength() const {
+		return length - HeaderLength - 2;
+	}
+
+public:
+	/** Returns Attribute ID (Get Command). */
+	uint16_t getAttributeID() const {
+		return (uint16_t) ((data[2] << 8) | data[3]);
+	}
+
+public:
+	/** Returns Start Address (Memory Load or Memory Dump Command). */
+	uint32_t getStartAddress() const {
+		const uint8_t* p = (getCommandTypeID() == SMCPCommandTypeID::MemoryDumpCommand) ? data + 3 : data + 2;
+		return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+	}
+
+public:
+	/** Returns a pointer to the Load Data field (Memory Load Command). */
+	const uint8_t* getLoadDataAsPointer() const {
+		return data + HeaderLength + 4;
+	}
+
+public:
+	/** Returns the length of the Load Data field (Memory Load Command). */
+	size_t getLoadDataLength() const {
+		return length - HeaderLength - 4;
+	}
+
+public:
+	/** Returns the raw N of Dumps field (Memory Dump Command); 0 means one dump. */
+	uint8_t getNOfDumps() const {
+		return data[2] & 0x03;
+	}
+
+public:
+	/** Returns Dump Length (Memory Dump Command). */
+	uint32_t getDumpLength() const {
+		return ((uint32_t) data[7] << 16) | ((uint32_t) data[8] << 8) | data[9];
+	}
+
+public:
+	/** Copies the viewed message into an SMCPCommandMessage instance.
+	 * @param[out] message destination.
+	 */
+	void copyTo(SMCPCommandMessage& message) const {
+		if (data == NULL) {
+			throw SMCPException("SMCPCommandMessageView: empty view");
+		}
+		message.interpretAsCommandMessage((uint8_t*) data, length);
+	}
+};
+
+#endif /* SMCPCOMMANDMESSAGEVIEW_HH_ */
@@ -0,0 +1,272 @@
+/*
+ * SMCPCommandTemplate.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCOMMANDTEMPLATE_HH_
+#define SMCPCOMMANDTEMPLATE_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPCommandMessage.hh"
+#include "SMCPException.hh"
+
+/** A patchable field of an SMCPCommandTemplate. */
+class SMCPCommandTemplateSlot {
+public:
+	std::string name;
+	/** Position of the first octet of the field counted from the head of the message. */
+	size_t offset;
+	/** Width of the field in octets (1 to 8). */
+	size_t width;
+	bool bigEndian;
+};
+
+/** A command message serialized once, whose fields can be patched when stamped.
+ * A template is created from an SMCPCommandMessage (or its wire bytes), and
+ * named slots are registered on the fields that change from command to
+ * command (e.g. a parameter of an Action Command or the Start Address of a
+ * Memory Load Command). stamp() copies the serialized bytes to an output
+ * buffer and overwrites only the slots, so the message object is not rebuilt.
+ *
+ * Example usage:
+ * @code
+ * SMCPActionCommandMessage command;
+ * ...set Lower FOID, Operation ID, and 4-octet parameters...
+ * SMCPCommandTemplate rotate(command);
+ * size_t angle = rotate.addParameterSlot("angle", 0, 2);
+ * size_t counter = rotate.addParameterSlot("counter", 2, 2);
+ *
+ * //single command
+ * uint64_t values[] = { 900, 1 };
+ * size_t length = rotate.stamp(buffer, sizeof(buffer), values);
+ *
+ * //batch: one array of values per slot
+ * const uint64_t* columns[] = { angles, counters };
+ * size_t written = rotate.stampBatch(buffer, sizeof(buffer), columns, nCommands);
+ * @endcode
+ */
+class SMCPCommandTemplate {
+private:
+	std::vector<uint8_t> bytes;
+	std::vector<SMCPCommandTemplateSlot> slots;
+
+public:
+	/** Constructor.
+	 * @param[in] message command message to be serialized.
+	 */
+	SMCPCommandTemplate(SMCPCommandMessage& message) {
+		bytes.resize(message.getLength());
+		message.getAsByteArray(&(bytes[0]), bytes.size());
+	}
+
+public:
+	/** Constructor.
+	 * @param[in] data wire bytes of a command message.
+	 * @param[in] length length of the message.
+	 */
+	SMCPCommandTemplate(const uint8_t* data, size_t length) {
+		if (length < SMCPCommandMessageHeader::HeaderLength) {
+			throw SMCPException("SMCPCommandTemplate: size error");
+		}
+		bytes.assign(data, data + length);
+	}
+
+public:
+	/** Returns Command Type ID of the template. */
+	uint8_t getCommandTypeID() const {
+		return bytes[0] & 0x0F;
+	}
+
+public:
+	/** Adds a slot at an arbitrary position of the message.
+	 * @param[in] name name of the slot.
+	 * @param[in] offset position of the field counted from the head of the message.
+	 * @param[in] width width of the field in octets (1 to 8).
+	 * @param[in] bigEndian byte order of the field.
+	 * @return index of the slot, used as the index of values passed to stamp().
+	 */
+	size_t addSlot(std::string name, size_t offset, size_t width, bool bigEndian = true) {
+		if (width == 0 || 8 < width) {
+			throw SMCPException("SMCPCommandTemplate: slot width should be 1 to 8");
+		}
+		if (bytes.size() < offset + width) {
+			throw SMCPException("SMCPCommandTemplate: slot exceeds the message");
+		}
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].name == name) {
+				throw SMCPException("SMCPCommandTemplate: duplicated slot name " + name);
+			}
+		}
+		SMCPCommandTemplateSlot slot;
+		slot.name = name;
+		slot.offset = offset;
+		slot.width = width;
+		slot.bigEndian = bigEndian;
+		slots.push_back(slot);
+		return slots.size() - 1;
+	}
+
+public:
+	/** Adds a slot in the parameters of an Action Command.
+	 * @param[in] name name of the slot.
+	 * @param[in] parameterOffset position of the field counted from the head of the parameters.
+	 * @param[in] width width of the field in octets (1 to 8).
+	 * @param[in] bigEndian byte order of the field.
+	 * @return index of the slot.
+	 */
+	size_t addParameterSlot(std::string name, size_t parameterOffset, size_t width, bool bigEndian = true) {
+		if (getCommandTypeID() != SMCPCommandTypeID::ActionCommand) {
+			throw SMCPException("SMCPCommandTemplate: parameter slot requires an Action Command");
+		}
+		return addSlot(name, SMCPCommandMessageHeader::HeaderLength + 2 + parameterOffset, width, bigEndian);
+	}
+
+public:
+	/** Adds a slot in the load data of a Memory Load Command.
+	 * @param[in] name name of the slot.
+	 * @param[in] loadDataOffset position of the field counted from the head of the load data.
+	 * @param[in] width width of the field in octets (1 to 8).
+	 * @param[in] bigEndian byte order of the field.
+	 * @return index of the slot.
+	 */
+	size_t addLoadDataSlot(std::string name, size_t loadDataOffset, size_t width, bool bigEndian = true) {
+		if (getCommandTypeID() != SMCPCommandTypeID::MemoryLoadCommand) {
+			throw SMCPException("SMCPCommandTemplate: load data slot requires a Memory Load Command");
+		}
+		return addSlot(name, SMCPCommandMessageHeader::HeaderLength + 4 + loadDataOffset, width, bigEndian);
+	}
+
+public:
+	/** Adds a slot on the 4-octet Start Address of a Memory Load or Memory Dump Command.
+	 * @param[in] name name of the slot.
+	 * @return index of the slot.
+	 */
+	size_t addStartAddressSlot(std::string name = "startAddress") {
+		switch (getCommandTypeID()) {
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return addSlot(name, SMCPCommandMessageHeader::HeaderLength, 4);
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return addSlot(name, SMCPCommandMessageHeader::HeaderLength + 1, 4);
+		default:
+			throw SMCPException("SMCPCommandTemplate: start address slot requires a Memory Load/Dump Command");
+		}
+	}
+
+public:
+	/** Returns the index of a slot.
+	 * @param[in] name name of the slot.
+	 */
+	size_t getSlotIndex(const std::string& name) const {
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].name == name) {
+				return i;
+			}
+		}
+		throw SMCPException("SMCPCommandTemplate: undefined slot " + name);
+	}
+
+public:
+	const SMCPCommandTemplateSlot& getSlot(size_t index) const {
+		return slots.at(index);
+	}
+
+public:
+	size_t getNSlots() const {
+		return slots.size();
+	}
+
+public:
+	/** Returns the length of a stamped command. */
+	size_t getLength() const {
+		return bytes.size();
+	}
+
+public:
+	/** Returns the serialized command with the slots holding their template values. */
+	const std::vector<uint8_t>& getAsByteVector() const {
+		return bytes;
+	}
+
+public:
+	/** Writes a command into a buffer.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @param[in] values values of the slots, indexed by slot index (getNSlots() elements).
+	 * @return the number of bytes written (getLength()).
+	 */
+	size_t stamp(uint8_t* buffer, size_t size, const uint64_t* values) const {
+		if (size < bytes.size()) {
+			throw SMCPException("buffer too small");
+		}
+		memcpy(buffer, &(bytes[0]), bytes.size());
+		for (size_t s = 0; s < slots.size(); s++) {
+			writeSlot(buffer, slots[s], values[s]);
+		}
+		return bytes.size();
+	}
+
+public:
+	/** Writes commands back to back into a buffer.
+	 * Command i is written at buffer + i * getLength().
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @param[in] slotValues array of getNSlots() arrays; slotValues[s][i] is the value
+	 * of slot s of command i. A NULL array leaves the slot at its template value.
+	 * @param[in] nCommands number of commands.
+	 * @return the number of bytes written (nCommands * getLength()).
+	 */
+	size_t stampBatch(uint8_t* buffer, size_t size, const uint64_t* const * slotValues, size_t nCommands) const {
+		const size_t length = bytes.size();
+		if (size / length < nCommands) {
+			throw SMCPException("buffer too small");
+		}
+		for (size_t i = 0; i < nCommands; i++) {
+			memcpy(buffer + i * length, &(bytes[0]), length);
+		}
+		//patch slot by slot so that each value array is read sequentially
+		for (size_t s = 0; s < slots.size(); s++) {
+			const uint64_t* values = slotValues[s];
+			if (values == NULL) {
+				continue;
+			}
+			const SMCPCommandTemplateSlot& slot = slots[s];
+			for (size_t i = 0; i < nCommands; i++) {
+				writeSlot(buffer + i * length, slot, values[i]);
+			}
+		}
+		return nCommands * length;
+	}
+
+public:
+	/** Overwrites one slot of a command already written to a buffer.
+	 * @param[in,out] message head of the command.
+	 * @param[in] index slot index.
+	 * @param[in] value new value.
+	 */
+	void patch(uint8_t* message, size_t index, uint64_t value) const {
+		writeSlot(message, slots.at(index), value);
+	}
+
+private:
+	static void writeSlot(uint8_t* message, const SMCPCommandTemplateSlot& slot, uint64_t value) {
+		uint8_t* p = message + slot.offset;
+		if (slot.bigEndian) {
+			for (size_t i = slot.width; i != 0; i--) {
+				p[i - 1] = (uint8_t) value;
+				value >>= 8;
+			}
+		} else {
+			for (size_t i = 0; i < slot.width; i++) {
+				p[i] = (uint8_t) value;
+				value >>= 8;
+			}
+		}
+	}
+};
+
+#endif /* SMCPCOMMANDTEMPLATE_HH_ */
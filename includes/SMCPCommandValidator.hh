@@ -0,0 +1,479 @@
+/*
+ * SMCPCommandValidator.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCOMMANDVALIDATOR_HH_
+#define SMCPCOMMANDVALIDATOR_HH_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "SMCPTypeClasses.hh"
+#include "SMCPCommandMessage.hh"
+#include "SMCPCommandMessageView.hh"
+#include "SMCPException.hh"
+#include "SMCPInstrumentation.hh"
+
+/** A class which collects verdict flags returned by SMCPCommandValidator.
+ * A verdict is a bitwise OR of the flags; Valid (0) means that all checks passed.
+ */
+class SMCPCommandVerdict {
+public:
+	enum {
+		Valid = 0x00,
+		MalformedMessage = 0x01, //shorter than required for the Command Type ID
+		CommandTypeNotAllowed = 0x02,
+		IDNotAllowed = 0x04, //Operation ID (Action) or Attribute ID (Get)
+		ParameterTooLong = 0x08,
+		LoadDataTooLong = 0x10,
+		AddressOutOfRange = 0x20,
+		AcknowledgeRequestViolation = 0x40
+	};
+
+public:
+	/** Returns a human-readable list of the flags set in a verdict. */
+	static std::string toString(uint32_t verdict) {
+		if (verdict == Valid) {
+			return "Valid";
+		}
+		static const char* names[] = { "MalformedMessage", "CommandTypeNotAllowed", "IDNotAllowed", "ParameterTooLong",
+				"LoadDataTooLong", "AddressOutOfRange", "AcknowledgeRequestViolation" };
+		std::string result;
+		for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+			if (verdict & (1 << i)) {
+				if (!result.empty()) {
+					result += "|";
+				}
+				result += names[i];
+			}
+		}
+		return result;
+	}
+};
+
+/** A class which collects acknowledge-request policies used by SMCPCommandValidationRules. */
+class SMCPAcknowledgePolicy {
+public:
+	enum {
+		Any = 0x00, //both NoAcknowledgeTelemetry and RequestAcknowledgeTelemetry are accepted
+		Required = 0x01, //RequestAcknowledgeTelemetry is required
+		Forbidden = 0x02 //NoAcknowledgeTelemetry is required
+	};
+};
+
+/** A rule set for SMCPCommandValidator.
+ *
+ * Nothing is allowed by default. For each allowed Command Type ID:
+ * - Action Command: if any operation is registered with allowOperation(), only
+ *   registered Operation IDs are accepted, each with its own maximum parameter
+ *   length. Otherwise every Operation ID is accepted with
+ *   SMCPCommandMessageData::MaximumParameterLength.
+ * - Get Command: likewise with allowAttribute().
+ * - Memory Load/Dump Command: the accessed region [Start Address, Start Address
+ *   + length) must lie inside a single range registered with allowMemoryRange().
+ *   Load Data may not exceed SMCPCommandMessageData::MaximumLoadDataLength.
+ */
+class SMCPCommandValidationRules {
+public:
+	class IDRule {
+	public:
+		uint16_t first;
+		uint16_t last;
+		size_t maximumParameterLength;
+	};
+
+public:
+	class MemoryRange {
+	public:
+		uint8_t commandTypeID;
+		uint64_t start;
+		uint64_t end; //exclusive
+	};
+
+public:
+	bool allowedCommandTypes[16];
+	int acknowledgePolicies[16];
+	std::vector<IDRule> operationRules;
+	std::vector<IDRule> attributeRules;
+	std::vector<MemoryRange> memoryRanges;
+
+public:
+	/** Constructor. Constructs an empty rule set. */
+	SMCPCommandValidationRules() {
+		for (size_t i = 0; i < 16; i++) {
+			allowedCommandTypes[i] = false;
+			acknowledgePolicies[i] = SMCPAcknowledgePolicy::Any;
+		}
+	}
+
+public:
+	/** Allows a Command Type ID.
+	 * @param[in] commandTypeID see SMCPCommandTypeID.
+	 * @param[in] acknowledgePolicy see SMCPAcknowledgePolicy.
+	 */
+	void allowCommandType(uint8_t commandTypeID, int acknowledgePolicy = SMCPAcknowledgePolicy::Any) {
+		if (16 <= commandTypeID) {
+			throw SMCPException("SMCPCommandValidationRules: Command Type ID should be smaller than 16");
+		}
+		allowedCommandTypes[commandTypeID] = true;
+		acknowledgePolicies[commandTypeID] = acknowledgePolicy;
+	}
+
+public:
+	/** Allows an Operation ID of Action Command. */
+	void allowOperation(uint16_t operationID,
+			size_t maximumParameterLength = SMCPCommandMessageData::MaximumParameterLength) {
+		allowOperations(operationID, operationID, maximumParameterLength);
+	}
+
+public:
+	/** Allows Operation IDs first..last (inclusive) of Action Command. */
+	void allowOperations(uint16_t first, uint16_t last,
+			size_t maximumParameterLength = SMCPCommandMessageData::MaximumParameterLength) {
+		IDRule rule;
+		rule.first = first;
+		rule.last = last;
+		rule.maximumParameterLength = maximumParameterLength;
+		operationRules.push_back(rule);
+	}
+
+public:
+	/** Allows an Attribute ID of Get Command. */
+	void allowAttribute(uint16_t attributeID) {
+		allowAttributes(attributeID, attributeID);
+	}
+
+public:
+	/** Allows Attribute IDs first..last (inclusive) of Get Command. */
+	void allowAttributes(uint16_t first, uint16_t last) {
+		IDRule rule;
+		rule.first = first;
+		rule.last = last;
+		rule.maximumParameterLength = 0;
+		attributeRules.push_back(rule);
+	}
+
+public:
+	/** Allows a memory range for Memory Load or Memory Dump Command.
+	 * @param[in] commandTypeID SMCPCommandTypeID::MemoryLoadCommand or SMCPCommandTypeID::MemoryDumpCommand.
+	 * @param[in] startAddress first address of the range.
+	 * @param[in] length length of the range in bytes.
+	 */
+	void allowMemoryRange(uint8_t commandTypeID, uint32_t startAddress, uint64_t length) {
+		if (commandTypeID != SMCPCommandTypeID::MemoryLoadCommand
+				&& commandTypeID != SMCPCommandTypeID::MemoryDumpCommand) {
+			throw SMCPException("SMCPCommandValidationRules: memory range is defined only for Memory Load/Dump");
+		}
+		MemoryRange range;
+		range.commandTypeID = commandTypeID;
+		range.start = startAddress;
+		range.end = startAddress + length;
+		memoryRanges.push_back(range);
+	}
+};
+
+/** A class which validates SMCP Command Messages before uplink.
+ *
+ * The rule set is compiled once into lookup tables: a flag table indexed by
+ * Command Type ID, maximum-length tables indexed by Operation ID / Attribute ID,
+ * and sorted, merged address ranges for Memory Load/Dump. Validation reads
+ * fields in place (from an SMCPCommandMessageView or through the pointer
+ * accessors of SMCPCommandMessageData) and never copies a message.
+ *
+ * Example usage:
+ * @code
+ * SMCPCommandValidationRules rules;
+ * rules.allowCommandType(SMCPCommandTypeID::ActionCommand, SMCPAcknowledgePolicy::Required);
+ * rules.allowOperation(0x0010, 4);
+ * rules.allowCommandType(SMCPCommandTypeID::MemoryDumpCommand);
+ * rules.allowMemoryRange(SMCPCommandTypeID::MemoryDumpCommand, 0x00100000, 0x10000);
+ * SMCPCommandValidator validator(rules);
+ *
+ * std::vector<uint32_t> verdicts;
+ * size_t nInvalid = validator.validate(commands, verdicts);
+ * @endcode
+ */
+class SMCPCommandValidator {
+private:
+	static const uint16_t NotAllowed = 0xFFFF;
+
+private:
+	enum {
+		TypeAllowed = 0x01, //
+		TypeAcknowledgeRequired = 0x02, //
+		TypeAcknowledgeForbidden = 0x04
+	};
+
+private:
+	class AddressRange {
+	public:
+		uint64_t start;
+		uint64_t end;
+
+	public:
+		bool operator<(const AddressRange& other) const {
+			return start < other.start;
+		}
+	};
+
+private:
+	uint8_t typeFlags[16];
+	std::vector<uint16_t> maximumParameterLengths; //indexed by Operation ID
+	std::vector<uint16_t> attributeTable; //indexed by Attribute ID (0 = allowed)
+	std::vector<AddressRange> loadRanges;
+	std::vector<AddressRange> dumpRanges;
+
+public:
+	/** Constructor.
+	 * @param[in] rules rule set to be compiled.
+	 */
+	SMCPCommandValidator(const SMCPCommandValidationRules& rules) :
+			maximumParameterLengths(0x10000), attributeTable(0x10000) {
+		compile(rules);
+	}
+
+public:
+	/** Replaces the current tables with those compiled from a rule set. */
+	void compile(const SMCPCommandValidationRules& rules) {
+		for (size_t i = 0; i < 16; i++) {
+			typeFlags[i] = 0;
+			if (rules.allowedCommandTypes[i]) {
+				typeFlags[i] |= TypeAllowed;
+				if (rules.acknowledgePolicies[i] == SMCPAcknowledgePolicy::Required) {
+					typeFlags[i] |= TypeAcknowledgeRequired;
+				} else if (rules.acknowledgePolicies[i] == SMCPAcknowledgePolicy::Forbidden) {
+					typeFlags[i] |= TypeAcknowledgeForbidden;
+				}
+			}
+		}
+
+		compileIDRules(rules.operationRules, maximumParameterLengths, SMCPCommandMessageData::MaximumParameterLength);
+		compileIDRules(rules.attributeRules, attributeTable, 0);
+
+		loadRanges.clear();
+		dumpRanges.clear();
+		for (size_t i = 0; i < rules.memoryRanges.size(); i++) {
+			AddressRange range;
+			range.start = rules.memoryRanges[i].start;
+			range.end = rules.memoryRanges[i].end;
+			if (rules.memoryRanges[i].commandTypeID == SMCPCommandTypeID::MemoryLoadCommand) {
+				loadRanges.push_back(range);
+			} else {
+				dumpRanges.push_back(range);
+			}
+		}
+		mergeRanges(loadRanges);
+		mergeRanges(dumpRanges);
+	}
+
+public:
+	/** Validates a command message stored in a byte array.
+	 * @param[in] view command message.
+	 * @return verdict (see SMCPCommandVerdict).
+	 */
+	uint32_t validate(const SMCPCommandMessageView& view) const {
+		if (!view.isValid()) {
+			SMCP_INSTRUMENT_VALIDATION_FAILURE(SMCPInstrumentedType::Undefined);
+			return SMCPCommandVerdict::MalformedMessage;
+		}
+		uint8_t commandTypeID = view.getCommandTypeID();
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand:
+			return validateFields(commandTypeID, view.getAcknowledgeRequest(), view.getOperationID(),
+					view.getParametersLength(), 0, 0);
+		case SMCPCommandTypeID::GetCommand:
+			return validateFields(commandTypeID, view.getAcknowledgeRequest(), view.getAttributeID(), 0, 0, 0);
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return validateFields(commandTypeID, view.getAcknowledgeRequest(), 0, view.getLoadDataLength(),
+					view.getStartAddress(), view.getLoadDataLength());
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return validateFields(commandTypeID, view.getAcknowledgeRequest(), 0, 0, view.getStartAddress(),
+					view.getDumpLength());
+		default:
+			return validateFields(commandTypeID, view.getAcknowledgeRequest(), 0, 0, 0, 0);
+		}
+	}
+
+public:
+	/** Validates a command message stored in a byte array.
+	 * @param[in] data byte array which contains a command message.
+	 * @param[in] length length of the command message.
+	 * @return verdict (see SMCPCommandVerdict).
+	 */
+	uint32_t validate(const uint8_t* data, size_t length) const {
+		SMCPCommandMessageView view;
+		view.tryInterpretAsCommandMessage(data, length);
+		return validate(view);
+	}
+
+public:
+	/** Validates an SMCPCommandMessage instance without copying its fields.
+	 * @param[in] message command message.
+	 * @return verdict (see SMCPCommandVerdict).
+	 */
+	uint32_t validate(SMCPCommandMessage& message) const {
+		SMCPCommandMessageHeader* header = message.getMessageHeader();
+		SMCPCommandMessageData* data = message.getMessageData();
+		uint8_t commandTypeID = (uint8_t) header->getCommandTypeID().to_ulong();
+		uint8_t acknowledgeRequest = (uint8_t) header->getAcknowledgeRequest().to_ulong();
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand: {
+			const uint8_t* operationID = data->getOperationIDAsPointer();
+			return validateFields(commandTypeID, acknowledgeRequest, (uint16_t) ((operationID[0] << 8) | operationID[1]),
+					data->getParametersLength(), 0, 0);
+		}
+		case SMCPCommandTypeID::GetCommand:
+			return validateFields(commandTypeID, acknowledgeRequest, data->getAttributeID(), 0, 0, 0);
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return validateFields(commandTypeID, acknowledgeRequest, 0, data->getLoadDataLength(),
+					data->getStartAddress(), data->getLoadDataLength());
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return validateFields(commandTypeID, acknowledgeRequest, 0, 0, data->getStartAddress(),
+					data->getDumpLength());
+		default:
+			return validateFields(commandTypeID, acknowledgeRequest, 0, 0, 0, 0);
+		}
+	}
+
+public:
+	/** Validates a batch of command messages.
+	 * @param[in] messages command messages.
+	 * @param[out] verdicts verdict of each message (resized to messages.size()).
+	 * @return the number of invalid messages.
+	 */
+	size_t validate(const std::vector<SMCPCommandMessage*>& messages, std::vector<uint32_t>& verdicts) const {
+		verdicts.resize(messages.size());
+		size_t nInvalid = 0;
+		for (size_t i = 0; i < messages.size(); i++) {
+			verdicts[i] = validate(*messages[i]);
+			nInvalid += (verdicts[i] != SMCPCommandVerdict::Valid);
+		}
+		return nInvalid;
+	}
+
+public:
+	/** Validates a batch of command messages stored in byte arrays.
+	 * @param[in] messages pointers to the command messages.
+	 * @param[in] lengths lengths of the command messages.
+	 * @param[in] nMessages number of messages.
+	 * @param[out] verdicts array which receives nMessages verdicts.
+	 * @return the number of invalid messages.
+	 */
+	size_t validate(const uint8_t* const * messages, const size_t* lengths, size_t nMessages, uint32_t* verdicts) const {
+		size_t nInvalid = 0;
+		for (size_t i = 0; i < nMessages; i++) {
+			verdicts[i] = validate(messages[i], lengths[i]);
+			nInvalid += (verdicts[i] != SMCPCommandVerdict::Valid);
+		}
+		return nInvalid;
+	}
+
+private:
+	uint32_t validateFields(uint8_t commandTypeID, uint8_t acknowledgeRequest, uint16_t id, size_t dataLength,
+			uint64_t startAddress, uint64_t regionLength) const {
+		uint8_t flags = typeFlags[commandTypeID];
+		if ((flags & TypeAllowed) == 0) {
+			SMCP_INSTRUMENT_VALIDATION_FAILURE(SMCPInstrumentedType::fromCommandTypeID(commandTypeID));
+			return SMCPCommandVerdict::CommandTypeNotAllowed;
+		}
+
+		uint32_t verdict = SMCPCommandVerdict::Valid;
+		if (acknowledgeRequest == SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+			verdict |= (flags & TypeAcknowledgeRequired) ? SMCPCommandVerdict::AcknowledgeRequestViolation : 0;
+		} else if (acknowledgeRequest == SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry) {
+			verdict |= (flags & TypeAcknowledgeForbidden) ? SMCPCommandVerdict::AcknowledgeRequestViolation : 0;
+		} else {
+			verdict |= SMCPCommandVerdict::AcknowledgeRequestViolation;
+		}
+
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand: {
+			uint16_t maximumParameterLength = maximumParameterLengths[id];
+			if (maximumParameterLength == NotAllowed) {
+				verdict |= SMCPCommandVerdict::IDNotAllowed;
+			} else if (maximumParameterLength < dataLength) {
+				verdict |= SMCPCommandVerdict::ParameterTooLong;
+			}
+			break;
+		}
+		case SMCPCommandTypeID::GetCommand:
+			if (attributeTable[id] == NotAllowed) {
+				verdict |= SMCPCommandVerdict::IDNotAllowed;
+			}
+			break;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			if (SMCPCommandMessageData::MaximumLoadDataLength < dataLength) {
+				verdict |= SMCPCommandVerdict::LoadDataTooLong;
+			}
+			if (!isInside(loadRanges, startAddress, regionLength)) {
+				verdict |= SMCPCommandVerdict::AddressOutOfRange;
+			}
+			break;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			if (!isInside(dumpRanges, startAddress, regionLength)) {
+				verdict |= SMCPCommandVerdict::AddressOutOfRange;
+			}
+			break;
+		default:
+			break;
+		}
+		if (verdict != SMCPCommandVerdict::Valid) {
+			SMCP_INSTRUMENT_VALIDATION_FAILURE(SMCPInstrumentedType::fromCommandTypeID(commandTypeID));
+		}
+		return verdict;
+	}
+
+private:
+	static bool isInside(const std::vector<AddressRange>& ranges, uint64_t startAddress, uint64_t length) {
+		//find the last range which starts at or before startAddress
+		size_t low = 0, high = ranges.size();
+		while (low < high) {
+			size_t middle = (low + high) / 2;
+			if (ranges[middle].start <= startAddress) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		if (low == 0) {
+			return false;
+		}
+		const AddressRange& range = ranges[low - 1];
+		return startAddress < range.end && startAddress + length <= range.end;
+	}
+
+private:
+	static void mergeRanges(std::vector<AddressRange>& ranges) {
+		std::sort(ranges.begin(), ranges.end());
+		size_t n = 0;
+		for (size_t i = 0; i < ranges.size(); i++) {
+			if (n != 0 && ranges[i].start <= ranges[n - 1].end) {
+				ranges[n - 1].end = std::max(ranges[n - 1].end, ranges[i].end);
+			} else {
+				ranges[n++] = ranges[i];
+			}
+		}
+		ranges.resize(n);
+	}
+
+private:
+	static void compileIDRules(const std::vector<SMCPCommandValidationRules::IDRule>& rules,
+			std::vector<uint16_t>& table, size_t defaultValue) {
+		if (rules.empty()) {
+			std::fill(table.begin(), table.end(), (uint16_t) defaultValue);
+			return;
+		}
+		std::fill(table.begin(), table.end(), (uint16_t) NotAllowed);
+		for (size_t i = 0; i < rules.size(); i++) {
+			size_t value = (rules[i].maximumParameterLength < NotAllowed) ? rules[i].maximumParameterLength : NotAllowed - 1;
+			for (uint32_t id = rules[i].first; id <= rules[i].last; id++) {
+				table[id] = (uint16_t) value;
+			}
+		}
+	}
+};
+
+#endif /* SMCPCOMMANDVALIDATOR_HH_ */
@@ -0,0 +1,380 @@
+/*
+ * SMCPCurrentValueTable.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPCURRENTVALUETABLE_HH_
+#define SMCPCURRENTVALUETABLE_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPException.hh"
+
+/** A table which holds the latest Attribute Value of each (lowerFOID, AttributeID)
+ * received via SMCPValueTelemetryMessage.
+ *
+ * The table is designed for one writer (the ingest thread) and many readers
+ * (display or monitoring threads). Each slot is protected by a sequence lock;
+ * the writer never waits for readers, and readers never take a lock but retry
+ * when they observe a slot being rewritten. All memory is allocated in the
+ * constructor, so neither update() nor read() allocates.
+ *
+ * Attribute Values longer than the maximum value length given to the constructor
+ * are truncated in the table; the original length is still reported.
+ *
+ * Example usage:
+ * @code
+ * SMCPCurrentValueTable table;
+ * //ingest thread
+ * table.update(valueTelemetryMessage);
+ * //display thread
+ * SMCPCurrentValueTable::Value value;
+ * if (table.read(lowerFOID, attributeID, value)) {
+ * 	...value.bytes, value.receiveTime, value.updateCount...
+ * }
+ * @endcode
+ */
+class SMCPCurrentValueTable {
+public:
+	static const size_t DefaultCapacity = 4096;
+	static const size_t DefaultMaximumValueLength = 64;
+
+public:
+	/** The latest value of a single attribute, as returned by read(). */
+	class Value {
+	public:
+		uint8_t lowerFOID;
+		uint16_t attributeID;
+		/** Receive time in nanoseconds (see SMCPCurrentValueTable::getCurrentTime()). */
+		uint64_t receiveTime;
+		/** Number of updates received for this attribute. */
+		uint64_t updateCount;
+		/** Length of the received Attribute Value (may exceed bytes.size() when truncated). */
+		size_t length;
+		std::vector<uint8_t> bytes;
+	};
+
+public:
+	/** A copy of the whole table taken by snapshot().
+	 * Entries and value bytes are kept in two flat arrays whose capacity is
+	 * reused, so taking repeated snapshots into the same instance does not
+	 * allocate once the table has stopped growing.
+	 */
+	class Snapshot {
+	public:
+		class Entry {
+		public:
+			uint8_t lowerFOID;
+			uint16_t attributeID;
+			uint64_t receiveTime;
+			uint64_t updateCount;
+			size_t length;
+			size_t storedLength;
+			size_t offset;
+		};
+
+	public:
+		std::vector<Entry> entries;
+		std::vector<uint8_t> bytes;
+		/** Table generation at the time the snapshot was taken. */
+		uint64_t generation;
+
+	public:
+		Snapshot() :
+				generation(0) {
+		}
+
+	public:
+		/** Returns the number of entries. */
+		size_t size() const {
+			return entries.size();
+		}
+
+	public:
+		/** Returns a pointer to the stored value bytes of the i-th entry. */
+		const uint8_t* getValueAsPointer(size_t i) const {
+			return bytes.empty() ? NULL : &bytes[entries[i].offset];
+		}
+	};
+
+private:
+	class Slot {
+	public:
+		std::atomic<uint32_t> key; //0 = empty
+		std::atomic<uint32_t> sequence; //odd while the writer is updating the slot
+		std::atomic<uint64_t> receiveTime;
+		std::atomic<uint64_t> updateCount;
+		std::atomic<uint64_t> length;
+	};
+
+private:
+	static const uint32_t OccupiedFlag = 0x01000000;
+
+private:
+	size_t capacity;
+	size_t maximumValueLength;
+	size_t wordsPerSlot;
+	size_t mask;
+	std::vector<Slot> slots;
+	std::vector<std::atomic<uint64_t> > words;
+	std::vector<std::atomic<uint32_t> > slotIndices; //insertion order, used by snapshot()
+	std::atomic<size_t> nEntries;
+	std::atomic<uint64_t> generation;
+
+public:
+	/** Constructor.
+	 * @param[in] capacity maximum number of (lowerFOID, AttributeID) pairs.
+	 * @param[in] maximumValueLength number of Attribute Value bytes stored per pair.
+	 */
+	SMCPCurrentValueTable(size_t capacity = DefaultCapacity, size_t maximumValueLength = DefaultMaximumValueLength) :
+			capacity(capacity), maximumValueLength(maximumValueLength), //
+			wordsPerSlot((maximumValueLength + 7) / 8), mask(0), //
+			slots(roundUpToPowerOfTwo(capacity * 2)), //
+			words(roundUpToPowerOfTwo(capacity * 2) * ((maximumValueLength + 7) / 8)), //
+			slotIndices(capacity), nEntries(0), generation(0) {
+		if (capacity == 0) {
+			throw SMCPException("SMCPCurrentValueTable: capacity should be larger than 0");
+		}
+		mask = slots.size() - 1;
+		for (size_t i = 0; i < slots.size(); i++) {
+			slots[i].key.store(0, std::memory_order_relaxed);
+			slots[i].sequence.store(0, std::memory_order_relaxed);
+		}
+	}
+
+public:
+	/** Stores the latest value of an attribute. Must be called from a single writer thread.
+	 * @param[in] lowerFOID Lower FOID of the telemetry.
+	 * @param[in] attributeID Attribute ID of the telemetry.
+	 * @param[in] value pointer to the Attribute Value bytes.
+	 * @param[in] length length of the Attribute Value.
+	 * @param[in] receiveTime receive time in nanoseconds.
+	 */
+	void update(uint8_t lowerFOID, uint16_t attributeID, const uint8_t* value, size_t length, uint64_t receiveTime) {
+		Slot& slot = slots[findOrInsert(toKey(lowerFOID, attributeID))];
+		std::atomic<uint64_t>* slotWords = &words[(&slot - &slots[0]) * wordsPerSlot];
+
+		uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		size_t storedLength = (length < maximumValueLength) ? length : maximumValueLength;
+		for (size_t i = 0, offset = 0; offset < storedLength; i++, offset += 8) {
+			uint64_t word = 0;
+			size_t n = (storedLength - offset < 8) ? storedLength - offset : 8;
+			memcpy(&word, value + offset, n);
+			slotWords[i].store(word, std::memory_order_relaxed);
+		}
+		slot.length.store(length, std::memory_order_relaxed);
+		slot.receiveTime.store(receiveTime, std::memory_order_relaxed);
+		slot.updateCount.store(slot.updateCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+public:
+	/** Stores the latest value of an attribute using the current time as receive time.
+	 */
+	void update(uint8_t lowerFOID, uint16_t attributeID, const uint8_t* value, size_t length) {
+		update(lowerFOID, attributeID, value, length, getCurrentTime());
+	}
+
+public:
+	/** Stores the Attribute Value of a Value Telemetry message.
+	 * Messages of other telemetry types are ignored.
+	 * @param[in] message telemetry message.
+	 * @param[in] receiveTime receive time in nanoseconds.
+	 * @return true if the message was stored.
+	 */
+	bool update(SMCPTelemetryMessage& message, uint64_t receiveTime) {
+		SMCPTelemetryMessageHeader* header = message.getMessageHeader();
+		if (header->getTelemetryTypeID().to_ulong() != SMCPTelemetryTypeID::ValueTelemetry) {
+			return false;
+		}
+		SMCPTelemetryMessageData* data = message.getMessageData();
+		update(header->getLowerFOID(), data->getAttributeID(), data->getAttributeValuesAsPointer(),
+				data->getAttributeValuesLength(), receiveTime);
+		return true;
+	}
+
+public:
+	/** Stores the Attribute Value of a Value Telemetry message using the current time as receive time.
+	 */
+	bool update(SMCPTelemetryMessage& message) {
+		return update(message, getCurrentTime());
+	}
+
+public:
+	/** Reads the latest value of an attribute. Can be called from any thread.
+	 * value.bytes is resized to the stored length; its capacity is reused.
+	 * @param[in] lowerFOID Lower FOID of the telemetry.
+	 * @param[in] attributeID Attribute ID of the telemetry.
+	 * @param[out] value destination.
+	 * @return false if no value has been received for the attribute.
+	 */
+	bool read(uint8_t lowerFOID, uint16_t attributeID, Value& value) const {
+		size_t index;
+		if (!find(toKey(lowerFOID, attributeID), index)) {
+			return false;
+		}
+		value.lowerFOID = lowerFOID;
+		value.attributeID = attributeID;
+		value.bytes.resize(maximumValueLength);
+		size_t storedLength;
+		readSlot(index, value.receiveTime, value.updateCount, value.length, storedLength,
+				value.bytes.empty() ? NULL : &value.bytes[0]);
+		value.bytes.resize(storedLength);
+		return true;
+	}
+
+public:
+	/** Copies all entries of the table. Can be called from any thread.
+	 * Each entry is internally consistent; entries may be taken at slightly
+	 * different moments while the writer keeps updating the table.
+	 * @param[out] snapshot destination; its previous content is discarded.
+	 */
+	void snapshot(Snapshot& snapshot) const {
+		snapshot.generation = generation.load(std::memory_order_acquire);
+		size_t n = nEntries.load(std::memory_order_acquire);
+		snapshot.entries.resize(n);
+		snapshot.bytes.resize(n * maximumValueLength);
+		for (size_t i = 0; i < n; i++) {
+			size_t index = slotIndices[i].load(std::memory_order_relaxed);
+			uint32_t key = slots[index].key.load(std::memory_order_relaxed);
+			Snapshot::Entry& entry = snapshot.entries[i];
+			entry.lowerFOID = (key >> 16) & 0xFF;
+			entry.attributeID = key & 0xFFFF;
+			entry.offset = i * maximumValueLength;
+			readSlot(index, entry.receiveTime, entry.updateCount, entry.length, entry.storedLength,
+					snapshot.bytes.empty() ? NULL : &snapshot.bytes[entry.offset]);
+		}
+	}
+
+public:
+	/** Returns the number of (lowerFOID, AttributeID) pairs stored in the table. */
+	size_t size() const {
+		return nEntries.load(std::memory_order_acquire);
+	}
+
+public:
+	/** Returns a counter incremented on every update.
+	 * Readers can compare it against Snapshot::generation to skip unchanged tables.
+	 */
+	uint64_t getGeneration() const {
+		return generation.load(std::memory_order_acquire);
+	}
+
+public:
+	size_t getCapacity() const {
+		return capacity;
+	}
+
+public:
+	size_t getMaximumValueLength() const {
+		return maximumValueLength;
+	}
+
+public:
+	/** Returns current time in nanoseconds since the epoch. */
+	static uint64_t getCurrentTime() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	static uint32_t toKey(uint8_t lowerFOID, uint16_t attributeID) {
+		return OccupiedFlag | ((uint32_t) lowerFOID << 16) | attributeID;
+	}
+
+private:
+	static size_t hash(uint32_t key) {
+		key ^= key >> 15;
+		key *= 0x2c1b3c6dU;
+		key ^= key >> 12;
+		return key;
+	}
+
+private:
+	static size_t roundUpToPowerOfTwo(size_t n) {
+		size_t result = 1;
+		while (result < n) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+private:
+	bool find(uint32_t key, size_t& index) const {
+		for (size_t i = hash(key) & mask, probe = 0; probe < slots.size(); i = (i + 1) & mask, probe++) {
+			uint32_t slotKey = slots[i].key.load(std::memory_order_acquire);
+			if (slotKey == key) {
+				index = i;
+				return true;
+			} else if (slotKey == 0) {
+				return false;
+			}
+		}
+		return false;
+	}
+
+private:
+	size_t findOrInsert(uint32_t key) {
+		size_t i = hash(key) & mask;
+		while (true) {
+			uint32_t slotKey = slots[i].key.load(std::memory_order_relaxed);
+			if (slotKey == key) {
+				return i;
+			} else if (slotKey == 0) {
+				break;
+			}
+			i = (i + 1) & mask;
+		}
+
+		size_t n = nEntries.load(std::memory_order_relaxed);
+		if (n == capacity) {
+			throw SMCPException("SMCPCurrentValueTable: table is full");
+		}
+		slots[i].receiveTime.store(0, std::memory_order_relaxed);
+		slots[i].updateCount.store(0, std::memory_order_relaxed);
+		slots[i].length.store(0, std::memory_order_relaxed);
+		slots[i].key.store(key, std::memory_order_release);
+		slotIndices[n].store(i, std::memory_order_relaxed);
+		nEntries.store(n + 1, std::memory_order_release);
+		return i;
+	}
+
+private:
+	void readSlot(size_t index, uint64_t& receiveTime, uint64_t& updateCount, size_t& length, size_t& storedLength,
+			uint8_t* destination) const {
+		const Slot& slot = slots[index];
+		const std::atomic<uint64_t>* slotWords = &words[index * wordsPerSlot];
+		while (true) {
+			uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				continue;
+			}
+			length = slot.length.load(std::memory_order_relaxed);
+			receiveTime = slot.receiveTime.load(std::memory_order_relaxed);
+			updateCount = slot.updateCount.load(std::memory_order_relaxed);
+			storedLength = (length < maximumValueLength) ? length : maximumValueLength;
+			for (size_t i = 0, offset = 0; offset < storedLength; i++, offset += 8) {
+				uint64_t word = slotWords[i].load(std::memory_order_relaxed);
+				size_t n = (storedLength - offset < 8) ? storedLength - offset : 8;
+				memcpy(destination + offset, &word, n);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+				return;
+			}
+		}
+	}
+};
+
+#endif /* SMCPCURRENTVALUETABLE_HH_ */
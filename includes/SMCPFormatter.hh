@@ -0,0 +1,534 @@
+/*
+ * SMCPFormatter.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPFORMATTER_HH_
+#define SMCPFORMATTER_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include "SMCPTypeClasses.hh"
+
+/** A class which formats SMCP messages into a caller-owned string.
+ *
+ * Text is appended to a std::string provided by the caller, so a string
+ * which is cleared and reused for every message reaches a steady capacity
+ * and no further memory is allocated. Numbers are converted with a digit
+ * table instead of iostream manipulators, and field labels are constants.
+ *
+ * Two formats are provided:
+ * - the multi-line dump format of toString() of the message, header, and
+ *   data classes (the append*() methods taking field values; the classes
+ *   delegate to them, and the output is identical to the former
+ *   stringstream-based implementation), and
+ * - a compact single-line format for logging (appendCompactCommand()
+ *   and appendCompactTelemetry(), which read a message directly from
+ *   a byte array).
+ *
+ * Example usage:
+ * @code
+ * std::string line;
+ * for (...) {
+ *   line.clear();
+ *   SMCPFormatter::appendCompactTelemetry(line, data, length);
+ *   line += '\n';
+ *   fwrite(line.data(), 1, line.size(), logFile);
+ * }
+ * @endcode
+ */
+class SMCPFormatter {
+public:
+	/** Number of Attribute Value/Parameter bytes printed by the compact format by default. */
+	static const size_t DefaultCompactValueLength = 16;
+
+private:
+	/** Longest line of the dump format is well below this. */
+	static const size_t LineBufferSize = 128;
+
+	/* ---------------- primitives ---------------- */
+
+public:
+	/** Writes a value in lowercase hexadecimal, zero-padded to at least nDigits digits.
+	 * @return pointer to the character following the written digits.
+	 */
+	static char* writeHex(char* p, uint64_t value, int nDigits) {
+		static const char digits[] = "0123456789abcdef";
+		int n = 1;
+		while (n < 16 && (value >> (4 * n)) != 0) {
+			n++;
+		}
+		n = (n < nDigits) ? nDigits : n;
+		for (int i = n - 1; 0 <= i; i--) {
+			p[i] = digits[value & 0x0F];
+			value >>= 4;
+		}
+		return p + n;
+	}
+
+public:
+	/** Writes a value in decimal, zero-padded to at least nDigits digits.
+	 * @return pointer to the character following the written digits.
+	 */
+	static char* writeDecimal(char* p, uint64_t value, int nDigits = 1) {
+		char reversed[20];
+		int n = 0;
+		do {
+			reversed[n++] = (char) ('0' + value % 10);
+			value /= 10;
+		} while (value != 0);
+		while (n < nDigits) {
+			*p++ = '0';
+			nDigits--;
+		}
+		while (n != 0) {
+			*p++ = reversed[--n];
+		}
+		return p;
+	}
+
+public:
+	/** Writes the lowest nBits bits of a value as '0'/'1' characters, most significant first. */
+	static char* writeBits(char* p, uint32_t value, int nBits) {
+		for (int i = nBits - 1; 0 <= i; i--) {
+			*p++ = ((value >> i) & 1) ? '1' : '0';
+		}
+		return p;
+	}
+
+public:
+	/** Writes a string literal (its length is known at compile time). */
+	template<size_t N>
+	static char* writeLiteral(char* p, const char (&text)[N]) {
+		memcpy(p, text, N - 1);
+		return p + N - 1;
+	}
+
+public:
+	/** Writes a null-terminated string. */
+	static char* writeString(char* p, const char* text) {
+		size_t length = strlen(text);
+		memcpy(p, text, length);
+		return p + length;
+	}
+
+public:
+	/** Appends a string literal. */
+	template<size_t N>
+	static void appendLiteral(std::string& out, const char (&text)[N]) {
+		out.append(text, N - 1);
+	}
+
+	/* ---------------- dump format ---------------- */
+
+public:
+	/** Appends the dump of SMCPCommandMessageHeader. */
+	static void appendCommandMessageHeader(std::string& out, uint8_t acknowledgeRequest, uint8_t smcpVersion,
+			uint8_t commandTypeID, uint8_t lowerFOID) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Header ===\n");
+
+		p = writeLiteral(line, "AcknowledgeRequest = ");
+		p = writeBits(p, acknowledgeRequest, 2);
+		if (acknowledgeRequest == SMCPAcknowledgeRequest::NoAcknowledgeTelemetry) {
+			p = writeLiteral(p, "b (NoAcknowledgeTelemetry)\n");
+		} else if (acknowledgeRequest == SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry) {
+			p = writeLiteral(p, "b (AcknowledgeTelemetry is requested)\n");
+		} else {
+			p = writeLiteral(p, "b (Undefined value)\n");
+		}
+		out.append(line, p - line);
+
+		appendVersion(out, smcpVersion);
+
+		p = writeLiteral(line, "CommandTypeID      = ");
+		p = writeBits(p, commandTypeID, 4);
+		p = writeLiteral(p, "b (");
+		p = writeString(p, getCommandTypeName(commandTypeID));
+		p = writeLiteral(p, ")\n");
+		out.append(line, p - line);
+
+		appendLowerFOID(out, lowerFOID);
+	}
+
+public:
+	/** Appends the dump of SMCPTelemetryMessageHeader.
+	 * @param[in] messageLength value printed as MessageLength.
+	 */
+	static void appendTelemetryMessageHeader(std::string& out, uint8_t reserved, uint8_t smcpVersion,
+			uint8_t telemetryTypeID, uint32_t messageLength, uint8_t lowerFOID) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Header ===\n");
+
+		p = writeLiteral(line, "Reserved           = ");
+		p = writeBits(p, reserved, 2);
+		if (reserved != 0) {
+			p = writeLiteral(p, "b (Undefined value)\n");
+		} else {
+			p = writeLiteral(p, "b (Reserved)\n");
+		}
+		out.append(line, p - line);
+
+		appendVersion(out, smcpVersion);
+
+		p = writeLiteral(line, "TelemetryTypeID    = ");
+		p = writeBits(p, telemetryTypeID, 4);
+		p = writeLiteral(p, "b (");
+		p = writeString(p, getTelemetryTypeName(telemetryTypeID));
+		p = writeLiteral(p, ")\n");
+		out.append(line, p - line);
+
+		p = writeLiteral(line, "MessageLength      = ");
+		p = writeDecimal(p, messageLength);
+		p = writeLiteral(p, " bytes (decial)\n");
+		out.append(line, p - line);
+
+		appendLowerFOID(out, lowerFOID);
+	}
+
+public:
+	/** Appends the dump of SMCPCommandMessageData of an Action Command. */
+	static void appendActionCommandData(std::string& out, uint16_t operationID, const uint8_t* parameters,
+			size_t length, size_t maximumDumpLength) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Data ===\n");
+		p = writeLiteral(line, "OperationID        = 0x");
+		p = writeHex(p, operationID, 4);
+		*p++ = '\n';
+		out.append(line, p - line);
+		p = writeLiteral(line, "Parameter Length   = ");
+		p = writeDecimal(p, length);
+		p = writeLiteral(p, " bytes (decimal)\n");
+		out.append(line, p - line);
+		for (size_t i = 0; i < maximumDumpLength && i < length; i++) {
+			p = writeLiteral(line, "Parameter[");
+			p = writeDecimal(p, i, 4);
+			p = writeLiteral(p, "]    = 0x");
+			p = writeHex(p, parameters[i], 2);
+			*p++ = '\n';
+			out.append(line, p - line);
+		}
+		if (maximumDumpLength < length) {
+			p = writeLiteral(line, "Parameter continues... (total size = ");
+			p = writeDecimal(p, length);
+			p = writeLiteral(p, " bytes)\n");
+			out.append(line, p - line);
+		}
+	}
+
+public:
+	/** Appends the dump of SMCPCommandMessageData of a Get Command. */
+	static void appendGetCommandData(std::string& out, uint16_t attributeID) {
+		appendLiteral(out, "=== Command Message Data ===\n");
+		appendAttributeID(out, attributeID);
+	}
+
+public:
+	/** Appends the dump of SMCPCommandMessageData of a Memory Dump Command.
+	 * @param[in] nOfDumps raw 2-bit N of Dumps field.
+	 */
+	static void appendMemoryDumpCommandData(std::string& out, uint16_t attributeID, uint8_t nOfDumps,
+			uint32_t startAddress, uint32_t dumpLength) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Data ===\n");
+		appendAttributeID(out, attributeID);
+		p = writeLiteral(line, "Number of dumps    = ");
+		p = writeDecimal(p, nOfDumps + 1);
+		*p++ = '(';
+		p = writeBits(p, nOfDumps, 2);
+		p = writeLiteral(p, ")\n");
+		out.append(line, p - line);
+		appendStartAddress(out, startAddress);
+		p = writeLiteral(line, "Dump Length        = 0x");
+		p = writeHex(p, dumpLength, 6);
+		*p++ = '\n';
+		out.append(line, p - line);
+	}
+
+public:
+	/** Appends the dump of SMCPCommandMessageData of a Memory Load Command. */
+	static void appendMemoryLoadCommandData(std::string& out, uint32_t startAddress, const uint8_t* loadData,
+			size_t length, size_t maximumDumpLength) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Data ===\n");
+		appendStartAddress(out, startAddress);
+		p = writeLiteral(line, "Load Data Length   = ");
+		p = writeDecimal(p, length);
+		p = writeLiteral(p, " bytes (decimal)\n");
+		out.append(line, p - line);
+		for (size_t i = 0; i < maximumDumpLength && i < length; i++) {
+			p = writeLiteral(line, "Load Data[");
+			p = writeDecimal(p, i, 4);
+			p = writeLiteral(p, "]    = 0x");
+			p = writeHex(p, loadData[i], 2);
+			*p++ = '\n';
+			out.append(line, p - line);
+		}
+		if (maximumDumpLength < length) {
+			p = writeLiteral(line, "Load Data continues... (total size = ");
+			p = writeDecimal(p, length);
+			p = writeLiteral(p, " bytes)\n");
+			out.append(line, p - line);
+		}
+	}
+
+public:
+	/** Appends the dump of SMCPTelemetryMessageData. */
+	static void appendTelemetryMessageData(std::string& out, uint16_t attributeID, const uint8_t* attributeValues,
+			size_t length, size_t maximumDumpLength) {
+		char line[LineBufferSize];
+		char* p;
+		appendLiteral(out, "=== Command Message Data ===\n");
+		p = writeLiteral(line, "AttributeID        = ");
+		p = writeHex(p, attributeID, 4);
+		*p++ = '\n';
+		out.append(line, p - line);
+		p = writeLiteral(line, "Attr.Val. Length   = ");
+		p = writeDecimal(p, length);
+		p = writeLiteral(p, " bytes (decimal)\n");
+		out.append(line, p - line);
+		for (size_t i = 0; i < maximumDumpLength && i < length; i++) {
+			p = writeLiteral(line, "Attr.Val.[");
+			p = writeDecimal(p, i, 8);
+			p = writeLiteral(p, "]= 0x");
+			p = writeHex(p, attributeValues[i], 2);
+			*p++ = '\n';
+			out.append(line, p - line);
+		}
+		if (maximumDumpLength < length) {
+			p = writeLiteral(line, "The AttributeValues field continue... (total size = ");
+			p = writeDecimal(p, length);
+			p = writeLiteral(p, " bytes)\n");
+			out.append(line, p - line);
+		}
+	}
+
+public:
+	/** Appends the banner which precedes the header dump in SMCPCommandMessage::toString()
+	 * or SMCPTelemetryMessage::toString().
+	 * @param[in] className "SMCPCommandMessage" or "SMCPTelemetryMessage".
+	 */
+	static void appendMessageBanner(std::string& out, const char* className) {
+		appendLiteral(out, "---------------------------------\n");
+		out += className;
+		appendLiteral(out, "\n---------------------------------\n");
+	}
+
+	/* ---------------- compact format ---------------- */
+
+public:
+	/** Appends a single-line summary of a command message stored in a byte array (no newline).
+	 * e.g. "CMD ActionCommand ack=1 foid=0x12 op=0x0001 params(3)=0a0b0c"
+	 * @param[in] data byte array which contains a command message.
+	 * @param[in] length length of the command message.
+	 * @param[in] maximumValueLength number of Parameter/Load Data bytes printed
+	 * (longer fields end with "...").
+	 */
+	static void appendCompactCommand(std::string& out, const uint8_t* data, size_t length,
+			size_t maximumValueLength = DefaultCompactValueLength) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "CMD ");
+		if (length < 2) {
+			p = writeLiteral(p, "malformed length=");
+			p = writeDecimal(p, length);
+			out.append(line, p - line);
+			return;
+		}
+		uint8_t commandTypeID = data[0] & 0x0F;
+		p = writeString(p, getCommandTypeName(commandTypeID));
+		p = writeLiteral(p, " ack=");
+		p = writeDecimal(p, data[0] >> 6);
+		p = writeLiteral(p, " foid=0x");
+		p = writeHex(p, data[1], 2);
+		const uint8_t* messageData = data + 2;
+		size_t dataLength = length - 2;
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand:
+			if (2 <= dataLength) {
+				p = writeLiteral(p, " op=0x");
+				p = writeHex(p, (messageData[0] << 8) | messageData[1], 4);
+				out.append(line, p - line);
+				appendCompactBytes(out, " params(", messageData + 2, dataLength - 2, maximumValueLength);
+				return;
+			}
+			break;
+		case SMCPCommandTypeID::GetCommand:
+			if (2 <= dataLength) {
+				p = writeLiteral(p, " aid=0x");
+				p = writeHex(p, (messageData[0] << 8) | messageData[1], 4);
+				out.append(line, p - line);
+				return;
+			}
+			break;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			if (4 <= dataLength) {
+				p = writeLiteral(p, " start=0x");
+				p = writeHex(p, readUInt32(messageData), 8);
+				out.append(line, p - line);
+				appendCompactBytes(out, " data(", messageData + 4, dataLength - 4, maximumValueLength);
+				return;
+			}
+			break;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			if (8 <= dataLength) {
+				p = writeLiteral(p, " dumps=");
+				p = writeDecimal(p, (messageData[0] & 0x03) + 1);
+				p = writeLiteral(p, " start=0x");
+				p = writeHex(p, readUInt32(messageData + 1), 8);
+				p = writeLiteral(p, " length=0x");
+				p = writeHex(p, ((uint32_t) messageData[5] << 16) | (messageData[6] << 8) | messageData[7], 6);
+				out.append(line, p - line);
+				return;
+			}
+			break;
+		default:
+			out.append(line, p - line);
+			appendCompactBytes(out, " data(", messageData, dataLength, maximumValueLength);
+			return;
+		}
+		p = writeLiteral(p, " truncated length=");
+		p = writeDecimal(p, length);
+		out.append(line, p - line);
+	}
+
+public:
+	/** Appends a single-line summary of a telemetry message stored in a byte array (no newline).
+	 * e.g. "TLM ValueTelemetry foid=0x12 aid=0x0001 length=10 value(3)=0a0b0c"
+	 * @param[in] data byte array which contains a telemetry message.
+	 * @param[in] length length of the byte array; the Message Length field is
+	 * used when it is shorter.
+	 * @param[in] maximumValueLength number of Attribute Value bytes printed
+	 * (longer values end with "...").
+	 */
+	static void appendCompactTelemetry(std::string& out, const uint8_t* data, size_t length,
+			size_t maximumValueLength = DefaultCompactValueLength) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "TLM ");
+		if (length < 7) {
+			p = writeLiteral(p, "malformed length=");
+			p = writeDecimal(p, length);
+			out.append(line, p - line);
+			return;
+		}
+		size_t messageLength = ((size_t) data[1] << 16) | ((size_t) data[2] << 8) | data[3];
+		p = writeString(p, getTelemetryTypeName(data[0] & 0x0F));
+		p = writeLiteral(p, " foid=0x");
+		p = writeHex(p, data[4], 2);
+		p = writeLiteral(p, " aid=0x");
+		p = writeHex(p, (data[5] << 8) | data[6], 4);
+		p = writeLiteral(p, " length=");
+		p = writeDecimal(p, messageLength);
+		out.append(line, p - line);
+		size_t end = (7 <= messageLength && messageLength < length) ? messageLength : length;
+		appendCompactBytes(out, " value(", data + 7, end - 7, maximumValueLength);
+	}
+
+	/* ---------------- names ---------------- */
+
+public:
+	static const char* getCommandTypeName(uint8_t commandTypeID) {
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand:
+			return "ActionCommand";
+		case SMCPCommandTypeID::GetCommand:
+			return "GetCommand";
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return "MemoryLoadCommand";
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return "MemoryDumpCommand";
+		default:
+			return "Undefined value";
+		}
+	}
+
+public:
+	static const char* getTelemetryTypeName(uint8_t telemetryTypeID) {
+		switch (telemetryTypeID) {
+		case SMCPTelemetryTypeID::ValueTelemetry:
+			return "ValueTelemetry";
+		case SMCPTelemetryTypeID::NotificationTelemetry:
+			return "NotificationTelemetry";
+		case SMCPTelemetryTypeID::AcknowledgeTelemetry:
+			return "AcknowledgeTelemetry";
+		case SMCPTelemetryTypeID::MemoryDumpTelemetry:
+			return "MemoryDumpTelemetry";
+		default:
+			return "Undefined value";
+		}
+	}
+
+	/* ---------------- helpers ---------------- */
+
+private:
+	static void appendVersion(std::string& out, uint8_t smcpVersion) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "SMCP Version       = ");
+		p = writeBits(p, smcpVersion, 2);
+		p = writeLiteral(p, "b\n");
+		out.append(line, p - line);
+	}
+
+private:
+	static void appendLowerFOID(std::string& out, uint8_t lowerFOID) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "lowerFOID          = 0x");
+		p = writeHex(p, lowerFOID, 2);
+		*p++ = '\n';
+		out.append(line, p - line);
+	}
+
+private:
+	static void appendAttributeID(std::string& out, uint16_t attributeID) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "AttributeID        = 0x");
+		p = writeHex(p, attributeID, 4);
+		*p++ = '\n';
+		out.append(line, p - line);
+	}
+
+private:
+	static void appendStartAddress(std::string& out, uint32_t startAddress) {
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, "Start Address      = 0x");
+		p = writeHex(p, startAddress, 8);
+		*p++ = '\n';
+		out.append(line, p - line);
+	}
+
+private:
+	/** Appends "<label><length>)=<hex bytes>", truncated to maximumLength bytes. */
+	template<size_t N>
+	static void appendCompactBytes(std::string& out, const char (&label)[N], const uint8_t* bytes, size_t length,
+			size_t maximumLength) {
+		static const char digits[] = "0123456789abcdef";
+		char line[LineBufferSize];
+		char* p = writeLiteral(line, label);
+		p = writeDecimal(p, length);
+		p = writeLiteral(p, ")=");
+		out.append(line, p - line);
+		size_t n = (length < maximumLength) ? length : maximumLength;
+		size_t offset = out.size();
+		out.resize(offset + 2 * n);
+		for (size_t i = 0; i < n; i++) {
+			out[offset + 2 * i] = digits[bytes[i] >> 4];
+			out[offset + 2 * i + 1] = digits[bytes[i] & 0x0F];
+		}
+		if (n < length) {
+			appendLiteral(out, "...");
+		}
+	}
+
+private:
+	static uint32_t readUInt32(const uint8_t* p) {
+		return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+	}
+};
+
+#endif /* SMCPFORMATTER_HH_ */
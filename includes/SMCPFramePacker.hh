@@ -0,0 +1,374 @@
+/*
+ * SMCPFramePacker.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPFRAMEPACKER_HH_
+#define SMCPFRAMEPACKER_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPMessage.hh"
+#include "SMCPCommandMessageView.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** An interface which receives frames completed by SMCPFramePacker.
+ */
+class SMCPFrameListener {
+public:
+	virtual ~SMCPFrameListener() {
+	}
+
+public:
+	/** Invoked when a frame is flushed.
+	 * @param[in] frame frame content (valid only during the call).
+	 * @param[in] length length of the frame (at most the frame size of the packer).
+	 * @param[in] nMessages number of SMCP messages in the frame.
+	 */
+	virtual void frameCompleted(const uint8_t* frame, size_t length, size_t nMessages) = 0;
+};
+
+/** A class which packs serialized SMCP messages into frames of a configurable maximum size
+ * (e.g. the payload size of a UDP datagram on the link).
+ *
+ * A frame carries messages of one kind only, back to back. Telemetry
+ * messages are delimited by their Message Length field. Command messages,
+ * which have no length field, are each preceded by a 2-octet big-endian
+ * length. SMCPFrameUnpacker reads such frames.
+ *
+ * A frame is flushed to the listener when the next message does not fit,
+ * when flush() is called, or when poll() is called after the maximum delay
+ * has elapsed since the first message of the frame was added. Time is given
+ * in nanoseconds; the overloads without a time argument use getCurrentTime().
+ *
+ * Example usage:
+ * @code
+ * SMCPFramePacker packer(1472, SMCPMessageType::CommandMessage, 2 * 1000000ULL, &sender); //2-ms deadline
+ * packer.add(getCommand);
+ * ...
+ * //in the event loop
+ * packer.poll();
+ * @endcode
+ */
+class SMCPFramePacker {
+public:
+	/** Length of the length prefix of command messages. */
+	static const size_t CommandLengthPrefixLength = 2;
+
+private:
+	std::vector<uint8_t> frame;
+	size_t frameLength;
+	size_t nMessagesInFrame;
+	uint8_t messageType;
+	uint64_t maximumDelay;
+	uint64_t firstMessageTime;
+	SMCPFrameListener* listener;
+
+private:
+	uint64_t nFrames;
+	uint64_t nMessages;
+	uint64_t nDeadlineFlushes;
+
+public:
+	/** Constructor.
+	 * @param[in] frameSize maximum length of a frame.
+	 * @param[in] messageType SMCPMessageType::TelemetryMessage or SMCPMessageType::CommandMessage.
+	 * @param[in] maximumDelay maximum time (ns) a message waits in a partially filled frame.
+	 * @param[in] listener receiver of frames.
+	 */
+	SMCPFramePacker(size_t frameSize, uint8_t messageType, uint64_t maximumDelay, SMCPFrameListener* listener) :
+			frame(frameSize), frameLength(0), nMessagesInFrame(0), messageType(messageType),
+			maximumDelay(maximumDelay), firstMessageTime(0), listener(listener), nFrames(0), nMessages(0),
+			nDeadlineFlushes(0) {
+		if (messageType != SMCPMessageType::TelemetryMessage && messageType != SMCPMessageType::CommandMessage) {
+			throw SMCPException("SMCPFramePacker: undefined message type");
+		}
+		if (frameSize <= getPrefixLength()) {
+			throw SMCPException("SMCPFramePacker: frame size too small");
+		}
+	}
+
+public:
+	/** Adds a serialized message.
+	 * The message is validated with SMCPTelemetryMessageView or SMCPCommandMessageView;
+	 * for telemetry, the Message Length field must also equal length.
+	 * @param[in] message wire bytes of a message of the packer's kind.
+	 * @param[in] length length of the message.
+	 * @param[in] now current time in nanoseconds.
+	 */
+	void add(const uint8_t* message, size_t length, uint64_t now) {
+		validate(message, length);
+		uint8_t* destination = reserve(length, now);
+		memcpy(destination, message, length);
+		commit(length);
+	}
+
+public:
+	/** Adds a serialized message using the current time. */
+	void add(const uint8_t* message, size_t length) {
+		add(message, length, getCurrentTime());
+	}
+
+public:
+	/** Serializes a message directly into the frame.
+	 * The serialized bytes are validated as in add(const uint8_t*, size_t, uint64_t)
+	 * before they become part of the frame.
+	 * @param[in] message message of the packer's kind.
+	 * @param[in] now current time in nanoseconds.
+	 */
+	void add(SMCPMessage& message, uint64_t now) {
+		if (message.data == NULL || message.data->getSMCPMessageType() != messageType) {
+			throw SMCPException("SMCPFramePacker: message kind differs from the packer's message type");
+		}
+		size_t length = message.getLength();
+		uint8_t* destination = reserve(length, now);
+		message.getAsByteArray(destination, length);
+		//not committed on failure, so the bytes are overwritten by the next message
+		validate(destination, length);
+		commit(length);
+	}
+
+public:
+	/** Serializes a message directly into the frame using the current time. */
+	void add(SMCPMessage& message) {
+		add(message, getCurrentTime());
+	}
+
+public:
+	/** Flushes the frame if the maximum delay has elapsed since its first message was added.
+	 * @param[in] now current time in nanoseconds.
+	 * @return true if a frame was flushed.
+	 */
+	bool poll(uint64_t now) {
+		if (nMessagesInFrame == 0 || now - firstMessageTime < maximumDelay) {
+			return false;
+		}
+		nDeadlineFlushes++;
+		flush();
+		return true;
+	}
+
+public:
+	/** Flushes the frame if the maximum delay has elapsed, using the current time. */
+	bool poll() {
+		return poll(getCurrentTime());
+	}
+
+public:
+	/** Passes the current frame, if not empty, to the listener. */
+	void flush() {
+		if (nMessagesInFrame == 0) {
+			return;
+		}
+		size_t length = frameLength;
+		size_t n = nMessagesInFrame;
+		frameLength = 0;
+		nMessagesInFrame = 0;
+		nFrames++;
+		if (listener != NULL) {
+			listener->frameCompleted(&(frame[0]), length, n);
+		}
+	}
+
+public:
+	/** Returns the time by which poll() should be called, or UINT64_MAX if the frame is empty. */
+	uint64_t getDeadline() const {
+		return (nMessagesInFrame == 0) ? UINT64_MAX : firstMessageTime + maximumDelay;
+	}
+
+public:
+	size_t getFrameSize() const {
+		return frame.size();
+	}
+
+public:
+	/** Returns the number of frames flushed so far. */
+	uint64_t getNFrames() const {
+		return nFrames;
+	}
+
+public:
+	/** Returns the number of messages added so far. */
+	uint64_t getNMessages() const {
+		return nMessages;
+	}
+
+public:
+	/** Returns the number of frames flushed by poll() because of the deadline. */
+	uint64_t getNDeadlineFlushes() const {
+		return nDeadlineFlushes;
+	}
+
+public:
+	/** Returns current time in nanoseconds (monotonic clock). */
+	static uint64_t getCurrentTime() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	size_t getPrefixLength() const {
+		return (messageType == SMCPMessageType::CommandMessage) ? (size_t) CommandLengthPrefixLength : 0;
+	}
+
+private:
+	/** Makes room for a message, flushing the frame if necessary, and writes the length prefix.
+	 * @return position where the message should be written.
+	 */
+	uint8_t* reserve(size_t length, uint64_t now) {
+		size_t prefixLength = getPrefixLength();
+		if (frame.size() < prefixLength + length || (prefixLength != 0 && 0xFFFF < length)) {
+			throw SMCPException("SMCPFramePacker: message does not fit in a frame");
+		}
+		if (frame.size() - frameLength < prefixLength + length) {
+			flush();
+		}
+		if (nMessagesInFrame == 0) {
+			firstMessageTime = now;
+		}
+		uint8_t* p = &(frame[frameLength]);
+		if (prefixLength != 0) {
+			p[0] = (uint8_t) (length >> 8);
+			p[1] = (uint8_t) length;
+		}
+		return p + prefixLength;
+	}
+
+private:
+	/** Throws SMCPException if the bytes are not a well-formed message of the packer's kind. */
+	void validate(const uint8_t* message, size_t length) const {
+		if (messageType == SMCPMessageType::TelemetryMessage) {
+			SMCPTelemetryMessageView view;
+			if (!view.tryInterpretAsTelemetryMessage(message, length)) {
+				throw SMCPException("SMCPFramePacker: malformed telemetry message");
+			}
+			if (view.getMessageLength() != length) {
+				throw SMCPException("SMCPFramePacker: Message Length differs from the number of bytes");
+			}
+		} else {
+			SMCPCommandMessageView view;
+			if (!view.tryInterpretAsCommandMessage(message, length)) {
+				throw SMCPException("SMCPFramePacker: malformed command message");
+			}
+		}
+	}
+
+private:
+	void commit(size_t length) {
+		frameLength += getPrefixLength() + length;
+		nMessagesInFrame++;
+		nMessages++;
+		if (frameLength == frame.size()) {
+			flush();
+		}
+	}
+};
+
+/** A class which reads messages from frames written by SMCPFramePacker.
+ * Views are placed directly on the frame, which must outlive them.
+ *
+ * Example usage:
+ * @code
+ * SMCPFrameUnpacker unpacker(SMCPMessageType::TelemetryMessage);
+ * SMCPTelemetryMessageView message;
+ * unpacker.setFrame(datagram, datagramLength);
+ * while (unpacker.next(message)) {
+ * 	...
+ * }
+ * if (unpacker.hasError()) {
+ * 	...the rest of the frame was malformed...
+ * }
+ * @endcode
+ */
+class SMCPFrameUnpacker {
+private:
+	const uint8_t* frame;
+	size_t length;
+	size_t offset;
+	uint8_t messageType;
+	bool error;
+
+public:
+	/** Constructor.
+	 * @param[in] messageType SMCPMessageType::TelemetryMessage or SMCPMessageType::CommandMessage.
+	 */
+	SMCPFrameUnpacker(uint8_t messageType) :
+			frame(NULL), length(0), offset(0), messageType(messageType), error(false) {
+		if (messageType != SMCPMessageType::TelemetryMessage && messageType != SMCPMessageType::CommandMessage) {
+			throw SMCPException("SMCPFrameUnpacker: undefined message type");
+		}
+	}
+
+public:
+	/** Starts reading a frame.
+	 * @param[in] frame frame content.
+	 * @param[in] length length of the frame.
+	 */
+	void setFrame(const uint8_t* frame, size_t length) {
+		this->frame = frame;
+		this->length = length;
+		this->offset = 0;
+		this->error = false;
+	}
+
+public:
+	/** Places a view on the next telemetry message of the frame.
+	 * @param[out] message view to be placed.
+	 * @return false at the end of the frame or on a malformed message (see hasError()).
+	 */
+	bool next(SMCPTelemetryMessageView& message) {
+		if (messageType != SMCPMessageType::TelemetryMessage) {
+			throw SMCPException("SMCPFrameUnpacker: not a telemetry frame");
+		}
+		if (offset == length) {
+			return false;
+		}
+		if (!message.tryInterpretAsTelemetryMessage(frame + offset, length - offset)) {
+			error = true;
+			offset = length;
+			return false;
+		}
+		offset += message.getLength();
+		return true;
+	}
+
+public:
+	/** Places a view on the next command message of the frame.
+	 * @param[out] message view to be placed.
+	 * @return false at the end of the frame or on a malformed message (see hasError()).
+	 */
+	bool next(SMCPCommandMessageView& message) {
+		if (messageType != SMCPMessageType::CommandMessage) {
+			throw SMCPException("SMCPFrameUnpacker: not a command frame");
+		}
+		if (offset == length) {
+			return false;
+		}
+		const size_t prefixLength = SMCPFramePacker::CommandLengthPrefixLength;
+		size_t messageLength = 0;
+		if (prefixLength <= length - offset) {
+			messageLength = ((size_t) frame[offset] << 8) | frame[offset + 1];
+		}
+		if (length - offset < prefixLength + messageLength
+				|| !message.tryInterpretAsCommandMessage(frame + offset + prefixLength, messageLength)) {
+			error = true;
+			offset = length;
+			return false;
+		}
+		offset += prefixLength + messageLength;
+		return true;
+	}
+
+public:
+	/** Returns true if the last frame contained a malformed message. */
+	bool hasError() const {
+		return error;
+	}
+};
+
+#endif /* SMCPFRAMEPACKER_HH_ */
@@ -0,0 +1,523 @@
+/*
+ * SMCPInstrumentation.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPINSTRUMENTATION_HH_
+#define SMCPINSTRUMENTATION_HH_
+
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <sstream>
+#include "SMCPTypeClasses.hh"
+
+/** @def SMCP_ENABLE_INSTRUMENTATION
+ * Define to 1 (e.g. -DSMCP_ENABLE_INSTRUMENTATION=1) to record latency
+ * histograms and counters in the encode/decode paths of the library.
+ * When 0 (default), the instrumentation macros expand to nothing.
+ */
+#ifndef SMCP_ENABLE_INSTRUMENTATION
+#define SMCP_ENABLE_INSTRUMENTATION 0
+#endif
+
+/** A class which collects message-type indices used by SMCPInstrumentation. */
+class SMCPInstrumentedType {
+public:
+	enum {
+		ActionCommand, GetCommand, MemoryLoadCommand, MemoryDumpCommand, //
+		ValueTelemetry, NotificationTelemetry, AcknowledgeTelemetry, MemoryDumpTelemetry, //
+		Undefined, NTypes
+	};
+
+public:
+	/** Converts a Command Type ID to an index. */
+	static int fromCommandTypeID(uint8_t commandTypeID) {
+		switch (commandTypeID) {
+		case SMCPCommandTypeID::ActionCommand:
+			return ActionCommand;
+		case SMCPCommandTypeID::GetCommand:
+			return GetCommand;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			return MemoryLoadCommand;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			return MemoryDumpCommand;
+		default:
+			return Undefined;
+		}
+	}
+
+public:
+	/** Converts a Telemetry Type ID to an index. */
+	static int fromTelemetryTypeID(uint8_t telemetryTypeID) {
+		switch (telemetryTypeID) {
+		case SMCPTelemetryTypeID::ValueTelemetry:
+			return ValueTelemetry;
+		case SMCPTelemetryTypeID::NotificationTelemetry:
+			return NotificationTelemetry;
+		case SMCPTelemetryTypeID::AcknowledgeTelemetry:
+			return AcknowledgeTelemetry;
+		case SMCPTelemetryTypeID::MemoryDumpTelemetry:
+			return MemoryDumpTelemetry;
+		default:
+			return Undefined;
+		}
+	}
+
+public:
+	static const char* getName(int type) {
+		static const char* names[] = { "ActionCommand", "GetCommand", "MemoryLoadCommand", "MemoryDumpCommand",
+				"ValueTelemetry", "NotificationTelemetry", "AcknowledgeTelemetry", "MemoryDumpTelemetry", "Undefined" };
+		return (0 <= type && type < NTypes) ? names[type] : "Undefined";
+	}
+};
+
+/** A class which collects instrumented operations. */
+class SMCPInstrumentedOperation {
+public:
+	enum {
+		Decode, Encode, NOperations
+	};
+
+public:
+	static const char* getName(int operation) {
+		return (operation == Decode) ? "decode" : "encode";
+	}
+};
+
+/** A latency histogram with HDR-style log-linear buckets.
+ * Values below 16 have their own buckets; above that, each power of two is
+ * divided into 16 sub-buckets, so any recorded value is reported within
+ * 1/16 (6.25%) of its true value. Values are in nanoseconds.
+ */
+class SMCPLatencyHistogram {
+public:
+	static const int SubBucketBits = 4;
+	static const int SubBucketCount = 1 << SubBucketBits;
+	/** Values at or above 2^MaximumExponent (about 18 minutes in ns) go to the last bucket. */
+	static const int MaximumExponent = 40;
+	static const size_t NBuckets = SubBucketCount + (MaximumExponent - SubBucketBits) * SubBucketCount;
+
+public:
+	std::vector<uint64_t> counts;
+	uint64_t count;
+	uint64_t sum;
+	uint64_t minimum;
+	uint64_t maximum;
+
+public:
+	/** Constructor. */
+	SMCPLatencyHistogram() :
+			counts(NBuckets) {
+		reset();
+	}
+
+public:
+	void reset() {
+		for (size_t i = 0; i < NBuckets; i++) {
+			counts[i] = 0;
+		}
+		count = 0;
+		sum = 0;
+		minimum = UINT64_MAX;
+		maximum = 0;
+	}
+
+public:
+	/** Returns the bucket index of a value. */
+	static size_t getBucketIndex(uint64_t value) {
+		if (value < (uint64_t) SubBucketCount) {
+			return (size_t) value;
+		}
+		int exponent = 63;
+		while (((value >> exponent) & 1) == 0) {
+			exponent--;
+		}
+		if (MaximumExponent <= exponent) {
+			return NBuckets - 1;
+		}
+		size_t subBucket = (size_t) ((value >> (exponent - SubBucketBits)) & (SubBucketCount - 1));
+		return SubBucketCount + (exponent - SubBucketBits) * SubBucketCount + subBucket;
+	}
+
+public:
+	/** Returns the smallest value which falls into a bucket. */
+	static uint64_t getBucketLowerBound(size_t index) {
+		if (index < (size_t) SubBucketCount) {
+			return index;
+		}
+		size_t exponent = (index - SubBucketCount) / SubBucketCount + SubBucketBits;
+		size_t subBucket = (index - SubBucketCount) % SubBucketCount;
+		return ((uint64_t) 1 << exponent) + ((uint64_t) subBucket << (exponent - SubBucketBits));
+	}
+
+public:
+	void record(uint64_t value) {
+		counts[getBucketIndex(value)]++;
+		count++;
+		sum += value;
+		minimum = (value < minimum) ? value : minimum;
+		maximum = (maximum < value) ? value : maximum;
+	}
+
+public:
+	void merge(const SMCPLatencyHistogram& other) {
+		for (size_t i = 0; i < NBuckets; i++) {
+			counts[i] += other.counts[i];
+		}
+		count += other.count;
+		sum += other.sum;
+		minimum = (other.minimum < minimum) ? other.minimum : minimum;
+		maximum = (maximum < other.maximum) ? other.maximum : maximum;
+	}
+
+public:
+	/** Returns the value at a percentile (0-100), as the lower bound of the containing bucket.
+	 * The nearest-rank definition is used: the value of rank ceil(percentile / 100 * count).
+	 */
+	uint64_t getPercentile(double percentile) const {
+		if (count == 0) {
+			return 0;
+		}
+		double exactRank = ceil(percentile / 100.0 * count);
+		uint64_t rank = (exactRank < 1) ? 1 : ((double) count < exactRank ? count : (uint64_t) exactRank);
+		uint64_t accumulated = 0;
+		for (size_t i = 0; i < NBuckets; i++) {
+			accumulated += counts[i];
+			if (rank <= accumulated) {
+				uint64_t value = getBucketLowerBound(i);
+				return (value < minimum) ? minimum : (maximum < value ? maximum : value);
+			}
+		}
+		return maximum;
+	}
+
+public:
+	double getMean() const {
+		return (count == 0) ? 0.0 : (double) sum / count;
+	}
+};
+
+/** A snapshot of all instrumentation data, merged over all threads.
+ * @see SMCPInstrumentation::snapshot().
+ */
+class SMCPInstrumentationSnapshot {
+public:
+	SMCPLatencyHistogram latencies[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+	uint64_t validationFailures[SMCPInstrumentedType::NTypes];
+	uint64_t exceptions[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+
+public:
+	SMCPInstrumentationSnapshot() {
+		reset();
+	}
+
+public:
+	void reset() {
+		for (int t = 0; t < SMCPInstrumentedType::NTypes; t++) {
+			validationFailures[t] = 0;
+			for (int o = 0; o < SMCPInstrumentedOperation::NOperations; o++) {
+				latencies[t][o].reset();
+				exceptions[t][o] = 0;
+			}
+		}
+	}
+
+public:
+	/** Returns a table of count, mean, percentiles, failures and exceptions per type and operation. */
+	std::string toString() const {
+		std::stringstream ss;
+		ss << "type operation count mean_ns p50_ns p99_ns p999_ns max_ns exceptions validation_failures" << std::endl;
+		for (int t = 0; t < SMCPInstrumentedType::NTypes; t++) {
+			for (int o = 0; o < SMCPInstrumentedOperation::NOperations; o++) {
+				const SMCPLatencyHistogram& h = latencies[t][o];
+				if (h.count == 0 && exceptions[t][o] == 0 && (o != 0 || validationFailures[t] == 0)) {
+					continue;
+				}
+				ss << SMCPInstrumentedType::getName(t) << " " << SMCPInstrumentedOperation::getName(o) << " "
+						<< h.count << " " << (uint64_t) h.getMean() << " " << h.getPercentile(50) << " "
+						<< h.getPercentile(99) << " " << h.getPercentile(99.9) << " " << h.maximum << " "
+						<< exceptions[t][o] << " " << (o == 0 ? validationFailures[t] : 0) << std::endl;
+			}
+		}
+		return ss.str();
+	}
+};
+
+/** Instrumentation of the encode/decode paths.
+ *
+ * Each thread records into its own counters, which only that thread writes
+ * (relaxed atomic stores, no read-modify-write), so recording does not
+ * contend between threads. snapshot() merges the counters of all live threads
+ * and of threads which have already exited.
+ *
+ * The library records through the SMCP_INSTRUMENT_* macros, which expand to
+ * nothing unless SMCP_ENABLE_INSTRUMENTATION is 1. Applications may call the
+ * record functions directly, e.g. to time their own handlers.
+ *
+ * Example usage:
+ * @code
+ * //compile with -DSMCP_ENABLE_INSTRUMENTATION=1
+ * SMCPInstrumentationSnapshot snapshot;
+ * SMCPInstrumentation::snapshot(snapshot);
+ * std::cout << snapshot.toString();
+ * @endcode
+ */
+class SMCPInstrumentation {
+private:
+	class ThreadCounters {
+	public:
+		std::atomic<uint64_t> counts[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations][SMCPLatencyHistogram::NBuckets];
+		std::atomic<uint64_t> sum[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+		std::atomic<uint64_t> minimum[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+		std::atomic<uint64_t> maximum[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+		std::atomic<uint64_t> exceptions[SMCPInstrumentedType::NTypes][SMCPInstrumentedOperation::NOperations];
+		std::atomic<uint64_t> validationFailures[SMCPInstrumentedType::NTypes];
+
+	public:
+		ThreadCounters() {
+			reset();
+		}
+
+	public:
+		void reset() {
+			for (int t = 0; t < SMCPInstrumentedType::NTypes; t++) {
+				validationFailures[t].store(0, std::memory_order_relaxed);
+				for (int o = 0; o < SMCPInstrumentedOperation::NOperations; o++) {
+					for (size_t i = 0; i < SMCPLatencyHistogram::NBuckets; i++) {
+						counts[t][o][i].store(0, std::memory_order_relaxed);
+					}
+					sum[t][o].store(0, std::memory_order_relaxed);
+					minimum[t][o].store(UINT64_MAX, std::memory_order_relaxed);
+					maximum[t][o].store(0, std::memory_order_relaxed);
+					exceptions[t][o].store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+
+	public:
+		void addTo(SMCPInstrumentationSnapshot& snapshot) const {
+			for (int t = 0; t < SMCPInstrumentedType::NTypes; t++) {
+				snapshot.validationFailures[t] += validationFailures[t].load(std::memory_order_relaxed);
+				for (int o = 0; o < SMCPInstrumentedOperation::NOperations; o++) {
+					SMCPLatencyHistogram& h = snapshot.latencies[t][o];
+					for (size_t i = 0; i < SMCPLatencyHistogram::NBuckets; i++) {
+						uint64_t n = counts[t][o][i].load(std::memory_order_relaxed);
+						h.counts[i] += n;
+						h.count += n;
+					}
+					h.sum += sum[t][o].load(std::memory_order_relaxed);
+					uint64_t min = minimum[t][o].load(std::memory_order_relaxed);
+					uint64_t max = maximum[t][o].load(std::memory_order_relaxed);
+					h.minimum = (min < h.minimum) ? min : h.minimum;
+					h.maximum = (h.maximum < max) ? max : h.maximum;
+					snapshot.exceptions[t][o] += exceptions[t][o].load(std::memory_order_relaxed);
+				}
+			}
+		}
+	};
+
+private:
+	class Registry {
+	public:
+		std::mutex mutex;
+		std::vector<ThreadCounters*> threads;
+		SMCPInstrumentationSnapshot retired;
+	};
+
+private:
+	/** Unregisters the counters of a thread when it exits. */
+	class ThreadCountersHolder {
+	public:
+		ThreadCounters* counters;
+
+	public:
+		ThreadCountersHolder() :
+				counters(NULL) {
+		}
+
+	public:
+		~ThreadCountersHolder() {
+			if (counters == NULL) {
+				return;
+			}
+			Registry& registry = getRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			counters->addTo(registry.retired);
+			for (size_t i = 0; i < registry.threads.size(); i++) {
+				if (registry.threads[i] == counters) {
+					registry.threads.erase(registry.threads.begin() + i);
+					break;
+				}
+			}
+			delete counters;
+		}
+	};
+
+private:
+	static Registry& getRegistry() {
+		static Registry* registry = new Registry(); //never destroyed; threads may exit after main()
+		return *registry;
+	}
+
+private:
+	static ThreadCounters& getThreadCounters() {
+		static thread_local ThreadCountersHolder holder;
+		if (holder.counters == NULL) {
+			ThreadCounters* counters = new ThreadCounters();
+			Registry& registry = getRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.threads.push_back(counters);
+			holder.counters = counters;
+		}
+		return *holder.counters;
+	}
+
+private:
+	static void increment(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+public:
+	/** Returns true if the library was compiled with SMCP_ENABLE_INSTRUMENTATION=1. */
+	static bool isEnabled() {
+		return SMCP_ENABLE_INSTRUMENTATION != 0;
+	}
+
+public:
+	/** Returns a monotonic time stamp in nanoseconds. */
+	static uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+public:
+	/** Records the latency of an operation.
+	 * @param[in] type see SMCPInstrumentedType.
+	 * @param[in] operation see SMCPInstrumentedOperation.
+	 * @param[in] nanoseconds latency.
+	 */
+	static void recordLatency(int type, int operation, uint64_t nanoseconds) {
+		ThreadCounters& counters = getThreadCounters();
+		increment(counters.counts[type][operation][SMCPLatencyHistogram::getBucketIndex(nanoseconds)]);
+		increment(counters.sum[type][operation], nanoseconds);
+		if (nanoseconds < counters.minimum[type][operation].load(std::memory_order_relaxed)) {
+			counters.minimum[type][operation].store(nanoseconds, std::memory_order_relaxed);
+		}
+		if (counters.maximum[type][operation].load(std::memory_order_relaxed) < nanoseconds) {
+			counters.maximum[type][operation].store(nanoseconds, std::memory_order_relaxed);
+		}
+	}
+
+public:
+	/** Counts an exception thrown by an operation. */
+	static void countException(int type, int operation) {
+		increment(getThreadCounters().exceptions[type][operation]);
+	}
+
+public:
+	/** Counts a message which failed validation. */
+	static void countValidationFailure(int type) {
+		increment(getThreadCounters().validationFailures[type]);
+	}
+
+public:
+	/** Merges the counters of all threads.
+	 * @param[out] snapshot destination; its previous content is discarded.
+	 */
+	static void snapshot(SMCPInstrumentationSnapshot& snapshot) {
+		snapshot.reset();
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (int t = 0; t < SMCPInstrumentedType::NTypes; t++) {
+			snapshot.validationFailures[t] = registry.retired.validationFailures[t];
+			for (int o = 0; o < SMCPInstrumentedOperation::NOperations; o++) {
+				snapshot.latencies[t][o].merge(registry.retired.latencies[t][o]);
+				snapshot.exceptions[t][o] = registry.retired.exceptions[t][o];
+			}
+		}
+		for (size_t i = 0; i < registry.threads.size(); i++) {
+			registry.threads[i]->addTo(snapshot);
+		}
+	}
+
+public:
+	/** Clears the counters of all threads.
+	 * Counts recorded concurrently with reset() may be partially lost.
+	 */
+	static void reset() {
+		Registry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.retired.reset();
+		for (size_t i = 0; i < registry.threads.size(); i++) {
+			registry.threads[i]->reset();
+		}
+	}
+};
+
+/** Measures the latency of an operation from construction to destruction.
+ * If the scope is left by an exception, the exception is counted instead.
+ * Used through SMCP_INSTRUMENT_SCOPE.
+ */
+class SMCPInstrumentationScope {
+private:
+	int type;
+	int operation;
+	uint64_t start;
+#if __cplusplus >= 201703L
+	int uncaughtExceptions; //exceptions already in flight when the scope was entered
+#endif
+
+public:
+	SMCPInstrumentationScope(int type, int operation) :
+			type(type), operation(operation), start(SMCPInstrumentation::now())
+#if __cplusplus >= 201703L
+					, uncaughtExceptions(std::uncaught_exceptions())
+#endif
+	{
+	}
+
+public:
+	~SMCPInstrumentationScope() {
+		if (isUnwinding()) {
+			SMCPInstrumentation::countException(type, operation);
+		} else {
+			SMCPInstrumentation::recordLatency(type, operation, SMCPInstrumentation::now() - start);
+		}
+	}
+
+public:
+	void setType(int type) {
+		this->type = type;
+	}
+
+private:
+	/** Returns true if the scope is being left by an exception (a scope entered
+	 * from a destructor during unwinding is not, unless a new exception leaves it).
+	 */
+	bool isUnwinding() const {
+#if __cplusplus >= 201703L
+		return uncaughtExceptions < std::uncaught_exceptions();
+#else
+		return std::uncaught_exception();
+#endif
+	}
+};
+
+#if SMCP_ENABLE_INSTRUMENTATION
+#define SMCP_INSTRUMENT_SCOPE(type, operation) SMCPInstrumentationScope smcpInstrumentationScope((type), (operation))
+#define SMCP_INSTRUMENT_SET_TYPE(type) smcpInstrumentationScope.setType(type)
+#define SMCP_INSTRUMENT_VALIDATION_FAILURE(type) SMCPInstrumentation::countValidationFailure(type)
+#else
+#define SMCP_INSTRUMENT_SCOPE(type, operation) ((void) 0)
+#define SMCP_INSTRUMENT_SET_TYPE(type) ((void) 0)
+#define SMCP_INSTRUMENT_VALIDATION_FAILURE(type) ((void) 0)
+#endif
+
+#endif /* SMCPINSTRUMENTATION_HH_ */
@@ -0,0 +1,275 @@
+/*
+ * SMCPMemoryImageDiff.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPMEMORYIMAGEDIFF_HH_
+#define SMCPMEMORYIMAGEDIFF_HH_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPFormatter.hh"
+#include "SMCPUtility.hh"
+#include "SMCPException.hh"
+
+/** A range of addresses where a memory dump differs from the reference image. */
+class SMCPMemoryDifference {
+public:
+	uint64_t address;
+	uint64_t length;
+
+public:
+	SMCPMemoryDifference(uint64_t address = 0, uint64_t length = 0) :
+			address(address), length(length) {
+	}
+};
+
+/** A class which compares memory dumps with a reference image and lists the
+ * differences as (address, length) ranges.
+ *
+ * Equal stretches are skipped with SMCPUtility::findFirstDifference() and
+ * differing stretches measured with SMCPUtility::findFirstEqual(), both
+ * vectorized with AVX2/SSE2. Differences separated by at most mergeGap
+ * equal bytes are coalesced into one range, also across chunk boundaries.
+ *
+ * In streaming mode, begin() sets the start address of a dump (the Start
+ * Address of SMCPMemoryDumpCommandMessage) and each Memory Dump Telemetry
+ * payload is compared with feed() as it arrives, so the dumped image is
+ * never stored. Dumped bytes outside the reference image are counted by
+ * getNOutOfRangeBytes() but not compared.
+ *
+ * A Memory Dump Command with nOfDumps > 0 dumps the same region more than
+ * once. Pass the Dump Length to begin() as regionLength so that the address
+ * wraps back to the start address after each repetition; otherwise the
+ * repetitions are compared with the memory following the region. The
+ * ranges of each repetition are listed in turn.
+ *
+ * The reference image is not copied and must outlive the diff. Ranges are
+ * kept in a vector whose capacity is reused from one dump to the next.
+ *
+ * Example usage:
+ * @code
+ * SMCPMemoryImageDiff diff(eepromImage, eepromSize, 0x10000000);
+ * diff.begin(dumpStartAddress, dumpLength);
+ * ...for each Memory Dump Telemetry of the dump...
+ * diff.feed(view);
+ * ...
+ * for (size_t i = 0; i < diff.getDifferences().size(); i++) {
+ * 	...diff.getDifferences()[i].address, diff.getDifferences()[i].length...
+ * }
+ * @endcode
+ */
+class SMCPMemoryImageDiff {
+private:
+	const uint8_t* reference;
+	size_t referenceLength;
+	uint64_t baseAddress;
+	uint64_t mergeGap;
+	uint64_t cursor;
+	uint64_t regionStart;
+	uint64_t regionLength;
+	std::vector<SMCPMemoryDifference> differences;
+
+private:
+	uint64_t nComparedBytes;
+	uint64_t nDifferentBytes;
+	uint64_t nOutOfRangeBytes;
+
+public:
+	/** Constructor.
+	 * @param[in] reference reference image (not copied).
+	 * @param[in] referenceLength length of the reference image.
+	 * @param[in] baseAddress address of the first byte of the reference image.
+	 * @param[in] mergeGap differences separated by at most this number of equal bytes are coalesced.
+	 */
+	SMCPMemoryImageDiff(const uint8_t* reference, size_t referenceLength, uint64_t baseAddress = 0,
+			uint64_t mergeGap = 0) :
+			reference(reference), referenceLength(referenceLength), baseAddress(baseAddress), mergeGap(mergeGap),
+			cursor(baseAddress), regionStart(baseAddress), regionLength(0), nComparedBytes(0), nDifferentBytes(0), nOutOfRangeBytes(0) {
+	}
+
+public:
+	/** Clears the result and starts a streaming comparison.
+	 * @param[in] startAddress address of the first byte which will be fed.
+	 * @param[in] regionLength length of the dumped region (the Dump Length); the address
+	 * wraps back to startAddress after this number of bytes. 0 means no wrapping.
+	 */
+	void begin(uint64_t startAddress, uint64_t regionLength = 0) {
+		clear();
+		cursor = startAddress;
+		regionStart = startAddress;
+		this->regionLength = regionLength;
+	}
+
+public:
+	/** Compares the next chunk of a dump (streaming mode) and advances the address.
+	 * A chunk may span the end of one repetition of the region and the start of the next.
+	 */
+	void feed(const uint8_t* data, size_t length) {
+		if (regionLength == 0) {
+			compare(cursor, data, length);
+			cursor += length;
+			return;
+		}
+		while (length != 0) {
+			uint64_t remaining = regionStart + regionLength - cursor;
+			size_t n = (remaining < length) ? (size_t) remaining : length;
+			compare(cursor, data, n);
+			cursor += n;
+			data += n;
+			length -= n;
+			if (cursor == regionStart + regionLength) {
+				cursor = regionStart;
+			}
+		}
+	}
+
+public:
+	/** Compares the Attribute Values of a Memory Dump Telemetry as the next chunk of a dump.
+	 * @return false if the message is not a Memory Dump Telemetry (nothing is compared).
+	 */
+	bool feed(const SMCPTelemetryMessageView& message) {
+		if (message.getTelemetryTypeID() != SMCPTelemetryTypeID::MemoryDumpTelemetry) {
+			return false;
+		}
+		feed(message.getAttributeValuesAsPointer(), message.getAttributeValuesLength());
+		return true;
+	}
+
+public:
+	/** Compares a chunk of dumped memory at an arbitrary address.
+	 * Ranges stay sorted and coalesced when chunks are compared in increasing address order.
+	 * @param[in] address address of the first byte of data.
+	 * @param[in] data dumped bytes.
+	 * @param[in] length number of dumped bytes.
+	 */
+	void compare(uint64_t address, const uint8_t* data, size_t length) {
+		//clip to the reference image
+		uint64_t referenceEnd = baseAddress + referenceLength;
+		if (address < baseAddress) {
+			uint64_t skip = (baseAddress - address < length) ? baseAddress - address : length;
+			nOutOfRangeBytes += skip;
+			address += skip;
+			data += skip;
+			length -= (size_t) skip;
+		}
+		if (referenceEnd < address + length) {
+			uint64_t skip = (address < referenceEnd) ? address + length - referenceEnd : length;
+			nOutOfRangeBytes += skip;
+			length -= (size_t) skip;
+		}
+		if (length == 0) {
+			return;
+		}
+
+		const uint8_t* expected = reference + (address - baseAddress);
+		size_t position = 0;
+		while (position < length) {
+			position += SMCPUtility::findFirstDifference(expected + position, data + position, length - position);
+			if (position == length) {
+				break;
+			}
+			size_t end = position
+					+ SMCPUtility::findFirstEqual(expected + position, data + position, length - position);
+			addDifference(address + position, end - position);
+			position = end;
+		}
+		nComparedBytes += length;
+	}
+
+public:
+	/** Clears the ranges and counters. */
+	void clear() {
+		differences.clear();
+		nComparedBytes = 0;
+		nDifferentBytes = 0;
+		nOutOfRangeBytes = 0;
+	}
+
+public:
+	/** Returns the difference ranges found since begin() or clear(). */
+	const std::vector<SMCPMemoryDifference>& getDifferences() const {
+		return differences;
+	}
+
+public:
+	/** Returns true if no difference has been found. */
+	bool isIdentical() const {
+		return differences.empty();
+	}
+
+public:
+	/** Returns the address of the next byte in streaming mode. */
+	uint64_t getCurrentAddress() const {
+		return cursor;
+	}
+
+public:
+	uint64_t getNComparedBytes() const {
+		return nComparedBytes;
+	}
+
+public:
+	/** Returns the number of differing bytes (equal bytes inside coalesced ranges are not counted). */
+	uint64_t getNDifferentBytes() const {
+		return nDifferentBytes;
+	}
+
+public:
+	/** Returns the number of dumped bytes which were outside the reference image. */
+	uint64_t getNOutOfRangeBytes() const {
+		return nOutOfRangeBytes;
+	}
+
+public:
+	/** Returns the ranges one per line as "0xADDRESS LENGTH". */
+	std::string toString() const {
+		std::string result;
+		for (size_t i = 0; i < differences.size(); i++) {
+			char line[64];
+			char* p = SMCPFormatter::writeLiteral(line, "0x");
+			p = SMCPFormatter::writeHex(p, differences[i].address, 8);
+			*p++ = ' ';
+			p = SMCPFormatter::writeDecimal(p, differences[i].length);
+			*p++ = '\n';
+			result.append(line, p - line);
+		}
+		return result;
+	}
+
+public:
+	/** Compares two whole images.
+	 * @param[in] reference reference image.
+	 * @param[in] image dumped image of the same length.
+	 * @param[in] length length of the images.
+	 * @param[in] baseAddress address of the first byte.
+	 * @param[in] mergeGap see the constructor.
+	 * @return difference ranges.
+	 */
+	static std::vector<SMCPMemoryDifference> diff(const uint8_t* reference, const uint8_t* image, size_t length,
+			uint64_t baseAddress = 0, uint64_t mergeGap = 0) {
+		SMCPMemoryImageDiff diff(reference, length, baseAddress, mergeGap);
+		diff.compare(baseAddress, image, length);
+		return diff.getDifferences();
+	}
+
+private:
+	void addDifference(uint64_t address, uint64_t length) {
+		nDifferentBytes += length;
+		if (!differences.empty()) {
+			SMCPMemoryDifference& last = differences.back();
+			uint64_t lastEnd = last.address + last.length;
+			if (lastEnd <= address && address - lastEnd <= mergeGap) {
+				last.length = address + length - last.address;
+				return;
+			}
+		}
+		differences.push_back(SMCPMemoryDifference(address, length));
+	}
+};
+
+#endif /* SMCPMEMORYIMAGEDIFF_HH_ */
@@ -14,6 +14,7 @@
 #include "SMCPTypeClasses.hh"
 #include "SMCPMessageHeader.hh"
 #include "SMCPMessageData.hh"
+#include "SMCPInstrumentation.hh"
 
 /** A class that represents SMCP Message.
  * Comprises of instances of SMCPMessageHeader and SMCPMessageData, or derived classes of them.
@@ -42,20 +43,68 @@ public:
 	 * @return a uint8_t vector that contains packet content
 	 */
 	std::vector<unsigned char> getAsByteVector() {
-		std::vector<unsigned char> result;
-		std::vector<unsigned char> headerVector = header->getAsByteVector();
-		std::vector<unsigned char> dataVector = data->getAsByteVector();
-		result.insert(result.end(), headerVector.begin(), headerVector.end());
-		result.insert(result.end(), dataVector.begin(), dataVector.end());
+		SMCP_INSTRUMENT_SCOPE(SMCPInstrumentedType::Undefined, SMCPInstrumentedOperation::Encode);
+		std::vector<unsigned char> result(getLength());
+		if (!result.empty()) {
+			writeByteArray(&(result[0]), result.size());
+			SMCP_INSTRUMENT_SET_TYPE(getInstrumentedType(result[0]));
+		}
 		return result;
 	}
 
+public:
+	/** Writes packet content into a caller-provided buffer.
+	 * Unlike getAsByteVector(), this method does not allocate memory
+	 * (with the header and data classes provided by the library), so a
+	 * buffer can be reused to encode messages in steady state.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (same as getLength()).
+	 */
+	size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		SMCP_INSTRUMENT_SCOPE(SMCPInstrumentedType::Undefined, SMCPInstrumentedOperation::Encode);
+		size_t length = writeByteArray(buffer, size);
+		SMCP_INSTRUMENT_SET_TYPE(getInstrumentedType(buffer[0]));
+		return length;
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	size_t getLength() {
+		return header->getLength() + data->getLength();
+	}
+
+private:
+	size_t writeByteArray(uint8_t* buffer, size_t size) {
+		size_t headerLength = header->getAsByteArray(buffer, size);
+		return headerLength + data->getAsByteArray(buffer + headerLength, size - headerLength);
+	}
+
+private:
+	int getInstrumentedType(uint8_t firstByte) const {
+		if (data->getSMCPMessageType() == SMCPMessageType::TelemetryMessage) {
+			return SMCPInstrumentedType::fromTelemetryTypeID(firstByte & 0x0F);
+		} else {
+			return SMCPInstrumentedType::fromCommandTypeID(firstByte & 0x0F);
+		}
+	}
+
 public:
 	/** Returns string value of this instance.
 	 * Implementations are provided in derived classes.
 	 */
 	virtual std::string toString() = 0;
 
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * The default implementation appends toString(); implementations
+	 * override it to format without intermediate strings (see SMCPFormatter).
+	 * @param[out] out destination.
+	 */
+	virtual void appendString(std::string& out) {
+		out += toString();
+	}
+
 public:
 	/** Dumps content to a provided output stream.
 	 * @param[in] os output stream instance.
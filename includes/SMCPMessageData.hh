@@ -12,6 +12,7 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <string.h>
 #include "SMCPMessage.hh"
 #include "SMCPException.hh"
 
@@ -34,14 +35,49 @@ public:
 public:
 	virtual std::string toString() = 0;
 
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * The default implementation appends toString(); implementations
+	 * override it to format without intermediate strings (see SMCPFormatter).
+	 * @param[out] out destination.
+	 */
+	virtual void appendString(std::string& out) {
+		out += toString();
+	}
+
 public:
 	virtual std::vector<uint8_t> getAsByteVector() = 0;
 
 public:
-	virtual void setMessageData(uint8_t* data, size_t length) throw (SMCPException) = 0;
+	/** Writes packet content into a caller-provided buffer.
+	 * The default implementation copies getAsByteVector(); implementations
+	 * override it to write without allocating memory.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (same as getLength()).
+	 */
+	virtual size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		std::vector<uint8_t> result = getAsByteVector();
+		if (size < result.size()) {
+			throw SMCPException("buffer too small");
+		}
+		if (!result.empty()) {
+			memcpy(buffer, &(result[0]), result.size());
+		}
+		return result.size();
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	virtual size_t getLength() {
+		return getAsByteVector().size();
+	}
+
+public:
+	virtual void setMessageData(uint8_t* data, size_t length) = 0;
 
 public:
-	virtual void setMessageData(std::vector<uint8_t>& data) throw (SMCPException) =0;
+	virtual void setMessageData(std::vector<uint8_t>& data) =0;
 
 public:
 	virtual bool equals(SMCPMessageData* data) =0;
@@ -13,6 +13,7 @@
 #include <iostream>
 #include <bitset>
 #include <vector>
+#include <string.h>
 #include "SMCPMessage.hh"
 #include "SMCPException.hh"
 
@@ -50,14 +51,49 @@ public:
 public:
 	virtual std::string toString() = 0;
 
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * The default implementation appends toString(); implementations
+	 * override it to format without intermediate strings (see SMCPFormatter).
+	 * @param[out] out destination.
+	 */
+	virtual void appendString(std::string& out) {
+		out += toString();
+	}
+
 public:
 	virtual std::vector<uint8_t> getAsByteVector() = 0;
 
+public:
+	/** Writes packet content into a caller-provided buffer.
+	 * The default implementation copies getAsByteVector(); implementations
+	 * override it to write without allocating memory.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (same as getLength()).
+	 */
+	virtual size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		std::vector<uint8_t> result = getAsByteVector();
+		if (size < result.size()) {
+			throw SMCPException("buffer too small");
+		}
+		if (!result.empty()) {
+			memcpy(buffer, &(result[0]), result.size());
+		}
+		return result.size();
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	virtual size_t getLength() {
+		return getAsByteVector().size();
+	}
+
 public:
 	virtual void setMessageHeader(uint8_t* data) = 0;
 
 public:
-	virtual void setMessageHeader(std::vector<uint8_t>& data) throw (SMCPException) = 0;
+	virtual void setMessageHeader(std::vector<uint8_t>& data) = 0;
 
 public:
 	virtual bool equals(SMCPMessageHeader* header) =0;
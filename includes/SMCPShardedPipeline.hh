@@ -0,0 +1,480 @@
+/*
+ * SMCPShardedPipeline.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPSHARDEDPIPELINE_HH_
+#define SMCPSHARDEDPIPELINE_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPTrafficStatistics.hh"
+#include "SMCPException.hh"
+
+/** An interface which processes the telemetry of one shard of SMCPShardedPipeline.
+ * An instance is called only from the worker thread of its shard, in the
+ * order in which the messages were submitted.
+ */
+class SMCPShardHandler {
+public:
+	virtual ~SMCPShardHandler() {
+	}
+
+public:
+	/** Invoked for each message routed to the shard.
+	 * @param[in] message view of the message (valid only during the call).
+	 * @param[in] receiveTime time given to SMCPShardedPipeline::submit().
+	 */
+	virtual void handle(const SMCPTelemetryMessageView& message, uint64_t receiveTime) = 0;
+
+public:
+	/** Invoked when the worker has drained its queue after stop(). */
+	virtual void finish() {
+	}
+};
+
+/** An interface which creates the handler of each shard.
+ * createHandler() is called from the worker thread of the shard after the
+ * thread has been pinned, so that the handler allocates its memory on the
+ * local NUMA node; implementations should therefore be thread-safe.
+ */
+class SMCPShardHandlerFactory {
+public:
+	virtual ~SMCPShardHandlerFactory() {
+	}
+
+public:
+	virtual SMCPShardHandler* createHandler(size_t shardIndex) = 0;
+};
+
+/** An interface which selects the shard of a message.
+ * All messages which must stay in order relative to each other should be
+ * mapped to the same value. The default router uses Lower FOID.
+ */
+class SMCPShardRouter {
+public:
+	virtual ~SMCPShardRouter() {
+	}
+
+public:
+	/** Returns a key; the message is sent to shard (key % number of shards). */
+	virtual size_t route(const SMCPTelemetryMessageView& message) = 0;
+};
+
+/** Counters of one shard of SMCPShardedPipeline. */
+class SMCPShardStatistics {
+public:
+	/** Messages queued to the shard. */
+	uint64_t nSubmitted;
+	/** Bytes of messages queued to the shard. */
+	uint64_t nSubmittedBytes;
+	/** Messages passed to the handler. */
+	uint64_t nProcessed;
+	/** Number of times submit() waited because the queue of the shard was full. */
+	uint64_t nFullWaits;
+	/** Exceptions thrown by the handler (the message is skipped). */
+	uint64_t nHandlerErrors;
+	/** CPU the worker is pinned to, or -1. */
+	int cpu;
+};
+
+/** A class which decodes and processes telemetry on several worker threads.
+ *
+ * Messages given to submit() are routed to a shard by Lower FOID (or by an
+ * SMCPShardRouter), copied into the single-producer/single-consumer ring
+ * buffer of the shard, and passed to the SMCPShardHandler of the shard by its
+ * worker thread. Messages of one shard are handled in submission order.
+ *
+ * Each worker can be pinned to a CPU (Linux only; elsewhere the CPU list is
+ * ignored). After pinning, the worker allocates its ring buffer and creates
+ * its handler, so that both are placed on the worker's NUMA node. Each
+ * shard has its own SMCPTrafficStatistics and SMCPShardStatistics; nothing
+ * is shared between workers.
+ *
+ * submit() must be called from one thread at a time. When a ring buffer is
+ * full, submit() waits for the worker (back-pressure) while trySubmit()
+ * returns false.
+ *
+ * A Message Length shorter than the minimum message means that the input
+ * is corrupted: the submit methods count it in getNInvalid() and throw
+ * SMCPException, so that the caller can discard its buffered data and
+ * resynchronize instead of retrying the same bytes.
+ *
+ * Example usage:
+ * @code
+ * class DecoderFactory: public SMCPShardHandlerFactory {
+ * 	SMCPShardHandler* createHandler(size_t shardIndex) {
+ * 		return new Decoder(shardIndex);
+ * 	}
+ * } factory;
+ * std::vector<int> cpus = { 2, 3, 4, 5 };
+ * SMCPShardedPipeline pipeline(4, &factory, NULL, cpus);
+ * pipeline.start();
+ * while (...) {
+ * 	size_t n = receive(buffer);
+ * 	pipeline.submitStream(buffer, n, SMCPCurrentValueTable::getCurrentTime());
+ * }
+ * pipeline.stop(); //drains the queues and joins the workers
+ * SMCPTrafficStatisticsSnapshot counts;
+ * pipeline.getTrafficStatistics(0).snapshot(counts);
+ * @endcode
+ */
+class SMCPShardedPipeline {
+public:
+	static const size_t DefaultRingCapacity = 4 * 1024 * 1024;
+
+private:
+	/** Each record is [length:4][reserved:4][receiveTime:8][message] padded to 8 bytes. */
+	static const size_t RecordHeaderLength = 16;
+	static const uint32_t WrapMarker = 0xFFFFFFFF;
+	static const size_t CacheLineSize = 64;
+
+private:
+	class Shard {
+	public:
+		//written by the producer
+		alignas(CacheLineSize) std::atomic<uint64_t> writePosition;
+		uint64_t cachedReadPosition;
+		std::atomic<uint64_t> nSubmitted;
+		std::atomic<uint64_t> nSubmittedBytes;
+		std::atomic<uint64_t> nFullWaits;
+
+		//written by the worker
+		alignas(CacheLineSize) std::atomic<uint64_t> readPosition;
+		std::atomic<uint64_t> nProcessed;
+		std::atomic<uint64_t> nHandlerErrors;
+
+		alignas(CacheLineSize) std::vector<uint8_t> ring;
+		size_t mask;
+		SMCPShardHandler* handler;
+		SMCPTrafficStatistics* statistics;
+		std::thread thread;
+		int cpu;
+
+	public:
+		Shard() :
+				writePosition(0), cachedReadPosition(0), nSubmitted(0), nSubmittedBytes(0), nFullWaits(0),
+				readPosition(0), nProcessed(0), nHandlerErrors(0), mask(0), handler(NULL), statistics(NULL), cpu(-1) {
+		}
+	};
+
+private:
+	std::vector<Shard*> shards;
+	SMCPShardHandlerFactory* factory;
+	SMCPShardRouter* router;
+	size_t ringCapacity;
+	std::atomic<bool> running;
+	bool started;
+	std::mutex mutex;
+	std::condition_variable condition;
+	size_t nReady;
+	uint64_t nInvalid;
+
+public:
+	/** Constructor.
+	 * @param[in] nShards number of shards (worker threads).
+	 * @param[in] factory creator of the handler of each shard.
+	 * @param[in] router shard selector; NULL to route by Lower FOID.
+	 * @param[in] cpus CPU of each worker; empty (or -1 entries) for no pinning.
+	 * @param[in] ringCapacity size of the ring buffer of each shard in bytes (rounded up to a power of two).
+	 */
+	SMCPShardedPipeline(size_t nShards, SMCPShardHandlerFactory* factory, SMCPShardRouter* router = NULL,
+			std::vector<int> cpus = std::vector<int>(), size_t ringCapacity = DefaultRingCapacity) :
+			factory(factory), router(router), ringCapacity(CacheLineSize), running(false), started(false), nReady(0),
+			nInvalid(0) {
+		if (nShards == 0 || factory == NULL) {
+			throw SMCPException("SMCPShardedPipeline: at least one shard and a handler factory are required");
+		}
+		while (this->ringCapacity < ringCapacity) {
+			this->ringCapacity *= 2;
+		}
+		for (size_t i = 0; i < nShards; i++) {
+			Shard* shard = new Shard();
+			shard->cpu = (i < cpus.size()) ? cpus[i] : -1;
+			shard->mask = this->ringCapacity - 1;
+			shards.push_back(shard);
+		}
+	}
+
+public:
+	/** Destructor. Stops the workers if running and deletes the handlers. */
+	~SMCPShardedPipeline() {
+		stop();
+		for (size_t i = 0; i < shards.size(); i++) {
+			delete shards[i]->handler;
+			delete shards[i]->statistics;
+			delete shards[i];
+		}
+	}
+
+public:
+	/** Starts the workers and returns when all of them are ready to receive messages. */
+	void start() {
+		if (started) {
+			throw SMCPException("SMCPShardedPipeline: already started");
+		}
+		started = true;
+		running.store(true);
+		for (size_t i = 0; i < shards.size(); i++) {
+			shards[i]->thread = std::thread(&SMCPShardedPipeline::run, this, i);
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		while (nReady < shards.size()) {
+			condition.wait(lock);
+		}
+	}
+
+public:
+	/** Lets the workers process all queued messages, then joins them. */
+	void stop() {
+		if (!running.load()) {
+			return;
+		}
+		running.store(false);
+		for (size_t i = 0; i < shards.size(); i++) {
+			if (shards[i]->thread.joinable()) {
+				shards[i]->thread.join();
+			}
+		}
+	}
+
+public:
+	/** Queues a telemetry message, waiting while the ring buffer of its shard is full.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @param[in] receiveTime time passed to the handler.
+	 * @return the length of the message, or 0 if the array does not start with a complete message.
+	 * @throw SMCPException if the Message Length is shorter than the minimum message.
+	 */
+	size_t submit(const uint8_t* data, size_t length, uint64_t receiveTime) {
+		return submit(data, length, receiveTime, true);
+	}
+
+public:
+	/** Queues a telemetry message without waiting.
+	 * @return the length of the message, or 0 if the message is incomplete or its shard is full.
+	 * @throw SMCPException if the Message Length is shorter than the minimum message.
+	 */
+	size_t trySubmit(const uint8_t* data, size_t length, uint64_t receiveTime) {
+		return submit(data, length, receiveTime, false);
+	}
+
+public:
+	/** Queues telemetry messages stored back to back in a byte array.
+	 * @return number of bytes consumed; a trailing incomplete message is not consumed
+	 * and should be passed again with the following data.
+	 * @throw SMCPException if a Message Length is shorter than the minimum message
+	 * (the messages before it have been queued).
+	 */
+	size_t submitStream(const uint8_t* data, size_t length, uint64_t receiveTime) {
+		size_t offset = 0;
+		while (offset < length) {
+			size_t messageLength = submit(data + offset, length - offset, receiveTime, true);
+			if (messageLength == 0) {
+				break;
+			}
+			offset += messageLength;
+		}
+		return offset;
+	}
+
+public:
+	size_t getNShards() const {
+		return shards.size();
+	}
+
+public:
+	/** Returns the handler of a shard (NULL before start()). */
+	SMCPShardHandler* getHandler(size_t shardIndex) {
+		return shards.at(shardIndex)->handler;
+	}
+
+public:
+	/** Returns the traffic statistics of a shard. Valid after start(). */
+	SMCPTrafficStatistics& getTrafficStatistics(size_t shardIndex) {
+		SMCPTrafficStatistics* statistics = shards.at(shardIndex)->statistics;
+		if (statistics == NULL) {
+			throw SMCPException("SMCPShardedPipeline: not started");
+		}
+		return *statistics;
+	}
+
+public:
+	/** Returns the counters of a shard. */
+	SMCPShardStatistics getStatistics(size_t shardIndex) const {
+		const Shard* shard = shards.at(shardIndex);
+		SMCPShardStatistics result;
+		result.nSubmitted = shard->nSubmitted.load(std::memory_order_relaxed);
+		result.nSubmittedBytes = shard->nSubmittedBytes.load(std::memory_order_relaxed);
+		result.nProcessed = shard->nProcessed.load(std::memory_order_relaxed);
+		result.nFullWaits = shard->nFullWaits.load(std::memory_order_relaxed);
+		result.nHandlerErrors = shard->nHandlerErrors.load(std::memory_order_relaxed);
+		result.cpu = shard->cpu;
+		return result;
+	}
+
+public:
+	/** Returns the number of invalid Message Lengths found by the submit methods. */
+	uint64_t getNInvalid() const {
+		return nInvalid;
+	}
+
+private:
+	size_t submit(const uint8_t* data, size_t length, uint64_t receiveTime, bool wait) {
+		if (SMCPTelemetryMessageView::HeaderLength <= length
+				&& SMCPTelemetryMessageView::getMessageLength(data) < SMCPTelemetryMessageView::MinimumMessageLength) {
+			nInvalid++;
+			throw SMCPException("SMCPShardedPipeline: invalid Message Length");
+		}
+		SMCPTelemetryMessageView message;
+		if (!message.tryInterpretAsTelemetryMessage(data, length)) {
+			return 0;
+		}
+		if (!running.load(std::memory_order_relaxed)) {
+			throw SMCPException("SMCPShardedPipeline: not running");
+		}
+		size_t key = (router != NULL) ? router->route(message) : message.getLowerFOID();
+		Shard& shard = *shards[key % shards.size()];
+		size_t messageLength = message.getLength();
+		size_t recordLength = (RecordHeaderLength + messageLength + 7) & ~(size_t) 7;
+		if (ringCapacity / 2 < recordLength) {
+			throw SMCPException("SMCPShardedPipeline: message larger than half of the ring buffer");
+		}
+
+		uint64_t position = shard.writePosition.load(std::memory_order_relaxed);
+		size_t offset = position & shard.mask;
+		size_t padding = (ringCapacity - offset < recordLength) ? ringCapacity - offset : 0;
+		size_t required = padding + recordLength;
+		if (ringCapacity - (position - shard.cachedReadPosition) < required) {
+			shard.cachedReadPosition = shard.readPosition.load(std::memory_order_acquire);
+			if (ringCapacity - (position - shard.cachedReadPosition) < required) {
+				if (!wait) {
+					return 0;
+				}
+				shard.nFullWaits.store(shard.nFullWaits.load(std::memory_order_relaxed) + 1,
+						std::memory_order_relaxed);
+				do {
+					std::this_thread::yield();
+					shard.cachedReadPosition = shard.readPosition.load(std::memory_order_acquire);
+				} while (ringCapacity - (position - shard.cachedReadPosition) < required);
+			}
+		}
+
+		uint8_t* ring = &(shard.ring[0]);
+		if (padding != 0) {
+			uint32_t marker = WrapMarker;
+			memcpy(ring + offset, &marker, 4);
+			offset = 0;
+		}
+		uint32_t length32 = (uint32_t) messageLength;
+		memcpy(ring + offset, &length32, 4);
+		memcpy(ring + offset + 8, &receiveTime, 8);
+		memcpy(ring + offset + RecordHeaderLength, data, messageLength);
+		shard.writePosition.store(position + required, std::memory_order_release);
+		shard.nSubmitted.store(shard.nSubmitted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		shard.nSubmittedBytes.store(shard.nSubmittedBytes.load(std::memory_order_relaxed) + messageLength,
+				std::memory_order_relaxed);
+		return messageLength;
+	}
+
+private:
+	void run(size_t shardIndex) {
+		Shard& shard = *shards[shardIndex];
+		pin(shard.cpu);
+		//allocate after pinning so that the memory is placed on the local node (first touch)
+		shard.ring.assign(ringCapacity, 0);
+		shard.statistics = new SMCPTrafficStatistics(1024);
+		shard.handler = factory->createHandler(shardIndex);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			nReady++;
+		}
+		condition.notify_all();
+
+		const uint8_t* ring = &(shard.ring[0]);
+		SMCPTelemetryMessageView message;
+		uint64_t readPosition = 0;
+		size_t nIdle = 0;
+		while (true) {
+			uint64_t writePosition = shard.writePosition.load(std::memory_order_acquire);
+			if (readPosition == writePosition) {
+				if (!running.load(std::memory_order_acquire)) {
+					//re-check: records may have been written just before running was cleared
+					if (readPosition == shard.writePosition.load(std::memory_order_acquire)) {
+						break;
+					}
+					continue;
+				}
+				idle(nIdle++);
+				continue;
+			}
+			nIdle = 0;
+			uint64_t nProcessed = shard.nProcessed.load(std::memory_order_relaxed);
+			while (readPosition != writePosition) {
+				size_t offset = readPosition & shard.mask;
+				uint32_t messageLength;
+				memcpy(&messageLength, ring + offset, 4);
+				if (messageLength == WrapMarker) {
+					readPosition += ringCapacity - offset;
+					continue;
+				}
+				uint64_t receiveTime;
+				memcpy(&receiveTime, ring + offset + 8, 8);
+				const uint8_t* data = ring + offset + RecordHeaderLength;
+				message.tryInterpretAsTelemetryMessage(data, messageLength);
+				shard.statistics->record(data, messageLength);
+				try {
+					shard.handler->handle(message, receiveTime);
+				} catch (std::exception&) {
+					shard.nHandlerErrors.store(shard.nHandlerErrors.load(std::memory_order_relaxed) + 1,
+							std::memory_order_relaxed);
+				}
+				nProcessed++;
+				readPosition += (RecordHeaderLength + messageLength + 7) & ~(uint64_t) 7;
+			}
+			//release the whole batch at once
+			shard.nProcessed.store(nProcessed, std::memory_order_relaxed);
+			shard.readPosition.store(readPosition, std::memory_order_release);
+		}
+		shard.handler->finish();
+	}
+
+private:
+	static void idle(size_t nIdle) {
+		if (nIdle < 64) {
+			return;
+		} else if (nIdle < 1024) {
+			std::this_thread::yield();
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+
+private:
+	static void pin(int cpu) {
+		if (cpu < 0) {
+			return;
+		}
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+};
+
+#endif /* SMCPSHARDEDPIPELINE_HH_ */
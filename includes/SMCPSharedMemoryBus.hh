@@ -0,0 +1,495 @@
+/*
+ * SMCPSharedMemoryBus.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPSHAREDMEMORYBUS_HH_
+#define SMCPSHAREDMEMORYBUS_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** Control block at the head of a shared-memory bus segment.
+ * Positions are byte offsets in the data area counted from the creation of
+ * the bus (they never wrap); the offset in the ring is position % capacity.
+ */
+class SMCPSharedMemoryBusHeader {
+public:
+	static const uint64_t Magic = 0x5342504D43504D53ULL; //"SMPCMPBS"
+	static const uint32_t Version = 1;
+
+public:
+	uint64_t magic;
+	uint32_t version;
+	uint32_t headerLength;
+	uint64_t capacity;
+	/** Position of the oldest record which has not been overwritten. */
+	alignas(64) std::atomic<uint64_t> tailPosition;
+	/** End of the region the writer may be overwriting (published before the data are written). */
+	alignas(64) std::atomic<uint64_t> reservedPosition;
+	/** End of the last complete record (published after the data are written). */
+	alignas(64) std::atomic<uint64_t> writePosition;
+	alignas(64) uint8_t padding[1];
+};
+
+/** Receive metadata carried with each message on the bus. */
+class SMCPSharedMemoryBusRecord {
+public:
+	/** Length of the message. */
+	uint32_t length;
+	/** Source identifier given by the writer (e.g. link or ground station). */
+	uint32_t source;
+	/** Receive time given by the writer. */
+	uint64_t time;
+	/** Sequence number assigned by the writer, starting from 0. */
+	uint64_t sequence;
+};
+
+/** Constants and helpers shared by SMCPSharedMemoryBusWriter and SMCPSharedMemoryBusReader.
+ *
+ * The segment consists of SMCPSharedMemoryBusHeader followed by a data area
+ * of a power-of-two capacity. Each message is stored as a 24-octet
+ * SMCPSharedMemoryBusRecord followed by the message bytes, padded to 8
+ * octets. A record never straddles the end of the data area; when the
+ * remaining space is too short the writer skips to the beginning, leaving a
+ * padding record (length PaddingLength) if at least a record header fits.
+ */
+class SMCPSharedMemoryBus {
+public:
+	static const size_t RecordHeaderLength = sizeof(SMCPSharedMemoryBusRecord);
+	static const uint32_t PaddingLength = 0xFFFFFFFF;
+
+public:
+	static size_t getHeaderLength() {
+		return (sizeof(SMCPSharedMemoryBusHeader) + 63) & ~(size_t) 63;
+	}
+
+public:
+	/** Returns the length of the record which holds a message of a given length. */
+	static size_t getRecordLength(size_t messageLength) {
+		return RecordHeaderLength + ((messageLength + 7) & ~(size_t) 7);
+	}
+
+public:
+	/** Returns the position of the record following the one at position (which must be intact). */
+	static uint64_t getNextPosition(const uint8_t* data, uint64_t capacity, uint64_t position) {
+		size_t offset = (size_t) (position & (capacity - 1));
+		size_t toEnd = (size_t) (capacity - offset);
+		if (toEnd < RecordHeaderLength) {
+			return position + toEnd;
+		}
+		uint32_t length;
+		memcpy(&length, data + offset, sizeof(length));
+		if (length == PaddingLength) {
+			return position + toEnd;
+		}
+		return position + getRecordLength(length);
+	}
+};
+
+/** The single writer of a shared-memory telemetry bus.
+ *
+ * Messages are published into a ring in a POSIX shared-memory object (or,
+ * on Linux, an anonymous memfd whose descriptor is passed to the readers),
+ * so any number of SMCPSharedMemoryBusReader in other processes receive the
+ * stream without copies through the kernel. The writer never waits for
+ * readers; a reader which falls more than the capacity behind detects the
+ * overrun and skips to the oldest intact record.
+ *
+ * Link with -lrt on glibc older than 2.34.
+ *
+ * Example usage:
+ * @code
+ * SMCPSharedMemoryBusWriter bus("/smcp_telemetry", 64 * 1024 * 1024);
+ * ...for each received telemetry message...
+ * bus.publish(message, length, receiveTime, linkID);
+ * @endcode
+ */
+class SMCPSharedMemoryBusWriter {
+private:
+	std::string name;
+	int fd;
+	uint8_t* segment;
+	size_t segmentLength;
+	SMCPSharedMemoryBusHeader* header;
+	uint8_t* data;
+	uint64_t capacity;
+	uint64_t position;
+	uint64_t tail;
+	uint64_t sequence;
+
+public:
+	/** Constructor. Creates (or truncates) a shared-memory object.
+	 * @param[in] name name of the POSIX shared-memory object (e.g. "/smcp_telemetry"),
+	 * or empty to create an anonymous memfd (Linux only; see getFileDescriptor()).
+	 * @param[in] capacity size of the data area; rounded up to a power of two.
+	 */
+	SMCPSharedMemoryBusWriter(std::string name, size_t capacity) :
+			name(name), fd(-1), segment(NULL), segmentLength(0), header(NULL), data(NULL), capacity(4096),
+			position(0), tail(0), sequence(0) {
+		while (this->capacity < capacity) {
+			this->capacity <<= 1;
+		}
+		if (name.empty()) {
+#if defined(__linux__)
+			fd = memfd_create("smcp_bus", 0);
+#else
+			throw SMCPException("SMCPSharedMemoryBusWriter: anonymous segments are supported only on Linux");
+#endif
+		} else {
+			fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+		}
+		if (fd < 0) {
+			throw SMCPException(std::string("SMCPSharedMemoryBusWriter: cannot create segment: ") + strerror(errno));
+		}
+		segmentLength = SMCPSharedMemoryBus::getHeaderLength() + (size_t) this->capacity;
+		void* p = MAP_FAILED;
+		if (ftruncate(fd, (off_t) segmentLength) == 0) {
+			p = mmap(NULL, segmentLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		if (p == MAP_FAILED) {
+			int error = errno;
+			close(fd);
+			if (!name.empty()) {
+				shm_unlink(name.c_str());
+			}
+			throw SMCPException(std::string("SMCPSharedMemoryBusWriter: cannot map segment: ") + strerror(error));
+		}
+		segment = (uint8_t*) p;
+		header = new (segment) SMCPSharedMemoryBusHeader();
+		header->tailPosition.store(0, std::memory_order_relaxed);
+		header->reservedPosition.store(0, std::memory_order_relaxed);
+		header->writePosition.store(0, std::memory_order_relaxed);
+		header->capacity = this->capacity;
+		header->headerLength = (uint32_t) SMCPSharedMemoryBus::getHeaderLength();
+		header->version = SMCPSharedMemoryBusHeader::Version;
+		std::atomic_thread_fence(std::memory_order_release);
+		header->magic = SMCPSharedMemoryBusHeader::Magic; //readers check the magic last
+		data = segment + SMCPSharedMemoryBus::getHeaderLength();
+	}
+
+public:
+	/** Destructor. Unmaps the segment and removes the shared-memory object name.
+	 * Readers which have already mapped the segment keep working.
+	 */
+	~SMCPSharedMemoryBusWriter() {
+		munmap(segment, segmentLength);
+		close(fd);
+		if (!name.empty()) {
+			shm_unlink(name.c_str());
+		}
+	}
+
+public:
+	/** Publishes a message.
+	 * @param[in] message message bytes.
+	 * @param[in] length length of the message (at most getMaximumMessageLength()).
+	 * @param[in] time receive time.
+	 * @param[in] source source identifier.
+	 */
+	void publish(const uint8_t* message, size_t length, uint64_t time, uint32_t source = 0) {
+		if (getMaximumMessageLength() < length) {
+			throw SMCPException("SMCPSharedMemoryBusWriter: message too long");
+		}
+		size_t recordLength = SMCPSharedMemoryBus::getRecordLength(length);
+		size_t offset = (size_t) (position & (capacity - 1));
+		size_t toEnd = (size_t) (capacity - offset);
+		uint64_t start = (toEnd < recordLength) ? position + toEnd : position;
+		uint64_t end = start + recordLength;
+
+		//release the records which will be overwritten, then announce the overwrite
+		while (capacity < end - tail) {
+			tail = SMCPSharedMemoryBus::getNextPosition(data, capacity, tail);
+		}
+		header->tailPosition.store(tail, std::memory_order_relaxed);
+		header->reservedPosition.store(end, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		if (start != position && SMCPSharedMemoryBus::RecordHeaderLength <= toEnd) {
+			uint32_t padding = SMCPSharedMemoryBus::PaddingLength;
+			memcpy(data + offset, &padding, sizeof(padding));
+		}
+		SMCPSharedMemoryBusRecord record;
+		record.length = (uint32_t) length;
+		record.source = source;
+		record.time = time;
+		record.sequence = sequence++;
+		uint8_t* p = data + (size_t) (start & (capacity - 1));
+		memcpy(p, &record, sizeof(record));
+		memcpy(p + SMCPSharedMemoryBus::RecordHeaderLength, message, length);
+
+		position = end;
+		header->writePosition.store(end, std::memory_order_release);
+	}
+
+public:
+	/** Publishes the message a view is placed on. */
+	void publish(const SMCPTelemetryMessageView& message, uint64_t time, uint32_t source = 0) {
+		publish(message.getAsPointer(), message.getLength(), time, source);
+	}
+
+public:
+	/** Returns the file descriptor of the segment (e.g. to pass an anonymous segment over a UNIX socket). */
+	int getFileDescriptor() const {
+		return fd;
+	}
+
+public:
+	uint64_t getCapacity() const {
+		return capacity;
+	}
+
+public:
+	/** Returns the longest message which can be published. */
+	size_t getMaximumMessageLength() const {
+		return (size_t) (capacity / 4);
+	}
+
+public:
+	/** Returns the number of messages published. */
+	uint64_t getNPublished() const {
+		return sequence;
+	}
+};
+
+/** A reader of a shared-memory telemetry bus written by SMCPSharedMemoryBusWriter.
+ *
+ * Each reader keeps its own cursor and places SMCPTelemetryMessageView
+ * directly on the shared segment. Because the writer never waits, a record
+ * may be overwritten while it is being used; call isValid() after
+ * processing a message to confirm that it was intact, and discard the
+ * result otherwise. Lost messages are counted from the sequence numbers.
+ *
+ * Example usage:
+ * @code
+ * SMCPSharedMemoryBusReader bus("/smcp_telemetry");
+ * SMCPTelemetryMessageView message;
+ * SMCPSharedMemoryBusRecord record;
+ * for (;;) {
+ * 	while (bus.next(message, record)) {
+ * 		...decode message...
+ * 		if (!bus.isValid()) {
+ * 			...overwritten while decoding; discard...
+ * 		}
+ * 	}
+ * 	...sleep or do other work...
+ * }
+ * @endcode
+ */
+class SMCPSharedMemoryBusReader {
+private:
+	int fd;
+	uint8_t* segment;
+	size_t segmentLength;
+	const SMCPSharedMemoryBusHeader* header;
+	const uint8_t* data;
+	uint64_t capacity;
+	uint64_t cursor;
+	uint64_t recordPosition;
+	uint64_t expectedSequence;
+	bool started;
+
+private:
+	uint64_t nReceived;
+	uint64_t nLost;
+	uint64_t nOverruns;
+	uint64_t nInvalid;
+
+public:
+	/** Constructor. Opens a named bus.
+	 * @param[in] name name of the POSIX shared-memory object.
+	 * @param[in] fromOldest if true, starts from the oldest message in the ring; otherwise from the next one published.
+	 */
+	SMCPSharedMemoryBusReader(std::string name, bool fromOldest = false) :
+			fd(-1) {
+		initialize();
+		fd = shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0) {
+			throw SMCPException(std::string("SMCPSharedMemoryBusReader: cannot open segment: ") + strerror(errno));
+		}
+		map(fromOldest);
+	}
+
+public:
+	/** Constructor. Opens a bus from a file descriptor (e.g. of an anonymous segment received from the writer).
+	 * The descriptor is duplicated.
+	 */
+	SMCPSharedMemoryBusReader(int fileDescriptor, bool fromOldest = false) :
+			fd(-1) {
+		initialize();
+		fd = dup(fileDescriptor);
+		if (fd < 0) {
+			throw SMCPException(std::string("SMCPSharedMemoryBusReader: cannot open segment: ") + strerror(errno));
+		}
+		map(fromOldest);
+	}
+
+public:
+	~SMCPSharedMemoryBusReader() {
+		munmap(segment, segmentLength);
+		close(fd);
+	}
+
+public:
+	/** Places a view on the next message.
+	 * @param[out] message view placed on the shared segment.
+	 * @param[out] record receive metadata of the message.
+	 * @return false if no new message is available.
+	 */
+	bool next(SMCPTelemetryMessageView& message, SMCPSharedMemoryBusRecord& record) {
+		for (;;) {
+			uint64_t end = header->writePosition.load(std::memory_order_acquire);
+			if (cursor == end) {
+				return false;
+			}
+			size_t offset = (size_t) (cursor & (capacity - 1));
+			size_t toEnd = (size_t) (capacity - offset);
+			if (toEnd < SMCPSharedMemoryBus::RecordHeaderLength) {
+				cursor += toEnd;
+				continue;
+			}
+			memcpy(&record, data + offset, sizeof(record));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (isOverwritten(cursor)) {
+				recover();
+				continue;
+			}
+			if (record.length == SMCPSharedMemoryBus::PaddingLength) {
+				cursor += toEnd;
+				continue;
+			}
+			recordPosition = cursor;
+			cursor += SMCPSharedMemoryBus::getRecordLength(record.length);
+			if (started && expectedSequence < record.sequence) {
+				nLost += record.sequence - expectedSequence;
+			}
+			started = true;
+			expectedSequence = record.sequence + 1;
+			if (!message.tryInterpretAsTelemetryMessage(data + offset + SMCPSharedMemoryBus::RecordHeaderLength,
+					record.length)) {
+				nInvalid++;
+				continue;
+			}
+			nReceived++;
+			return true;
+		}
+	}
+
+public:
+	/** Returns true if the message returned by the last next() has not been overwritten since. */
+	bool isValid() {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return !isOverwritten(recordPosition);
+	}
+
+public:
+	/** Moves the cursor to the newest end of the stream, skipping unread messages. */
+	void skipToLatest() {
+		cursor = header->writePosition.load(std::memory_order_acquire);
+		started = false;
+	}
+
+public:
+	/** Returns the number of bytes of records not yet read (0 if overrun). */
+	uint64_t getNPendingBytes() const {
+		uint64_t end = header->writePosition.load(std::memory_order_acquire);
+		return (capacity < end - cursor) ? 0 : end - cursor;
+	}
+
+public:
+	/** Returns the number of messages returned by next(). */
+	uint64_t getNReceived() const {
+		return nReceived;
+	}
+
+public:
+	/** Returns the number of messages overwritten before they were read. */
+	uint64_t getNLost() const {
+		return nLost;
+	}
+
+public:
+	/** Returns the number of times the reader fell behind the writer by more than the capacity. */
+	uint64_t getNOverruns() const {
+		return nOverruns;
+	}
+
+public:
+	/** Returns the number of records which were not valid telemetry messages. */
+	uint64_t getNInvalid() const {
+		return nInvalid;
+	}
+
+private:
+	void initialize() {
+		segment = NULL;
+		segmentLength = 0;
+		header = NULL;
+		data = NULL;
+		capacity = 0;
+		cursor = 0;
+		recordPosition = 0;
+		expectedSequence = 0;
+		started = false;
+		nReceived = 0;
+		nLost = 0;
+		nOverruns = 0;
+		nInvalid = 0;
+	}
+
+private:
+	void map(bool fromOldest) {
+		struct stat status;
+		if (fstat(fd, &status) != 0 || (size_t) status.st_size < SMCPSharedMemoryBus::getHeaderLength()) {
+			close(fd);
+			throw SMCPException("SMCPSharedMemoryBusReader: segment too small");
+		}
+		segmentLength = (size_t) status.st_size;
+		void* p = mmap(NULL, segmentLength, PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			int error = errno;
+			close(fd);
+			throw SMCPException(std::string("SMCPSharedMemoryBusReader: cannot map segment: ") + strerror(error));
+		}
+		segment = (uint8_t*) p;
+		header = (const SMCPSharedMemoryBusHeader*) segment;
+		if (header->magic != SMCPSharedMemoryBusHeader::Magic || header->version != SMCPSharedMemoryBusHeader::Version
+				|| segmentLength < header->headerLength + header->capacity) {
+			munmap(segment, segmentLength);
+			close(fd);
+			throw SMCPException("SMCPSharedMemoryBusReader: not an SMCP bus segment");
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		capacity = header->capacity;
+		data = segment + header->headerLength;
+		if (fromOldest) {
+			cursor = header->tailPosition.load(std::memory_order_acquire);
+		} else {
+			cursor = header->writePosition.load(std::memory_order_acquire);
+		}
+	}
+
+private:
+	bool isOverwritten(uint64_t position) const {
+		return capacity < header->reservedPosition.load(std::memory_order_relaxed) - position;
+	}
+
+private:
+	void recover() {
+		nOverruns++;
+		cursor = header->tailPosition.load(std::memory_order_acquire);
+	}
+};
+
+#endif /* SMCPSHAREDMEMORYBUS_HH_ */
@@ -0,0 +1,300 @@
+/*
+ * SMCPSpacePacket.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPSPACEPACKET_HH_
+#define SMCPSPACEPACKET_HH_
+
+#include <stdint.h>
+#include <vector>
+#include "SMCPMessage.hh"
+#include "SMCPCommandMessage.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPCommandMessageView.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** A class which collects CCSDS Space Packet Types.
+ * Used by SMCPSpacePacketEncoder.
+ */
+class SMCPSpacePacketType {
+public:
+	static const uint8_t Telemetry = 0x00;
+	static const uint8_t Telecommand = 0x01;
+};
+
+/** A class which writes SMCP messages encapsulated in CCSDS Space Packets.
+ * The 6-octet Packet Primary Header and the SMCP message are written
+ * directly into one caller-provided buffer, without an intermediate vector.
+ * The header is
+ * - Packet Version Number = 000b,
+ * - Packet Type = 0 (telemetry) or 1 (telecommand),
+ * - Secondary Header Flag = 0,
+ * - APID (11 bits),
+ * - Sequence Flags = 11b (unsegmented user data),
+ * - Packet Sequence Count (14 bits, counted per APID), and
+ * - Packet Data Length = (length of the SMCP message) - 1.
+ *
+ * The sequence counters are not protected; use one encoder per thread.
+ *
+ * Example usage:
+ * @code
+ * SMCPSpacePacketEncoder encoder;
+ * uint8_t buffer[SMCPSpacePacketEncoder::MaximumPacketLength];
+ * size_t length = encoder.encode(getCommand, 0x123, buffer, sizeof(buffer));
+ * send(buffer, length);
+ * @endcode
+ */
+class SMCPSpacePacketEncoder {
+public:
+	static const size_t PrimaryHeaderLength = 6;
+	static const size_t NAPIDs = 2048;
+	static const size_t MaximumPacketDataLength = 65536;
+	static const size_t MaximumPacketLength = PrimaryHeaderLength + MaximumPacketDataLength;
+
+private:
+	std::vector<uint16_t> sequenceCounts;
+
+public:
+	/** Constructor. */
+	SMCPSpacePacketEncoder() :
+			sequenceCounts(NAPIDs, 0) {
+	}
+
+public:
+	/** Writes a command message as a telecommand Space Packet.
+	 * @param[in] message command message.
+	 * @param[in] apid APID.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written.
+	 */
+	size_t encode(SMCPCommandMessage& message, uint16_t apid, uint8_t* buffer, size_t size) {
+		return encode(message, apid, SMCPSpacePacketType::Telecommand, buffer, size);
+	}
+
+public:
+	/** Writes a telemetry message as a telemetry Space Packet.
+	 * @param[in] message telemetry message.
+	 * @param[in] apid APID.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written.
+	 */
+	size_t encode(SMCPTelemetryMessage& message, uint16_t apid, uint8_t* buffer, size_t size) {
+		return encode(message, apid, SMCPSpacePacketType::Telemetry, buffer, size);
+	}
+
+public:
+	/** Writes a message as a Space Packet.
+	 * @param[in] message SMCP message.
+	 * @param[in] apid APID.
+	 * @param[in] packetType Packet Type (see SMCPSpacePacketType).
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written.
+	 */
+	size_t encode(SMCPMessage& message, uint16_t apid, uint8_t packetType, uint8_t* buffer, size_t size) {
+		size_t messageLength = message.getLength();
+		writePrimaryHeader(buffer, size, apid, packetType, messageLength);
+		message.getAsByteArray(buffer + PrimaryHeaderLength, size - PrimaryHeaderLength);
+		return PrimaryHeaderLength + messageLength;
+	}
+
+public:
+	/** Writes the Packet Primary Header for an SMCP message which the caller writes
+	 * at buffer + PrimaryHeaderLength (e.g. with SMCPCommandTemplate::stamp()).
+	 * The sequence count of the APID is incremented.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer, which should also hold the SMCP message.
+	 * @param[in] apid APID.
+	 * @param[in] packetType Packet Type (see SMCPSpacePacketType).
+	 * @param[in] messageLength length of the SMCP message.
+	 * @return PrimaryHeaderLength.
+	 */
+	size_t writePrimaryHeader(uint8_t* buffer, size_t size, uint16_t apid, uint8_t packetType, size_t messageLength) {
+		if (NAPIDs <= apid) {
+			throw SMCPException("SMCPSpacePacketEncoder: APID should be less than 2048");
+		}
+		if (messageLength == 0 || (size_t) MaximumPacketDataLength < messageLength) {
+			throw SMCPException("SMCPSpacePacketEncoder: SMCP message does not fit in a Space Packet");
+		}
+		if (size < PrimaryHeaderLength + messageLength) {
+			throw SMCPException("buffer too small");
+		}
+		uint16_t sequenceCount = sequenceCounts[apid];
+		sequenceCounts[apid] = (sequenceCount + 1) & 0x3FFF;
+		size_t packetDataLength = messageLength - 1;
+		buffer[0] = (uint8_t) (((packetType & 0x01) << 4) | (apid >> 8));
+		buffer[1] = (uint8_t) apid;
+		buffer[2] = (uint8_t) (0xC0 | (sequenceCount >> 8));
+		buffer[3] = (uint8_t) sequenceCount;
+		buffer[4] = (uint8_t) (packetDataLength >> 8);
+		buffer[5] = (uint8_t) packetDataLength;
+		return PrimaryHeaderLength;
+	}
+
+public:
+	/** Returns the sequence count which will be used for the next packet of an APID. */
+	uint16_t getSequenceCount(uint16_t apid) const {
+		return sequenceCounts.at(apid);
+	}
+
+public:
+	/** Sets the sequence count which will be used for the next packet of an APID. */
+	void setSequenceCount(uint16_t apid, uint16_t sequenceCount) {
+		sequenceCounts.at(apid) = sequenceCount & 0x3FFF;
+	}
+};
+
+/** A read-only view of a CCSDS Space Packet which carries an SMCP message.
+ * The SMCP message in the Packet Data Field is decoded in place with
+ * SMCPCommandMessageView or SMCPTelemetryMessageView, so no byte is copied.
+ *
+ * Example usage:
+ * @code
+ * SMCPSpacePacketView packet;
+ * SMCPTelemetryMessageView telemetry;
+ * for (size_t offset = 0; packet.tryInterpretAsSpacePacket(buffer + offset, length - offset); offset +=
+ * 		packet.getLength()) {
+ * 	if (packet.tryGetTelemetryMessage(telemetry)) {
+ * 		...packet.getAPID(), telemetry.getAttributeID()...
+ * 	}
+ * }
+ * @endcode
+ */
+class SMCPSpacePacketView {
+public:
+	static const size_t PrimaryHeaderLength = SMCPSpacePacketEncoder::PrimaryHeaderLength;
+
+private:
+	const uint8_t* data;
+	size_t length;
+
+public:
+	/** Constructor. Constructs an empty view. */
+	SMCPSpacePacketView() :
+			data(NULL), length(0) {
+	}
+
+public:
+	/** Places the view on a byte array.
+	 * @param[in] data byte array which starts with a Space Packet.
+	 * @param[in] length length of the byte array.
+	 */
+	void interpretAsSpacePacket(const uint8_t* data, size_t length) {
+		if (!tryInterpretAsSpacePacket(data, length)) {
+			throw SMCPException("size error");
+		}
+	}
+
+public:
+	/** Places the view on a byte array without throwing an exception.
+	 * @param[in] data byte array which starts with a Space Packet.
+	 * @param[in] length length of the byte array.
+	 * @return false if the array does not contain a complete version-1 (000b) Space Packet
+	 * (the view is left empty in that case).
+	 */
+	bool tryInterpretAsSpacePacket(const uint8_t* data, size_t length) {
+		this->data = NULL;
+		this->length = 0;
+		if (length < PrimaryHeaderLength || (data[0] >> 5) != 0) {
+			return false;
+		}
+		size_t packetLength = PrimaryHeaderLength + (((size_t) data[4] << 8) | data[5]) + 1;
+		if (length < packetLength) {
+			return false;
+		}
+		this->data = data;
+		this->length = packetLength;
+		return true;
+	}
+
+public:
+	/** Returns true if the view has been placed on a packet. */
+	bool isValid() const {
+		return data != NULL;
+	}
+
+public:
+	/** Returns a pointer to the first byte of the packet. */
+	const uint8_t* getAsPointer() const {
+		return data;
+	}
+
+public:
+	/** Returns the length of the packet including the Primary Header. */
+	size_t getLength() const {
+		return length;
+	}
+
+public:
+	/** Returns Packet Type (see SMCPSpacePacketType). */
+	uint8_t getPacketType() const {
+		return (data[0] >> 4) & 0x01;
+	}
+
+public:
+	bool getSecondaryHeaderFlag() const {
+		return (data[0] & 0x08) != 0;
+	}
+
+public:
+	uint16_t getAPID() const {
+		return (uint16_t) (((data[0] & 0x07) << 8) | data[1]);
+	}
+
+public:
+	uint8_t getSequenceFlags() const {
+		return data[2] >> 6;
+	}
+
+public:
+	uint16_t getSequenceCount() const {
+		return (uint16_t) (((data[2] & 0x3F) << 8) | data[3]);
+	}
+
+public:
+	/** Returns a pointer to the Packet Data Field. */
+	const uint8_t* getPacketDataAsPointer() const {
+		return data + PrimaryHeaderLength;
+	}
+
+public:
+	/** Returns the length of the Packet Data Field (Packet Data Length + 1). */
+	size_t getPacketDataLength() const {
+		return length - PrimaryHeaderLength;
+	}
+
+public:
+	/** Places a view on the command message in the Packet Data Field.
+	 * @param[out] message view to be placed.
+	 * @param[in] secondaryHeaderLength length of the Secondary Header preceding the SMCP message.
+	 * @return false if the Packet Data Field does not contain a command message.
+	 */
+	bool tryGetCommandMessage(SMCPCommandMessageView& message, size_t secondaryHeaderLength = 0) const {
+		if (data == NULL || getPacketDataLength() < secondaryHeaderLength) {
+			return false;
+		}
+		return message.tryInterpretAsCommandMessage(getPacketDataAsPointer() + secondaryHeaderLength,
+				getPacketDataLength() - secondaryHeaderLength);
+	}
+
+public:
+	/** Places a view on the telemetry message in the Packet Data Field.
+	 * @param[out] message view to be placed.
+	 * @param[in] secondaryHeaderLength length of the Secondary Header preceding the SMCP message.
+	 * @return false if the Packet Data Field does not contain a telemetry message.
+	 */
+	bool tryGetTelemetryMessage(SMCPTelemetryMessageView& message, size_t secondaryHeaderLength = 0) const {
+		if (data == NULL || getPacketDataLength() < secondaryHeaderLength) {
+			return false;
+		}
+		return message.tryInterpretAsTelemetryMessage(getPacketDataAsPointer() + secondaryHeaderLength,
+				getPacketDataLength() - secondaryHeaderLength);
+	}
+};
+
+#endif /* SMCPSPACEPACKET_HH_ */
@@ -0,0 +1,760 @@
+/*
+ * SMCPStagePipeline.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPSTAGEPIPELINE_HH_
+#define SMCPSTAGEPIPELINE_HH_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPFormatter.hh"
+#include "SMCPException.hh"
+
+/** A class which collects overflow policies of SMCPBoundedQueue. */
+class SMCPQueuePolicy {
+public:
+	enum {
+		/** The producer waits until the consumer makes room (back-pressure). */
+		Block,
+		/** The incoming item is discarded. */
+		DropNewest,
+		/** The oldest queued item is discarded to make room. */
+		DropOldest,
+		/** Items are appended to a spill file and read back in order when the queue drains. */
+		SpillToDisk
+	};
+
+public:
+	static const char* getName(int policy) {
+		static const char* names[] = { "Block", "DropNewest", "DropOldest", "SpillToDisk" };
+		return (0 <= policy && policy <= SpillToDisk) ? names[policy] : "Undefined";
+	}
+};
+
+/** Limits and overflow policy of an SMCPBoundedQueue. */
+class SMCPQueueConfiguration {
+public:
+	size_t maximumItems;
+	size_t maximumBytes;
+	int policy;
+	/** Directory of the spill file; empty to use tmpfile(). */
+	std::string spillDirectory;
+
+public:
+	SMCPQueueConfiguration(size_t maximumItems = 1024, size_t maximumBytes = 16 * 1024 * 1024,
+			int policy = SMCPQueuePolicy::Block, std::string spillDirectory = "") :
+			maximumItems(maximumItems), maximumBytes(maximumBytes), policy(policy), spillDirectory(spillDirectory) {
+	}
+};
+
+/** A serialized message (or chunk of a byte stream) passed between pipeline stages. */
+class SMCPPipelineItem {
+public:
+	std::vector<uint8_t> bytes;
+	/** Time stamp given by the producer (e.g. receive time). */
+	uint64_t time;
+};
+
+/** Queue counters of one stage of SMCPStagePipeline. */
+class SMCPStageMetrics {
+public:
+	std::string name;
+	int policy;
+	/** Time of the snapshot in nanoseconds (monotonic clock). */
+	uint64_t time;
+	/** Items currently in memory. */
+	size_t queueItems;
+	/** Bytes currently in memory. */
+	size_t queueBytes;
+	/** Largest number of items held in memory. */
+	size_t maximumQueueItems;
+	/** Items currently in the spill file. */
+	uint64_t spilledItems;
+	/** Items pushed to the queue, including those later dropped by the overflow policy.
+	 * Once the pipeline has stopped, nReceived == nProcessed + nDropped.
+	 */
+	uint64_t nReceived;
+	/** Items passed to the stage. */
+	uint64_t nProcessed;
+	/** Items discarded by the overflow policy: rejected incoming items (DropNewest, or a
+	 * failed spill write), or queued items evicted to make room (DropOldest).
+	 */
+	uint64_t nDropped;
+	/** Items written to the spill file. */
+	uint64_t nSpilled;
+	/** Exceptions thrown by the stage. */
+	uint64_t nErrors;
+	/** Total time producers waited for room in the queue (ns). */
+	uint64_t stallTime;
+	/** Total time the stage spent processing items (ns). */
+	uint64_t busyTime;
+
+public:
+	/** Returns items processed per second since a previous snapshot. */
+	double getThroughput(const SMCPStageMetrics& previous) const {
+		if (time <= previous.time) {
+			return 0;
+		}
+		return (nProcessed - previous.nProcessed) * 1e9 / (time - previous.time);
+	}
+
+public:
+	/** Returns the fraction of time the stage was processing since a previous snapshot. */
+	double getUtilization(const SMCPStageMetrics& previous) const {
+		if (time <= previous.time) {
+			return 0;
+		}
+		return (double) (busyTime - previous.busyTime) / (time - previous.time);
+	}
+
+public:
+	/** Appends a one-line summary. */
+	void appendString(std::string& out) const {
+		char line[512];
+		char* p = line;
+		p = SMCPFormatter::writeString(p, name.c_str());
+		p = SMCPFormatter::writeLiteral(p, " policy=");
+		p = SMCPFormatter::writeString(p, SMCPQueuePolicy::getName(policy));
+		p = SMCPFormatter::writeLiteral(p, " depth=");
+		p = SMCPFormatter::writeDecimal(p, queueItems);
+		p = SMCPFormatter::writeLiteral(p, " bytes=");
+		p = SMCPFormatter::writeDecimal(p, queueBytes);
+		p = SMCPFormatter::writeLiteral(p, " maxDepth=");
+		p = SMCPFormatter::writeDecimal(p, maximumQueueItems);
+		p = SMCPFormatter::writeLiteral(p, " spilled=");
+		p = SMCPFormatter::writeDecimal(p, spilledItems);
+		p = SMCPFormatter::writeLiteral(p, " received=");
+		p = SMCPFormatter::writeDecimal(p, nReceived);
+		p = SMCPFormatter::writeLiteral(p, " processed=");
+		p = SMCPFormatter::writeDecimal(p, nProcessed);
+		p = SMCPFormatter::writeLiteral(p, " dropped=");
+		p = SMCPFormatter::writeDecimal(p, nDropped);
+		p = SMCPFormatter::writeLiteral(p, " errors=");
+		p = SMCPFormatter::writeDecimal(p, nErrors);
+		p = SMCPFormatter::writeLiteral(p, " stall_ms=");
+		p = SMCPFormatter::writeDecimal(p, stallTime / 1000000);
+		p = SMCPFormatter::writeLiteral(p, " busy_ms=");
+		p = SMCPFormatter::writeDecimal(p, busyTime / 1000000);
+		*p++ = '\n';
+		out.append(line, p - line);
+	}
+};
+
+/** A bounded multi-producer/single-consumer queue of SMCPPipelineItem.
+ * The queue is full when it holds maximumItems items or when an item would
+ * exceed maximumBytes (a single item larger than maximumBytes is still
+ * accepted into an empty queue). Items are recycled, so a queue in steady
+ * state does not allocate memory.
+ */
+class SMCPBoundedQueue {
+private:
+	SMCPQueueConfiguration configuration;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque<SMCPPipelineItem*> items;
+	std::vector<SMCPPipelineItem*> pool;
+	size_t nBytes;
+	size_t nProducers;
+
+private:
+	FILE* spillFile;
+	uint64_t spillWritePosition;
+	uint64_t spillReadPosition;
+	uint64_t spilledItems;
+
+private:
+	size_t maximumQueueItems;
+	uint64_t nReceived;
+	uint64_t nDropped;
+	uint64_t nSpilled;
+	uint64_t stallTime;
+
+public:
+	/** Constructor.
+	 * @param[in] configuration limits and overflow policy.
+	 * @param[in] nProducers number of producers; the queue is closed when all of them have called close().
+	 */
+	SMCPBoundedQueue(SMCPQueueConfiguration configuration, size_t nProducers = 1) :
+			configuration(configuration), nBytes(0), nProducers(nProducers), spillFile(NULL), spillWritePosition(0),
+			spillReadPosition(0), spilledItems(0), maximumQueueItems(0), nReceived(0), nDropped(0), nSpilled(0),
+			stallTime(0) {
+		if (configuration.maximumItems == 0) {
+			throw SMCPException("SMCPBoundedQueue: maximumItems should be larger than 0");
+		}
+		if (configuration.policy < SMCPQueuePolicy::Block || SMCPQueuePolicy::SpillToDisk < configuration.policy) {
+			throw SMCPException("SMCPBoundedQueue: undefined policy");
+		}
+	}
+
+public:
+	~SMCPBoundedQueue() {
+		for (size_t i = 0; i < items.size(); i++) {
+			delete items[i];
+		}
+		for (size_t i = 0; i < pool.size(); i++) {
+			delete pool[i];
+		}
+		if (spillFile != NULL) {
+			fclose(spillFile);
+		}
+	}
+
+public:
+	/** Adds a producer (call before the producer starts pushing). */
+	void addProducer() {
+		std::lock_guard<std::mutex> lock(mutex);
+		nProducers++;
+	}
+
+public:
+	/** Queues a copy of data, applying the overflow policy when the queue is full.
+	 * @return false if the item was discarded.
+	 */
+	bool push(const uint8_t* data, size_t length, uint64_t time) {
+		std::unique_lock<std::mutex> lock(mutex);
+		nReceived++;
+		if (spilledItems != 0) {
+			//keep FIFO order: while the spill file is not empty, new items go after it
+			return spill(data, length, time);
+		}
+		if (isFull(length)) {
+			switch (configuration.policy) {
+			case SMCPQueuePolicy::Block: {
+				uint64_t start = getCurrentTime();
+				do {
+					notFull.wait(lock);
+				} while (isFull(length));
+				stallTime += getCurrentTime() - start;
+				break;
+			}
+			case SMCPQueuePolicy::DropNewest:
+				nDropped++;
+				return false;
+			case SMCPQueuePolicy::DropOldest:
+				while (!items.empty() && isFull(length)) {
+					SMCPPipelineItem* oldest = items.front();
+					items.pop_front();
+					nBytes -= oldest->bytes.size();
+					pool.push_back(oldest);
+					nDropped++;
+				}
+				break;
+			case SMCPQueuePolicy::SpillToDisk:
+				return spill(data, length, time);
+			}
+		}
+		SMCPPipelineItem* item = allocate();
+		item->bytes.assign(data, data + length);
+		item->time = time;
+		enqueue(item);
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+
+public:
+	/** Takes the oldest item, waiting while the queue is empty.
+	 * @param[in,out] item the item returned by the previous call (recycled; may be NULL),
+	 * replaced by the next item.
+	 * @return false when the queue is closed and drained.
+	 */
+	bool pop(SMCPPipelineItem*& item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (item != NULL) {
+			pool.push_back(item);
+			item = NULL;
+		}
+		while (items.empty()) {
+			if (spilledItems != 0) {
+				refill();
+				continue;
+			}
+			if (nProducers == 0) {
+				return false;
+			}
+			notEmpty.wait(lock);
+		}
+		item = items.front();
+		items.pop_front();
+		nBytes -= item->bytes.size();
+		lock.unlock();
+		notFull.notify_all();
+		return true;
+	}
+
+public:
+	/** Tells that one producer will push no more items. */
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (nProducers != 0) {
+				nProducers--;
+			}
+		}
+		notEmpty.notify_all();
+	}
+
+public:
+	/** Fills the queue part of the metrics. */
+	void getMetrics(SMCPStageMetrics& metrics) {
+		std::lock_guard<std::mutex> lock(mutex);
+		metrics.policy = configuration.policy;
+		metrics.queueItems = items.size();
+		metrics.queueBytes = nBytes;
+		metrics.maximumQueueItems = maximumQueueItems;
+		metrics.spilledItems = spilledItems;
+		metrics.nReceived = nReceived;
+		metrics.nDropped = nDropped;
+		metrics.nSpilled = nSpilled;
+		metrics.stallTime = stallTime;
+	}
+
+public:
+	/** Returns current time in nanoseconds (monotonic clock). */
+	static uint64_t getCurrentTime() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	bool isFull(size_t length) const {
+		return configuration.maximumItems <= items.size()
+				|| (!items.empty() && configuration.maximumBytes < nBytes + length);
+	}
+
+private:
+	SMCPPipelineItem* allocate() {
+		if (pool.empty()) {
+			return new SMCPPipelineItem();
+		}
+		SMCPPipelineItem* item = pool.back();
+		pool.pop_back();
+		return item;
+	}
+
+private:
+	void enqueue(SMCPPipelineItem* item) {
+		items.push_back(item);
+		nBytes += item->bytes.size();
+		if (maximumQueueItems < items.size()) {
+			maximumQueueItems = items.size();
+		}
+	}
+
+private:
+	/** Appends a record [length:4][time:8][data] to the spill file. Called with the lock held. */
+	bool spill(const uint8_t* data, size_t length, uint64_t time) {
+		if (spillFile == NULL) {
+			spillFile = openSpillFile();
+			if (spillFile == NULL) {
+				nDropped++;
+				return false;
+			}
+		}
+		uint32_t length32 = (uint32_t) length;
+		if (fseek(spillFile, (long) spillWritePosition, SEEK_SET) != 0 || fwrite(&length32, 4, 1, spillFile) != 1
+				|| fwrite(&time, 8, 1, spillFile) != 1 || (length != 0 && fwrite(data, length, 1, spillFile) != 1)) {
+			nDropped++;
+			return false;
+		}
+		spillWritePosition += 12 + length;
+		spilledItems++;
+		nSpilled++;
+		return true;
+	}
+
+private:
+	/** Moves spilled records back to memory, up to the queue limits. Called with the lock held. */
+	void refill() {
+		fflush(spillFile);
+		if (fseek(spillFile, (long) spillReadPosition, SEEK_SET) != 0) {
+			throw SMCPException("SMCPBoundedQueue: spill file read error");
+		}
+		while (spilledItems != 0) {
+			uint32_t length;
+			uint64_t time;
+			if (fread(&length, 4, 1, spillFile) != 1 || fread(&time, 8, 1, spillFile) != 1) {
+				throw SMCPException("SMCPBoundedQueue: spill file read error");
+			}
+			if (!items.empty() && isFull(length)) {
+				fseek(spillFile, (long) spillReadPosition, SEEK_SET);
+				break;
+			}
+			SMCPPipelineItem* item = allocate();
+			item->bytes.resize(length);
+			if (length != 0 && fread(&(item->bytes[0]), length, 1, spillFile) != 1) {
+				pool.push_back(item);
+				throw SMCPException("SMCPBoundedQueue: spill file read error");
+			}
+			item->time = time;
+			enqueue(item);
+			spillReadPosition += 12 + length;
+			spilledItems--;
+		}
+		if (spilledItems == 0) {
+			//reuse the file from the beginning
+			spillReadPosition = 0;
+			spillWritePosition = 0;
+		}
+	}
+
+private:
+	FILE* openSpillFile() {
+		if (configuration.spillDirectory.empty()) {
+			return tmpfile();
+		}
+		char suffix[32];
+		char* p = SMCPFormatter::writeHex(suffix, (uint64_t) (uintptr_t) this, 16);
+		*p = '\0';
+		std::string path = configuration.spillDirectory + "/smcp_spill_" + suffix + ".bin";
+		FILE* file = fopen(path.c_str(), "w+b");
+		if (file != NULL) {
+			remove(path.c_str()); //deleted when closed
+		}
+		return file;
+	}
+};
+
+/** The outputs of a stage of SMCPStagePipeline. */
+class SMCPPipelineOutput {
+private:
+	std::vector<SMCPBoundedQueue*> queues;
+
+public:
+	void addQueue(SMCPBoundedQueue* queue) {
+		queues.push_back(queue);
+	}
+
+public:
+	/** Returns the number of downstream stages. */
+	size_t getNPorts() const {
+		return queues.size();
+	}
+
+public:
+	/** Sends data to all downstream stages. Blocks if a Block-policy queue is full.
+	 * @return false if any downstream queue discarded the data.
+	 */
+	bool emit(const uint8_t* data, size_t length, uint64_t time) {
+		bool accepted = true;
+		for (size_t i = 0; i < queues.size(); i++) {
+			accepted = queues[i]->push(data, length, time) && accepted;
+		}
+		return accepted;
+	}
+
+public:
+	/** Sends data to one downstream stage (in the order of SMCPStagePipeline::connect()).
+	 * @return false if the queue discarded the data.
+	 */
+	bool emit(size_t port, const uint8_t* data, size_t length, uint64_t time) {
+		return queues.at(port)->push(data, length, time);
+	}
+};
+
+/** An interface of a processing stage of SMCPStagePipeline.
+ * A stage runs on its own thread and receives the items of its input queue in order.
+ */
+class SMCPPipelineStage {
+public:
+	virtual ~SMCPPipelineStage() {
+	}
+
+public:
+	/** Invoked for each input item.
+	 * @param[in] item input (valid only during the call).
+	 * @param[in] output downstream stages.
+	 */
+	virtual void process(const SMCPPipelineItem& item, SMCPPipelineOutput& output) = 0;
+
+public:
+	/** Invoked after the last item, before the downstream queues are closed. */
+	virtual void finish(SMCPPipelineOutput&) {
+	}
+};
+
+/** A stage which calls a function for each item (e.g. a lambda acting as decoder, filter, or sink). */
+class SMCPFunctionStage: public SMCPPipelineStage {
+private:
+	std::function<void(const SMCPPipelineItem&, SMCPPipelineOutput&)> function;
+
+public:
+	SMCPFunctionStage(std::function<void(const SMCPPipelineItem&, SMCPPipelineOutput&)> function) :
+			function(function) {
+	}
+
+public:
+	void process(const SMCPPipelineItem& item, SMCPPipelineOutput& output) {
+		function(item, output);
+	}
+};
+
+/** A stage which splits chunks of a telemetry byte stream into telemetry messages.
+ * A message split across chunks is reassembled. When a Message Length
+ * shorter than the minimum message is found, the rest of the buffered
+ * stream is discarded and counted.
+ */
+class SMCPTelemetryFramerStage: public SMCPPipelineStage {
+private:
+	std::vector<uint8_t> remainder;
+	std::atomic<uint64_t> nDiscardedBytes;
+
+public:
+	SMCPTelemetryFramerStage() :
+			nDiscardedBytes(0) {
+	}
+
+public:
+	void process(const SMCPPipelineItem& item, SMCPPipelineOutput& output) {
+		const uint8_t* data = item.bytes.empty() ? NULL : &(item.bytes[0]);
+		size_t length = item.bytes.size();
+		if (!remainder.empty()) {
+			remainder.insert(remainder.end(), data, data + length);
+			size_t consumed = split(&(remainder[0]), remainder.size(), item.time, output);
+			remainder.erase(remainder.begin(), remainder.begin() + consumed);
+		} else if (length != 0) {
+			size_t consumed = split(data, length, item.time, output);
+			remainder.assign(data + consumed, data + length);
+		}
+	}
+
+public:
+	/** Returns the number of bytes discarded because of invalid Message Length. */
+	uint64_t getNDiscardedBytes() const {
+		return nDiscardedBytes.load(std::memory_order_relaxed);
+	}
+
+private:
+	size_t split(const uint8_t* data, size_t length, uint64_t time, SMCPPipelineOutput& output) {
+		size_t offset = 0;
+		while (SMCPTelemetryMessageView::HeaderLength <= length - offset) {
+			size_t messageLength = SMCPTelemetryMessageView::getMessageLength(data + offset);
+			if (messageLength < SMCPTelemetryMessageView::MinimumMessageLength) {
+				nDiscardedBytes.store(nDiscardedBytes.load(std::memory_order_relaxed) + length - offset,
+						std::memory_order_relaxed);
+				return length;
+			}
+			if (length - offset < messageLength) {
+				break;
+			}
+			output.emit(data + offset, messageLength, time);
+			offset += messageLength;
+		}
+		return offset;
+	}
+};
+
+/** A pipeline of processing stages connected by bounded queues.
+ *
+ * Each stage has an input queue (see SMCPQueueConfiguration and
+ * SMCPQueuePolicy) and runs on its own thread. Items enter the pipeline with
+ * push() and flow along the connections, which should form a directed
+ * acyclic graph (e.g. framer -> decoder -> filter -> router -> sinks). With the
+ * Block policy, a slow stage stalls its producers and the back-pressure
+ * propagates upstream; with the drop policies data is discarded and
+ * counted; with SpillToDisk the backlog goes to a file instead of memory.
+ * getMetrics() reports queue depth, drops, stall and busy time per stage.
+ *
+ * Stages are not owned by the pipeline.
+ *
+ * Example usage:
+ * @code
+ * SMCPTelemetryFramerStage framer;
+ * SMCPFunctionStage archive([&](const SMCPPipelineItem& item, SMCPPipelineOutput&) {
+ * 	...write item.bytes...
+ * });
+ * SMCPStagePipeline pipeline;
+ * size_t f = pipeline.addStage("framer", &framer);
+ * size_t a = pipeline.addStage("archive", &archive,
+ * 		SMCPQueueConfiguration(100000, 64 * 1024 * 1024, SMCPQueuePolicy::SpillToDisk, "/var/tmp"));
+ * pipeline.connect(f, a);
+ * pipeline.start();
+ * pipeline.push(f, datagram, length, receiveTime);
+ * ...
+ * std::cout << pipeline.toString();
+ * pipeline.stop();
+ * @endcode
+ */
+class SMCPStagePipeline {
+private:
+	class StageEntry {
+	public:
+		std::string name;
+		SMCPPipelineStage* stage;
+		SMCPBoundedQueue* queue;
+		SMCPPipelineOutput output;
+		std::vector<size_t> downstream;
+		std::thread thread;
+		std::atomic<uint64_t> nProcessed;
+		std::atomic<uint64_t> nErrors;
+		std::atomic<uint64_t> busyTime;
+
+	public:
+		StageEntry() :
+				stage(NULL), queue(NULL), nProcessed(0), nErrors(0), busyTime(0) {
+		}
+	};
+
+private:
+	std::vector<StageEntry*> stages;
+	bool started;
+	bool stopped;
+
+public:
+	SMCPStagePipeline() :
+			started(false), stopped(false) {
+	}
+
+public:
+	/** Destructor. Stops the pipeline if running. */
+	~SMCPStagePipeline() {
+		stop();
+		for (size_t i = 0; i < stages.size(); i++) {
+			delete stages[i]->queue;
+			delete stages[i];
+		}
+	}
+
+public:
+	/** Adds a stage.
+	 * @param[in] name name shown in metrics.
+	 * @param[in] stage processing stage (not owned).
+	 * @param[in] configuration input queue limits and overflow policy.
+	 * @return index of the stage.
+	 */
+	size_t addStage(std::string name, SMCPPipelineStage* stage,
+			SMCPQueueConfiguration configuration = SMCPQueueConfiguration()) {
+		if (started) {
+			throw SMCPException("SMCPStagePipeline: stages should be added before start()");
+		}
+		StageEntry* entry = new StageEntry();
+		entry->name = name;
+		entry->stage = stage;
+		entry->queue = new SMCPBoundedQueue(configuration, 1); //the external producer (push())
+		stages.push_back(entry);
+		return stages.size() - 1;
+	}
+
+public:
+	/** Connects the output of a stage to the input of another.
+	 * Ports of SMCPPipelineOutput are numbered in the order of connect() calls.
+	 */
+	void connect(size_t from, size_t to) {
+		if (started) {
+			throw SMCPException("SMCPStagePipeline: stages should be connected before start()");
+		}
+		if (stages.size() <= from || stages.size() <= to || from == to) {
+			throw SMCPException("SMCPStagePipeline: invalid connection");
+		}
+		stages[from]->output.addQueue(stages[to]->queue);
+		stages[from]->downstream.push_back(to);
+		stages[to]->queue->addProducer();
+	}
+
+public:
+	/** Starts one thread per stage. */
+	void start() {
+		if (started) {
+			throw SMCPException("SMCPStagePipeline: already started");
+		}
+		started = true;
+		for (size_t i = 0; i < stages.size(); i++) {
+			stages[i]->thread = std::thread(&SMCPStagePipeline::run, this, i);
+		}
+	}
+
+public:
+	/** Feeds data to a stage, applying the overflow policy of its queue.
+	 * @return false if the data was discarded.
+	 */
+	bool push(size_t stage, const uint8_t* data, size_t length, uint64_t time) {
+		return stages.at(stage)->queue->push(data, length, time);
+	}
+
+public:
+	/** Ends the input, lets all stages drain their queues in order, and joins the threads. */
+	void stop() {
+		if (!started || stopped) {
+			return;
+		}
+		stopped = true;
+		for (size_t i = 0; i < stages.size(); i++) {
+			stages[i]->queue->close();
+		}
+		for (size_t i = 0; i < stages.size(); i++) {
+			stages[i]->thread.join();
+		}
+	}
+
+public:
+	size_t getNStages() const {
+		return stages.size();
+	}
+
+public:
+	/** Returns the metrics of a stage. */
+	SMCPStageMetrics getMetrics(size_t stage) {
+		StageEntry* entry = stages.at(stage);
+		SMCPStageMetrics metrics;
+		metrics.name = entry->name;
+		metrics.time = SMCPBoundedQueue::getCurrentTime();
+		entry->queue->getMetrics(metrics);
+		metrics.nProcessed = entry->nProcessed.load(std::memory_order_relaxed);
+		metrics.nErrors = entry->nErrors.load(std::memory_order_relaxed);
+		metrics.busyTime = entry->busyTime.load(std::memory_order_relaxed);
+		return metrics;
+	}
+
+public:
+	/** Returns one line of metrics per stage. */
+	std::string toString() {
+		std::string result;
+		for (size_t i = 0; i < stages.size(); i++) {
+			getMetrics(i).appendString(result);
+		}
+		return result;
+	}
+
+private:
+	void run(size_t index) {
+		StageEntry& entry = *stages[index];
+		SMCPPipelineItem* item = NULL;
+		while (entry.queue->pop(item)) {
+			uint64_t start = SMCPBoundedQueue::getCurrentTime();
+			try {
+				entry.stage->process(*item, entry.output);
+			} catch (std::exception&) {
+				entry.nErrors.store(entry.nErrors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+			entry.busyTime.store(
+					entry.busyTime.load(std::memory_order_relaxed) + SMCPBoundedQueue::getCurrentTime() - start,
+					std::memory_order_relaxed);
+			entry.nProcessed.store(entry.nProcessed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		try {
+			entry.stage->finish(entry.output);
+		} catch (std::exception&) {
+			entry.nErrors.store(entry.nErrors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+		for (size_t i = 0; i < entry.downstream.size(); i++) {
+			stages[entry.downstream[i]]->queue->close();
+		}
+	}
+};
+
+#endif /* SMCPSTAGEPIPELINE_HH_ */
@@ -0,0 +1,304 @@
+/*
+ * SMCPTelemetryAggregator.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYAGGREGATOR_HH_
+#define SMCPTELEMETRYAGGREGATOR_HH_
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPAttributeSchema.hh"
+#include "SMCPException.hh"
+
+/** A summary record of one attribute over one time bucket.
+ * Emitted by SMCPTelemetryAggregator when a bucket is closed.
+ * For array-valued attributes, minimum/maximum/mean are taken over all
+ * elements of all samples in the bucket, and last is the last element
+ * of the last sample.
+ */
+class SMCPTelemetrySummary {
+public:
+	uint64_t bucketStartTime;
+	uint64_t bucketWidth;
+	uint8_t lowerFOID;
+	uint16_t attributeID;
+	/** Number of telemetry messages aggregated. */
+	uint32_t nSamples;
+	/** Number of elements aggregated (equals nSamples for scalar attributes). */
+	uint64_t nElements;
+	double minimum;
+	double maximum;
+	double mean;
+	double last;
+};
+
+/** An interface which receives summary records from SMCPTelemetryAggregator.
+ */
+class SMCPTelemetrySummaryListener {
+public:
+	virtual ~SMCPTelemetrySummaryListener() {
+	}
+
+public:
+	/** Invoked once per attribute when a bucket is closed.
+	 * @param[in] summary summary record (valid only during the call).
+	 */
+	virtual void summaryClosed(const SMCPTelemetrySummary& summary) = 0;
+};
+
+/** A class which downsamples Value Telemetry into per-bucket
+ * minimum/maximum/mean/last summaries while the stream is received.
+ *
+ * Attribute Values are decoded according to an SMCPAttributeSchema; attributes
+ * which are not in the schema, or defined as SMCPAttributeType::Raw, are ignored.
+ * Buckets are aligned to multiples of the bucket width. A bucket is closed,
+ * and its summaries are passed to the listener, when a sample belonging to a
+ * later bucket arrives or when flush() is called. Samples older than the
+ * current bucket are counted and dropped. The schema should be complete before
+ * the first sample is added; lookups are cached per (lowerFOID, AttributeID).
+ *
+ * Example usage:
+ * @code
+ * SMCPTelemetryAggregator aggregator(schema, 60 * 1000000000ULL, &listener); //1-min buckets
+ * aggregator.add(valueTelemetryMessage, receiveTime);
+ * ...
+ * aggregator.flush();
+ * @endcode
+ */
+class SMCPTelemetryAggregator {
+public:
+	/** Number of elements decoded and reduced at a time. */
+	static const size_t ChunkSize = 256;
+
+private:
+	class Accumulator {
+	public:
+		const SMCPAttributeDefinition* definition;
+		uint32_t nSamples;
+		uint64_t nElements;
+		double minimum;
+		double maximum;
+		double sum;
+		double last;
+	};
+
+private:
+	SMCPAttributeSchema& schema;
+	uint64_t bucketWidth;
+	SMCPTelemetrySummaryListener* listener;
+	uint64_t bucketStartTime;
+	bool bucketOpen;
+	std::map<uint32_t, size_t> indices;
+	std::vector<Accumulator> accumulators;
+	std::vector<size_t> activeAccumulators;
+	uint64_t nLateSamples;
+	uint64_t nIgnoredSamples;
+
+public:
+	/** Constructor.
+	 * @param[in] schema attribute schema used to decode Attribute Values (referenced, not copied).
+	 * @param[in] bucketWidth width of a bucket in the unit of the time stamps given to add().
+	 * @param[in] listener receiver of summary records.
+	 */
+	SMCPTelemetryAggregator(SMCPAttributeSchema& schema, uint64_t bucketWidth, SMCPTelemetrySummaryListener* listener) :
+			schema(schema), bucketWidth(bucketWidth), listener(listener), bucketStartTime(0), bucketOpen(false), //
+			nLateSamples(0), nIgnoredSamples(0) {
+		if (bucketWidth == 0) {
+			throw SMCPException("SMCPTelemetryAggregator: bucket width should be larger than 0");
+		}
+	}
+
+public:
+	/** Adds a sample.
+	 * @param[in] lowerFOID Lower FOID of the telemetry.
+	 * @param[in] attributeID Attribute ID of the telemetry.
+	 * @param[in] value pointer to the Attribute Value bytes.
+	 * @param[in] length length of the Attribute Value.
+	 * @param[in] time time stamp of the sample.
+	 * @return true if the sample was aggregated.
+	 */
+	bool add(uint8_t lowerFOID, uint16_t attributeID, const uint8_t* value, size_t length, uint64_t time) {
+		uint64_t sampleBucketStartTime = time - time % bucketWidth;
+		if (!bucketOpen) {
+			bucketStartTime = sampleBucketStartTime;
+			bucketOpen = true;
+		} else if (sampleBucketStartTime < bucketStartTime) {
+			nLateSamples++;
+			return false;
+		} else if (bucketStartTime < sampleBucketStartTime) {
+			closeBucket();
+			bucketStartTime = sampleBucketStartTime;
+			bucketOpen = true;
+		}
+
+		Accumulator* accumulator = findAccumulator(lowerFOID, attributeID);
+		if (accumulator == NULL) {
+			nIgnoredSamples++;
+			return false;
+		}
+		size_t nElements = accumulator->definition->getNumberOfElements(length);
+		if (nElements == 0) {
+			nIgnoredSamples++;
+			return false;
+		}
+		if (accumulator->nSamples == 0) {
+			activeAccumulators.push_back(accumulator - &accumulators[0]);
+		}
+		reduce(*accumulator, value, nElements);
+		accumulator->nSamples++;
+		return true;
+	}
+
+public:
+	/** Adds a Value Telemetry message. Messages of other telemetry types are ignored.
+	 * @param[in] message telemetry message.
+	 * @param[in] time time stamp of the sample.
+	 * @return true if the sample was aggregated.
+	 */
+	bool add(SMCPTelemetryMessage& message, uint64_t time) {
+		SMCPTelemetryMessageHeader* header = message.getMessageHeader();
+		if (header->getTelemetryTypeID().to_ulong() != SMCPTelemetryTypeID::ValueTelemetry) {
+			return false;
+		}
+		SMCPTelemetryMessageData* data = message.getMessageData();
+		return add(header->getLowerFOID(), data->getAttributeID(), data->getAttributeValuesAsPointer(),
+				data->getAttributeValuesLength(), time);
+	}
+
+public:
+	/** Closes the current bucket and emits its summaries. */
+	void flush() {
+		if (bucketOpen) {
+			closeBucket();
+			bucketOpen = false;
+		}
+	}
+
+public:
+	uint64_t getBucketWidth() const {
+		return bucketWidth;
+	}
+
+public:
+	/** Returns the start time of the bucket currently being filled. */
+	uint64_t getBucketStartTime() const {
+		return bucketStartTime;
+	}
+
+public:
+	/** Returns the number of samples dropped because they belonged to an already closed bucket. */
+	uint64_t getNLateSamples() const {
+		return nLateSamples;
+	}
+
+public:
+	/** Returns the number of samples ignored because they are not described by the schema. */
+	uint64_t getNIgnoredSamples() const {
+		return nIgnoredSamples;
+	}
+
+private:
+	Accumulator* findAccumulator(uint8_t lowerFOID, uint16_t attributeID) {
+		uint32_t key = SMCPAttributeSchema::toKey(lowerFOID, attributeID);
+		std::map<uint32_t, size_t>::iterator it = indices.find(key);
+		if (it != indices.end()) {
+			return (it->second == NotDefined) ? NULL : &accumulators[it->second];
+		}
+		const SMCPAttributeDefinition* definition = schema.find(lowerFOID, attributeID);
+		if (definition == NULL || definition->type == SMCPAttributeType::Raw) {
+			indices[key] = NotDefined;
+			return NULL;
+		}
+		Accumulator accumulator;
+		accumulator.definition = definition;
+		accumulator.nSamples = 0;
+		accumulators.push_back(accumulator);
+		indices[key] = accumulators.size() - 1;
+		return &accumulators.back();
+	}
+
+private:
+	static const size_t NotDefined = (size_t) -1;
+
+private:
+	void reduce(Accumulator& accumulator, const uint8_t* value, size_t nElements) {
+		const SMCPAttributeDefinition* definition = accumulator.definition;
+		size_t elementSize = definition->getElementSize();
+		double elements[ChunkSize];
+		if (accumulator.nSamples == 0) {
+			definition->decode(value, 1, elements);
+			accumulator.minimum = elements[0];
+			accumulator.maximum = elements[0];
+			accumulator.sum = 0;
+			accumulator.nElements = 0;
+		}
+
+		//four independent lanes let the compiler vectorize the reduction
+		//without reassociating floating-point additions
+		double minimum[4], maximum[4], sum[4];
+		for (size_t k = 0; k < 4; k++) {
+			minimum[k] = accumulator.minimum;
+			maximum[k] = accumulator.maximum;
+			sum[k] = 0;
+		}
+		size_t remaining = nElements;
+		while (remaining != 0) {
+			size_t n = (remaining < ChunkSize) ? remaining : ChunkSize;
+			definition->decode(value, n, elements);
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				for (size_t k = 0; k < 4; k++) {
+					double x = elements[i + k];
+					minimum[k] = (x < minimum[k]) ? x : minimum[k];
+					maximum[k] = (maximum[k] < x) ? x : maximum[k];
+					sum[k] += x;
+				}
+			}
+			for (; i < n; i++) {
+				double x = elements[i];
+				minimum[0] = (x < minimum[0]) ? x : minimum[0];
+				maximum[0] = (maximum[0] < x) ? x : maximum[0];
+				sum[0] += x;
+			}
+			accumulator.last = elements[n - 1];
+			value += n * elementSize;
+			remaining -= n;
+		}
+		for (size_t k = 0; k < 4; k++) {
+			accumulator.minimum = (minimum[k] < accumulator.minimum) ? minimum[k] : accumulator.minimum;
+			accumulator.maximum = (accumulator.maximum < maximum[k]) ? maximum[k] : accumulator.maximum;
+		}
+		accumulator.sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+		accumulator.nElements += nElements;
+	}
+
+private:
+	void closeBucket() {
+		SMCPTelemetrySummary summary;
+		summary.bucketStartTime = bucketStartTime;
+		summary.bucketWidth = bucketWidth;
+		for (size_t i = 0; i < activeAccumulators.size(); i++) {
+			Accumulator& accumulator = accumulators[activeAccumulators[i]];
+			if (listener != NULL) {
+				summary.lowerFOID = accumulator.definition->lowerFOID;
+				summary.attributeID = accumulator.definition->attributeID;
+				summary.nSamples = accumulator.nSamples;
+				summary.nElements = accumulator.nElements;
+				summary.minimum = accumulator.minimum;
+				summary.maximum = accumulator.maximum;
+				summary.mean = accumulator.sum / accumulator.nElements;
+				summary.last = accumulator.last;
+				listener->summaryClosed(summary);
+			}
+			accumulator.nSamples = 0;
+		}
+		activeAccumulators.clear();
+	}
+};
+
+#endif /* SMCPTELEMETRYAGGREGATOR_HH_ */
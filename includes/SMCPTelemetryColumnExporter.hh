@@ -0,0 +1,369 @@
+/*
+ * SMCPTelemetryColumnExporter.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYCOLUMNEXPORTER_HH_
+#define SMCPTELEMETRYCOLUMNEXPORTER_HH_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <iostream>
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPAttributeSchema.hh"
+#include "SMCPFormatter.hh"
+#include "SMCPException.hh"
+
+/** A class which exports decoded telemetry as columns, for loading into dataframes.
+ *
+ * One row is produced per telemetry message with the columns
+ * - timestamp (uint64, given by the caller, e.g. ns since epoch),
+ * - lowerFOID (uint8), telemetryTypeID (uint8), attributeID (uint16),
+ * - payloadLength (uint32, length of the Attribute Value field),
+ * - payloadOffset (uint64, position of the Attribute Value field in the
+ *   input stream, so that raw values can be fetched from the original file),
+ * and, when an SMCPAttributeSchema is given,
+ * - value (float64, first element of the Attribute Value converted with the
+ *   schema; NaN if the attribute is not in the schema), and
+ * - nElements (uint32, number of elements in the Attribute Value).
+ *
+ * Rows are accumulated in column buffers and written every blockRows rows,
+ * either as CSV or in the following self-describing binary format
+ * (all integers little-endian):
+ * @code
+ * file   = "SMCPCOL1" version:u32(=1) nColumns:u32 column* block* end
+ * column = typeCode:u8 nameLength:u8 name:char[nameLength]
+ *          (typeCode: 1=uint8 2=uint16 3=uint32 4=uint64 5=float64)
+ * block  = nRows:u32 (nRows values of column 0) (nRows values of column 1) ...
+ * end    = 0:u32 totalRows:u64
+ * @endcode
+ *
+ * Example usage:
+ * @code
+ * std::ofstream ofs("telemetry.smcpcol", std::ios::binary);
+ * SMCPTelemetryColumnExporter exporter(ofs, SMCPTelemetryColumnExporter::BinaryFormat, &schema);
+ * size_t consumed = exporter.addStream(data, length, receiveTime, fileOffset);
+ * ...
+ * exporter.finish();
+ * @endcode
+ */
+class SMCPTelemetryColumnExporter {
+public:
+	enum {
+		BinaryFormat, CSVFormat
+	};
+
+public:
+	/** Column type codes of the binary format. */
+	enum {
+		UInt8Column = 1, UInt16Column = 2, UInt32Column = 3, UInt64Column = 4, Float64Column = 5
+	};
+
+public:
+	static const size_t DefaultBlockRows = 65536;
+	static const uint32_t FormatVersion = 1;
+
+private:
+	/** CSV text is written to the stream in chunks of about this size. */
+	static const size_t TextChunkSize = 65536;
+	static const size_t MaximumLineLength = 256;
+
+private:
+	std::ostream& os;
+	int format;
+	const SMCPAttributeSchema* schema;
+	size_t blockRows;
+	bool finished;
+	uint64_t nRows;
+
+	std::vector<uint64_t> timestamps;
+	std::vector<uint8_t> lowerFOIDs;
+	std::vector<uint8_t> telemetryTypeIDs;
+	std::vector<uint16_t> attributeIDs;
+	std::vector<uint32_t> payloadLengths;
+	std::vector<uint64_t> payloadOffsets;
+	std::vector<double> values;
+	std::vector<uint32_t> nElements;
+
+	std::string text;
+	std::vector<uint8_t> littleEndianBuffer;
+
+public:
+	/** Constructor.
+	 * @param[in] os output stream (opened in binary mode for BinaryFormat).
+	 * @param[in] format BinaryFormat or CSVFormat.
+	 * @param[in] schema if not NULL, value and nElements columns are added.
+	 * @param[in] blockRows number of rows buffered before they are written.
+	 */
+	SMCPTelemetryColumnExporter(std::ostream& os, int format = BinaryFormat, const SMCPAttributeSchema* schema = NULL,
+			size_t blockRows = DefaultBlockRows) :
+			os(os), format(format), schema(schema), blockRows(blockRows == 0 ? 1 : blockRows), finished(false),
+			nRows(0) {
+		text.reserve((size_t) TextChunkSize + (size_t) MaximumLineLength);
+		timestamps.reserve(this->blockRows);
+		lowerFOIDs.reserve(this->blockRows);
+		telemetryTypeIDs.reserve(this->blockRows);
+		attributeIDs.reserve(this->blockRows);
+		payloadLengths.reserve(this->blockRows);
+		payloadOffsets.reserve(this->blockRows);
+		if (schema != NULL) {
+			values.reserve(this->blockRows);
+			nElements.reserve(this->blockRows);
+		}
+		writeHeader();
+	}
+
+public:
+	/** Destructor. Writes buffered rows and the end marker if finish() was not called. */
+	~SMCPTelemetryColumnExporter() {
+		finish();
+	}
+
+public:
+	/** Adds a row. Ignored after finish().
+	 * @param[in] view telemetry message.
+	 * @param[in] timestamp value of the timestamp column.
+	 * @param[in] messageOffset position of the first byte of the message in the input stream.
+	 */
+	void add(const SMCPTelemetryMessageView& view, uint64_t timestamp, uint64_t messageOffset) {
+		if (finished || !view.isValid()) {
+			return;
+		}
+		timestamps.push_back(timestamp);
+		lowerFOIDs.push_back(view.getLowerFOID());
+		telemetryTypeIDs.push_back(view.getTelemetryTypeID());
+		attributeIDs.push_back(view.getAttributeID());
+		payloadLengths.push_back((uint32_t) view.getAttributeValuesLength());
+		payloadOffsets.push_back(messageOffset + (view.getAttributeValuesAsPointer() - view.getAsPointer()));
+		if (schema != NULL) {
+			double value = NAN;
+			uint32_t n = 0;
+			const SMCPAttributeDefinition* definition = schema->find(view.getLowerFOID(), view.getAttributeID());
+			if (definition != NULL) {
+				n = (uint32_t) definition->getNumberOfElements(view.getAttributeValuesLength());
+				if (n != 0) {
+					definition->decode(view.getAttributeValuesAsPointer(), 1, &value);
+				}
+			}
+			values.push_back(value);
+			nElements.push_back(n);
+		}
+		nRows++;
+		if (blockRows <= timestamps.size()) {
+			flush();
+		}
+	}
+
+public:
+	/** Adds rows for telemetry messages stored back to back in a byte array.
+	 * @param[in] data byte array.
+	 * @param[in] length length of the byte array.
+	 * @param[in] timestamp value of the timestamp column for all rows.
+	 * @param[in] streamOffset position of data[0] in the input stream.
+	 * @return number of bytes consumed; a trailing incomplete message is not
+	 * consumed and should be passed again with the following data.
+	 */
+	size_t addStream(const uint8_t* data, size_t length, uint64_t timestamp, uint64_t streamOffset) {
+		SMCPTelemetryMessageView view;
+		size_t offset = 0;
+		while (SMCPTelemetryMessageView::HeaderLength <= length - offset) {
+			size_t messageLength = SMCPTelemetryMessageView::getMessageLength(data + offset);
+			if (messageLength < SMCPTelemetryMessageView::MinimumMessageLength) {
+				throw SMCPException("SMCPTelemetryColumnExporter: invalid Message Length");
+			}
+			if (!view.tryInterpretAsTelemetryMessage(data + offset, length - offset)) {
+				break;
+			}
+			add(view, timestamp, streamOffset + offset);
+			offset += messageLength;
+		}
+		return offset;
+	}
+
+public:
+	/** Writes buffered rows as one block. */
+	void flush() {
+		size_t n = timestamps.size();
+		if (n == 0) {
+			return;
+		}
+		if (format == CSVFormat) {
+			writeCSVRows(n);
+		} else {
+			writeUInt32(text, (uint32_t) n);
+			os.write(text.data(), text.size());
+			text.clear();
+			writeColumn(timestamps);
+			writeColumn(lowerFOIDs);
+			writeColumn(telemetryTypeIDs);
+			writeColumn(attributeIDs);
+			writeColumn(payloadLengths);
+			writeColumn(payloadOffsets);
+			if (schema != NULL) {
+				writeColumn(values);
+				writeColumn(nElements);
+			}
+		}
+		timestamps.clear();
+		lowerFOIDs.clear();
+		telemetryTypeIDs.clear();
+		attributeIDs.clear();
+		payloadLengths.clear();
+		payloadOffsets.clear();
+		values.clear();
+		nElements.clear();
+	}
+
+public:
+	/** Writes buffered rows and, for BinaryFormat, the end marker. Further rows are ignored. */
+	void finish() {
+		if (finished) {
+			return;
+		}
+		flush();
+		if (format == BinaryFormat) {
+			writeUInt32(text, 0);
+			writeUInt64(text, nRows);
+			os.write(text.data(), text.size());
+			text.clear();
+		}
+		os.flush();
+		finished = true;
+	}
+
+public:
+	/** Returns the number of rows added so far (rows ignored after finish() are not counted). */
+	uint64_t getNRows() const {
+		return nRows;
+	}
+
+public:
+	/** Returns the column names in output order. */
+	std::vector<std::string> getColumnNames() const {
+		std::vector<std::string> names;
+		for (size_t i = 0; i < getNColumns(); i++) {
+			names.push_back(getColumnName(i));
+		}
+		return names;
+	}
+
+private:
+	size_t getNColumns() const {
+		return (schema != NULL) ? 8 : 6;
+	}
+
+private:
+	static const char* getColumnName(size_t index) {
+		static const char* names[] = { "timestamp", "lowerFOID", "telemetryTypeID", "attributeID", "payloadLength",
+				"payloadOffset", "value", "nElements" };
+		return names[index];
+	}
+
+private:
+	static uint8_t getColumnType(size_t index) {
+		static const uint8_t types[] = { UInt64Column, UInt8Column, UInt8Column, UInt16Column, UInt32Column,
+				UInt64Column, Float64Column, UInt32Column };
+		return types[index];
+	}
+
+private:
+	void writeHeader() {
+		if (format == CSVFormat) {
+			for (size_t i = 0; i < getNColumns(); i++) {
+				text += (i == 0) ? "" : ",";
+				text += getColumnName(i);
+			}
+			text += '\n';
+		} else {
+			text.append("SMCPCOL1", 8);
+			writeUInt32(text, FormatVersion);
+			writeUInt32(text, (uint32_t) getNColumns());
+			for (size_t i = 0; i < getNColumns(); i++) {
+				text += (char) getColumnType(i);
+				text += (char) strlen(getColumnName(i));
+				text += getColumnName(i);
+			}
+		}
+		os.write(text.data(), text.size());
+		text.clear();
+	}
+
+private:
+	void writeCSVRows(size_t n) {
+		char line[MaximumLineLength];
+		for (size_t i = 0; i < n; i++) {
+			char* p = line;
+			p = SMCPFormatter::writeDecimal(p, timestamps[i]);
+			*p++ = ',';
+			p = SMCPFormatter::writeDecimal(p, lowerFOIDs[i]);
+			*p++ = ',';
+			p = SMCPFormatter::writeDecimal(p, telemetryTypeIDs[i]);
+			*p++ = ',';
+			p = SMCPFormatter::writeDecimal(p, attributeIDs[i]);
+			*p++ = ',';
+			p = SMCPFormatter::writeDecimal(p, payloadLengths[i]);
+			*p++ = ',';
+			p = SMCPFormatter::writeDecimal(p, payloadOffsets[i]);
+			if (schema != NULL) {
+				*p++ = ',';
+				if (!isnan(values[i])) {
+					p += snprintf(p, 32, "%.17g", values[i]);
+				}
+				*p++ = ',';
+				p = SMCPFormatter::writeDecimal(p, nElements[i]);
+			}
+			*p++ = '\n';
+			text.append(line, p - line);
+			if (TextChunkSize <= text.size()) {
+				os.write(text.data(), text.size());
+				text.clear();
+			}
+		}
+		os.write(text.data(), text.size());
+		text.clear();
+	}
+
+private:
+	template<typename T>
+	void writeColumn(const std::vector<T>& column) {
+		if (isLittleEndian()) {
+			os.write((const char*) &(column[0]), column.size() * sizeof(T));
+			return;
+		}
+		littleEndianBuffer.resize(column.size() * sizeof(T));
+		for (size_t i = 0; i < column.size(); i++) {
+			const uint8_t* bytes = (const uint8_t*) &(column[i]);
+			for (size_t k = 0; k < sizeof(T); k++) {
+				littleEndianBuffer[i * sizeof(T) + k] = bytes[sizeof(T) - 1 - k];
+			}
+		}
+		os.write((const char*) &(littleEndianBuffer[0]), littleEndianBuffer.size());
+	}
+
+private:
+	static bool isLittleEndian() {
+		const uint16_t one = 1;
+		return *(const uint8_t*) &one == 1;
+	}
+
+private:
+	static void writeUInt32(std::string& out, uint32_t value) {
+		for (size_t i = 0; i < 4; i++) {
+			out += (char) ((value >> (8 * i)) & 0xFF);
+		}
+	}
+
+private:
+	static void writeUInt64(std::string& out, uint64_t value) {
+		for (size_t i = 0; i < 8; i++) {
+			out += (char) ((value >> (8 * i)) & 0xFF);
+		}
+	}
+};
+
+#endif /* SMCPTELEMETRYCOLUMNEXPORTER_HH_ */
@@ -0,0 +1,235 @@
+/*
+ * SMCPTelemetryHeaderBatch.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYHEADERBATCH_HH_
+#define SMCPTELEMETRYHEADERBATCH_HH_
+
+#include <stdint.h>
+#include <vector>
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** A class which decodes the header fields of concatenated telemetry messages
+ * into parallel arrays (structure of arrays), without constructing message
+ * objects.
+ *
+ * For the i-th message, the Telemetry Type ID, Message Length, Lower FOID,
+ * Attribute ID, and payload offset (offset of the Attribute Value from the
+ * start of the decoded buffer) are stored at index i of five columns.
+ * Filters over millions of messages can then run as simple loops over one
+ * or two columns, which the compiler vectorizes.
+ *
+ * decodeHeaders() is the core loop writing to caller-provided arrays; the
+ * decode() methods manage columns whose storage is reused, so repeated
+ * decoding does not allocate once the columns have grown.
+ *
+ * Example usage:
+ * @code
+ * SMCPTelemetryHeaderBatch batch;
+ * size_t consumed = batch.decode(buffer, length);
+ * const uint8_t* lowerFOIDs = batch.getLowerFOIDs();
+ * const uint16_t* attributeIDs = batch.getAttributeIDs();
+ * size_t nMatches = 0;
+ * for (size_t i = 0; i < batch.size(); i++) {
+ * 	nMatches += (lowerFOIDs[i] == 0x12) & (attributeIDs[i] == 0x0108);
+ * }
+ * @endcode
+ */
+class SMCPTelemetryHeaderBatch {
+public:
+	/** Number of messages decoded per call of decodeHeaders() by decode(). */
+	static const size_t BlockSize = 4096;
+
+private:
+	//sized to the capacity; only the first nMessages elements are valid
+	std::vector<uint8_t> typeIDs;
+	std::vector<uint32_t> lengths;
+	std::vector<uint8_t> lowerFOIDs;
+	std::vector<uint16_t> attributeIDs;
+	std::vector<uint64_t> payloadOffsets;
+	size_t nMessages;
+	bool error;
+
+public:
+	SMCPTelemetryHeaderBatch() :
+			nMessages(0), error(false) {
+	}
+
+public:
+	/** Decodes header fields of concatenated telemetry messages into raw arrays.
+	 * Decoding stops at the end of the buffer, at an incomplete message, at a
+	 * Message Length shorter than the minimum message, or after maximumMessages.
+	 * @param[in] data buffer of concatenated telemetry messages.
+	 * @param[in] length length of the buffer.
+	 * @param[out] typeIDs Telemetry Type IDs.
+	 * @param[out] lengths Message Lengths.
+	 * @param[out] lowerFOIDs Lower FOIDs.
+	 * @param[out] attributeIDs Attribute IDs.
+	 * @param[out] payloadOffsets offsets of the Attribute Values from data, plus baseOffset.
+	 * @param[in] maximumMessages size of each output array.
+	 * @param[out] consumed number of bytes of the decoded messages.
+	 * @param[in] baseOffset value added to payloadOffsets.
+	 * @return number of messages decoded.
+	 */
+	static size_t decodeHeaders(const uint8_t* data, size_t length, uint8_t* typeIDs, uint32_t* lengths,
+			uint8_t* lowerFOIDs, uint16_t* attributeIDs, uint64_t* payloadOffsets, size_t maximumMessages,
+			size_t& consumed, uint64_t baseOffset = 0) {
+		const size_t headerLength = SMCPTelemetryMessageView::HeaderLength;
+		const size_t minimumLength = SMCPTelemetryMessageView::MinimumMessageLength;
+		size_t offset = 0;
+		size_t n = 0;
+		while (n < maximumMessages && minimumLength <= length - offset) {
+			const uint8_t* p = data + offset;
+			uint32_t messageLength = ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+			if (messageLength < minimumLength || length - offset < messageLength) {
+				break;
+			}
+			typeIDs[n] = p[0] & 0x0F;
+			lengths[n] = messageLength;
+			lowerFOIDs[n] = p[4];
+			attributeIDs[n] = (uint16_t) ((p[5] << 8) | p[6]);
+			payloadOffsets[n] = baseOffset + offset + headerLength + 2;
+			offset += messageLength;
+			n++;
+		}
+		consumed = offset;
+		return n;
+	}
+
+public:
+	/** Clears the columns and decodes a buffer.
+	 * @param[in] data buffer of concatenated telemetry messages.
+	 * @param[in] length length of the buffer.
+	 * @return number of bytes of the decoded messages; the rest is an incomplete
+	 * trailing message or, if hasError(), starts with an invalid Message Length.
+	 */
+	size_t decode(const uint8_t* data, size_t length) {
+		clear();
+		return append(data, length, 0);
+	}
+
+public:
+	/** Clears the columns and decodes a buffer. */
+	size_t decode(const std::vector<uint8_t>& data) {
+		return decode(data.empty() ? NULL : &data[0], data.size());
+	}
+
+public:
+	/** Decodes a buffer and appends the result to the columns.
+	 * @param[in] data buffer of concatenated telemetry messages.
+	 * @param[in] length length of the buffer.
+	 * @param[in] baseOffset value added to payloadOffsets (e.g. the position of data in a file).
+	 * @return number of bytes of the decoded messages.
+	 */
+	size_t append(const uint8_t* data, size_t length, uint64_t baseOffset) {
+		size_t offset = 0;
+		error = false;
+		while (true) {
+			//no more messages than fit in the rest of the buffer
+			size_t blockSize = (length - offset) / SMCPTelemetryMessageView::MinimumMessageLength;
+			if (BlockSize < blockSize) {
+				blockSize = BlockSize;
+			}
+			if (blockSize == 0) {
+				break;
+			}
+			reserve(nMessages + blockSize);
+			size_t consumed;
+			size_t n = decodeHeaders(data + offset, length - offset, &typeIDs[nMessages], &lengths[nMessages],
+					&lowerFOIDs[nMessages], &attributeIDs[nMessages], &payloadOffsets[nMessages], blockSize, consumed,
+					baseOffset + offset);
+			nMessages += n;
+			offset += consumed;
+			if (n < blockSize) {
+				break;
+			}
+		}
+		if (SMCPTelemetryMessageView::HeaderLength <= length - offset
+				&& SMCPTelemetryMessageView::getMessageLength(data + offset)
+						< SMCPTelemetryMessageView::MinimumMessageLength) {
+			error = true;
+		}
+		return offset;
+	}
+
+public:
+	/** Removes all rows; the storage of the columns is kept. */
+	void clear() {
+		nMessages = 0;
+		error = false;
+	}
+
+public:
+	/** Returns the number of decoded messages. */
+	size_t size() const {
+		return nMessages;
+	}
+
+public:
+	/** Returns true if the last decode() or append() stopped at an invalid Message Length. */
+	bool hasError() const {
+		return error;
+	}
+
+public:
+	/** Returns the Telemetry Type ID column. */
+	const uint8_t* getTypeIDs() const {
+		return typeIDs.empty() ? NULL : &typeIDs[0];
+	}
+
+public:
+	/** Returns the Message Length column. */
+	const uint32_t* getLengths() const {
+		return lengths.empty() ? NULL : &lengths[0];
+	}
+
+public:
+	/** Returns the Lower FOID column. */
+	const uint8_t* getLowerFOIDs() const {
+		return lowerFOIDs.empty() ? NULL : &lowerFOIDs[0];
+	}
+
+public:
+	/** Returns the Attribute ID column. */
+	const uint16_t* getAttributeIDs() const {
+		return attributeIDs.empty() ? NULL : &attributeIDs[0];
+	}
+
+public:
+	/** Returns the column of offsets of the Attribute Values. */
+	const uint64_t* getPayloadOffsets() const {
+		return payloadOffsets.empty() ? NULL : &payloadOffsets[0];
+	}
+
+public:
+	/** Returns the offset of the first byte of the i-th message. */
+	uint64_t getMessageOffset(size_t i) const {
+		return payloadOffsets[i] - SMCPTelemetryMessageView::HeaderLength - 2;
+	}
+
+public:
+	/** Returns the length of the Attribute Value of the i-th message. */
+	size_t getAttributeValuesLength(size_t i) const {
+		return lengths[i] - SMCPTelemetryMessageView::HeaderLength - 2;
+	}
+
+private:
+	void reserve(size_t n) {
+		if (n <= typeIDs.size()) {
+			return;
+		}
+		if (n < typeIDs.size() * 2) {
+			n = typeIDs.size() * 2;
+		}
+		typeIDs.resize(n);
+		lengths.resize(n);
+		lowerFOIDs.resize(n);
+		attributeIDs.resize(n);
+		payloadOffsets.resize(n);
+	}
+};
+
+#endif /* SMCPTELEMETRYHEADERBATCH_HH_ */
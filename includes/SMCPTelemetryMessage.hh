@@ -13,6 +13,8 @@
 #include "SMCPTelemetryMessageHeader.hh"
 #include "SMCPTelemetryMessageData.hh"
 #include "SMCPException.hh"
+#include "SMCPInstrumentation.hh"
+#include "SMCPTrafficStatistics.hh"
 
 /** A class which represents an SMCP Telemetry Message.
  * Fields (see details for SMCP09 or ASTH-111):
@@ -48,15 +50,20 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
-		std::stringstream ss;
-		using std::endl;
-		ss << "---------------------------------" << endl;
-		ss << "SMCPTelemetryMessage" << endl;
-		ss << "---------------------------------" << endl;
-		ss << header->toString();
-		ss << data->toString();
-		ss << endl;
-		return ss.str();
+		std::string result;
+		appendString(result);
+		return result;
+	}
+
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
+		SMCPFormatter::appendMessageBanner(out, "SMCPTelemetryMessage");
+		header->appendString(out);
+		data->appendString(out);
+		out += '\n';
 	}
 
 public:
@@ -65,6 +72,11 @@ public:
 	 * @param[in] length of the input data.
 	 */
 	void interpretAsTelemetryMessage(uint8_t* data, size_t length) {
+		SMCP_INSTRUMENT_SCOPE(SMCPInstrumentedType::Undefined, SMCPInstrumentedOperation::Decode);
+		if (length != 0) {
+			SMCP_INSTRUMENT_SET_TYPE(SMCPInstrumentedType::fromTelemetryTypeID(data[0] & 0x0F));
+		}
+		SMCPTrafficStatistics::recordAttached(data, length);
 		if (length < SMCPTelemetryMessageHeader::HeaderLength + 1) {
 			throw SMCPException("size error");
 		}
@@ -11,6 +11,7 @@
 #include <vector>
 #include "SMCPMessageData.hh"
 #include "SMCPException.hh"
+#include "SMCPFormatter.hh"
 
 /** A class that represents SMCP Telemetry Message Data.
  */
@@ -41,32 +42,19 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::setfill;
-
-		ss << dec;
-
-		ss << "=== Command Message Data ===" << endl;
-		ss << "AttributeID        = " << hex << setw(4) << setfill('0') << (unsigned int) (attributeID[0] * 0x100
-				+ attributeID[1]) << dec << endl;
-		ss << "Attr.Val. Length   = " << dec << attributeValues.size() << " bytes (decimal)" << endl;
-		for (size_t i = 0; i < this->getMaximumDumpLength(); i++) {
-			if (i < attributeValues.size()) {
-				ss << "Attr.Val.[" << setw(8) << setfill('0') << i << "]= 0x" << hex << setw(2) << setfill('0')
-						<< (unsigned int) attributeValues[i] << dec << endl;
-			} else {
-				break;
-			}
-		}
+		std::string result;
+		appendString(result);
+		return result;
+	}
 
-		if (this->getMaximumDumpLength() < attributeValues.size()) {
-			ss << "The AttributeValues field continue... (total size = " << attributeValues.size() << " bytes)" << endl;
-		}
-		return ss.str();
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
+		SMCPFormatter::appendTelemetryMessageData(out, (uint16_t) (attributeID[0] * 0x100 + attributeID[1]),
+				attributeValues.empty() ? NULL : &(attributeValues[0]), attributeValues.size(),
+				this->getMaximumDumpLength());
 	}
 
 public:
@@ -84,28 +72,47 @@ public:
 		return result;
 	}
 
+public:
+	/** Writes packet content into a caller-provided buffer without allocating memory.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (same as getLength()).
+	 */
+	size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		size_t length = getLength();
+		if (size < length) {
+			throw SMCPException("buffer too small");
+		}
+		buffer[0] = attributeID[0];
+		buffer[1] = attributeID[1];
+		if (!attributeValues.empty()) {
+			memcpy(buffer + 2, &(attributeValues[0]), attributeValues.size());
+		}
+		if (!attachment.empty()) {
+			memcpy(buffer + 2 + attributeValues.size(), &(attachment[0]), attachment.size());
+		}
+		return length;
+	}
+
 public:
 	/** Sets Message Data based on a provided uint8_t array.
 	 * @param[in] data uint8_t array which contains Message Data.
 	 * @param[in] length the length of the array.
 	 */
-	void setMessageData(uint8_t* data, size_t length) throw (SMCPException) {
+	void setMessageData(uint8_t* data, size_t length) {
 		if (length < 3) {
 			throw SMCPException("size error");
 		}
 		attributeID[0] = data[0];
 		attributeID[1] = data[1];
-		attributeValues.clear();
-		for (size_t i = 2; i < length; i++) {
-			attributeValues.push_back(data[i]);
-		}
+		attributeValues.assign(data + 2, data + length);
 	}
 
 public:
 	/** Sets Message Data based on a provided uint8_t vector.
 	 * @param[in] data uint8_t vector which contains Message Data.
 	 */
-	void setMessageData(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageData(std::vector<uint8_t>& data) {
 		if (data.size() != 0) {
 			setMessageData(&(data[0]), data.size());
 		} else {
@@ -181,13 +188,27 @@ public:
 		return attributeValues;
 	}
 
+public:
+	/** Returns a pointer to the Attribute Value field without copying it.
+	 * The pointer is invalidated when the Attribute Value field is modified.
+	 */
+	const uint8_t* getAttributeValuesAsPointer() const {
+		return attributeValues.empty() ? NULL : &attributeValues[0];
+	}
+
+public:
+	/** Returns the length of the Attribute Value field. */
+	size_t getAttributeValuesLength() const {
+		return attributeValues.size();
+	}
+
 public:
 	void setAttachment(std::vector<uint8_t>& attachment) {
 		this->attachment = attachment;
 	}
 
 public:
-	void setAttributeID(std::vector<uint8_t>& attributeID) throw (SMCPException) {
+	void setAttributeID(std::vector<uint8_t>& attributeID) {
 		if (attributeID.size() == 2) {
 			this->attributeID[0] = attributeID[0];
 			this->attributeID[1] = attributeID[1];
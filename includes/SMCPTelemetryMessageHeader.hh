@@ -9,8 +9,10 @@
 #define SMCPTELEMETRYMESSAGEHEADER_HH_
 
 #include <bitset>
+#include <iomanip>
 #include "SMCPMessageHeader.hh"
 #include "SMCPException.hh"
+#include "SMCPFormatter.hh"
 
 /** A class that represents SMCP Telemetry Message Header.
  * Extends SMCPMessageHeader.
@@ -51,51 +53,19 @@ public:
 	 * @returns string dump of this packet.
 	 */
 	std::string toString() {
-		std::stringstream ss;
-		using std::endl;
-		using std::hex;
-		using std::dec;
-		using std::setw;
-		using std::setfill;
-
-		ss << dec;
-
-		ss << "=== Command Message Header ===" << endl;
-
-		ss << "Reserved           = " << reserved.to_string() << "b ";
-		if (reserved.to_ulong() != ReservedFieldValue) {
-			ss << "(Undefined value)" << endl;
-		} else {
-			ss << "(Reserved)" << endl;
-		}
-
-		ss << "SMCP Version       = " << smcpVersion.to_string() << "b" << endl;
-
-		ss << "TelemetryTypeID    = " << telemetryTypeID.to_string() << "b ";
-		switch (telemetryTypeID.to_ulong()) {
-		case SMCPTelemetryTypeID::ValueTelemetry:
-			ss << "(ValueTelemetry)" << endl;
-			break;
-		case SMCPTelemetryTypeID::NotificationTelemetry:
-			ss << "(NotificationTelemetry)" << endl;
-			break;
-		case SMCPTelemetryTypeID::AcknowledgeTelemetry:
-			ss << "(AcknowledgeTelemetry)" << endl;
-			break;
-		case SMCPTelemetryTypeID::MemoryDumpTelemetry:
-			ss << "(MemoryDumpTelemetry)" << endl;
-			break;
-		default:
-			ss << "(Undefined value)" << endl;
-			break;
-		}
-
-		ss << "MessageLength      = "
-				<< (uint32_t) (messageLength[2] * 0x10000 + messageLength[1] * 0x100 + messageLength[0])
-				<< " bytes (decial)" << std::right << endl;
+		std::string result;
+		appendString(result);
+		return result;
+	}
 
-		ss << "lowerFOID          = 0x" << hex << setw(2) << setfill('0') << (uint32_t) lowerFOID << dec << endl;
-		return ss.str();
+public:
+	/** Appends string dump of this instance to a caller-owned string.
+	 * @param[out] out destination.
+	 */
+	void appendString(std::string& out) {
+		SMCPFormatter::appendTelemetryMessageHeader(out, (uint8_t) reserved.to_ulong(),
+				(uint8_t) smcpVersion.to_ulong(), (uint8_t) telemetryTypeID.to_ulong(),
+				(uint32_t) (messageLength[2] * 0x10000 + messageLength[1] * 0x100 + messageLength[0]), lowerFOID);
 	}
 
 public:
@@ -118,6 +88,32 @@ public:
 		return result;
 	}
 
+public:
+	/** Writes packet content into a caller-provided buffer without allocating memory.
+	 * @param[out] buffer destination.
+	 * @param[in] size size of the buffer.
+	 * @return the number of bytes written (HeaderLength).
+	 */
+	size_t getAsByteArray(uint8_t* buffer, size_t size) {
+		if (size < HeaderLength) {
+			throw SMCPException("buffer too small");
+		}
+		buffer[0] = reserved.to_ulong() * 0x40 //
+				+ smcpVersion.to_ulong() * 0x10 //
+				+ telemetryTypeID.to_ulong();
+		buffer[1] = messageLength[0];
+		buffer[2] = messageLength[1];
+		buffer[3] = messageLength[2];
+		buffer[4] = lowerFOID;
+		return HeaderLength;
+	}
+
+public:
+	/** Returns the number of bytes written by getAsByteArray(). */
+	size_t getLength() {
+		return HeaderLength;
+	}
+
 public:
 	/** Sets header field values based on a provided uint8_t array.
 	 * @param[in] data uint8_t array which contains Telemetry Message Header.
@@ -143,7 +139,7 @@ public:
 	/** Sets header field values based on a provided uint8_t vector.
 	 * @param[in] data uint8_t vector which contains Telemetry Message Header.
 	 */
-	void setMessageHeader(std::vector<uint8_t>& data) throw (SMCPException) {
+	void setMessageHeader(std::vector<uint8_t>& data) {
 		if (data.size() == HeaderLength) {
 			setMessageHeader(&(data[0]));
 		} else {
@@ -0,0 +1,176 @@
+/*
+ * SMCPTelemetryMessageView.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYMESSAGEVIEW_HH_
+#define SMCPTELEMETRYMESSAGEVIEW_HH_
+
+#include <stdint.h>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPException.hh"
+
+/** A read-only view of an SMCP Telemetry Message stored in a byte array.
+ * Unlike SMCPTelemetryMessage, the view does not copy the message; field
+ * values are read directly from the byte array, which must outlive the view.
+ * The extent of the message is taken from the Message Length field, so a view
+ * can be placed on the head of a buffer which contains concatenated messages.
+ *
+ * Example usage:
+ * @code
+ * SMCPTelemetryMessageView view;
+ * for (size_t offset = 0; offset < length; offset += view.getLength()) {
+ * 	view.interpretAsTelemetryMessage(buffer + offset, length - offset);
+ * 	...view.getLowerFOID(), view.getAttributeID(), view.getAttributeValuesAsPointer()...
+ * }
+ * @endcode
+ */
+class SMCPTelemetryMessageView {
+public:
+	static const size_t HeaderLength = SMCPTelemetryMessageHeader::HeaderLength;
+
+public:
+	/** Header, 2-octet Attribute ID, and at least 1 octet of Attribute Value. */
+	static const size_t MinimumMessageLength = SMCPTelemetryMessageHeader::HeaderLength + 3;
+
+private:
+	const uint8_t* data;
+	size_t length;
+
+public:
+	/** Constructor. Constructs an empty view. */
+	SMCPTelemetryMessageView() :
+			data(NULL), length(0) {
+	}
+
+public:
+	/** Constructor.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 */
+	SMCPTelemetryMessageView(const uint8_t* data, size_t length) :
+			data(NULL), length(0) {
+		interpretAsTelemetryMessage(data, length);
+	}
+
+public:
+	/** Places the view on a byte array.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 */
+	void interpretAsTelemetryMessage(const uint8_t* data, size_t length) {
+		if (!tryInterpretAsTelemetryMessage(data, length)) {
+			throw SMCPException("size error");
+		}
+	}
+
+public:
+	/** Places the view on a byte array without throwing an exception.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @return false if the array does not contain a complete telemetry message
+	 * (the view is left empty in that case).
+	 */
+	bool tryInterpretAsTelemetryMessage(const uint8_t* data, size_t length) {
+		if (length < MinimumMessageLength) {
+			this->data = NULL;
+			this->length = 0;
+			return false;
+		}
+		size_t messageLength = getMessageLength(data);
+		if (messageLength < MinimumMessageLength || length < messageLength) {
+			this->data = NULL;
+			this->length = 0;
+			return false;
+		}
+		this->data = data;
+		this->length = messageLength;
+		return true;
+	}
+
+public:
+	/** Returns the value of the Message Length field of a message stored in a byte array.
+	 * @param[in] data byte array which contains at least the 5-octet header.
+	 */
+	static size_t getMessageLength(const uint8_t* data) {
+		return ((size_t) data[1] << 16) | ((size_t) data[2] << 8) | data[3];
+	}
+
+public:
+	/** Returns true if the view has been placed on a message. */
+	bool isValid() const {
+		return data != NULL;
+	}
+
+public:
+	/** Returns a pointer to the first byte of the message. */
+	const uint8_t* getAsPointer() const {
+		return data;
+	}
+
+public:
+	/** Returns the length of the message (equals the Message Length field). */
+	size_t getLength() const {
+		return length;
+	}
+
+public:
+	uint8_t getReserved() const {
+		return data[0] >> 6;
+	}
+
+public:
+	uint8_t getSMCPVersion() const {
+		return (data[0] >> 4) & 0x03;
+	}
+
+public:
+	/** Returns Telemetry Type ID.
+	 * @see SMCPTelemetryTypeID.
+	 */
+	uint8_t getTelemetryTypeID() const {
+		return data[0] & 0x0F;
+	}
+
+public:
+	uint32_t getMessageLength() const {
+		return (uint32_t) length;
+	}
+
+public:
+	uint8_t getLowerFOID() const {
+		return data[4];
+	}
+
+public:
+	uint16_t getAttributeID() const {
+		return (uint16_t) ((data[5] << 8) | data[6]);
+	}
+
+public:
+	/** Returns a pointer to the Attribute Value field. */
+	const uint8_t* getAttributeValuesAsPointer() const {
+		return data + HeaderLength + 2;
+	}
+
+public:
+	/** Returns the length of the Attribute Value field. */
+	size_t getAttributeValuesLength() const {
+		return length - HeaderLength - 2;
+	}
+
+public:
+	/** Copies the viewed message into an SMCPTelemetryMessage instance.
+	 * @param[out] message destination.
+	 */
+	void copyTo(SMCPTelemetryMessage& message) const {
+		if (data == NULL) {
+			throw SMCPException("SMCPTelemetryMessageView: empty view");
+		}
+		message.interpretAsTelemetryMessage((uint8_t*) data, length);
+	}
+};
+
+#endif /* SMCPTELEMETRYMESSAGEVIEW_HH_ */
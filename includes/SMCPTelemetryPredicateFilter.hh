@@ -0,0 +1,835 @@
+/*
+ * SMCPTelemetryPredicateFilter.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYPREDICATEFILTER_HH_
+#define SMCPTELEMETRYPREDICATEFILTER_HH_
+
+#include <stdint.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <vector>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** A class which evaluates many filter expressions against a telemetry message
+ * in a single pass, and returns the set of matching subscribers as a bitmask.
+ *
+ * Each expression is parsed once when it is added, and compiled into a flat
+ * bytecode program shared by all subscribers. Top-level conditions of the form
+ * "type == constant" and "foid == constant" are also folded into lookup tables,
+ * so that predicates which cannot match a message are skipped without running
+ * their code.
+ *
+ * Expression syntax:
+ * - integers: 18, 0x12
+ * - header fields: type (Telemetry Type ID), version (SMCP Version), reserved,
+ *   length (Message Length), foid (Lower FOID), aid (Attribute ID),
+ *   valuelength (length of the Attribute Value)
+ * - Attribute Value bytes: payload[n] (octet n), payload16[n], payload32[n]
+ *   (big-endian 16/32-bit integers starting at octet n)
+ * - telemetry type names: ValueTelemetry, NotificationTelemetry,
+ *   AcknowledgeTelemetry, MemoryDumpTelemetry
+ * - operators, from the lowest precedence: ||, &&, == != < <= > >=, |, ^, &,
+ *   << >>, unary ! ~. Unlike C, bitwise operators bind tighter than comparisons,
+ *   so "payload[3] & 0x0F == 2" means "(payload[3] & 0x0F) == 2".
+ *
+ * A predicate which reads beyond the end of the Attribute Value evaluates to false.
+ *
+ * Example usage:
+ * @code
+ * SMCPTelemetryPredicateFilter filter;
+ * filter.add(0, "type == NotificationTelemetry && foid == 0x12 && payload[3] & 0x0F == 2");
+ * filter.add(1, "type == NotificationTelemetry && aid == 0x0100");
+ * uint64_t subscribers = filter.evaluate(view); //bit n set if subscriber n matches
+ * @endcode
+ */
+class SMCPTelemetryPredicateFilter {
+public:
+	static const size_t MaximumNumberOfSubscribers = 64;
+	static const size_t MaximumStackDepth = 32;
+
+private:
+	enum {
+		FieldType, FieldVersion, FieldReserved, FieldLength, FieldFOID, FieldAttributeID, FieldValueLength, NFields
+	};
+
+private:
+	enum {
+		OpBegin, //skip to jump unless the predicate is a candidate
+		OpPush,
+		OpLoadField,
+		OpLoadPayload8,
+		OpLoadPayload16,
+		OpLoadPayload32,
+		OpNot,
+		OpBitNot,
+		OpToBool,
+		OpJumpIfZero, //peek; jump if zero, otherwise pop
+		OpJumpIfNonZero, //peek; jump if non zero, otherwise pop
+		OpMatch, //pop; if non zero, add subscribers
+		OpEnd,
+		//binary operators (stack, stack), followed by (stack, immediate) variants
+		OpOr,
+		OpXor,
+		OpAnd,
+		OpShiftLeft,
+		OpShiftRight,
+		OpEqual,
+		OpNotEqual,
+		OpLess,
+		OpLessEqual,
+		OpGreater,
+		OpGreaterEqual,
+		NBinaryOperators = OpGreaterEqual - OpOr + 1,
+		OpImmediateOffset = NBinaryOperators
+	};
+
+private:
+	class Instruction {
+	public:
+		int opcode;
+		int64_t operand;
+		size_t jump;
+	};
+
+private:
+	enum {
+		NodeConstant, NodeField, NodePayload8, NodePayload16, NodePayload32, NodeUnary, NodeBinary, NodeLogicalAnd,
+		NodeLogicalOr
+	};
+
+private:
+	class Node {
+	public:
+		int kind;
+		int op;
+		int64_t value;
+		int left;
+		int right;
+	};
+
+private:
+	class Token {
+	public:
+		std::string text;
+		size_t position;
+		bool isNumber;
+		int64_t value;
+	};
+
+private:
+	class Predicate {
+	public:
+		std::string expression;
+		uint64_t subscribers;
+		int requiredType; //-1 = any
+		int requiredFOID; //-1 = any
+	};
+
+private:
+	std::vector<Predicate> predicates;
+	std::vector<Instruction> code;
+	uint64_t typeCandidates[16];
+	uint64_t foidCandidates[256];
+
+	//parser state (used only while add() runs)
+	std::vector<Token> tokens;
+	size_t tokenIndex;
+	std::vector<Node> nodes;
+	std::string expression;
+
+public:
+	/** Constructor. */
+	SMCPTelemetryPredicateFilter() {
+		clear();
+	}
+
+public:
+	/** Removes all predicates. */
+	void clear() {
+		predicates.clear();
+		code.clear();
+		rebuildCandidateTables();
+		Instruction end;
+		end.opcode = OpEnd;
+		end.operand = 0;
+		end.jump = 0;
+		code.push_back(end);
+	}
+
+public:
+	/** Compiles an expression and adds it as a predicate of a subscriber.
+	 * A subscriber may have several predicates; it matches if any of them does.
+	 * @param[in] subscriberIndex index of the subscriber (0-63), i.e. bit position in evaluate() result.
+	 * @param[in] expression filter expression.
+	 */
+	void add(size_t subscriberIndex, const std::string& expression) {
+		if (MaximumNumberOfSubscribers <= subscriberIndex) {
+			throw SMCPException("SMCPTelemetryPredicateFilter: subscriber index should be smaller than 64");
+		}
+		if (MaximumNumberOfSubscribers <= predicates.size()) {
+			throw SMCPException("SMCPTelemetryPredicateFilter: too many predicates");
+		}
+		this->expression = expression;
+		tokenize();
+		nodes.clear();
+		tokenIndex = 0;
+		int root = parseLogicalOr();
+		if (tokenIndex != tokens.size()) {
+			throwParseError("unexpected token", tokens[tokenIndex].position);
+		}
+		size_t depth = getStackDepth(root);
+		if (MaximumStackDepth < depth) {
+			throwParseError("expression is too complex", 0);
+		}
+
+		Predicate predicate;
+		predicate.expression = expression;
+		predicate.subscribers = (uint64_t) 1 << subscriberIndex;
+		predicate.requiredType = -1;
+		predicate.requiredFOID = -1;
+		findRequiredValues(root, predicate);
+
+		//replace the trailing OpEnd with the new predicate, then re-append OpEnd
+		size_t predicateIndex = predicates.size();
+		code.pop_back();
+		size_t begin = code.size();
+		emit(OpBegin, predicateIndex);
+		emitNode(root);
+		emit(OpMatch, predicate.subscribers);
+		size_t next = code.size();
+		for (size_t i = begin; i < next; i++) {
+			if (code[i].opcode == OpBegin || code[i].opcode == OpLoadPayload8 || code[i].opcode == OpLoadPayload16
+					|| code[i].opcode == OpLoadPayload32) {
+				code[i].jump = next;
+			}
+		}
+		emit(OpEnd, 0);
+
+		predicates.push_back(predicate);
+		rebuildCandidateTables();
+		tokens.clear();
+		nodes.clear();
+	}
+
+public:
+	/** Evaluates all predicates against a telemetry message.
+	 * @param[in] view telemetry message.
+	 * @return bitmask of matching subscribers.
+	 */
+	uint64_t evaluate(const SMCPTelemetryMessageView& view) const {
+		int64_t fields[NFields];
+		fields[FieldType] = view.getTelemetryTypeID();
+		fields[FieldVersion] = view.getSMCPVersion();
+		fields[FieldReserved] = view.getReserved();
+		fields[FieldLength] = view.getMessageLength();
+		fields[FieldFOID] = view.getLowerFOID();
+		fields[FieldAttributeID] = view.getAttributeID();
+		fields[FieldValueLength] = view.getAttributeValuesLength();
+		const uint8_t* payload = view.getAttributeValuesAsPointer();
+		size_t payloadLength = view.getAttributeValuesLength();
+		uint64_t candidates = typeCandidates[fields[FieldType]] & foidCandidates[fields[FieldFOID]];
+
+		uint64_t result = 0;
+		int64_t stack[MaximumStackDepth + 1];
+		size_t sp = 0;
+		const Instruction* program = &code[0];
+		size_t pc = 0;
+		while (true) {
+			const Instruction& instruction = program[pc++];
+			switch (instruction.opcode) {
+			case OpBegin:
+				if (((candidates >> instruction.operand) & 1) == 0) {
+					pc = instruction.jump;
+				}
+				sp = 0;
+				break;
+			case OpPush:
+				stack[sp++] = instruction.operand;
+				break;
+			case OpLoadField:
+				stack[sp++] = fields[instruction.operand];
+				break;
+			case OpLoadPayload8:
+				if (payloadLength < (uint64_t) instruction.operand + 1) {
+					pc = instruction.jump;
+					break;
+				}
+				stack[sp++] = payload[instruction.operand];
+				break;
+			case OpLoadPayload16:
+				if (payloadLength < (uint64_t) instruction.operand + 2) {
+					pc = instruction.jump;
+					break;
+				}
+				stack[sp++] = ((int64_t) payload[instruction.operand] << 8) | payload[instruction.operand + 1];
+				break;
+			case OpLoadPayload32:
+				if (payloadLength < (uint64_t) instruction.operand + 4) {
+					pc = instruction.jump;
+					break;
+				}
+				stack[sp++] = ((int64_t) payload[instruction.operand] << 24)
+						| ((int64_t) payload[instruction.operand + 1] << 16)
+						| ((int64_t) payload[instruction.operand + 2] << 8) | payload[instruction.operand + 3];
+				break;
+			case OpNot:
+				stack[sp - 1] = !stack[sp - 1];
+				break;
+			case OpBitNot:
+				stack[sp - 1] = ~stack[sp - 1];
+				break;
+			case OpToBool:
+				stack[sp - 1] = (stack[sp - 1] != 0);
+				break;
+			case OpJumpIfZero:
+				if (stack[sp - 1] == 0) {
+					pc = instruction.jump;
+				} else {
+					sp--;
+				}
+				break;
+			case OpJumpIfNonZero:
+				if (stack[sp - 1] != 0) {
+					pc = instruction.jump;
+				} else {
+					sp--;
+				}
+				break;
+			case OpMatch:
+				if (stack[--sp] != 0) {
+					result |= (uint64_t) instruction.operand;
+				}
+				break;
+			case OpEnd:
+				return result;
+			default:
+				if (instruction.opcode < OpOr + OpImmediateOffset) {
+					sp--;
+					stack[sp - 1] = applyBinaryOperator(instruction.opcode, stack[sp - 1], stack[sp]);
+				} else {
+					stack[sp - 1] = applyBinaryOperator(instruction.opcode - OpImmediateOffset, stack[sp - 1],
+							instruction.operand);
+				}
+				break;
+			}
+		}
+		return result;
+	}
+
+public:
+	/** Evaluates all predicates against a telemetry message stored in a byte array.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @return bitmask of matching subscribers.
+	 */
+	uint64_t evaluate(const uint8_t* data, size_t length) const {
+		SMCPTelemetryMessageView view(data, length);
+		return evaluate(view);
+	}
+
+public:
+	/** Returns the number of predicates. */
+	size_t size() const {
+		return predicates.size();
+	}
+
+public:
+	/** Returns a human-readable listing of the compiled program. */
+	std::string toString() const {
+		std::stringstream ss;
+		for (size_t i = 0; i < predicates.size(); i++) {
+			ss << "predicate " << i << " (subscribers 0x" << std::hex << predicates[i].subscribers << std::dec << ") : "
+					<< predicates[i].expression << std::endl;
+		}
+		for (size_t i = 0; i < code.size(); i++) {
+			ss << i << " : " << getOpcodeName(code[i].opcode) << " " << code[i].operand;
+			if (code[i].opcode == OpBegin || code[i].opcode == OpLoadPayload8 || code[i].opcode == OpLoadPayload16
+					|| code[i].opcode == OpLoadPayload32 || code[i].opcode == OpJumpIfZero
+					|| code[i].opcode == OpJumpIfNonZero) {
+				ss << " -> " << code[i].jump;
+			}
+			ss << std::endl;
+		}
+		return ss.str();
+	}
+
+private:
+	static int64_t applyBinaryOperator(int opcode, int64_t a, int64_t b) {
+		switch (opcode) {
+		case OpOr:
+			return a | b;
+		case OpXor:
+			return a ^ b;
+		case OpAnd:
+			return a & b;
+		case OpShiftLeft:
+			return (0 <= b && b < 64) ? (int64_t) ((uint64_t) a << b) : 0;
+		case OpShiftRight:
+			return (0 <= b && b < 64) ? (a >> b) : 0;
+		case OpEqual:
+			return a == b;
+		case OpNotEqual:
+			return a != b;
+		case OpLess:
+			return a < b;
+		case OpLessEqual:
+			return a <= b;
+		case OpGreater:
+			return a > b;
+		case OpGreaterEqual:
+			return a >= b;
+		default:
+			return 0;
+		}
+	}
+
+private:
+	static std::string getOpcodeName(int opcode) {
+		static const char* names[] = { "Begin", "Push", "LoadField", "LoadPayload8", "LoadPayload16", "LoadPayload32",
+				"Not", "BitNot", "ToBool", "JumpIfZero", "JumpIfNonZero", "Match", "End", "Or", "Xor", "And",
+				"ShiftLeft", "ShiftRight", "Equal", "NotEqual", "Less", "LessEqual", "Greater", "GreaterEqual" };
+		if (OpOr + OpImmediateOffset <= opcode) {
+			return std::string(names[opcode - OpImmediateOffset]) + "Imm";
+		}
+		return names[opcode];
+	}
+
+private:
+	void rebuildCandidateTables() {
+		for (size_t i = 0; i < 16; i++) {
+			typeCandidates[i] = 0;
+		}
+		for (size_t i = 0; i < 256; i++) {
+			foidCandidates[i] = 0;
+		}
+		for (size_t k = 0; k < predicates.size(); k++) {
+			uint64_t bit = (uint64_t) 1 << k;
+			for (int i = 0; i < 16; i++) {
+				if (predicates[k].requiredType < 0 || predicates[k].requiredType == i) {
+					typeCandidates[i] |= bit;
+				}
+			}
+			for (int i = 0; i < 256; i++) {
+				if (predicates[k].requiredFOID < 0 || predicates[k].requiredFOID == i) {
+					foidCandidates[i] |= bit;
+				}
+			}
+		}
+	}
+
+	/* ---------------- code generation ---------------- */
+
+private:
+	void emit(int opcode, int64_t operand) {
+		Instruction instruction;
+		instruction.opcode = opcode;
+		instruction.operand = operand;
+		instruction.jump = 0;
+		code.push_back(instruction);
+	}
+
+private:
+	void emitNode(int index) {
+		const Node node = nodes[index];
+		switch (node.kind) {
+		case NodeConstant:
+			emit(OpPush, node.value);
+			break;
+		case NodeField:
+			emit(OpLoadField, node.value);
+			break;
+		case NodePayload8:
+			emit(OpLoadPayload8, node.value);
+			break;
+		case NodePayload16:
+			emit(OpLoadPayload16, node.value);
+			break;
+		case NodePayload32:
+			emit(OpLoadPayload32, node.value);
+			break;
+		case NodeUnary:
+			emitNode(node.left);
+			emit(node.op, 0);
+			break;
+		case NodeBinary:
+			emitNode(node.left);
+			if (nodes[node.right].kind == NodeConstant) {
+				emit(node.op + OpImmediateOffset, nodes[node.right].value);
+			} else {
+				emitNode(node.right);
+				emit(node.op, 0);
+			}
+			break;
+		case NodeLogicalAnd:
+		case NodeLogicalOr: {
+			emitNode(node.left);
+			emitToBool(node.left);
+			size_t jump = code.size();
+			emit(node.kind == NodeLogicalAnd ? OpJumpIfZero : OpJumpIfNonZero, 0);
+			emitNode(node.right);
+			emitToBool(node.right);
+			code[jump].jump = code.size();
+			break;
+		}
+		}
+	}
+
+private:
+	/** Emits OpToBool unless the node already yields 0 or 1. */
+	void emitToBool(int index) {
+		const Node& node = nodes[index];
+		bool isBoolean = node.kind == NodeLogicalAnd || node.kind == NodeLogicalOr
+				|| (node.kind == NodeUnary && node.op == OpNot)
+				|| (node.kind == NodeBinary && OpEqual <= node.op && node.op <= OpGreaterEqual);
+		if (!isBoolean) {
+			emit(OpToBool, 0);
+		}
+	}
+
+private:
+	size_t getStackDepth(int index) const {
+		const Node& node = nodes[index];
+		switch (node.kind) {
+		case NodeUnary:
+			return getStackDepth(node.left);
+		case NodeBinary:
+		case NodeLogicalAnd:
+		case NodeLogicalOr: {
+			size_t left = getStackDepth(node.left);
+			size_t right = getStackDepth(node.right) + 1;
+			return (left < right) ? right : left;
+		}
+		default:
+			return 1;
+		}
+	}
+
+private:
+	void findRequiredValues(int index, Predicate& predicate) const {
+		const Node& node = nodes[index];
+		if (node.kind == NodeLogicalAnd) {
+			findRequiredValues(node.left, predicate);
+			findRequiredValues(node.right, predicate);
+		} else if (node.kind == NodeBinary && node.op == OpEqual) {
+			const Node& left = nodes[node.left];
+			const Node& right = nodes[node.right];
+			if (left.kind == NodeField && right.kind == NodeConstant) {
+				if (left.value == FieldType && 0 <= right.value && right.value < 16) {
+					predicate.requiredType = (int) right.value;
+				} else if (left.value == FieldFOID && 0 <= right.value && right.value < 256) {
+					predicate.requiredFOID = (int) right.value;
+				}
+			}
+		}
+	}
+
+	/* ---------------- parser ---------------- */
+
+private:
+	void throwParseError(std::string message, size_t position) const {
+		std::stringstream ss;
+		ss << "SMCPTelemetryPredicateFilter: " << message << " at position " << position << " in \"" << expression
+				<< "\"";
+		throw SMCPException(ss.str());
+	}
+
+private:
+	void tokenize() {
+		tokens.clear();
+		size_t i = 0;
+		const std::string& s = expression;
+		while (i < s.size()) {
+			char c = s[i];
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+				i++;
+				continue;
+			}
+			Token token;
+			token.position = i;
+			token.isNumber = false;
+			token.value = 0;
+			if ('0' <= c && c <= '9') {
+				size_t start = i;
+				int base = 10;
+				if (c == '0' && i + 1 < s.size() && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+					base = 16;
+					i += 2;
+				}
+				uint64_t value = 0;
+				size_t nDigits = 0;
+				while (i < s.size()) {
+					int digit = toDigit(s[i]);
+					if (digit < 0 || base <= digit) {
+						break;
+					}
+					value = value * base + digit;
+					i++;
+					nDigits++;
+				}
+				if (nDigits == 0 || (i < s.size() && (isalnum((unsigned char) s[i]) || s[i] == '_'))) {
+					throwParseError("invalid number", start);
+				}
+				token.text = s.substr(start, i - start);
+				token.isNumber = true;
+				token.value = (int64_t) value;
+			} else if (isalpha((unsigned char) c) || c == '_') {
+				size_t start = i;
+				while (i < s.size() && (isalnum((unsigned char) s[i]) || s[i] == '_')) {
+					i++;
+				}
+				token.text = s.substr(start, i - start);
+			} else {
+				static const char* operators[] = { "||", "&&", "==", "!=", "<=", ">=", "<<", ">>", "<", ">", "|", "^",
+						"&", "!", "~", "(", ")", "[", "]" };
+				bool found = false;
+				for (size_t k = 0; k < sizeof(operators) / sizeof(operators[0]); k++) {
+					std::string op = operators[k];
+					if (s.compare(i, op.size(), op) == 0) {
+						token.text = op;
+						i += op.size();
+						found = true;
+						break;
+					}
+				}
+				if (!found) {
+					throwParseError("unexpected character", i);
+				}
+			}
+			tokens.push_back(token);
+		}
+	}
+
+private:
+	static int toDigit(char c) {
+		if ('0' <= c && c <= '9') {
+			return c - '0';
+		} else if ('a' <= c && c <= 'f') {
+			return c - 'a' + 10;
+		} else if ('A' <= c && c <= 'F') {
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+private:
+	bool accept(const char* text) {
+		if (tokenIndex < tokens.size() && !tokens[tokenIndex].isNumber && tokens[tokenIndex].text == text) {
+			tokenIndex++;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	void expect(const char* text) {
+		if (!accept(text)) {
+			throwParseError(std::string("'") + text + "' expected", currentPosition());
+		}
+	}
+
+private:
+	size_t currentPosition() const {
+		return (tokenIndex < tokens.size()) ? tokens[tokenIndex].position : expression.size();
+	}
+
+private:
+	int addNode(int kind, int op, int64_t value, int left, int right) {
+		Node node;
+		node.kind = kind;
+		node.op = op;
+		node.value = value;
+		node.left = left;
+		node.right = right;
+		nodes.push_back(node);
+		return (int) nodes.size() - 1;
+	}
+
+private:
+	int addBinaryNode(int op, int left, int right) {
+		if (nodes[left].kind == NodeConstant && nodes[right].kind == NodeConstant) {
+			return addNode(NodeConstant, 0, applyBinaryOperator(op, nodes[left].value, nodes[right].value), -1, -1);
+		}
+		return addNode(NodeBinary, op, 0, left, right);
+	}
+
+private:
+	int parseLogicalOr() {
+		int left = parseLogicalAnd();
+		while (accept("||")) {
+			left = addNode(NodeLogicalOr, 0, 0, left, parseLogicalAnd());
+		}
+		return left;
+	}
+
+private:
+	int parseLogicalAnd() {
+		int left = parseComparison();
+		while (accept("&&")) {
+			left = addNode(NodeLogicalAnd, 0, 0, left, parseComparison());
+		}
+		return left;
+	}
+
+private:
+	int parseComparison() {
+		int left = parseBitOr();
+		while (true) {
+			int op;
+			if (accept("==")) {
+				op = OpEqual;
+			} else if (accept("!=")) {
+				op = OpNotEqual;
+			} else if (accept("<=")) {
+				op = OpLessEqual;
+			} else if (accept(">=")) {
+				op = OpGreaterEqual;
+			} else if (accept("<")) {
+				op = OpLess;
+			} else if (accept(">")) {
+				op = OpGreater;
+			} else {
+				return left;
+			}
+			int right = parseBitOr();
+			//keep constants on the right so that immediate instructions can be used
+			if (nodes[left].kind == NodeConstant && nodes[right].kind != NodeConstant) {
+				std::swap(left, right);
+				op = getSwappedComparison(op);
+			}
+			left = addBinaryNode(op, left, right);
+		}
+	}
+
+private:
+	static int getSwappedComparison(int op) {
+		switch (op) {
+		case OpLess:
+			return OpGreater;
+		case OpLessEqual:
+			return OpGreaterEqual;
+		case OpGreater:
+			return OpLess;
+		case OpGreaterEqual:
+			return OpLessEqual;
+		default:
+			return op;
+		}
+	}
+
+private:
+	int parseBitOr() {
+		int left = parseBitXor();
+		while (accept("|")) {
+			left = addBinaryNode(OpOr, left, parseBitXor());
+		}
+		return left;
+	}
+
+private:
+	int parseBitXor() {
+		int left = parseBitAnd();
+		while (accept("^")) {
+			left = addBinaryNode(OpXor, left, parseBitAnd());
+		}
+		return left;
+	}
+
+private:
+	int parseBitAnd() {
+		int left = parseShift();
+		while (accept("&")) {
+			left = addBinaryNode(OpAnd, left, parseShift());
+		}
+		return left;
+	}
+
+private:
+	int parseShift() {
+		int left = parseUnary();
+		while (true) {
+			if (accept("<<")) {
+				left = addBinaryNode(OpShiftLeft, left, parseUnary());
+			} else if (accept(">>")) {
+				left = addBinaryNode(OpShiftRight, left, parseUnary());
+			} else {
+				return left;
+			}
+		}
+	}
+
+private:
+	int parseUnary() {
+		if (accept("!")) {
+			int operand = parseUnary();
+			if (nodes[operand].kind == NodeConstant) {
+				return addNode(NodeConstant, 0, !nodes[operand].value, -1, -1);
+			}
+			return addNode(NodeUnary, OpNot, 0, operand, -1);
+		} else if (accept("~")) {
+			int operand = parseUnary();
+			if (nodes[operand].kind == NodeConstant) {
+				return addNode(NodeConstant, 0, ~nodes[operand].value, -1, -1);
+			}
+			return addNode(NodeUnary, OpBitNot, 0, operand, -1);
+		}
+		return parsePrimary();
+	}
+
+private:
+	int parsePrimary() {
+		if (tokens.size() <= tokenIndex) {
+			throwParseError("unexpected end of expression", expression.size());
+		}
+		Token token = tokens[tokenIndex];
+		if (token.isNumber) {
+			tokenIndex++;
+			return addNode(NodeConstant, 0, token.value, -1, -1);
+		}
+		if (accept("(")) {
+			int inner = parseLogicalOr();
+			expect(")");
+			return inner;
+		}
+		tokenIndex++;
+		const std::string& name = token.text;
+		if (name == "payload" || name == "payload16" || name == "payload32") {
+			expect("[");
+			if (tokens.size() <= tokenIndex || !tokens[tokenIndex].isNumber) {
+				throwParseError("constant index expected", currentPosition());
+			}
+			int64_t offset = tokens[tokenIndex++].value;
+			if (offset < 0 || 0xFFFFFF < offset) {
+				throwParseError("index out of range", tokens[tokenIndex - 1].position);
+			}
+			expect("]");
+			int kind = (name == "payload") ? NodePayload8 : (name == "payload16") ? NodePayload16 : NodePayload32;
+			return addNode(kind, 0, offset, -1, -1);
+		}
+		static const char* fieldNames[] = { "type", "version", "reserved", "length", "foid", "aid", "valuelength" };
+		for (size_t i = 0; i < NFields; i++) {
+			if (name == fieldNames[i]) {
+				return addNode(NodeField, 0, i, -1, -1);
+			}
+		}
+		if (name == "ValueTelemetry") {
+			return addNode(NodeConstant, 0, SMCPTelemetryTypeID::ValueTelemetry, -1, -1);
+		} else if (name == "NotificationTelemetry") {
+			return addNode(NodeConstant, 0, SMCPTelemetryTypeID::NotificationTelemetry, -1, -1);
+		} else if (name == "AcknowledgeTelemetry") {
+			return addNode(NodeConstant, 0, SMCPTelemetryTypeID::AcknowledgeTelemetry, -1, -1);
+		} else if (name == "MemoryDumpTelemetry") {
+			return addNode(NodeConstant, 0, SMCPTelemetryTypeID::MemoryDumpTelemetry, -1, -1);
+		}
+		throwParseError("unknown identifier '" + name + "'", token.position);
+		return -1;
+	}
+};
+
+#endif /* SMCPTELEMETRYPREDICATEFILTER_HH_ */
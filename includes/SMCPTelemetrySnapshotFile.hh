@@ -0,0 +1,378 @@
+/*
+ * SMCPTelemetrySnapshotFile.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYSNAPSHOTFILE_HH_
+#define SMCPTELEMETRYSNAPSHOTFILE_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <string>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPCurrentValueTable.hh"
+#include "SMCPException.hh"
+
+/** A memory-mapped file which keeps the latest Attribute Value of each
+ * (lowerFOID, AttributeID), so that SMCPCurrentValueTable can be restored in
+ * milliseconds after a restart instead of waiting for a full telemetry cycle.
+ *
+ * The file is a fixed-size open-addressing hash table, updated in place
+ * through a shared mapping; an update is a few stores into the page cache,
+ * and the kernel writes the pages back in the background (call sync() to
+ * force it). The header records a format version, the table geometry, and
+ * whether the file was closed cleanly. A file whose header does not match
+ * the constructor arguments is reinitialized. Each slot carries a sequence
+ * number which is odd while the slot is being written; a slot left odd by a
+ * crash of the writing process is discarded when the file is opened (see
+ * getNDiscarded()). Torn values are detected only after a crash of the
+ * process, whose stores survive in the page cache. After a power loss or a
+ * kernel crash, updates since the last sync(true) may be lost, and a slot
+ * whose pages were written back at different moments may hold a torn value
+ * with an even sequence number.
+ *
+ * The file is written by one thread of one process. The update count of an
+ * attribute is not restored by loadInto(); the restored entries start from 1.
+ *
+ * Example usage:
+ * @code
+ * SMCPCurrentValueTable table;
+ * SMCPTelemetrySnapshotFile snapshotFile("/var/lib/smcp/current_values.bin");
+ * snapshotFile.loadInto(table); //displays are complete at once
+ * ...for each received telemetry message...
+ * table.update(message, receiveTime);
+ * snapshotFile.update(message, receiveTime);
+ * @endcode
+ */
+class SMCPTelemetrySnapshotFile {
+public:
+	static const uint64_t Magic = 0x31504E53504D4353ULL; //"SMCPSNP1"
+	static const uint32_t Version = 1;
+	static const size_t HeaderLength = 64;
+	static const size_t SlotHeaderLength = 32;
+
+private:
+	/** Layout of the first HeaderLength bytes of the file. */
+	class Header {
+	public:
+		uint64_t magic;
+		uint32_t version;
+		/** Non-zero while the file is open for writing. */
+		uint32_t dirty;
+		uint64_t nSlots;
+		uint64_t maximumValueLength;
+		uint64_t slotLength;
+		uint64_t nEntries;
+		uint64_t generation;
+		uint64_t reserved;
+	};
+
+private:
+	/** Layout of the head of a slot; Attribute Value bytes follow. */
+	class Slot {
+	public:
+		uint32_t key; //0 = empty
+		uint32_t sequence; //odd while being written
+		uint32_t length;
+		uint32_t reserved;
+		uint64_t receiveTime;
+		/** 0 if the slot holds no valid value (e.g. discarded after a crash). */
+		uint64_t updateCount;
+	};
+
+private:
+	static const uint32_t OccupiedFlag = 0x01000000;
+
+private:
+	std::string path;
+	int fd;
+	uint8_t* mapping;
+	size_t mappingLength;
+	Header* header;
+	size_t capacity;
+	size_t maximumValueLength;
+	size_t nSlots;
+	size_t slotLength;
+	size_t mask;
+	bool restored;
+	bool cleanlyClosed;
+	size_t nDiscarded;
+
+public:
+	/** Constructor. Opens (or creates) a snapshot file.
+	 * @param[in] path path of the file.
+	 * @param[in] capacity maximum number of (lowerFOID, AttributeID) pairs.
+	 * @param[in] maximumValueLength number of Attribute Value bytes stored per pair.
+	 */
+	SMCPTelemetrySnapshotFile(std::string path, size_t capacity = SMCPCurrentValueTable::DefaultCapacity,
+			size_t maximumValueLength = SMCPCurrentValueTable::DefaultMaximumValueLength) :
+			path(path), fd(-1), mapping(NULL), mappingLength(0), header(NULL), capacity(capacity),
+			maximumValueLength(maximumValueLength), nSlots(1), slotLength(0), mask(0), restored(false),
+			cleanlyClosed(false), nDiscarded(0) {
+		if (capacity == 0) {
+			throw SMCPException("SMCPTelemetrySnapshotFile: capacity should be larger than 0");
+		}
+		while (nSlots < capacity * 2) {
+			nSlots <<= 1;
+		}
+		mask = nSlots - 1;
+		slotLength = SlotHeaderLength + ((maximumValueLength + 7) & ~(size_t) 7);
+		mappingLength = HeaderLength + nSlots * slotLength;
+
+		fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) {
+			throw SMCPException(std::string("SMCPTelemetrySnapshotFile: cannot open ") + path + ": " + strerror(errno));
+		}
+		struct stat status;
+		bool reuse = (fstat(fd, &status) == 0 && (size_t) status.st_size == mappingLength);
+		if (!reuse) {
+			if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t) mappingLength) != 0) {
+				int error = errno;
+				close(fd);
+				throw SMCPException(std::string("SMCPTelemetrySnapshotFile: cannot resize ") + path + ": " + strerror(error));
+			}
+		}
+		void* p = mmap(NULL, mappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			int error = errno;
+			close(fd);
+			throw SMCPException(std::string("SMCPTelemetrySnapshotFile: cannot map ") + path + ": " + strerror(error));
+		}
+		mapping = (uint8_t*) p;
+		header = (Header*) mapping;
+
+		if (reuse && header->magic == Magic && header->version == Version && header->nSlots == nSlots
+				&& header->maximumValueLength == maximumValueLength && header->slotLength == slotLength) {
+			restored = true;
+			cleanlyClosed = (header->dirty == 0);
+			recover();
+		} else {
+			memset(mapping, 0, mappingLength);
+			header->version = Version;
+			header->nSlots = nSlots;
+			header->maximumValueLength = maximumValueLength;
+			header->slotLength = slotLength;
+			header->magic = Magic;
+		}
+		header->dirty = 1;
+	}
+
+public:
+	/** Destructor. Writes the file back and marks it as cleanly closed. */
+	~SMCPTelemetrySnapshotFile() {
+		msync(mapping, mappingLength, MS_SYNC);
+		header->dirty = 0;
+		msync(mapping, HeaderLength, MS_SYNC);
+		munmap(mapping, mappingLength);
+		close(fd);
+	}
+
+public:
+	/** Stores the latest value of an attribute.
+	 * @param[in] lowerFOID Lower FOID of the telemetry.
+	 * @param[in] attributeID Attribute ID of the telemetry.
+	 * @param[in] value pointer to the Attribute Value bytes.
+	 * @param[in] length length of the Attribute Value (truncated to the maximum value length).
+	 * @param[in] receiveTime receive time in nanoseconds since the epoch.
+	 */
+	void update(uint8_t lowerFOID, uint16_t attributeID, const uint8_t* value, size_t length, uint64_t receiveTime) {
+		Slot* slot = getSlot(findOrInsert(toKey(lowerFOID, attributeID)));
+		size_t storedLength = (length < maximumValueLength) ? length : maximumValueLength;
+		uint32_t sequence = slot->sequence;
+		slot->sequence = sequence + 1;
+		//keep the compiler from moving the value stores out of the odd period;
+		//a crashed process leaves its stores in the page cache in program order
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		memcpy((uint8_t*) slot + SlotHeaderLength, value, storedLength);
+		slot->length = (uint32_t) storedLength;
+		slot->receiveTime = receiveTime;
+		slot->updateCount++;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		slot->sequence = sequence + 2;
+		header->generation++;
+	}
+
+public:
+	/** Stores the Attribute Value of a Value Telemetry message.
+	 * Messages of other telemetry types are ignored.
+	 * @return true if the message was stored.
+	 */
+	bool update(SMCPTelemetryMessage& message, uint64_t receiveTime) {
+		SMCPTelemetryMessageHeader* messageHeader = message.getMessageHeader();
+		if (messageHeader->getTelemetryTypeID().to_ulong() != SMCPTelemetryTypeID::ValueTelemetry) {
+			return false;
+		}
+		SMCPTelemetryMessageData* data = message.getMessageData();
+		update(messageHeader->getLowerFOID(), data->getAttributeID(), data->getAttributeValuesAsPointer(),
+				data->getAttributeValuesLength(), receiveTime);
+		return true;
+	}
+
+public:
+	/** Stores the Attribute Value of a Value Telemetry message placed in a view.
+	 * Messages of other telemetry types are ignored.
+	 * @return true if the message was stored.
+	 */
+	bool update(const SMCPTelemetryMessageView& message, uint64_t receiveTime) {
+		if (message.getTelemetryTypeID() != SMCPTelemetryTypeID::ValueTelemetry) {
+			return false;
+		}
+		update(message.getLowerFOID(), message.getAttributeID(), message.getAttributeValuesAsPointer(),
+				message.getAttributeValuesLength(), receiveTime);
+		return true;
+	}
+
+public:
+	/** Stores all entries of a snapshot of SMCPCurrentValueTable (e.g. periodically, instead of per message). */
+	void store(const SMCPCurrentValueTable::Snapshot& snapshot) {
+		for (size_t i = 0; i < snapshot.size(); i++) {
+			const SMCPCurrentValueTable::Snapshot::Entry& entry = snapshot.entries[i];
+			update(entry.lowerFOID, entry.attributeID, snapshot.getValueAsPointer(i), entry.storedLength,
+					entry.receiveTime);
+		}
+	}
+
+public:
+	/** Copies the stored values into a table, keeping their receive times.
+	 * @return the number of entries loaded.
+	 */
+	size_t loadInto(SMCPCurrentValueTable& table) const {
+		size_t n = 0;
+		for (size_t i = 0; i < nSlots; i++) {
+			const Slot* slot = getSlot(i);
+			if (slot->key == 0 || slot->updateCount == 0) {
+				continue;
+			}
+			table.update((slot->key >> 16) & 0xFF, slot->key & 0xFFFF, (const uint8_t*) slot + SlotHeaderLength,
+					slot->length, slot->receiveTime);
+			n++;
+		}
+		return n;
+	}
+
+public:
+	/** Writes modified pages back to the file.
+	 * @param[in] synchronous if true, waits until the data are on storage.
+	 */
+	void sync(bool synchronous = false) {
+		if (msync(mapping, mappingLength, synchronous ? MS_SYNC : MS_ASYNC) != 0) {
+			throw SMCPException(std::string("SMCPTelemetrySnapshotFile: msync failed: ") + strerror(errno));
+		}
+	}
+
+public:
+	/** Returns true if the file contained a snapshot of the same geometry when opened. */
+	bool wasRestored() const {
+		return restored;
+	}
+
+public:
+	/** Returns true if the restored file had been closed cleanly (false after a crash). */
+	bool wasCleanlyClosed() const {
+		return cleanlyClosed;
+	}
+
+public:
+	/** Returns the number of slots discarded when opening because they were being written at a crash. */
+	size_t getNDiscarded() const {
+		return nDiscarded;
+	}
+
+public:
+	/** Returns the number of (lowerFOID, AttributeID) pairs in the file. */
+	size_t size() const {
+		return (size_t) header->nEntries;
+	}
+
+public:
+	/** Returns a counter incremented on every update (persisted across restarts). */
+	uint64_t getGeneration() const {
+		return header->generation;
+	}
+
+public:
+	size_t getCapacity() const {
+		return capacity;
+	}
+
+public:
+	const std::string& getPath() const {
+		return path;
+	}
+
+private:
+	static uint32_t toKey(uint8_t lowerFOID, uint16_t attributeID) {
+		return OccupiedFlag | ((uint32_t) lowerFOID << 16) | attributeID;
+	}
+
+private:
+	static size_t hash(uint32_t key) {
+		key ^= key >> 15;
+		key *= 0x2c1b3c6dU;
+		key ^= key >> 12;
+		return key;
+	}
+
+private:
+	Slot* getSlot(size_t index) const {
+		return (Slot*) (mapping + HeaderLength + index * slotLength);
+	}
+
+private:
+	size_t findOrInsert(uint32_t key) {
+		size_t i = hash(key) & mask;
+		while (true) {
+			uint32_t slotKey = getSlot(i)->key;
+			if (slotKey == key) {
+				return i;
+			} else if (slotKey == 0) {
+				break;
+			}
+			i = (i + 1) & mask;
+		}
+		if (header->nEntries == capacity) {
+			throw SMCPException("SMCPTelemetrySnapshotFile: file is full");
+		}
+		Slot* slot = getSlot(i);
+		slot->sequence = 0;
+		slot->length = 0;
+		slot->receiveTime = 0;
+		slot->updateCount = 0;
+		slot->key = key;
+		header->nEntries++;
+		return i;
+	}
+
+private:
+	/** Invalidates slots torn by a crash and recounts the entries. */
+	void recover() {
+		size_t n = 0;
+		for (size_t i = 0; i < nSlots; i++) {
+			Slot* slot = getSlot(i);
+			if (slot->key == 0) {
+				continue;
+			}
+			n++;
+			if ((slot->sequence & 1) != 0 || maximumValueLength < slot->length
+					|| (slot->key & 0xFF000000) != OccupiedFlag) {
+				//the key is kept so that probe sequences stay intact
+				slot->sequence = 0;
+				slot->updateCount = 0;
+				slot->length = 0;
+				nDiscarded++;
+			}
+		}
+		header->nEntries = n;
+	}
+};
+
+#endif /* SMCPTELEMETRYSNAPSHOTFILE_HH_ */
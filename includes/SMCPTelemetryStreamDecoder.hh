@@ -0,0 +1,211 @@
+/*
+ * SMCPTelemetryStreamDecoder.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYSTREAMDECODER_HH_
+#define SMCPTELEMETRYSTREAMDECODER_HH_
+
+#include <stdint.h>
+#include <string.h>
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** An interface which receives telemetry messages decoded by SMCPTelemetryStreamDecoder.
+ * For each message, onMessageBegin() is invoked once, onAttributeValue() zero
+ * or more times with consecutive pieces of the Attribute Value, and
+ * onMessageEnd() once after the last piece.
+ */
+class SMCPTelemetryStreamSink {
+public:
+	virtual ~SMCPTelemetryStreamSink() {
+	}
+
+public:
+	/** Invoked when the header and the Attribute ID of a message have been received.
+	 * @param[in] telemetryTypeID Telemetry Type ID (see SMCPTelemetryTypeID).
+	 * @param[in] lowerFOID Lower FOID.
+	 * @param[in] attributeID Attribute ID.
+	 * @param[in] messageLength value of the Message Length field.
+	 */
+	virtual void onMessageBegin(uint8_t telemetryTypeID, uint8_t lowerFOID, uint16_t attributeID,
+			size_t messageLength) = 0;
+
+public:
+	/** Invoked with a piece of the Attribute Value.
+	 * @param[in] data Attribute Value bytes (valid only during the call; points into the fed fragment).
+	 * @param[in] length number of bytes.
+	 * @param[in] offset offset of data[0] in the Attribute Value.
+	 */
+	virtual void onAttributeValue(const uint8_t* data, size_t length, size_t offset) = 0;
+
+public:
+	/** Invoked when the last byte of the message has been delivered. */
+	virtual void onMessageEnd() = 0;
+};
+
+/** A class which decodes a stream of telemetry messages fed in fragments of any size.
+ *
+ * Unlike SMCPTelemetryMessage::interpretAsTelemetryMessage(), which needs the
+ * whole message (up to 16 MB) in memory and copies it, the decoder keeps
+ * only the 7-octet header and Attribute ID in a staging buffer and passes
+ * the Attribute Value to SMCPTelemetryStreamSink directly from the fed
+ * fragments. Memory use is therefore constant regardless of message size.
+ *
+ * When a Message Length shorter than the minimum message is found, the
+ * decoder stops and hasError() returns true until reset() is called.
+ *
+ * Example usage:
+ * @code
+ * class DumpWriter: public SMCPTelemetryStreamSink {
+ * 	...
+ * 	void onAttributeValue(const uint8_t* data, size_t length, size_t offset) {
+ * 		fwrite(data, 1, length, file);
+ * 	}
+ * 	...
+ * };
+ * DumpWriter writer;
+ * SMCPTelemetryStreamDecoder decoder(&writer);
+ * while ((n = recv(socket, buffer, sizeof(buffer), 0)) > 0) {
+ * 	decoder.feed(buffer, n);
+ * }
+ * @endcode
+ */
+class SMCPTelemetryStreamDecoder {
+public:
+	/** Length of the header and the Attribute ID. */
+	static const size_t StagingLength = SMCPTelemetryMessageView::HeaderLength + 2;
+
+private:
+	SMCPTelemetryStreamSink* sink;
+	uint8_t staging[StagingLength];
+	size_t nStaged;
+	size_t valueLength;
+	size_t valueOffset;
+	bool error;
+
+private:
+	uint64_t nMessages;
+	uint64_t nBytes;
+
+public:
+	/** Constructor.
+	 * @param[in] sink receiver of decoded messages.
+	 */
+	SMCPTelemetryStreamDecoder(SMCPTelemetryStreamSink* sink) :
+			sink(sink), nStaged(0), valueLength(0), valueOffset(0), error(false), nMessages(0), nBytes(0) {
+		if (sink == NULL) {
+			throw SMCPException("SMCPTelemetryStreamDecoder: sink should not be NULL");
+		}
+	}
+
+public:
+	/** Decodes a fragment of the stream.
+	 * @param[in] data fragment.
+	 * @param[in] length length of the fragment.
+	 * @return number of bytes consumed (less than length only when an error is found,
+	 * in which case the invalid header is the last part consumed).
+	 *
+	 * If the sink throws, the exception propagates and getNBytes() includes the
+	 * bytes consumed before it (a piece is consumed once onAttributeValue() has
+	 * returned). Call reset() before feeding more data to discard the partial message.
+	 */
+	size_t feed(const uint8_t* data, size_t length) {
+		size_t position = 0;
+		while (position < length && !error) {
+			if (nStaged < StagingLength) {
+				size_t n = StagingLength - nStaged;
+				if (length - position < n) {
+					n = length - position;
+				}
+				memcpy(staging + nStaged, data + position, n);
+				nStaged += n;
+				position += n;
+				nBytes += n;
+				if (nStaged < StagingLength) {
+					break;
+				}
+				size_t messageLength = SMCPTelemetryMessageView::getMessageLength(staging);
+				if (messageLength < SMCPTelemetryMessageView::MinimumMessageLength) {
+					error = true;
+					break;
+				}
+				valueLength = messageLength - StagingLength;
+				valueOffset = 0;
+				sink->onMessageBegin(staging[0] & 0x0F, staging[4], (uint16_t) ((staging[5] << 8) | staging[6]),
+						messageLength);
+			}
+			size_t n = valueLength - valueOffset;
+			if (length - position < n) {
+				n = length - position;
+			}
+			if (n != 0) {
+				sink->onAttributeValue(data + position, n, valueOffset);
+				valueOffset += n;
+				position += n;
+				nBytes += n;
+			}
+			if (valueOffset == valueLength) {
+				nStaged = 0;
+				nMessages++;
+				sink->onMessageEnd();
+			}
+		}
+		return position;
+	}
+
+public:
+	/** Discards a partially received message and clears the error. */
+	void reset() {
+		nStaged = 0;
+		valueLength = 0;
+		valueOffset = 0;
+		error = false;
+	}
+
+public:
+	/** Returns true if an invalid Message Length has been found. */
+	bool hasError() const {
+		return error;
+	}
+
+public:
+	/** Returns true if a message has been started but not completed. */
+	bool isInMessage() const {
+		return nStaged != 0;
+	}
+
+public:
+	/** Returns the number of bytes still expected for the current message
+	 * (0 between messages; a lower bound while the header is incomplete).
+	 */
+	size_t getNRemainingBytes() const {
+		if (nStaged == 0) {
+			return 0;
+		} else if (nStaged < StagingLength) {
+			return SMCPTelemetryMessageView::MinimumMessageLength - nStaged;
+		}
+		return valueLength - valueOffset;
+	}
+
+public:
+	/** Returns the header and Attribute ID of the current message (valid after onMessageBegin()). */
+	const uint8_t* getHeaderAsPointer() const {
+		return staging;
+	}
+
+public:
+	/** Returns the number of completed messages. */
+	uint64_t getNMessages() const {
+		return nMessages;
+	}
+
+public:
+	/** Returns the number of bytes consumed. */
+	uint64_t getNBytes() const {
+		return nBytes;
+	}
+};
+
+#endif /* SMCPTELEMETRYSTREAMDECODER_HH_ */
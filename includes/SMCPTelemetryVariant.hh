@@ -0,0 +1,193 @@
+/*
+ * SMCPTelemetryVariant.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTELEMETRYVARIANT_HH_
+#define SMCPTELEMETRYVARIANT_HH_
+
+#if __cplusplus < 201703L
+#error "SMCPTelemetryVariant.hh requires C++17 (std::variant)"
+#endif
+
+#include <stdint.h>
+#include <utility>
+#include <variant>
+#include "SMCPTypeClasses.hh"
+#include "SMCPTelemetryMessage.hh"
+#include "SMCPTelemetryMessageView.hh"
+#include "SMCPException.hh"
+
+/** A read-only view of a telemetry message whose Telemetry Type ID is known at compile time.
+ * The view adds no state to SMCPTelemetryMessageView; getTelemetryTypeID()
+ * returns a constant, and copyTo() fills the corresponding concrete message
+ * class (e.g. SMCPValueTelemetryMessage).
+ * Instances are obtained from SMCPTelemetryDispatcher.
+ */
+template<uint8_t TypeID, typename MessageClass>
+class SMCPTypedTelemetryView: public SMCPTelemetryMessageView {
+public:
+	typedef MessageClass MessageType;
+
+public:
+	static constexpr uint8_t TelemetryTypeID = TypeID;
+
+public:
+	/** Constructor. Constructs an empty view. */
+	SMCPTypedTelemetryView() {
+	}
+
+public:
+	/** Constructor.
+	 * @param[in] view view placed on a message whose Telemetry Type ID equals TypeID.
+	 */
+	explicit SMCPTypedTelemetryView(const SMCPTelemetryMessageView& view) :
+			SMCPTelemetryMessageView(view) {
+	}
+
+public:
+	/** Returns Telemetry Type ID (a compile-time constant). */
+	constexpr uint8_t getTelemetryTypeID() const {
+		return TypeID;
+	}
+
+public:
+	/** Copies the viewed message into an instance of the concrete message class.
+	 * @param[out] message destination.
+	 */
+	void copyTo(MessageClass& message) const {
+		SMCPTelemetryMessageView::copyTo(message);
+	}
+};
+
+typedef SMCPTypedTelemetryView<SMCPTelemetryTypeID::ValueTelemetry, SMCPValueTelemetryMessage> SMCPValueTelemetryView;
+typedef SMCPTypedTelemetryView<SMCPTelemetryTypeID::NotificationTelemetry, SMCPNotificationTelemetryMessage> SMCPNotificationTelemetryView;
+typedef SMCPTypedTelemetryView<SMCPTelemetryTypeID::AcknowledgeTelemetry, SMCPAcknowledgeTelemetryMessage> SMCPAcknowledgeTelemetryView;
+typedef SMCPTypedTelemetryView<SMCPTelemetryTypeID::MemoryDumpTelemetry, SMCPMemoryDumpTelemetryMessage> SMCPMemoryDumpTelemetryView;
+
+/** A view of a telemetry message whose Telemetry Type ID is not defined in SMCPTelemetryTypeID.
+ * getTelemetryTypeID() of the base class returns the actual value.
+ */
+class SMCPUndefinedTelemetryView: public SMCPTelemetryMessageView {
+public:
+	SMCPUndefinedTelemetryView() {
+	}
+
+public:
+	explicit SMCPUndefinedTelemetryView(const SMCPTelemetryMessageView& view) :
+			SMCPTelemetryMessageView(view) {
+	}
+};
+
+/** A telemetry message view typed by its Telemetry Type ID. */
+typedef std::variant<SMCPValueTelemetryView, SMCPNotificationTelemetryView, SMCPAcknowledgeTelemetryView,
+		SMCPMemoryDumpTelemetryView, SMCPUndefinedTelemetryView> SMCPTelemetryVariant;
+
+/** Builds a visitor from lambdas, for use with std::visit() and SMCPTelemetryDispatcher::visit().
+ * @code
+ * std::visit(SMCPOverloaded { [](const SMCPValueTelemetryView& v) {...}, [](const auto& other) {...} }, variant);
+ * @endcode
+ */
+template<typename ... Functions>
+struct SMCPOverloaded: Functions... {
+	using Functions::operator()...;
+};
+
+template<typename ... Functions>
+SMCPOverloaded(Functions...) -> SMCPOverloaded<Functions...>;
+
+/** A class which decodes telemetry messages into views typed by Telemetry Type ID.
+ * Neither heap allocation nor virtual call is involved; the views point into
+ * the given byte array, which must outlive them.
+ *
+ * Example usage:
+ * @code
+ * //as a variant
+ * SMCPTelemetryVariant message = SMCPTelemetryDispatcher::decode(data, length);
+ * if (auto value = std::get_if<SMCPValueTelemetryView>(&message)) {
+ * 	...value->getAttributeID()...
+ * }
+ *
+ * //or directly with a visitor; the handler for each type is called from a
+ * //switch statement and can be inlined
+ * SMCPTelemetryDispatcher::visit(data, length, SMCPOverloaded {
+ * 	[&](const SMCPValueTelemetryView& view) {...},
+ * 	[&](const SMCPMemoryDumpTelemetryView& view) {...},
+ * 	[&](const SMCPTelemetryMessageView& view) {...} //other types
+ * });
+ * @endcode
+ */
+class SMCPTelemetryDispatcher {
+public:
+	/** Calls the visitor with the typed view corresponding to the Telemetry Type ID of a view.
+	 * @param[in] view view placed on a telemetry message.
+	 * @param[in] visitor callable which accepts each of the view types of SMCPTelemetryVariant.
+	 * @return the value returned by the visitor.
+	 */
+	template<typename Visitor>
+	static decltype(auto) dispatch(const SMCPTelemetryMessageView& view, Visitor&& visitor) {
+		switch (view.getTelemetryTypeID()) {
+		case SMCPTelemetryTypeID::ValueTelemetry:
+			return std::forward<Visitor>(visitor)(SMCPValueTelemetryView(view));
+		case SMCPTelemetryTypeID::NotificationTelemetry:
+			return std::forward<Visitor>(visitor)(SMCPNotificationTelemetryView(view));
+		case SMCPTelemetryTypeID::AcknowledgeTelemetry:
+			return std::forward<Visitor>(visitor)(SMCPAcknowledgeTelemetryView(view));
+		case SMCPTelemetryTypeID::MemoryDumpTelemetry:
+			return std::forward<Visitor>(visitor)(SMCPMemoryDumpTelemetryView(view));
+		default:
+			return std::forward<Visitor>(visitor)(SMCPUndefinedTelemetryView(view));
+		}
+	}
+
+public:
+	/** Decodes a telemetry message.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @return typed view of the message.
+	 */
+	static SMCPTelemetryVariant decode(const uint8_t* data, size_t length) {
+		SMCPTelemetryVariant result;
+		if (!tryDecode(data, length, result)) {
+			throw SMCPException("size error");
+		}
+		return result;
+	}
+
+public:
+	/** Decodes a telemetry message without throwing an exception.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @param[out] result typed view of the message (unchanged on failure).
+	 * @return false if the array does not contain a complete telemetry message.
+	 */
+	static bool tryDecode(const uint8_t* data, size_t length, SMCPTelemetryVariant& result) {
+		SMCPTelemetryMessageView view;
+		if (!view.tryInterpretAsTelemetryMessage(data, length)) {
+			return false;
+		}
+		dispatch(view, [&result](auto&& typedView) {
+			result.template emplace<std::decay_t<decltype(typedView)> >(typedView);
+		});
+		return true;
+	}
+
+public:
+	/** Decodes a telemetry message and calls the visitor with the typed view.
+	 * @param[in] data byte array which starts with a telemetry message.
+	 * @param[in] length length of the byte array.
+	 * @param[in] visitor callable which accepts each of the view types of SMCPTelemetryVariant.
+	 * @return the value returned by the visitor.
+	 */
+	template<typename Visitor>
+	static decltype(auto) visit(const uint8_t* data, size_t length, Visitor&& visitor) {
+		SMCPTelemetryMessageView view;
+		if (!view.tryInterpretAsTelemetryMessage(data, length)) {
+			throw SMCPException("size error");
+		}
+		return dispatch(view, std::forward<Visitor>(visitor));
+	}
+};
+
+#endif /* SMCPTELEMETRYVARIANT_HH_ */
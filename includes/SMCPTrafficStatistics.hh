@@ -0,0 +1,540 @@
+/*
+ * SMCPTrafficStatistics.hh
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SMCPTRAFFICSTATISTICS_HH_
+#define SMCPTRAFFICSTATISTICS_HH_
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+/** Message, byte and error counts of a lowerFOID/Telemetry Type ID pair. */
+class SMCPTrafficCounts {
+public:
+	uint64_t nMessages;
+	uint64_t nBytes;
+	uint64_t nErrors;
+
+public:
+	SMCPTrafficCounts() :
+			nMessages(0), nBytes(0), nErrors(0) {
+	}
+};
+
+/** Message and byte counts of a lowerFOID/AttributeID pair. */
+class SMCPAttributeTrafficCounts {
+public:
+	uint8_t lowerFOID;
+	uint16_t attributeID;
+	uint64_t nMessages;
+	uint64_t nBytes;
+
+public:
+	SMCPAttributeTrafficCounts() :
+			lowerFOID(0), attributeID(0), nMessages(0), nBytes(0) {
+	}
+};
+
+/** Rates computed from two snapshots. */
+class SMCPTrafficRates {
+public:
+	double messagesPerSecond;
+	double bytesPerSecond;
+	double errorsPerSecond;
+
+public:
+	SMCPTrafficRates() :
+			messagesPerSecond(0), bytesPerSecond(0), errorsPerSecond(0) {
+	}
+};
+
+/** Merged counts of SMCPTrafficStatistics at a point in time.
+ * @see SMCPTrafficStatistics::snapshot().
+ */
+class SMCPTrafficStatisticsSnapshot {
+public:
+	static const size_t NFOIDs = 256;
+	static const size_t NTypes = 16;
+
+public:
+	/** Time of the snapshot in nanoseconds (steady clock). */
+	uint64_t time;
+	/** Counts indexed by (lowerFOID << 4) | telemetryTypeID. */
+	std::vector<SMCPTrafficCounts> counts;
+	/** Counts per lowerFOID/AttributeID, sorted by lowerFOID and AttributeID. */
+	std::vector<SMCPAttributeTrafficCounts> attributes;
+	/** Messages too short to contain lowerFOID. */
+	uint64_t nUndecodable;
+	/** Messages whose AttributeID could not be counted because a per-thread table was full. */
+	uint64_t nAttributeOverflows;
+
+public:
+	SMCPTrafficStatisticsSnapshot() :
+			time(0), counts(NFOIDs * NTypes), nUndecodable(0), nAttributeOverflows(0) {
+	}
+
+public:
+	const SMCPTrafficCounts& getCounts(uint8_t lowerFOID, uint8_t telemetryTypeID) const {
+		return counts[((size_t) lowerFOID << 4) | (telemetryTypeID & 0x0F)];
+	}
+
+public:
+	/** Returns the sum over all lowerFOIDs and Telemetry Type IDs. */
+	SMCPTrafficCounts getTotal() const {
+		SMCPTrafficCounts total;
+		for (size_t i = 0; i < counts.size(); i++) {
+			total.nMessages += counts[i].nMessages;
+			total.nBytes += counts[i].nBytes;
+			total.nErrors += counts[i].nErrors;
+		}
+		return total;
+	}
+
+public:
+	/** Returns the counts of an AttributeID, or NULL if none was recorded. */
+	const SMCPAttributeTrafficCounts* getAttributeCounts(uint8_t lowerFOID, uint16_t attributeID) const {
+		size_t low = 0, high = attributes.size();
+		uint32_t key = ((uint32_t) lowerFOID << 16) | attributeID;
+		while (low < high) {
+			size_t middle = (low + high) / 2;
+			uint32_t middleKey = ((uint32_t) attributes[middle].lowerFOID << 16) | attributes[middle].attributeID;
+			if (middleKey < key) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		if (low < attributes.size() && attributes[low].lowerFOID == lowerFOID
+				&& attributes[low].attributeID == attributeID) {
+			return &attributes[low];
+		}
+		return NULL;
+	}
+
+public:
+	/** Returns total rates between a previous snapshot and this one. */
+	SMCPTrafficRates getRates(const SMCPTrafficStatisticsSnapshot& previous) const {
+		return computeRates(previous.getTotal(), getTotal(), previous.time);
+	}
+
+public:
+	/** Returns rates of a lowerFOID/Telemetry Type ID pair between a previous snapshot and this one. */
+	SMCPTrafficRates getRates(const SMCPTrafficStatisticsSnapshot& previous, uint8_t lowerFOID,
+			uint8_t telemetryTypeID) const {
+		return computeRates(previous.getCounts(lowerFOID, telemetryTypeID), getCounts(lowerFOID, telemetryTypeID),
+				previous.time);
+	}
+
+private:
+	SMCPTrafficRates computeRates(const SMCPTrafficCounts& before, const SMCPTrafficCounts& after,
+			uint64_t previousTime) const {
+		SMCPTrafficRates rates;
+		if (time <= previousTime) {
+			return rates;
+		}
+		double seconds = (time - previousTime) / 1e9;
+		rates.messagesPerSecond = (after.nMessages - before.nMessages) / seconds;
+		rates.bytesPerSecond = (after.nBytes - before.nBytes) / seconds;
+		rates.errorsPerSecond = (after.nErrors - before.nErrors) / seconds;
+		return rates;
+	}
+
+public:
+	/** Returns a table of non-zero counts. */
+	std::string toString() const {
+		std::stringstream ss;
+		ss << "lowerFOID type messages bytes errors" << std::endl;
+		for (size_t i = 0; i < counts.size(); i++) {
+			if (counts[i].nMessages == 0 && counts[i].nErrors == 0) {
+				continue;
+			}
+			ss << "0x" << std::hex << std::setw(2) << std::setfill('0') << (i >> 4) << " " << std::dec
+					<< (i & 0x0F) << " " << counts[i].nMessages << " " << counts[i].nBytes << " "
+					<< counts[i].nErrors << std::endl;
+		}
+		ss << "lowerFOID attributeID messages bytes" << std::endl;
+		for (size_t i = 0; i < attributes.size(); i++) {
+			ss << "0x" << std::hex << std::setw(2) << std::setfill('0') << (uint32_t) attributes[i].lowerFOID
+					<< " 0x" << std::setw(4) << attributes[i].attributeID << std::dec << " "
+					<< attributes[i].nMessages << " " << attributes[i].nBytes << std::endl;
+		}
+		ss << "undecodable " << nUndecodable << std::endl;
+		ss << "attributeOverflows " << nAttributeOverflows << std::endl;
+		return ss.str();
+	}
+};
+
+/** A collector of telemetry traffic statistics for capacity planning.
+ * Counts messages, bytes and errors per lowerFOID and Telemetry Type ID,
+ * and messages and bytes per lowerFOID/AttributeID.
+ *
+ * Each recording thread gets its own counter block: dense arrays indexed by
+ * lowerFOID/Telemetry Type ID and an open-addressing table for AttributeIDs.
+ * Only the owning thread writes a block (relaxed atomic stores without
+ * read-modify-write), so recording costs a few plain memory operations.
+ * snapshot() merges the blocks of all threads; calling it periodically
+ * and comparing consecutive snapshots gives rates.
+ *
+ * A collector can be attached to the decode path, in which case
+ * SMCPTelemetryMessage::interpretAsTelemetryMessage() records every message
+ * it receives (including ones rejected as too short). While a thread records
+ * into the attached collector it sets a flag of its own, so the decode path
+ * writes no cache line shared with other threads. detach() scans these
+ * flags and waits until threads already recording into the attached
+ * collector have returned, so the collector can be destroyed right after
+ * it. The destructor detaches the collector if it is still attached.
+ *
+ * Each thread caches the counter block of the collector it used last, so
+ * repeated attach/detach cycles do not accumulate per-thread state. A thread
+ * which alternates between several collectors looks its block up under the
+ * collector's mutex on every switch.
+ *
+ * Example usage:
+ * @code
+ * SMCPTrafficStatistics statistics;
+ * SMCPTrafficStatistics::attach(&statistics);
+ * SMCPTrafficStatisticsSnapshot previous, current;
+ * statistics.snapshot(previous);
+ * //... decode telemetry in any number of threads ...
+ * statistics.snapshot(current);
+ * std::cout << current.getRates(previous).messagesPerSecond << std::endl;
+ * SMCPTrafficStatistics::detach();
+ * @endcode
+ */
+class SMCPTrafficStatistics {
+public:
+	static const size_t NFOIDs = SMCPTrafficStatisticsSnapshot::NFOIDs;
+	static const size_t NTypes = SMCPTrafficStatisticsSnapshot::NTypes;
+	static const size_t DefaultAttributeCapacity = 4096;
+
+private:
+	class ThreadCounters {
+	public:
+		std::atomic<uint64_t> nMessages[NFOIDs * NTypes];
+		std::atomic<uint64_t> nBytes[NFOIDs * NTypes];
+		std::atomic<uint64_t> nErrors[NFOIDs * NTypes];
+		std::atomic<uint64_t> nUndecodable;
+		std::atomic<uint64_t> nAttributeOverflows;
+		/** 0 = empty, otherwise 0x01000000 | lowerFOID << 16 | AttributeID. */
+		std::vector<std::atomic<uint32_t> > attributeKeys;
+		std::vector<std::atomic<uint64_t> > attributeMessages;
+		std::vector<std::atomic<uint64_t> > attributeBytes;
+		size_t attributeMask;
+
+	public:
+		ThreadCounters(size_t attributeCapacity) :
+				attributeKeys(attributeCapacity), attributeMessages(attributeCapacity),
+				attributeBytes(attributeCapacity), attributeMask(attributeCapacity - 1) {
+			reset();
+		}
+
+	public:
+		void reset() {
+			for (size_t i = 0; i < NFOIDs * NTypes; i++) {
+				nMessages[i].store(0, std::memory_order_relaxed);
+				nBytes[i].store(0, std::memory_order_relaxed);
+				nErrors[i].store(0, std::memory_order_relaxed);
+			}
+			nUndecodable.store(0, std::memory_order_relaxed);
+			nAttributeOverflows.store(0, std::memory_order_relaxed);
+			for (size_t i = 0; i < attributeKeys.size(); i++) {
+				attributeMessages[i].store(0, std::memory_order_relaxed);
+				attributeBytes[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	};
+
+private:
+	/** Per-thread cache of the counter block of the collector used last.
+	 * Every instance is registered in getThreadCaches() for detach().
+	 */
+	class ThreadCache {
+	public:
+		uint64_t id;
+		ThreadCounters* counters;
+		/** True while the thread is in recordAttached(). */
+		std::atomic<bool> recording;
+
+	public:
+		ThreadCache() :
+				id(0), counters(NULL), recording(false) {
+			std::lock_guard<std::mutex> lock(getThreadCachesMutex());
+			getThreadCaches().push_back(this);
+		}
+
+	public:
+		~ThreadCache() {
+			std::lock_guard<std::mutex> lock(getThreadCachesMutex());
+			std::vector<ThreadCache*>& caches = getThreadCaches();
+			caches.erase(std::find(caches.begin(), caches.end(), this));
+		}
+	};
+
+private:
+	uint64_t id;
+	size_t attributeCapacity;
+	std::mutex mutex;
+	std::vector<ThreadCounters*> threads;
+	std::map<std::thread::id, ThreadCounters*> threadIndex;
+
+public:
+	/** Constructor.
+	 * @param[in] attributeCapacity number of distinct lowerFOID/AttributeID pairs
+	 * counted per thread (rounded up to a power of two).
+	 */
+	SMCPTrafficStatistics(size_t attributeCapacity = DefaultAttributeCapacity) :
+			id(getNextID()), attributeCapacity(1) {
+		while (this->attributeCapacity < attributeCapacity) {
+			this->attributeCapacity <<= 1;
+		}
+	}
+
+public:
+	~SMCPTrafficStatistics() {
+		if (getAttachedPointer().load() == this) {
+			detach();
+		}
+		ThreadCache& cache = getThreadCache();
+		if (cache.id == id) {
+			cache.id = 0;
+			cache.counters = NULL;
+		}
+		for (size_t i = 0; i < threads.size(); i++) {
+			delete threads[i];
+		}
+	}
+
+public:
+	/** Attaches a collector to SMCPTelemetryMessage::interpretAsTelemetryMessage().
+	 * A previously attached collector is detached first (see detach()).
+	 * @param[in] statistics collector, or NULL to detach.
+	 */
+	static void attach(SMCPTrafficStatistics* statistics) {
+		detach();
+		getAttachedPointer().store(statistics);
+	}
+
+public:
+	/** Detaches the attached collector and waits until threads which were
+	 * recording into it through recordAttached() have returned.
+	 */
+	static void detach() {
+		getAttachedPointer().store(NULL);
+		//callers which loaded the pointer before the store have set their recording flags;
+		//the lock keeps their caches alive (a recording thread does not take it)
+		std::lock_guard<std::mutex> lock(getThreadCachesMutex());
+		std::vector<ThreadCache*>& caches = getThreadCaches();
+		for (size_t i = 0; i < caches.size(); i++) {
+			while (caches[i]->recording.load()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+public:
+	/** Returns the attached collector, or NULL. */
+	static SMCPTrafficStatistics* getAttached() {
+		return getAttachedPointer().load(std::memory_order_acquire);
+	}
+
+public:
+	/** Records a telemetry message into the attached collector, if any.
+	 * @param[in] data byte array which contains a telemetry message.
+	 * @param[in] length length of the byte array.
+	 */
+	static void recordAttached(const uint8_t* data, size_t length) {
+		if (getAttachedPointer().load(std::memory_order_relaxed) == NULL) {
+			return;
+		}
+		ThreadCache& cache = getThreadCache();
+		cache.recording.store(true);
+		SMCPTrafficStatistics* statistics = getAttachedPointer().load();
+		if (statistics != NULL) {
+			try {
+				statistics->record(data, length);
+			} catch (...) {
+				cache.recording.store(false, std::memory_order_release);
+				throw;
+			}
+		}
+		cache.recording.store(false, std::memory_order_release);
+	}
+
+public:
+	/** Records a telemetry message.
+	 * A message is counted as an error if it is shorter than 8 bytes or
+	 * shorter than its Message Length field.
+	 * @param[in] data byte array which contains a telemetry message.
+	 * @param[in] length length of the byte array.
+	 */
+	void record(const uint8_t* data, size_t length) {
+		ThreadCounters& counters = getThreadCounters();
+		if (length < 5) {
+			increment(counters.nUndecodable);
+			return;
+		}
+		size_t index = ((size_t) data[4] << 4) | (data[0] & 0x0F);
+		increment(counters.nMessages[index]);
+		increment(counters.nBytes[index], length);
+		size_t messageLength = ((size_t) data[1] << 16) | ((size_t) data[2] << 8) | data[3];
+		if (length < 8 || messageLength < 8 || length < messageLength) {
+			increment(counters.nErrors[index]);
+		}
+		if (7 <= length) {
+			recordAttribute(counters, 0x01000000 | ((uint32_t) data[4] << 16) | ((uint32_t) data[5] << 8) | data[6],
+					length);
+		}
+	}
+
+public:
+	/** Records an error of a lowerFOID/Telemetry Type ID pair found outside of the collector
+	 * (e.g. a checksum error in a lower layer).
+	 */
+	void recordError(uint8_t lowerFOID, uint8_t telemetryTypeID) {
+		increment(getThreadCounters().nErrors[((size_t) lowerFOID << 4) | (telemetryTypeID & 0x0F)]);
+	}
+
+public:
+	/** Merges the counters of all threads.
+	 * @param[out] snapshot destination; its previous content is discarded.
+	 */
+	void snapshot(SMCPTrafficStatisticsSnapshot& snapshot) {
+		std::map<uint32_t, SMCPAttributeTrafficCounts> attributes;
+		snapshot.counts.assign(NFOIDs * NTypes, SMCPTrafficCounts());
+		snapshot.nUndecodable = 0;
+		snapshot.nAttributeOverflows = 0;
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshot.time = getCurrentTime();
+		for (size_t t = 0; t < threads.size(); t++) {
+			ThreadCounters& counters = *threads[t];
+			for (size_t i = 0; i < NFOIDs * NTypes; i++) {
+				snapshot.counts[i].nMessages += counters.nMessages[i].load(std::memory_order_relaxed);
+				snapshot.counts[i].nBytes += counters.nBytes[i].load(std::memory_order_relaxed);
+				snapshot.counts[i].nErrors += counters.nErrors[i].load(std::memory_order_relaxed);
+			}
+			snapshot.nUndecodable += counters.nUndecodable.load(std::memory_order_relaxed);
+			snapshot.nAttributeOverflows += counters.nAttributeOverflows.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < counters.attributeKeys.size(); i++) {
+				uint32_t key = counters.attributeKeys[i].load(std::memory_order_acquire);
+				if (key == 0) {
+					continue;
+				}
+				SMCPAttributeTrafficCounts& entry = attributes[key];
+				entry.lowerFOID = (uint8_t) (key >> 16);
+				entry.attributeID = (uint16_t) key;
+				entry.nMessages += counters.attributeMessages[i].load(std::memory_order_relaxed);
+				entry.nBytes += counters.attributeBytes[i].load(std::memory_order_relaxed);
+			}
+		}
+		snapshot.attributes.clear();
+		for (std::map<uint32_t, SMCPAttributeTrafficCounts>::iterator it = attributes.begin();
+				it != attributes.end(); it++) {
+			snapshot.attributes.push_back(it->second);
+		}
+	}
+
+public:
+	/** Clears the counters of all threads.
+	 * Counts recorded concurrently with reset() may be partially lost;
+	 * prefer comparing snapshots for periodic reporting.
+	 */
+	void reset() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i]->reset();
+		}
+	}
+
+public:
+	/** Returns steady-clock time in nanoseconds, as used in snapshots. */
+	static uint64_t getCurrentTime() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	void recordAttribute(ThreadCounters& counters, uint32_t key, size_t length) {
+		size_t index = (key * 2654435761u) & counters.attributeMask;
+		for (size_t probe = 0; probe <= counters.attributeMask; probe++) {
+			uint32_t slotKey = counters.attributeKeys[index].load(std::memory_order_relaxed);
+			if (slotKey == key) {
+				increment(counters.attributeMessages[index]);
+				increment(counters.attributeBytes[index], length);
+				return;
+			}
+			if (slotKey == 0) {
+				increment(counters.attributeMessages[index]);
+				increment(counters.attributeBytes[index], length);
+				counters.attributeKeys[index].store(key, std::memory_order_release);
+				return;
+			}
+			index = (index + 1) & counters.attributeMask;
+		}
+		increment(counters.nAttributeOverflows);
+	}
+
+private:
+	static void increment(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+private:
+	ThreadCounters& getThreadCounters() {
+		ThreadCache& cache = getThreadCache();
+		if (cache.id == id) {
+			return *cache.counters;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		ThreadCounters*& counters = threadIndex[std::this_thread::get_id()];
+		if (counters == NULL) {
+			counters = new ThreadCounters(attributeCapacity);
+			threads.push_back(counters);
+		}
+		cache.id = id;
+		cache.counters = counters;
+		return *counters;
+	}
+
+private:
+	static ThreadCache& getThreadCache() {
+		static thread_local ThreadCache cache;
+		return cache;
+	}
+
+private:
+	static std::atomic<SMCPTrafficStatistics*>& getAttachedPointer() {
+		static std::atomic<SMCPTrafficStatistics*> attached(NULL);
+		return attached;
+	}
+
+private:
+	static std::vector<ThreadCache*>& getThreadCaches() {
+		static std::vector<ThreadCache*> caches;
+		return caches;
+	}
+
+private:
+	static std::mutex& getThreadCachesMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+private:
+	static uint64_t getNextID() {
+		static std::atomic<uint64_t> nextID(1);
+		return nextID.fetch_add(1);
+	}
+};
+
+#endif /* SMCPTRAFFICSTATISTICS_HH_ */
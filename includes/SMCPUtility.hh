@@ -8,10 +8,18 @@
 #ifndef SMCPUTILITY_HH_
 #define SMCPUTILITY_HH_
 
+#include <stdint.h>
+#include <string.h>
 #include <bitset>
 #include <string>
 #include "SMCPException.hh"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /** A class that collects utility methods used in the SMCP Library.
  */
 class SMCPUtility {
@@ -24,7 +32,7 @@ public:
 	 * @endcode
 	 */
 	template<int n>
-	static std::bitset<n> createBitset(std::string str) throw (SMCPException) {
+	static std::bitset<n> createBitset(std::string str) {
 		std::bitset<n> result;
 		if (str.size() != n && str.size() - 1 != n) {
 			throw SMCPException("size error");
@@ -44,6 +52,114 @@ public:
 		}
 		return result;
 	}
+
+public:
+	/** Compares two byte arrays.
+	 * Uses 16-byte SSE2 comparisons when available, and memcmp() otherwise.
+	 * @param[in] a byte array.
+	 * @param[in] b byte array.
+	 * @param[in] length number of bytes to be compared.
+	 * @return true if the arrays have the same content.
+	 */
+	static bool equalBytes(const uint8_t* a, const uint8_t* b, size_t length) {
+#if defined(__SSE2__)
+		size_t i = 0;
+		for (; i + 16 <= length; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+			__m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+				return false;
+			}
+		}
+		return memcmp(a + i, b + i, length - i) == 0;
+#else
+		return memcmp(a, b, length) == 0;
+#endif
+	}
+
+public:
+	/** Returns the index of the first byte which differs between two byte arrays.
+	 * Uses 32-byte AVX2 or 16-byte SSE2 comparisons when available
+	 * (with GCC-compatible compilers, for __builtin_ctz()).
+	 * @param[in] a byte array.
+	 * @param[in] b byte array.
+	 * @param[in] length number of bytes to be compared.
+	 * @return index of the first differing byte, or length if the arrays are equal.
+	 */
+	static size_t findFirstDifference(const uint8_t* a, const uint8_t* b, size_t length) {
+		size_t i = 0;
+#if defined(__AVX2__) && defined(__GNUC__)
+		for (; i + 32 <= length; i += 32) {
+			__m256i x = _mm256_loadu_si256((const __m256i*) (a + i));
+			__m256i y = _mm256_loadu_si256((const __m256i*) (b + i));
+			uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+			if (mask != 0xFFFFFFFF) {
+				return i + __builtin_ctz(~mask);
+			}
+		}
+#endif
+#if defined(__SSE2__) && defined(__GNUC__)
+		for (; i + 16 <= length; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+			__m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+			uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+			if (mask != 0xFFFF) {
+				return i + __builtin_ctz(~mask);
+			}
+		}
+#else
+		for (; i + 8 <= length; i += 8) {
+			if (memcmp(a + i, b + i, 8) != 0) {
+				break;
+			}
+		}
+#endif
+		for (; i < length; i++) {
+			if (a[i] != b[i]) {
+				return i;
+			}
+		}
+		return length;
+	}
+
+public:
+	/** Returns the index of the first byte which is equal in two byte arrays.
+	 * Uses 32-byte AVX2 or 16-byte SSE2 comparisons when available
+	 * (with GCC-compatible compilers, for __builtin_ctz()).
+	 * @param[in] a byte array.
+	 * @param[in] b byte array.
+	 * @param[in] length number of bytes to be compared.
+	 * @return index of the first equal byte, or length if all bytes differ.
+	 */
+	static size_t findFirstEqual(const uint8_t* a, const uint8_t* b, size_t length) {
+		size_t i = 0;
+#if defined(__AVX2__) && defined(__GNUC__)
+		for (; i + 32 <= length; i += 32) {
+			__m256i x = _mm256_loadu_si256((const __m256i*) (a + i));
+			__m256i y = _mm256_loadu_si256((const __m256i*) (b + i));
+			uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+			if (mask != 0) {
+				return i + __builtin_ctz(mask);
+			}
+		}
+#endif
+#if defined(__SSE2__) && defined(__GNUC__)
+		for (; i + 16 <= length; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*) (a + i));
+			__m128i y = _mm_loadu_si128((const __m128i*) (b + i));
+			uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+			if (mask != 0) {
+				return i + __builtin_ctz(mask);
+			}
+		}
+#endif
+		for (; i < length; i++) {
+			if (a[i] == b[i]) {
+				return i;
+			}
+		}
+		return length;
+	}
 };
 
 #endif /* SMCPUTILITY_HH_ */
@@ -0,0 +1,1061 @@
+/*
+ * benchmark_smcp.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Micro benchmark of encode/decode of SMCP messages.
+ *
+ * For each of the four command types and the four telemetry types, and for
+ * payload (Message Data) sizes from 3 bytes to 16 MB, the following
+ * operations are measured:
+ *  - decode   : interpretAsCommandMessage() / interpretAsTelemetryMessage()
+ *  - encode   : getAsByteVector()
+ *  - serialize: getAsByteArray() into a reused buffer
+ *  - view     : SMCPCommandMessageView / SMCPTelemetryMessageView placement
+ *  - variant  : SMCPTelemetryDispatcher::visit() (telemetry only, C++17)
+ *  - template : SMCPCommandTemplate::stampBatch() of 16 commands (command only)
+ *  - spacePacket: encode into a CCSDS Space Packet and decode it with views
+ *  - framePacker: pack into 1472-byte frames and unpack them (messages up to 1470 bytes)
+ *  - headerBatch: SMCPTelemetryHeaderBatch over copies of the message concatenated up to 64 KB (telemetry only)
+ *  - streamDecode: SMCPTelemetryStreamDecoder fed in 1472-byte fragments (telemetry only)
+ *  - memoryDiff: compare a dump payload with a reference image differing every 64 bytes (telemetry only)
+ *  - sharedMemoryBus: publish to an anonymous shared-memory bus and read it back (telemetry up to 256 KB, Linux)
+ *  - length   : setMessageLengthAuto() (telemetry only)
+ *  - toString : toString()
+ *  - format   : appendString() into a reused string
+ *  - compact  : SMCPFormatter::appendCompactCommand()/appendCompactTelemetry()
+ *
+ * Results are printed one line per case, as JSON (default) or CSV, with
+ * iterations, ns/op, throughput, and heap allocations per op.
+ * Allocations are counted by replacing the global operator new/delete and,
+ * with glibc, malloc/calloc/realloc.
+ *
+ * With --check-allocations, the hot paths which must not allocate in steady
+ * state (view decode, serialize-into, decode into a reused message, and the
+ * stream-processing utilities) are run repeatedly instead, and the program
+ * exits with a non-zero status if any of them allocates memory.
+ */
+
+#include "SMCP.hh"
+#if __cplusplus >= 201703L
+#include "SMCPTelemetryVariant.hh"
+#endif
+#if defined(__linux__)
+#include "SMCPSharedMemoryBus.hh"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/* ---------------- allocation counter ---------------- */
+
+static uint64_t nAllocations = 0;
+static uint64_t nAllocatedBytes = 0;
+
+#if defined(__GLIBC__)
+//operator new below calls malloc, so counting here covers both
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+extern "C" void* malloc(size_t size) {
+	nAllocations++;
+	nAllocatedBytes += size;
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+	nAllocations++;
+	nAllocatedBytes += n * size;
+	return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+	nAllocations++;
+	nAllocatedBytes += size;
+	return __libc_realloc(p, size);
+}
+#define COUNT_OPERATOR_NEW 0
+#else
+#define COUNT_OPERATOR_NEW 1
+#endif
+
+//operator new/delete go through these helpers rather than calling malloc/free
+//directly, so that GCC does not report free() of a new'd pointer after inlining
+#if defined(__GNUC__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
+static NOINLINE void* countedAllocate(size_t size) {
+	if (COUNT_OPERATOR_NEW) {
+		nAllocations++;
+		nAllocatedBytes += size;
+	}
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+static NOINLINE void countedFree(void* p) {
+	free(p);
+}
+
+void* operator new(size_t size) {
+	return countedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+	return countedAllocate(size);
+}
+
+void operator delete(void* p) throw () {
+	countedFree(p);
+}
+
+void operator delete[](void* p) throw () {
+	countedFree(p);
+}
+
+void operator delete(void* p, size_t) throw () {
+	countedFree(p);
+}
+
+void operator delete[](void* p, size_t) throw () {
+	countedFree(p);
+}
+
+/* ---------------- benchmark framework ---------------- */
+
+class BenchmarkOptions {
+public:
+	double minimumTime; //seconds per case
+	size_t maximumPayloadSize;
+	std::string format;
+	std::string label;
+	std::string filter;
+
+public:
+	BenchmarkOptions() :
+			minimumTime(0.2), maximumPayloadSize(16777210), format("json"), label("") {
+	}
+};
+
+class BenchmarkResult {
+public:
+	std::string messageType;
+	std::string operation;
+	size_t payloadSize;
+	size_t messageSize;
+	uint64_t iterations;
+	double nanosecondsPerOperation;
+	double allocationsPerOperation;
+	double allocatedBytesPerOperation;
+};
+
+/** An operation measured by the benchmark. run() is invoked repeatedly. */
+class BenchmarkCase {
+public:
+	virtual ~BenchmarkCase() {
+	}
+
+public:
+	virtual void run() = 0;
+};
+
+static volatile size_t sink = 0;
+
+static BenchmarkResult measure(BenchmarkCase& benchmarkCase, const BenchmarkOptions& options) {
+	using namespace std::chrono;
+	//warm up (also lets vectors reach their steady-state capacity)
+	benchmarkCase.run();
+
+	BenchmarkResult result;
+	uint64_t iterations = 1;
+	while (true) {
+		uint64_t allocationsBefore = nAllocations;
+		uint64_t bytesBefore = nAllocatedBytes;
+		steady_clock::time_point start = steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++) {
+			benchmarkCase.run();
+		}
+		double elapsed = duration<double>(steady_clock::now() - start).count();
+		if (options.minimumTime <= elapsed || (1ULL << 40) <= iterations) {
+			result.iterations = iterations;
+			result.nanosecondsPerOperation = elapsed * 1e9 / iterations;
+			result.allocationsPerOperation = (double) (nAllocations - allocationsBefore) / iterations;
+			result.allocatedBytesPerOperation = (double) (nAllocatedBytes - bytesBefore) / iterations;
+			return result;
+		}
+		//aim directly at the minimum time when the first round gives a usable estimate
+		uint64_t next = (elapsed <= 0) ? iterations * 10 : (uint64_t) (iterations * options.minimumTime / elapsed * 1.2);
+		iterations = (next < iterations * 2) ? iterations * 2 : (next > iterations * 100 ? iterations * 100 : next);
+	}
+}
+
+static std::string escapeJSON(const std::string& str) {
+	std::string result;
+	for (size_t i = 0; i < str.size(); i++) {
+		unsigned char c = (unsigned char) str[i];
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += (char) c;
+		} else if (c < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			result += escaped;
+		} else {
+			result += (char) c;
+		}
+	}
+	return result;
+}
+
+static void printHeader(const BenchmarkOptions& options) {
+	if (options.format == "csv") {
+		printf("label,message_type,operation,payload_bytes,message_bytes,iterations,ns_per_op,ops_per_s,"
+				"mb_per_s,allocs_per_op,alloc_bytes_per_op\n");
+	}
+}
+
+static void printResult(const BenchmarkResult& r, const BenchmarkOptions& options) {
+	double opsPerSecond = 1e9 / r.nanosecondsPerOperation;
+	double megabytesPerSecond = opsPerSecond * r.messageSize / 1e6;
+	if (options.format == "csv") {
+		printf("%s,%s,%s,%zu,%zu,%llu,%.2f,%.1f,%.2f,%.2f,%.1f\n", options.label.c_str(), r.messageType.c_str(),
+				r.operation.c_str(), r.payloadSize, r.messageSize, (unsigned long long) r.iterations,
+				r.nanosecondsPerOperation, opsPerSecond, megabytesPerSecond, r.allocationsPerOperation,
+				r.allocatedBytesPerOperation);
+	} else {
+		printf("{\"label\":\"%s\",\"message_type\":\"%s\",\"operation\":\"%s\",\"payload_bytes\":%zu,"
+				"\"message_bytes\":%zu,\"iterations\":%llu,\"ns_per_op\":%.2f,\"ops_per_s\":%.1f,"
+				"\"mb_per_s\":%.2f,\"allocs_per_op\":%.2f,\"alloc_bytes_per_op\":%.1f}\n",
+				escapeJSON(options.label).c_str(), r.messageType.c_str(), r.operation.c_str(), r.payloadSize, r.messageSize,
+				(unsigned long long) r.iterations, r.nanosecondsPerOperation, opsPerSecond, megabytesPerSecond,
+				r.allocationsPerOperation, r.allocatedBytesPerOperation);
+	}
+	fflush(stdout);
+}
+
+/* ---------------- cases ---------------- */
+
+class CommandDecodeCase: public BenchmarkCase {
+public:
+	SMCPCommandMessage message;
+	std::vector<uint8_t>& bytes;
+
+public:
+	CommandDecodeCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+	}
+
+public:
+	void run() {
+		message.interpretAsCommandMessage(bytes);
+		sink += message.getMessageHeader()->getLowerFOID();
+	}
+};
+
+class TelemetryDecodeCase: public BenchmarkCase {
+public:
+	SMCPTelemetryMessage message;
+	std::vector<uint8_t>& bytes;
+
+public:
+	TelemetryDecodeCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+	}
+
+public:
+	void run() {
+		message.interpretAsTelemetryMessage(&bytes[0], bytes.size());
+		sink += message.getMessageHeader()->getLowerFOID();
+	}
+};
+
+class EncodeCase: public BenchmarkCase {
+public:
+	SMCPMessage& message;
+
+public:
+	EncodeCase(SMCPMessage& message) :
+			message(message) {
+	}
+
+public:
+	void run() {
+		sink += message.getAsByteVector().size();
+	}
+};
+
+class SerializeCase: public BenchmarkCase {
+public:
+	SMCPMessage& message;
+	std::vector<uint8_t> buffer;
+
+public:
+	SerializeCase(SMCPMessage& message) :
+			message(message), buffer(message.getLength()) {
+	}
+
+public:
+	void run() {
+		sink += message.getAsByteArray(&buffer[0], buffer.size());
+	}
+};
+
+class CommandViewCase: public BenchmarkCase {
+public:
+	SMCPCommandMessageView view;
+	std::vector<uint8_t>& bytes;
+
+public:
+	CommandViewCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+	}
+
+public:
+	void run() {
+		view.tryInterpretAsCommandMessage(&bytes[0], bytes.size());
+		sink += view.getLowerFOID() + view.getMessageDataLength();
+	}
+};
+
+class TelemetryViewCase: public BenchmarkCase {
+public:
+	SMCPTelemetryMessageView view;
+	std::vector<uint8_t>& bytes;
+
+public:
+	TelemetryViewCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+	}
+
+public:
+	void run() {
+		view.tryInterpretAsTelemetryMessage(&bytes[0], bytes.size());
+		sink += view.getLowerFOID() + view.getAttributeID() + view.getAttributeValuesLength();
+	}
+};
+
+class MessageLengthCase: public BenchmarkCase {
+public:
+	SMCPTelemetryMessage& message;
+
+public:
+	MessageLengthCase(SMCPTelemetryMessage& message) :
+			message(message) {
+	}
+
+public:
+	void run() {
+		message.setMessageLengthAuto();
+		sink += message.getMessageHeader()->getMessageLengthAsPointer()[2];
+	}
+};
+
+class ToStringCase: public BenchmarkCase {
+public:
+	SMCPMessage& message;
+
+public:
+	ToStringCase(SMCPMessage& message) :
+			message(message) {
+	}
+
+public:
+	void run() {
+		sink += message.toString().size();
+	}
+};
+
+class CurrentValueTableCase: public BenchmarkCase {
+public:
+	SMCPCurrentValueTable table;
+	SMCPCurrentValueTable::Value value;
+	SMCPTelemetryMessageView view;
+	std::vector<uint8_t>& bytes;
+
+public:
+	CurrentValueTableCase(std::vector<uint8_t>& bytes) :
+			table(16, 64), bytes(bytes) {
+	}
+
+public:
+	void run() {
+		view.tryInterpretAsTelemetryMessage(&bytes[0], bytes.size());
+		table.update(view.getLowerFOID(), view.getAttributeID(), view.getAttributeValuesAsPointer(),
+				view.getAttributeValuesLength(), 0);
+		sink += table.read(view.getLowerFOID(), view.getAttributeID(), value);
+	}
+};
+
+class ChangeDetectionCase: public BenchmarkCase {
+public:
+	SMCPChangeDetectionFilter filter;
+	std::vector<uint8_t>& bytes;
+	uint64_t time;
+
+public:
+	ChangeDetectionCase(std::vector<uint8_t>& bytes) :
+			filter(1000), bytes(bytes), time(0) {
+	}
+
+public:
+	void run() {
+		sink += filter.accept(&bytes[0], bytes.size(), time++);
+	}
+};
+
+class PredicateFilterCase: public BenchmarkCase {
+public:
+	SMCPTelemetryPredicateFilter filter;
+	SMCPTelemetryMessageView view;
+	std::vector<uint8_t>& bytes;
+
+public:
+	PredicateFilterCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+		filter.add(0, "type == ValueTelemetry && foid == 0x12 && aid < 0x100");
+		filter.add(1, "foid == 0x13 || payload[0] == 1");
+	}
+
+public:
+	void run() {
+		view.tryInterpretAsTelemetryMessage(&bytes[0], bytes.size());
+		sink += filter.evaluate(view);
+	}
+};
+
+class TrafficStatisticsCase: public BenchmarkCase {
+public:
+	SMCPTrafficStatistics statistics;
+	std::vector<uint8_t>& bytes;
+
+public:
+	TrafficStatisticsCase(std::vector<uint8_t>& bytes) :
+			statistics(64), bytes(bytes) {
+	}
+
+public:
+	void run() {
+		statistics.record(&bytes[0], bytes.size());
+	}
+};
+
+class CommandValidatorCase: public BenchmarkCase {
+public:
+	SMCPCommandValidationRules rules;
+	SMCPCommandValidator* validator;
+	std::vector<uint8_t>& bytes;
+
+public:
+	CommandValidatorCase(std::vector<uint8_t>& bytes) :
+			validator(NULL), bytes(bytes) {
+		for (uint8_t type = 0; type < 16; type++) {
+			rules.allowCommandType(type);
+		}
+		rules.allowOperations(0, 0xFFFF);
+		rules.allowAttributes(0, 0xFFFF);
+		rules.allowMemoryRange(SMCPCommandTypeID::MemoryLoadCommand, 0, 0x100000000ULL);
+		rules.allowMemoryRange(SMCPCommandTypeID::MemoryDumpCommand, 0, 0x100000000ULL);
+		validator = new SMCPCommandValidator(rules);
+	}
+
+public:
+	~CommandValidatorCase() {
+		delete validator;
+	}
+
+public:
+	void run() {
+		sink += validator->validate(&bytes[0], bytes.size());
+	}
+};
+
+class FormatCase: public BenchmarkCase {
+public:
+	SMCPMessage& message;
+	std::string text;
+
+public:
+	FormatCase(SMCPMessage& message) :
+			message(message) {
+	}
+
+public:
+	void run() {
+		text.clear();
+		message.appendString(text);
+		sink += text.size();
+	}
+};
+
+class CompactFormatCase: public BenchmarkCase {
+public:
+	std::vector<uint8_t>& bytes;
+	bool isCommand;
+	std::string text;
+
+public:
+	CompactFormatCase(std::vector<uint8_t>& bytes, bool isCommand) :
+			bytes(bytes), isCommand(isCommand) {
+	}
+
+public:
+	void run() {
+		text.clear();
+		if (isCommand) {
+			SMCPFormatter::appendCompactCommand(text, &bytes[0], bytes.size());
+		} else {
+			SMCPFormatter::appendCompactTelemetry(text, &bytes[0], bytes.size());
+		}
+		sink += text.size();
+	}
+};
+
+class CommandTemplateCase: public BenchmarkCase {
+public:
+	static const size_t NCommands = 16;
+	SMCPCommandTemplate commandTemplate;
+	std::vector<uint64_t> values;
+	const uint64_t* slotValues[1];
+	std::vector<uint8_t> buffer;
+
+public:
+	CommandTemplateCase(std::vector<uint8_t>& bytes) :
+			commandTemplate(&bytes[0], bytes.size()), values(NCommands), buffer(NCommands * bytes.size()) {
+		commandTemplate.addSlot("field", SMCPCommandMessageHeader::HeaderLength, 2);
+		slotValues[0] = &values[0];
+	}
+
+public:
+	void run() {
+		values[0]++;
+		sink += commandTemplate.stampBatch(&buffer[0], buffer.size(), slotValues, NCommands);
+	}
+};
+
+class SpacePacketCase: public BenchmarkCase {
+public:
+	SMCPMessage& message;
+	bool isCommand;
+	SMCPSpacePacketEncoder encoder;
+	SMCPSpacePacketView packet;
+	SMCPCommandMessageView command;
+	SMCPTelemetryMessageView telemetry;
+	std::vector<uint8_t> buffer;
+
+public:
+	SpacePacketCase(SMCPMessage& message, bool isCommand) :
+			message(message), isCommand(isCommand), buffer(SMCPSpacePacketEncoder::PrimaryHeaderLength + message.getLength()) {
+	}
+
+public:
+	void run() {
+		uint8_t packetType = isCommand ? SMCPSpacePacketType::Telecommand : SMCPSpacePacketType::Telemetry;
+		size_t length = encoder.encode(message, 0x123, packetType, &buffer[0], buffer.size());
+		packet.tryInterpretAsSpacePacket(&buffer[0], length);
+		if (isCommand) {
+			sink += packet.tryGetCommandMessage(command);
+		} else {
+			sink += packet.tryGetTelemetryMessage(telemetry);
+		}
+	}
+};
+
+class FramePackerCase: public BenchmarkCase, public SMCPFrameListener {
+public:
+	std::vector<uint8_t>& bytes;
+	bool isCommand;
+	SMCPFramePacker packer;
+	SMCPFrameUnpacker unpacker;
+	SMCPCommandMessageView command;
+	SMCPTelemetryMessageView telemetry;
+	uint64_t time;
+
+public:
+	FramePackerCase(std::vector<uint8_t>& bytes, bool isCommand) :
+			bytes(bytes), isCommand(isCommand),
+			packer(1472, isCommand ? SMCPMessageType::CommandMessage : SMCPMessageType::TelemetryMessage, 1000, this),
+			unpacker(isCommand ? SMCPMessageType::CommandMessage : SMCPMessageType::TelemetryMessage), time(0) {
+	}
+
+public:
+	void run() {
+		packer.add(&bytes[0], bytes.size(), time);
+		packer.poll(time++);
+	}
+
+public:
+	void frameCompleted(const uint8_t* frame, size_t length, size_t) {
+		unpacker.setFrame(frame, length);
+		if (isCommand) {
+			while (unpacker.next(command)) {
+				sink++;
+			}
+		} else {
+			while (unpacker.next(telemetry)) {
+				sink++;
+			}
+		}
+	}
+};
+
+#if __cplusplus >= 201703L
+class TelemetryVariantCase: public BenchmarkCase {
+public:
+	std::vector<uint8_t>& bytes;
+
+public:
+	TelemetryVariantCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes) {
+	}
+
+public:
+	void run() {
+		sink += SMCPTelemetryDispatcher::visit(&bytes[0], bytes.size(), SMCPOverloaded { //
+				[](const SMCPValueTelemetryView& view) {
+					return (size_t) view.getAttributeID();
+				}, //
+				[](const SMCPMemoryDumpTelemetryView& view) {
+					return view.getAttributeValuesLength();
+				}, //
+				[](const SMCPTelemetryMessageView& view) {
+					return view.getLength();
+				} });
+	}
+};
+#endif
+
+/** Stream buffer which discards everything written to it. */
+class NullStreamBuffer: public std::streambuf {
+protected:
+	std::streamsize xsputn(const char*, std::streamsize n) {
+		return n;
+	}
+
+protected:
+	int overflow(int c) {
+		return traits_type::not_eof(c);
+	}
+};
+
+class ColumnExporterCase: public BenchmarkCase {
+public:
+	std::vector<uint8_t>& bytes;
+	NullStreamBuffer buffer;
+	std::ostream os;
+	SMCPAttributeSchema schema;
+	SMCPTelemetryColumnExporter* exporter;
+	uint64_t offset;
+
+public:
+	ColumnExporterCase(std::vector<uint8_t>& bytes, int format) :
+			bytes(bytes), os(&buffer), exporter(NULL), offset(0) {
+		schema.add(0x12, 0x0108, SMCPAttributeType::Float32, "value");
+		exporter = new SMCPTelemetryColumnExporter(os, format, &schema, 64);
+	}
+
+public:
+	~ColumnExporterCase() {
+		delete exporter;
+	}
+
+public:
+	void run() {
+		offset += exporter->addStream(&bytes[0], bytes.size(), offset, offset);
+	}
+};
+
+class HeaderBatchCase: public BenchmarkCase {
+public:
+	std::vector<uint8_t> buffer;
+	SMCPTelemetryHeaderBatch batch;
+
+public:
+	HeaderBatchCase(std::vector<uint8_t>& bytes) {
+		do {
+			buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+		} while (buffer.size() + bytes.size() <= 65536);
+	}
+
+public:
+	void run() {
+		sink += batch.decode(buffer);
+	}
+};
+
+class StreamDecoderCase: public BenchmarkCase, public SMCPTelemetryStreamSink {
+public:
+	std::vector<uint8_t>& bytes;
+	SMCPTelemetryStreamDecoder decoder;
+
+public:
+	StreamDecoderCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes), decoder(this) {
+	}
+
+public:
+	void run() {
+		for (size_t offset = 0; offset < bytes.size(); offset += 1472) {
+			size_t length = (bytes.size() - offset < 1472) ? bytes.size() - offset : 1472;
+			decoder.feed(&bytes[offset], length);
+		}
+	}
+
+public:
+	void onMessageBegin(uint8_t, uint8_t, uint16_t attributeID, size_t) {
+		sink += attributeID;
+	}
+
+public:
+	void onAttributeValue(const uint8_t* data, size_t, size_t) {
+		sink += data[0];
+	}
+
+public:
+	void onMessageEnd() {
+		sink++;
+	}
+};
+
+class MemoryImageDiffCase: public BenchmarkCase {
+public:
+	std::vector<uint8_t>& bytes;
+	std::vector<uint8_t> reference;
+	SMCPMemoryImageDiff diff;
+
+public:
+	MemoryImageDiffCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes), reference(bytes), diff(&reference[0], reference.size()) {
+		for (size_t i = 0; i < reference.size(); i += 64) {
+			reference[i] ^= 0xFF;
+		}
+	}
+
+public:
+	void run() {
+		diff.begin(0);
+		diff.feed(&bytes[0], bytes.size());
+		sink += diff.getDifferences().size();
+	}
+};
+
+#if defined(__linux__)
+class SharedMemoryBusCase: public BenchmarkCase {
+public:
+	static const size_t Capacity = 1024 * 1024;
+
+public:
+	std::vector<uint8_t>& bytes;
+	SMCPSharedMemoryBusWriter writer;
+	SMCPSharedMemoryBusReader reader;
+	SMCPTelemetryMessageView telemetry;
+	SMCPSharedMemoryBusRecord record;
+	uint64_t time;
+
+public:
+	SharedMemoryBusCase(std::vector<uint8_t>& bytes) :
+			bytes(bytes), writer("", Capacity), reader(writer.getFileDescriptor()), time(0) {
+	}
+
+public:
+	void run() {
+		writer.publish(&bytes[0], bytes.size(), time++);
+		while (reader.next(telemetry, record)) {
+			sink += reader.isValid();
+		}
+	}
+};
+#endif
+
+/* ---------------- message construction ---------------- */
+
+class MessageTypeEntry {
+public:
+	const char* name;
+	bool isCommand;
+	uint8_t typeID;
+	size_t minimumPayloadSize;
+	size_t fixedPayloadSize; //0 = variable
+};
+
+static const MessageTypeEntry messageTypes[] = { //
+		{ "ActionCommand", true, SMCPCommandTypeID::ActionCommand, 2, 0 }, //
+		{ "GetCommand", true, SMCPCommandTypeID::GetCommand, 2, 2 }, //
+		{ "MemoryLoadCommand", true, SMCPCommandTypeID::MemoryLoadCommand, 5, 0 }, //
+		{ "MemoryDumpCommand", true, SMCPCommandTypeID::MemoryDumpCommand, 8, 8 }, //
+		{ "ValueTelemetry", false, SMCPTelemetryTypeID::ValueTelemetry, 3, 0 }, //
+		{ "NotificationTelemetry", false, SMCPTelemetryTypeID::NotificationTelemetry, 3, 0 }, //
+		{ "AcknowledgeTelemetry", false, SMCPTelemetryTypeID::AcknowledgeTelemetry, 3, 0 }, //
+		{ "MemoryDumpTelemetry", false, SMCPTelemetryTypeID::MemoryDumpTelemetry, 3, 0 } //
+};
+
+/** Builds the wire bytes of a message whose Message Data part has payloadSize bytes. */
+static std::vector<uint8_t> createMessageBytes(const MessageTypeEntry& type, size_t payloadSize) {
+	std::vector<uint8_t> bytes;
+	if (type.isCommand) {
+		bytes.push_back(0x40 /* ack requested */| 0x10 /* version */| type.typeID);
+		bytes.push_back(0x12); //lowerFOID
+	} else {
+		size_t messageLength = SMCPTelemetryMessage::SizeOfHeader + payloadSize;
+		bytes.push_back(0x10 /* version */| type.typeID);
+		bytes.push_back((messageLength >> 16) & 0xFF);
+		bytes.push_back((messageLength >> 8) & 0xFF);
+		bytes.push_back(messageLength & 0xFF);
+		bytes.push_back(0x12); //lowerFOID
+	}
+	for (size_t i = 0; i < payloadSize; i++) {
+		bytes.push_back((uint8_t) (i * 7 + 1));
+	}
+	return bytes;
+}
+
+/* ---------------- allocation check ---------------- */
+
+/** Runs a case repeatedly after warm-up and reports the allocations made.
+ * @return true if no allocation was made.
+ */
+static bool checkAllocations(const std::string& name, BenchmarkCase& benchmarkCase) {
+	const uint64_t iterations = 1000;
+	benchmarkCase.run();
+	uint64_t allocationsBefore = nAllocations;
+	uint64_t bytesBefore = nAllocatedBytes;
+	for (uint64_t i = 0; i < iterations; i++) {
+		benchmarkCase.run();
+	}
+	uint64_t allocations = nAllocations - allocationsBefore;
+	uint64_t bytes = nAllocatedBytes - bytesBefore;
+	if (allocations == 0) {
+		printf("PASS %s\n", name.c_str());
+		return true;
+	} else {
+		printf("FAIL %s: %llu allocations (%llu bytes) in %llu iterations\n", name.c_str(),
+				(unsigned long long) allocations, (unsigned long long) bytes, (unsigned long long) iterations);
+		return false;
+	}
+}
+
+/** Checks that the hot paths do not allocate in steady state.
+ * @return the number of failed checks.
+ */
+static int checkHotPathAllocations(const BenchmarkOptions& options) {
+	const size_t payloadSizes[] = { 3, 256, 4096 };
+	int nFailures = 0;
+	for (size_t t = 0; t < sizeof(messageTypes) / sizeof(messageTypes[0]); t++) {
+		const MessageTypeEntry& type = messageTypes[t];
+		for (size_t s = 0; s < sizeof(payloadSizes) / sizeof(payloadSizes[0]); s++) {
+			size_t payloadSize = payloadSizes[s];
+			if (type.fixedPayloadSize != 0) {
+				if (s != 0) {
+					break;
+				}
+				payloadSize = type.fixedPayloadSize;
+			} else if (payloadSize < type.minimumPayloadSize) {
+				payloadSize = type.minimumPayloadSize;
+			}
+
+			std::vector<uint8_t> bytes = createMessageBytes(type, payloadSize);
+			SMCPCommandMessage commandMessage;
+			SMCPTelemetryMessage telemetryMessage;
+			std::vector<std::pair<std::string, BenchmarkCase*> > cases;
+			if (type.isCommand) {
+				commandMessage.interpretAsCommandMessage(bytes);
+				cases.push_back(std::make_pair("view", (BenchmarkCase*) new CommandViewCase(bytes)));
+				cases.push_back(std::make_pair("decode", (BenchmarkCase*) new CommandDecodeCase(bytes)));
+				cases.push_back(std::make_pair("serialize", (BenchmarkCase*) new SerializeCase(commandMessage)));
+				cases.push_back(std::make_pair("validate", (BenchmarkCase*) new CommandValidatorCase(bytes)));
+				cases.push_back(std::make_pair("template", (BenchmarkCase*) new CommandTemplateCase(bytes)));
+				cases.push_back(std::make_pair("spacePacket", (BenchmarkCase*) new SpacePacketCase(commandMessage, true)));
+				cases.push_back(std::make_pair("format", (BenchmarkCase*) new FormatCase(commandMessage)));
+			} else {
+				telemetryMessage.interpretAsTelemetryMessage(bytes);
+				cases.push_back(std::make_pair("view", (BenchmarkCase*) new TelemetryViewCase(bytes)));
+#if __cplusplus >= 201703L
+				cases.push_back(std::make_pair("variant", (BenchmarkCase*) new TelemetryVariantCase(bytes)));
+#endif
+				cases.push_back(std::make_pair("decode", (BenchmarkCase*) new TelemetryDecodeCase(bytes)));
+				cases.push_back(std::make_pair("serialize", (BenchmarkCase*) new SerializeCase(telemetryMessage)));
+				cases.push_back(std::make_pair("currentValueTable", (BenchmarkCase*) new CurrentValueTableCase(bytes)));
+				cases.push_back(std::make_pair("changeDetection", (BenchmarkCase*) new ChangeDetectionCase(bytes)));
+				cases.push_back(std::make_pair("predicateFilter", (BenchmarkCase*) new PredicateFilterCase(bytes)));
+				cases.push_back(std::make_pair("trafficStatistics", (BenchmarkCase*) new TrafficStatisticsCase(bytes)));
+				cases.push_back(std::make_pair("format", (BenchmarkCase*) new FormatCase(telemetryMessage)));
+				cases.push_back(std::make_pair("spacePacket", (BenchmarkCase*) new SpacePacketCase(telemetryMessage, false)));
+				cases.push_back(std::make_pair("headerBatch", (BenchmarkCase*) new HeaderBatchCase(bytes)));
+				cases.push_back(std::make_pair("streamDecode", (BenchmarkCase*) new StreamDecoderCase(bytes)));
+				cases.push_back(std::make_pair("memoryDiff", (BenchmarkCase*) new MemoryImageDiffCase(bytes)));
+				cases.push_back(
+						std::make_pair("columnExport",
+								(BenchmarkCase*) new ColumnExporterCase(bytes, SMCPTelemetryColumnExporter::BinaryFormat)));
+				cases.push_back(
+						std::make_pair("columnExportCSV",
+								(BenchmarkCase*) new ColumnExporterCase(bytes, SMCPTelemetryColumnExporter::CSVFormat)));
+			}
+			if (bytes.size() + SMCPFramePacker::CommandLengthPrefixLength <= 1472) {
+				cases.push_back(std::make_pair("framePacker", (BenchmarkCase*) new FramePackerCase(bytes, type.isCommand)));
+			}
+#if defined(__linux__)
+			if (!type.isCommand && bytes.size() <= SharedMemoryBusCase::Capacity / 4) {
+				cases.push_back(std::make_pair("sharedMemoryBus", (BenchmarkCase*) new SharedMemoryBusCase(bytes)));
+			}
+#endif
+			cases.push_back(std::make_pair("compact", (BenchmarkCase*) new CompactFormatCase(bytes, type.isCommand)));
+
+			for (size_t c = 0; c < cases.size(); c++) {
+				char name[256];
+				snprintf(name, sizeof(name), "%s/%s/%zu", type.name, cases[c].first.c_str(), payloadSize);
+				if (options.filter.empty() || std::string(name).find(options.filter) != std::string::npos) {
+					nFailures += checkAllocations(name, *cases[c].second) ? 0 : 1;
+				}
+				delete cases[c].second;
+			}
+		}
+	}
+	return nFailures;
+}
+
+static void usage() {
+	fprintf(stderr, "benchmark_smcp [options]\n");
+	fprintf(stderr, "  --format=json|csv     output format (default json, one record per line)\n");
+	fprintf(stderr, "  --min-time=SECONDS    minimum measurement time per case (default 0.2)\n");
+	fprintf(stderr, "  --max-size=BYTES      largest payload size to measure (default 16777210)\n");
+	fprintf(stderr, "  --label=STRING        label recorded with each result (e.g. library version)\n");
+	fprintf(stderr, "  --filter=STRING       run only cases whose \"type/operation\" contains STRING\n");
+	fprintf(stderr, "  --check-allocations   check that hot paths do not allocate; exit 1 on failure\n");
+}
+
+int main(int argc, char* argv[]) {
+	BenchmarkOptions options;
+	bool checkOnly = false;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument.compare(0, 9, "--format=") == 0) {
+			options.format = argument.substr(9);
+		} else if (argument.compare(0, 11, "--min-time=") == 0) {
+			options.minimumTime = atof(argument.substr(11).c_str());
+		} else if (argument.compare(0, 11, "--max-size=") == 0) {
+			options.maximumPayloadSize = strtoul(argument.substr(11).c_str(), NULL, 0);
+		} else if (argument.compare(0, 8, "--label=") == 0) {
+			options.label = argument.substr(8);
+		} else if (argument.compare(0, 9, "--filter=") == 0) {
+			options.filter = argument.substr(9);
+		} else if (argument == "--check-allocations") {
+			checkOnly = true;
+		} else {
+			usage();
+			return -1;
+		}
+	}
+	if (options.format != "json" && options.format != "csv") {
+		usage();
+		return -1;
+	}
+
+	if (checkOnly) {
+		int nFailures = checkHotPathAllocations(options);
+		if (nFailures != 0) {
+			fprintf(stderr, "benchmark_smcp: %d hot path(s) allocated memory in steady state\n", nFailures);
+			return 1;
+		}
+		return 0;
+	}
+
+	//3 bytes up to the largest Message Data a 24-bit Message Length can describe
+	const size_t payloadSizes[] = { 3, 16, 256, 4096, 65536, 1048576, 16777210 };
+	const size_t nPayloadSizes = sizeof(payloadSizes) / sizeof(payloadSizes[0]);
+
+	printHeader(options);
+	for (size_t t = 0; t < sizeof(messageTypes) / sizeof(messageTypes[0]); t++) {
+		const MessageTypeEntry& type = messageTypes[t];
+		for (size_t s = 0; s < nPayloadSizes; s++) {
+			size_t payloadSize = payloadSizes[s];
+			if (options.maximumPayloadSize < payloadSize) {
+				break;
+			}
+			if (type.fixedPayloadSize != 0) {
+				//fixed-size messages are measured once
+				if (s != 0) {
+					break;
+				}
+				payloadSize = type.fixedPayloadSize;
+			} else if (payloadSize < type.minimumPayloadSize) {
+				payloadSize = type.minimumPayloadSize;
+			}
+
+			std::vector<uint8_t> bytes = createMessageBytes(type, payloadSize);
+			SMCPCommandMessage commandMessage;
+			SMCPTelemetryMessage telemetryMessage;
+			SMCPMessage* message;
+			if (type.isCommand) {
+				commandMessage.interpretAsCommandMessage(bytes);
+				message = &commandMessage;
+			} else {
+				telemetryMessage.interpretAsTelemetryMessage(bytes);
+				message = &telemetryMessage;
+			}
+
+			std::vector<std::pair<std::string, BenchmarkCase*> > cases;
+			if (type.isCommand) {
+				cases.push_back(std::make_pair("decode", (BenchmarkCase*) new CommandDecodeCase(bytes)));
+			} else {
+				cases.push_back(std::make_pair("decode", (BenchmarkCase*) new TelemetryDecodeCase(bytes)));
+			}
+			if (type.isCommand) {
+				cases.push_back(std::make_pair("view", (BenchmarkCase*) new CommandViewCase(bytes)));
+				cases.push_back(std::make_pair("template", (BenchmarkCase*) new CommandTemplateCase(bytes)));
+			} else {
+				cases.push_back(std::make_pair("view", (BenchmarkCase*) new TelemetryViewCase(bytes)));
+#if __cplusplus >= 201703L
+				cases.push_back(std::make_pair("variant", (BenchmarkCase*) new TelemetryVariantCase(bytes)));
+#endif
+			}
+			cases.push_back(std::make_pair("encode", (BenchmarkCase*) new EncodeCase(*message)));
+			cases.push_back(std::make_pair("serialize", (BenchmarkCase*) new SerializeCase(*message)));
+			if (bytes.size() + SMCPFramePacker::CommandLengthPrefixLength <= 1472) {
+				cases.push_back(std::make_pair("framePacker", (BenchmarkCase*) new FramePackerCase(bytes, type.isCommand)));
+			}
+#if defined(__linux__)
+			if (!type.isCommand && bytes.size() <= SharedMemoryBusCase::Capacity / 4) {
+				cases.push_back(std::make_pair("sharedMemoryBus", (BenchmarkCase*) new SharedMemoryBusCase(bytes)));
+			}
+#endif
+			if (message->getLength() <= SMCPSpacePacketEncoder::MaximumPacketDataLength) {
+				cases.push_back(std::make_pair("spacePacket", (BenchmarkCase*) new SpacePacketCase(*message, type.isCommand)));
+			}
+			if (!type.isCommand) {
+				cases.push_back(std::make_pair("length", (BenchmarkCase*) new MessageLengthCase(telemetryMessage)));
+				cases.push_back(std::make_pair("headerBatch", (BenchmarkCase*) new HeaderBatchCase(bytes)));
+				cases.push_back(std::make_pair("streamDecode", (BenchmarkCase*) new StreamDecoderCase(bytes)));
+				cases.push_back(std::make_pair("memoryDiff", (BenchmarkCase*) new MemoryImageDiffCase(bytes)));
+			}
+			cases.push_back(std::make_pair("toString", (BenchmarkCase*) new ToStringCase(*message)));
+			cases.push_back(std::make_pair("format", (BenchmarkCase*) new FormatCase(*message)));
+			cases.push_back(std::make_pair("compact", (BenchmarkCase*) new CompactFormatCase(bytes, type.isCommand)));
+
+			for (size_t c = 0; c < cases.size(); c++) {
+				std::string name = std::string(type.name) + "/" + cases[c].first;
+				if (options.filter.empty() || name.find(options.filter) != std::string::npos) {
+					BenchmarkResult result = measure(*cases[c].second, options);
+					result.messageType = type.name;
+					result.operation = cases[c].first;
+					result.payloadSize = payloadSize;
+					result.messageSize = bytes.size();
+					printResult(result, options);
+				}
+				delete cases[c].second;
+			}
+		}
+	}
+	return 0;
+}
@@ -5,37 +5,597 @@
  *      Author: yuasa
  */
 
+/* Interprets SMCP packets.
+ *
+ * Single packet mode (arguments are bytes of one command packet):
+ *   interpret_smcp_packet 0x41 0x12 0x00 0x01
+ *
+ * Batch mode (options start with --; files default to stdin, "-" is stdin):
+ *   interpret_smcp_packet --batch [--telemetry|--command] [--input=hex|binary]
+ *                         [--output=dump|json|compact] [file...]
+ *
+ * Input formats in batch mode:
+ *  - hex    : one packet per line. Bytes are either hex pairs ("41120001",
+ *             "41 12 00 01") or 0x-prefixed tokens ("0x41 0x12 0x0 0x1").
+ *             Empty lines and lines starting with '#' are skipped.
+ *  - binary : telemetry packets back to back (each carries its Message
+ *             Length), or command packets each preceded by a 2-byte
+ *             big-endian length, since command packets do not carry their
+ *             own length.
+ *
+ * Output formats in batch mode:
+ *  - dump    : the same text as SMCPMessage::toString()
+ *  - json    : one JSON object per packet
+ *  - compact : one line per packet (see SMCPFormatter)
+ *
+ * Input is read in large blocks, hex digits are converted by table lookup,
+ * and output is accumulated and written in large blocks.
+ */
+
 #include "SMCP.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <vector>
-#include <sstream>
+#include <string>
 
 int toInteger(std::string str) {
+	int base = (str.size() >= 2 && str[0] == '0' && (str[1] == 'X' || str[1] == 'x')) ? 16 : 10;
+	return (int) strtol(str.c_str(), NULL, base);
+}
+
+/* ---------------- batch mode ---------------- */
+
+class BatchOptions {
+public:
+	enum {
+		DumpOutput, JSONOutput, CompactOutput
+	};
+
+public:
+	bool isTelemetry;
+	bool isBinaryInput;
+	int outputFormat;
+	std::vector<std::string> files;
+
+public:
+	BatchOptions() :
+			isTelemetry(false), isBinaryInput(false), outputFormat(DumpOutput) {
+	}
+};
+
+/** Output accumulated in a string and written in large blocks. */
+class OutputBuffer {
+public:
+	static const size_t FlushSize = 1 << 20;
+
+public:
+	std::string text;
+
+public:
+	OutputBuffer() {
+		text.reserve(FlushSize * 2);
+	}
+
+public:
+	~OutputBuffer() {
+		flush();
+	}
+
+public:
+	void flushIfFull() {
+		if (FlushSize <= text.size()) {
+			flush();
+		}
+	}
+
+public:
+	void flush() {
+		fwrite(text.data(), 1, text.size(), stdout);
+		text.clear();
+	}
+};
+
+/** Hex digit values; -1 for other characters. */
+class HexTable {
+public:
+	int8_t values[256];
+
+public:
+	HexTable() {
+		for (int i = 0; i < 256; i++) {
+			values[i] = -1;
+		}
+		for (int i = 0; i < 10; i++) {
+			values['0' + i] = i;
+		}
+		for (int i = 0; i < 6; i++) {
+			values['a' + i] = 10 + i;
+			values['A' + i] = 10 + i;
+		}
+	}
+};
+
+static const HexTable hexTable;
+
+static inline bool isSeparator(char c) {
+	return c == ' ' || c == '\t' || c == ',' || c == ':';
+}
+
+/** Converts one line of hex text into bytes.
+ * @return false if the line contains anything else than hex bytes.
+ */
+static bool parseHexLine(const char* line, size_t length, std::vector<uint8_t>& bytes) {
+	//a line never holds more bytes than half its characters (plus one for a lone "0x1")
+	bytes.resize(length / 2 + 1);
+	uint8_t* out = &bytes[0];
+	size_t i = 0;
+	while (i < length) {
+		if (isSeparator(line[i])) {
+			i++;
+			continue;
+		}
+		if (i + 2 < length && line[i] == '0' && (line[i + 1] == 'x' || line[i + 1] == 'X')) {
+			//0x-prefixed token: one byte of one or two digits
+			size_t end = i + 2;
+			int value = 0;
+			for (; end < length && !isSeparator(line[end]); end++) {
+				int digit = hexTable.values[(uint8_t) line[end]];
+				if (digit < 0 || i + 4 <= end) {
+					return false;
+				}
+				value = value * 16 + digit;
+			}
+			if (end == i + 2) {
+				//"0x" without digits
+				return false;
+			}
+			*out++ = (uint8_t) value;
+			i = end;
+		} else {
+			//run of hex pairs, decoded until a separator
+			for (; i < length && !isSeparator(line[i]); i += 2) {
+				if (i + 1 == length) {
+					return false;
+				}
+				int high = hexTable.values[(uint8_t) line[i]];
+				int low = hexTable.values[(uint8_t) line[i + 1]];
+				if ((high | low) < 0) {
+					return false;
+				}
+				*out++ = (uint8_t) (high * 16 + low);
+			}
+		}
+	}
+	bytes.resize(out - &bytes[0]);
+	return true;
+}
+
+/** Formats decoded packets into an OutputBuffer. */
+class PacketPrinter {
+private:
+	const BatchOptions& options;
+	OutputBuffer& output;
+	SMCPCommandMessage command;
+	SMCPTelemetryMessage telemetry;
+	SMCPCommandMessageView commandView;
+	SMCPTelemetryMessageView telemetryView;
+	uint64_t nPackets;
+	uint64_t nErrors;
+
+public:
+	PacketPrinter(const BatchOptions& options, OutputBuffer& output) :
+			options(options), output(output), nPackets(0), nErrors(0) {
+	}
+
+public:
+	/** Prints a packet, or an error line if the packet is malformed.
+	 * Packets are validated with the views in every output format, so that
+	 * each malformed packet is counted once. Bytes after the Message Length of
+	 * a telemetry message are reported as an error in every output format.
+	 * @param[in] positionName "offset" (binary input) or "line" (hex input).
+	 * @param[in] position byte offset or line number of the packet.
+	 */
+	void print(const uint8_t* data, size_t length, const char* positionName, uint64_t position) {
+		nPackets++;
+		bool valid;
+		if (options.isTelemetry) {
+			valid = telemetryView.tryInterpretAsTelemetryMessage(data, length);
+		} else {
+			valid = commandView.tryInterpretAsCommandMessage(data, length);
+		}
+		if (!valid) {
+			nErrors++;
+			printError("size error", positionName, position);
+			output.flushIfFull();
+			return;
+		}
+		//a hex line may hold more bytes than the Message Length of the telemetry message
+		size_t messageLength = options.isTelemetry ? telemetryView.getLength() : length;
+		switch (options.outputFormat) {
+		case BatchOptions::JSONOutput:
+			if (options.isTelemetry) {
+				printTelemetryJSON(telemetryView, positionName, position);
+			} else {
+				printCommandJSON(commandView, positionName, position);
+			}
+			break;
+		case BatchOptions::CompactOutput:
+			if (options.isTelemetry) {
+				SMCPFormatter::appendCompactTelemetry(output.text, data, messageLength);
+			} else {
+				SMCPFormatter::appendCompactCommand(output.text, data, length);
+			}
+			output.text += '\n';
+			break;
+		default:
+			try {
+				if (options.isTelemetry) {
+					telemetry.interpretAsTelemetryMessage((uint8_t*) data, messageLength);
+					telemetry.appendString(output.text);
+				} else {
+					command.interpretAsCommandMessage((uint8_t*) data, length);
+					command.appendString(output.text);
+				}
+			} catch (SMCPException& e) {
+				nErrors++;
+				printError("size error", positionName, position);
+			}
+			break;
+		}
+		if (messageLength < length) {
+			char message[64];
+			snprintf(message, sizeof(message), "%llu trailing bytes after the message",
+					(unsigned long long) (length - messageLength));
+			nErrors++;
+			printError(message, positionName, position);
+		}
+		output.flushIfFull();
+	}
+
+public:
+	/** Prints an input error. */
+	void printError(const char* message, const char* positionName, uint64_t position) {
+		char line[256];
+		if (options.outputFormat == BatchOptions::JSONOutput) {
+			snprintf(line, sizeof(line), "{\"%s\":%llu,\"error\":\"%s\"}\n", positionName,
+					(unsigned long long) position, message);
+		} else {
+			snprintf(line, sizeof(line), "ERROR %s=%llu %s\n", positionName, (unsigned long long) position, message);
+		}
+		output.text += line;
+	}
+
+public:
+	void countError() {
+		nErrors++;
+	}
+
+public:
+	uint64_t getNPackets() const {
+		return nPackets;
+	}
+
+public:
+	uint64_t getNErrors() const {
+		return nErrors;
+	}
+
+private:
+	void beginJSON(const char* positionName, uint64_t position) {
+		char line[64];
+		char* p = line;
+		*p++ = '{';
+		*p++ = '"';
+		p = SMCPFormatter::writeString(p, positionName);
+		p = SMCPFormatter::writeLiteral(p, "\":");
+		p = SMCPFormatter::writeDecimal(p, position);
+		output.text.append(line, p - line);
+	}
+
+private:
+	void appendField(const char* name, uint64_t value) {
+		char line[64];
+		char* p = line;
+		*p++ = ',';
+		*p++ = '"';
+		p = SMCPFormatter::writeString(p, name);
+		p = SMCPFormatter::writeLiteral(p, "\":");
+		p = SMCPFormatter::writeDecimal(p, value);
+		output.text.append(line, p - line);
+	}
+
+private:
+	void appendField(const char* name, const char* value) {
+		output.text += ",\"";
+		output.text += name;
+		output.text += "\":\"";
+		output.text += value;
+		output.text += '"';
+	}
+
+private:
+	void appendHexField(const char* name, const uint8_t* bytes, size_t length) {
+		static const char digits[] = "0123456789abcdef";
+		output.text += ",\"";
+		output.text += name;
+		output.text += "\":\"";
+		size_t offset = output.text.size();
+		output.text.resize(offset + 2 * length);
+		for (size_t i = 0; i < length; i++) {
+			output.text[offset + 2 * i] = digits[bytes[i] >> 4];
+			output.text[offset + 2 * i + 1] = digits[bytes[i] & 0x0F];
+		}
+		output.text += '"';
+	}
+
+private:
+	void printCommandJSON(const SMCPCommandMessageView& view, const char* positionName, uint64_t position) {
+		beginJSON(positionName, position);
+		appendField("kind", "command");
+		appendField("type", SMCPFormatter::getCommandTypeName(view.getCommandTypeID()));
+		appendField("ack", view.getAcknowledgeRequest());
+		appendField("version", view.getSMCPVersion());
+		appendField("foid", view.getLowerFOID());
+		appendField("length", view.getLength());
+		switch (view.getCommandTypeID()) {
+		case SMCPCommandTypeID::ActionCommand:
+			appendField("operationID", view.getOperationID());
+			appendHexField("parameters", view.getParametersAsPointer(), view.getParametersLength());
+			break;
+		case SMCPCommandTypeID::GetCommand:
+			appendField("attributeID", view.getAttributeID());
+			break;
+		case SMCPCommandTypeID::MemoryLoadCommand:
+			appendField("startAddress", view.getStartAddress());
+			appendHexField("loadData", view.getLoadDataAsPointer(), view.getLoadDataLength());
+			break;
+		case SMCPCommandTypeID::MemoryDumpCommand:
+			appendField("nOfDumps", view.getNOfDumps() + 1);
+			appendField("startAddress", view.getStartAddress());
+			appendField("dumpLength", view.getDumpLength());
+			break;
+		default:
+			appendHexField("data", view.getMessageDataAsPointer(), view.getMessageDataLength());
+			break;
+		}
+		output.text += "}\n";
+	}
+
+private:
+	void printTelemetryJSON(const SMCPTelemetryMessageView& view, const char* positionName, uint64_t position) {
+		beginJSON(positionName, position);
+		appendField("kind", "telemetry");
+		appendField("type", SMCPFormatter::getTelemetryTypeName(view.getTelemetryTypeID()));
+		appendField("version", view.getSMCPVersion());
+		appendField("foid", view.getLowerFOID());
+		appendField("length", view.getMessageLength());
+		appendField("attributeID", view.getAttributeID());
+		appendHexField("value", view.getAttributeValuesAsPointer(), view.getAttributeValuesLength());
+		output.text += "}\n";
+	}
+};
+
+/** Reads a file in large blocks and passes packets to a PacketPrinter.
+ * @return false if the input ended in the middle of a packet or could not be resynchronized.
+ */
+class BatchReader {
+public:
+	static const size_t BlockSize = 1 << 20;
+
+private:
+	const BatchOptions& options;
+	PacketPrinter& printer;
+	std::vector<uint8_t> buffer;
+	std::vector<uint8_t> bytes;
+
+public:
+	BatchReader(const BatchOptions& options, PacketPrinter& printer) :
+			options(options), printer(printer), buffer(BlockSize * 2) {
+	}
+
+public:
+	bool read(FILE* file) {
+		if (options.isBinaryInput) {
+			return readBinary(file);
+		} else {
+			return readHex(file);
+		}
+	}
+
+private:
+	/** Reads more data after the unconsumed bytes [begin, end), which are moved to the front.
+	 * @return false at end of file.
+	 */
+	bool fill(FILE* file, size_t& begin, size_t& end, size_t required) {
+		size_t remaining = end - begin;
+		if (begin != 0) {
+			memmove(&buffer[0], &buffer[begin], remaining);
+			begin = 0;
+			end = remaining;
+		}
+		if (buffer.size() < required + BlockSize) {
+			buffer.resize(required + BlockSize);
+		}
+		size_t n = fread(&buffer[end], 1, buffer.size() - end, file);
+		end += n;
+		return n != 0;
+	}
+
+private:
+	bool readBinary(FILE* file) {
+		size_t begin = 0, end = 0;
+		uint64_t offset = 0;
+		bool eof = false;
+		while (true) {
+			size_t available = end - begin;
+			size_t required;
+			size_t headerLength;
+			if (options.isTelemetry) {
+				headerLength = 0;
+				required = 4;
+				if (4 <= available) {
+					required = SMCPTelemetryMessageView::getMessageLength(&buffer[begin]);
+					if (required < SMCPTelemetryMessageView::MinimumMessageLength) {
+						printer.countError();
+						printer.printError("invalid Message Length; cannot resynchronize", "offset", offset);
+						return false;
+					}
+				}
+			} else {
+				headerLength = 2;
+				required = 2;
+				if (2 <= available) {
+					required = 2 + ((size_t) buffer[begin] << 8) + buffer[begin + 1];
+				}
+			}
+			if (required <= available) {
+				printer.print(&buffer[begin + headerLength], required - headerLength, "offset", offset);
+				begin += required;
+				offset += required;
+				continue;
+			}
+			if (eof) {
+				if (available != 0) {
+					printer.countError();
+					printer.printError("truncated packet at end of input", "offset", offset);
+					return false;
+				}
+				return true;
+			}
+			eof = !fill(file, begin, end, required);
+		}
+	}
+
+private:
+	bool readHex(FILE* file) {
+		size_t begin = 0, end = 0;
+		uint64_t lineNumber = 0;
+		bool eof = false;
+		while (true) {
+			uint8_t* start = &buffer[begin];
+			uint8_t* newline = (uint8_t*) memchr(start, '\n', end - begin);
+			if (newline == NULL && !eof) {
+				eof = !fill(file, begin, end, end - begin);
+				continue;
+			}
+			if (newline == NULL && begin == end) {
+				return true;
+			}
+			size_t lineLength = (newline == NULL) ? end - begin : newline - start;
+			lineNumber++;
+			processHexLine((const char*) start, lineLength, lineNumber);
+			begin += lineLength + (newline == NULL ? 0 : 1);
+		}
+	}
+
+private:
+	void processHexLine(const char* line, size_t length, uint64_t lineNumber) {
+		if (length != 0 && line[length - 1] == '\r') {
+			length--;
+		}
+		size_t first = 0;
+		while (first < length && (line[first] == ' ' || line[first] == '\t')) {
+			first++;
+		}
+		if (first == length || line[first] == '#') {
+			return;
+		}
+		if (!parseHexLine(line + first, length - first, bytes)) {
+			printer.countError();
+			printer.printError("invalid hex text", "line", lineNumber);
+			return;
+		}
+		if (!bytes.empty()) {
+			printer.print(&bytes[0], bytes.size(), "line", lineNumber);
+		}
+	}
+};
+
+static void usage() {
 	using namespace std;
-	stringstream ss;
-	ss << str;
-	int avalue;
-	if (str.size() >= 2 && str[0] == '0' && (str[1] == 'X' || str[1] == 'x')) {
-		ss >> hex >> avalue;
-	} else {
-		ss >> avalue;
-	}
-	return avalue;
+	cerr << "interpret_smcp_packet (byte array)" << endl;
+	cerr << "interpret_smcp_packet --batch [options] [file...]" << endl;
+	cerr << "  --command             input is command packets (default)" << endl;
+	cerr << "  --telemetry           input is telemetry packets" << endl;
+	cerr << "  --input=hex|binary    one hex packet per line (default), or raw bytes" << endl;
+	cerr << "                        (commands in binary input carry a 2-byte big-endian length)" << endl;
+	cerr << "  --output=dump|json|compact" << endl;
+	cerr << "                        toString() dump (default), JSON lines, or one line per packet" << endl;
+	cerr << "  file                  input files; stdin if none or \"-\"" << endl;
+}
+
+static int runBatch(int argc, char* argv[]) {
+	BatchOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--batch") {
+		} else if (argument == "--telemetry") {
+			options.isTelemetry = true;
+		} else if (argument == "--command") {
+			options.isTelemetry = false;
+		} else if (argument == "--input=hex") {
+			options.isBinaryInput = false;
+		} else if (argument == "--input=binary") {
+			options.isBinaryInput = true;
+		} else if (argument == "--output=dump") {
+			options.outputFormat = BatchOptions::DumpOutput;
+		} else if (argument == "--output=json") {
+			options.outputFormat = BatchOptions::JSONOutput;
+		} else if (argument == "--output=compact") {
+			options.outputFormat = BatchOptions::CompactOutput;
+		} else if (argument == "-" || argument.compare(0, 2, "--") != 0) {
+			options.files.push_back(argument);
+		} else {
+			usage();
+			return -1;
+		}
+	}
+	if (options.files.empty()) {
+		options.files.push_back("-");
+	}
+
+	OutputBuffer output;
+	PacketPrinter printer(options, output);
+	BatchReader reader(options, printer);
+	bool succeeded = true;
+	for (size_t i = 0; i < options.files.size(); i++) {
+		FILE* file = (options.files[i] == "-") ? stdin : fopen(options.files[i].c_str(), "rb");
+		if (file == NULL) {
+			output.flush();
+			fprintf(stderr, "interpret_smcp_packet: cannot open %s\n", options.files[i].c_str());
+			succeeded = false;
+			continue;
+		}
+		succeeded = reader.read(file) && succeeded;
+		if (file != stdin) {
+			fclose(file);
+		}
+	}
+	output.flush();
+	fprintf(stderr, "interpret_smcp_packet: %llu packets, %llu errors\n", (unsigned long long) printer.getNPackets(),
+			(unsigned long long) printer.getNErrors());
+	return (succeeded && printer.getNErrors() == 0) ? 0 : 1;
 }
 
-int main(int argc,char* argv[]){
+int main(int argc, char* argv[]) {
 	using namespace std;
 
-	if(argc==1){
-		cerr << "interpret_smcp_packet (byte array)" << endl;
+	if (argc == 1) {
+		usage();
 		exit(-1);
 	}
 
-	SMCPCommandMessage* packet=new SMCPCommandMessage();
+	if (strncmp(argv[1], "--", 2) == 0) {
+		return runBatch(argc, argv);
+	}
+
+	SMCPCommandMessage packet;
 	vector<unsigned char> data;
-	for(int i=1;i<argc;i++){
-		data.push_back((unsigned char)toInteger(argv[i]));
+	for (int i = 1; i < argc; i++) {
+		data.push_back((unsigned char) toInteger(argv[i]));
 	}
-	packet->interpretAsCommandMessage(data);
-	packet->dumpToScreen();
+	packet.interpretAsCommandMessage(data);
+	packet.dumpToScreen();
 }
@@ -0,0 +1,1928 @@
+/*
+ * test_smcp.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Behavioral tests of the SMCP library.
+ *
+ * Each test function checks one utility against an independent reference
+ * (hand-written expected values, a naive byte loop, or the text produced by
+ * the original SMCPMessage::toString() implementation). The program prints
+ * each failed check and exits with a non-zero status if any check failed.
+ *
+ * Usage:
+ *   make test
+ */
+
+#include "SMCP.hh"
+#include "SMCPCommandBuilder.hh"
+#include "SMCPTelemetryVariant.hh"
+#include "SMCPShardedPipeline.hh"
+#include "SMCPStagePipeline.hh"
+#include "SMCPTelemetrySnapshotFile.hh"
+#if defined(__linux__)
+#include "SMCPSharedMemoryBus.hh"
+#endif
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ---------------- check helpers ---------------- */
+
+static int nChecks = 0;
+static int nFailures = 0;
+
+#define CHECK(condition) \
+	do { \
+		nChecks++; \
+		if (!(condition)) { \
+			nFailures++; \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+#define CHECK_THROWS(statement) \
+	do { \
+		nChecks++; \
+		bool thrown = false; \
+		try { \
+			statement; \
+		} catch (SMCPException&) { \
+			thrown = true; \
+		} \
+		if (!thrown) { \
+			nFailures++; \
+			printf("FAIL %s:%d: %s did not throw SMCPException\n", __FILE__, __LINE__, #statement); \
+		} \
+	} while (0)
+
+/* ---------------- message construction ---------------- */
+
+/** Returns wire bytes of a command message whose payload byte i is i*7+1. */
+static std::vector<uint8_t> createCommandBytes(uint8_t commandTypeID, size_t payloadSize) {
+	std::vector<uint8_t> bytes;
+	bytes.push_back(0x40 | 0x10 | commandTypeID);
+	bytes.push_back(0x12);
+	for (size_t i = 0; i < payloadSize; i++) {
+		bytes.push_back((uint8_t) (i * 7 + 1));
+	}
+	return bytes;
+}
+
+/** Returns wire bytes of a telemetry message whose Message Data byte i is i*7+1. */
+static std::vector<uint8_t> createTelemetryBytes(uint8_t telemetryTypeID, size_t payloadSize) {
+	size_t length = SMCPTelemetryMessageView::HeaderLength + payloadSize;
+	std::vector<uint8_t> bytes;
+	bytes.push_back(0x10 | telemetryTypeID);
+	bytes.push_back((uint8_t) (length >> 16));
+	bytes.push_back((uint8_t) (length >> 8));
+	bytes.push_back((uint8_t) length);
+	bytes.push_back(0x12);
+	for (size_t i = 0; i < payloadSize; i++) {
+		bytes.push_back((uint8_t) (i * 7 + 1));
+	}
+	return bytes;
+}
+
+/** Returns wire bytes of a telemetry message with the given header fields and random Attribute Value. */
+static std::vector<uint8_t> createRandomTelemetryBytes(uint8_t telemetryTypeID, uint8_t lowerFOID,
+		uint16_t attributeID, size_t valueLength) {
+	size_t length = SMCPTelemetryMessageView::HeaderLength + 2 + valueLength;
+	std::vector<uint8_t> bytes(length);
+	bytes[0] = 0x10 | telemetryTypeID;
+	bytes[1] = (uint8_t) (length >> 16);
+	bytes[2] = (uint8_t) (length >> 8);
+	bytes[3] = (uint8_t) length;
+	bytes[4] = lowerFOID;
+	bytes[5] = (uint8_t) (attributeID >> 8);
+	bytes[6] = (uint8_t) attributeID;
+	for (size_t i = 7; i < length; i++) {
+		bytes[i] = (uint8_t) rand();
+	}
+	return bytes;
+}
+
+/* ---------------- SMCPCurrentValueTable ---------------- */
+
+static void testCurrentValueTable() {
+	SMCPCurrentValueTable table(16, 8);
+	SMCPCurrentValueTable::Value value;
+	CHECK(!table.read(0x12, 0x0100, value));
+
+	uint8_t bytes[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+	table.update(0x12, 0x0100, bytes, 3, 1000);
+	table.update(0x12, 0x0101, bytes, 12, 2000);
+	table.update(0x12, 0x0100, bytes + 1, 3, 3000);
+	CHECK(table.size() == 2);
+	CHECK(table.read(0x12, 0x0100, value));
+	CHECK(value.receiveTime == 3000 && value.updateCount == 2 && value.length == 3);
+	CHECK(value.bytes.size() == 3 && value.bytes[0] == 2 && value.bytes[2] == 4);
+	//longer values are truncated to the maximum value length but report their length
+	CHECK(table.read(0x12, 0x0101, value));
+	CHECK(value.length == 12 && value.bytes.size() == 8 && value.bytes[7] == 8);
+	CHECK(!table.read(0x13, 0x0100, value));
+
+	SMCPCurrentValueTable::Snapshot snapshot;
+	table.snapshot(snapshot);
+	CHECK(snapshot.size() == 2);
+	CHECK(snapshot.entries[0].attributeID == 0x0100 && snapshot.entries[1].attributeID == 0x0101);
+	CHECK(snapshot.getValueAsPointer(1)[0] == 1 && snapshot.entries[1].storedLength == 8);
+
+	//seqlock: a reader must never observe a value mixing two updates
+	const size_t valueLength = 64;
+	SMCPCurrentValueTable shared(4, valueLength);
+	uint8_t first[valueLength];
+	memset(first, 0, valueLength);
+	shared.update(0x01, 0x0001, first, valueLength);
+	std::atomic<bool> done(false);
+	std::atomic<int> nTorn(0);
+	std::atomic<uint64_t> nReads(0);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 2; r++) {
+		readers.push_back(std::thread([&]() {
+			SMCPCurrentValueTable::Value readValue;
+			while (!done.load()) {
+				if (!shared.read(0x01, 0x0001, readValue) || readValue.bytes.size() != valueLength) {
+					nTorn++;
+					continue;
+				}
+				for (size_t i = 1; i < valueLength; i++) {
+					if (readValue.bytes[i] != readValue.bytes[0]) {
+						nTorn++;
+						break;
+					}
+				}
+				//every update writes (updateCount - 1) & 0xFF into all bytes
+				if (readValue.bytes[0] != (uint8_t) (readValue.updateCount - 1)) {
+					nTorn++;
+				}
+				nReads++;
+			}
+		}));
+	}
+	uint8_t next[valueLength];
+	for (uint32_t i = 1; i < 200000; i++) {
+		memset(next, (uint8_t) i, valueLength);
+		shared.update(0x01, 0x0001, next, valueLength);
+	}
+	done = true;
+	for (size_t r = 0; r < readers.size(); r++) {
+		readers[r].join();
+	}
+	CHECK(nTorn == 0);
+	CHECK(0 < nReads);
+}
+
+/* ---------------- SMCPInstrumentation ---------------- */
+
+/** Opens an instrumentation scope in its destructor, i.e. during unwinding. */
+class ScopeInDestructor {
+public:
+	~ScopeInDestructor() {
+		SMCPInstrumentationScope scope(SMCPInstrumentedType::GetCommand, SMCPInstrumentedOperation::Encode);
+	}
+};
+
+static void testInstrumentation() {
+	//nearest rank: with two samples, every percentile above 50 is the larger one
+	SMCPLatencyHistogram histogram;
+	histogram.record(518);
+	histogram.record(6469);
+	uint64_t largerBucket = SMCPLatencyHistogram::getBucketLowerBound(SMCPLatencyHistogram::getBucketIndex(6469));
+	CHECK(histogram.getPercentile(50) == 518);
+	CHECK(histogram.getPercentile(50.1) == largerBucket);
+	CHECK(histogram.getPercentile(99) == largerBucket);
+	CHECK(histogram.getPercentile(99.9) == largerBucket);
+	CHECK(histogram.getPercentile(0) == 518);
+	CHECK(histogram.getPercentile(100) == largerBucket);
+
+	SMCPLatencyHistogram hundred;
+	for (uint64_t i = 1; i <= 100; i++) {
+		hundred.record(i);
+	}
+	CHECK(hundred.getPercentile(1) == 1);
+	CHECK(hundred.getPercentile(1.5) == 2);
+
+	//a scope entered and left normally during unwinding records a latency, not an exception
+	SMCPInstrumentation::reset();
+	try {
+		ScopeInDestructor guard;
+		SMCPInstrumentationScope scope(SMCPInstrumentedType::GetCommand, SMCPInstrumentedOperation::Decode);
+		throw SMCPException("test");
+	} catch (SMCPException&) {
+	}
+	SMCPInstrumentationSnapshot snapshot;
+	SMCPInstrumentation::snapshot(snapshot);
+	const int type = SMCPInstrumentedType::GetCommand;
+	CHECK(snapshot.exceptions[type][SMCPInstrumentedOperation::Decode] == 1);
+	CHECK(snapshot.latencies[type][SMCPInstrumentedOperation::Decode].count == 0);
+#if __cplusplus >= 201703L
+	CHECK(snapshot.exceptions[type][SMCPInstrumentedOperation::Encode] == 0);
+	CHECK(snapshot.latencies[type][SMCPInstrumentedOperation::Encode].count == 1);
+#endif
+	SMCPInstrumentation::reset();
+}
+
+/* ---------------- SMCPTrafficStatistics ---------------- */
+
+static void testTrafficStatistics() {
+	std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 8);
+	SMCPTrafficStatistics statistics;
+	statistics.record(&bytes[0], bytes.size());
+	statistics.record(&bytes[0], 6);
+	statistics.record(&bytes[0], 3);
+	SMCPTrafficStatisticsSnapshot snapshot;
+	statistics.snapshot(snapshot);
+	const SMCPTrafficCounts& counts = snapshot.getCounts(0x12, SMCPTelemetryTypeID::ValueTelemetry);
+	CHECK(counts.nMessages == 2 && counts.nBytes == bytes.size() + 6 && counts.nErrors == 1);
+	CHECK(snapshot.nUndecodable == 1);
+	CHECK(snapshot.getAttributeCounts(0x12, 0x0100) != NULL);
+	CHECK(snapshot.getAttributeCounts(0x12, 0x0100)->nMessages == 1);
+
+	//collectors are destroyed right after detach() while other threads keep decoding
+	std::atomic<bool> done(false);
+	std::vector<std::thread> decoders;
+	for (int t = 0; t < 3; t++) {
+		decoders.push_back(std::thread([&]() {
+			std::vector<uint8_t> message = bytes;
+			SMCPTelemetryMessage telemetry;
+			while (!done.load()) {
+				telemetry.interpretAsTelemetryMessage(message);
+			}
+		}));
+	}
+	uint64_t nRecorded = 0;
+	for (int cycle = 0; cycle < 200; cycle++) {
+		SMCPTrafficStatistics* attached = new SMCPTrafficStatistics(16);
+		SMCPTrafficStatistics::attach(attached);
+		std::this_thread::yield();
+		SMCPTrafficStatistics::detach();
+		SMCPTrafficStatisticsSnapshot before, after;
+		attached->snapshot(before);
+		std::this_thread::yield();
+		attached->snapshot(after);
+		//nothing is recorded into a detached collector
+		CHECK(before.getTotal().nMessages == after.getTotal().nMessages);
+		nRecorded += after.getTotal().nMessages;
+		delete attached;
+	}
+	done = true;
+	for (size_t t = 0; t < decoders.size(); t++) {
+		decoders[t].join();
+	}
+	CHECK(0 < nRecorded);
+	CHECK(SMCPTrafficStatistics::getAttached() == NULL);
+}
+
+/* ---------------- SMCPTelemetryPredicateFilter ---------------- */
+
+static void testPredicateFilter() {
+	//Notification, foid 0x12, aid 0x0100, Attribute Value 00 01 02 32
+	uint8_t bytes[] = { 0x11, 0x00, 0x00, 0x0B, 0x12, 0x01, 0x00, 0x00, 0x01, 0x02, 0x32 };
+	SMCPTelemetryMessageView view;
+	CHECK(view.tryInterpretAsTelemetryMessage(bytes, sizeof(bytes)));
+
+	SMCPTelemetryPredicateFilter filter;
+	filter.add(0, "type == NotificationTelemetry && foid == 0x12 && payload[3] & 0x0F == 2");
+	filter.add(1, "type == ValueTelemetry");
+	filter.add(2, "aid == 0x0100 || foid == 0x99");
+	filter.add(3, "payload[10] == 0");
+	filter.add(4, "payload16[0] == 0x0001 && valuelength == 4");
+	filter.add(5, "!(length < 8) && 1 << 3 == 8 && ~0 != 0");
+	filter.add(6, "payload32[0] == 0x00010232");
+	filter.add(7, "0x12 == foid && version == 1 && reserved == 0");
+	CHECK(filter.size() == 8);
+	CHECK(filter.evaluate(view) == 0xF5);
+	CHECK(filter.evaluate(bytes, sizeof(bytes)) == 0xF5);
+
+	//a subscriber matches if any of its predicates does
+	filter.add(1, "foid == 0x12");
+	CHECK(filter.evaluate(view) == 0xF7);
+
+	//a type mismatch is skipped by the candidate tables
+	bytes[0] = 0x10;
+	CHECK(filter.evaluate(view) == 0xF6);
+
+	CHECK_THROWS(filter.add(8, "type =="));
+	CHECK_THROWS(filter.add(8, "payload[foid] == 1"));
+	CHECK_THROWS(filter.add(8, "payload[3 == 1"));
+	CHECK_THROWS(filter.add(8, "unknown == 1"));
+	CHECK_THROWS(filter.add(8, "(foid == 1"));
+	CHECK_THROWS(filter.add(8, "foid == 1)"));
+	CHECK_THROWS(filter.add(64, "foid == 1"));
+	//failed additions leave the filter unchanged
+	CHECK(filter.size() == 9);
+	CHECK(filter.evaluate(view) == 0xF6);
+
+	filter.clear();
+	CHECK(filter.evaluate(view) == 0);
+}
+
+/* ---------------- SMCPFormatter ---------------- */
+
+//output of SMCPMessage::toString() before it was reimplemented with SMCPFormatter
+static const char* expectedMemoryLoadCommand = //
+		"---------------------------------\n"
+		"SMCPCommandMessage\n"
+		"---------------------------------\n"
+		"=== Command Message Header ===\n"
+		"AcknowledgeRequest = 01b (AcknowledgeTelemetry is requested)\n"
+		"SMCP Version       = 01b\n"
+		"CommandTypeID      = 0100b (MemoryLoadCommand)\n"
+		"lowerFOID          = 0x12\n"
+		"=== Command Message Data ===\n"
+		"Start Address      = 0x01080f16\n"
+		"Load Data Length   = 5 bytes (decimal)\n"
+		"Load Data[0000]    = 0x1d\n"
+		"Load Data[0001]    = 0x24\n"
+		"Load Data[0002]    = 0x2b\n"
+		"Load Data[0003]    = 0x32\n"
+		"Load Data[0004]    = 0x39\n"
+		"\n";
+
+static const char* expectedMemoryDumpCommand = //
+		"---------------------------------\n"
+		"SMCPCommandMessage\n"
+		"---------------------------------\n"
+		"=== Command Message Header ===\n"
+		"AcknowledgeRequest = 01b (AcknowledgeTelemetry is requested)\n"
+		"SMCP Version       = 01b\n"
+		"CommandTypeID      = 0101b (MemoryDumpCommand)\n"
+		"lowerFOID          = 0x12\n"
+		"=== Command Message Data ===\n"
+		"AttributeID        = 0x0000\n"
+		"Number of dumps    = 2(01)\n"
+		"Start Address      = 0x080f161d\n"
+		"Dump Length        = 0x242b32\n"
+		"\n";
+
+static const char* expectedUndefinedCommand = //
+		"---------------------------------\n"
+		"SMCPCommandMessage\n"
+		"---------------------------------\n"
+		"=== Command Message Header ===\n"
+		"AcknowledgeRequest = 01b (AcknowledgeTelemetry is requested)\n"
+		"SMCP Version       = 01b\n"
+		"CommandTypeID      = 0010b (Undefined value)\n"
+		"lowerFOID          = 0x12\n"
+		"\n";
+
+static const char* expectedNotificationTelemetry = //
+		"---------------------------------\n"
+		"SMCPTelemetryMessage\n"
+		"---------------------------------\n"
+		"=== Command Message Header ===\n"
+		"Reserved           = 00b (Reserved)\n"
+		"SMCP Version       = 01b\n"
+		"TelemetryTypeID    = 0001b (NotificationTelemetry)\n"
+		"MessageLength      = 8 bytes (decial)\n"
+		"lowerFOID          = 0x12\n"
+		"=== Command Message Data ===\n"
+		"AttributeID        = 0108\n"
+		"Attr.Val. Length   = 1 bytes (decimal)\n"
+		"Attr.Val.[00000000]= 0x0f\n"
+		"\n";
+
+static const char* expectedMemoryDumpTelemetry = //
+		"---------------------------------\n"
+		"SMCPTelemetryMessage\n"
+		"---------------------------------\n"
+		"=== Command Message Header ===\n"
+		"Reserved           = 00b (Reserved)\n"
+		"SMCP Version       = 01b\n"
+		"TelemetryTypeID    = 0101b (MemoryDumpTelemetry)\n"
+		"MessageLength      = 24 bytes (decial)\n"
+		"lowerFOID          = 0x12\n"
+		"=== Command Message Data ===\n"
+		"AttributeID        = 0108\n"
+		"Attr.Val. Length   = 17 bytes (decimal)\n"
+		"Attr.Val.[00000000]= 0x0f\n"
+		"Attr.Val.[00000001]= 0x16\n"
+		"Attr.Val.[00000002]= 0x1d\n"
+		"Attr.Val.[00000003]= 0x24\n"
+		"Attr.Val.[00000004]= 0x2b\n"
+		"Attr.Val.[00000005]= 0x32\n"
+		"Attr.Val.[00000006]= 0x39\n"
+		"Attr.Val.[00000007]= 0x40\n"
+		"The AttributeValues field continue... (total size = 17 bytes)\n"
+		"\n";
+
+static void testFormatter() {
+	SMCPCommandMessage command;
+	std::vector<uint8_t> bytes = createCommandBytes(SMCPCommandTypeID::MemoryLoadCommand, 9);
+	command.interpretAsCommandMessage(bytes);
+	CHECK(command.toString() == expectedMemoryLoadCommand);
+	bytes = createCommandBytes(SMCPCommandTypeID::MemoryDumpCommand, 8);
+	command.interpretAsCommandMessage(bytes);
+	CHECK(command.toString() == expectedMemoryDumpCommand);
+	bytes = createCommandBytes(0x02, 2);
+	command.interpretAsCommandMessage(bytes);
+	CHECK(command.toString() == expectedUndefinedCommand);
+
+	SMCPTelemetryMessage telemetry;
+	bytes = createTelemetryBytes(SMCPTelemetryTypeID::NotificationTelemetry, 3);
+	telemetry.interpretAsTelemetryMessage(bytes);
+	CHECK(telemetry.toString() == expectedNotificationTelemetry);
+	bytes = createTelemetryBytes(SMCPTelemetryTypeID::MemoryDumpTelemetry, 19);
+	telemetry.interpretAsTelemetryMessage(bytes);
+	CHECK(telemetry.toString() == expectedMemoryDumpTelemetry);
+
+	//appendString() appends the same text
+	std::string out = "prefix";
+	telemetry.appendString(out);
+	CHECK(out == std::string("prefix") + expectedMemoryDumpTelemetry);
+}
+
+/* ---------------- SMCPTelemetryColumnExporter ---------------- */
+
+static void testColumnExporter() {
+	std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 4);
+	SMCPTelemetryMessageView view;
+	view.tryInterpretAsTelemetryMessage(&bytes[0], bytes.size());
+
+	std::stringstream binary;
+	SMCPTelemetryColumnExporter exporter(binary, SMCPTelemetryColumnExporter::BinaryFormat);
+	exporter.add(view, 1, 0);
+	exporter.add(view, 2, bytes.size());
+	exporter.finish();
+	std::string written = binary.str();
+	//rows added after finish() are neither counted nor written after the end marker
+	exporter.add(view, 3, 2 * bytes.size());
+	exporter.finish();
+	CHECK(exporter.getNRows() == 2);
+	CHECK(binary.str() == written);
+
+	std::stringstream csv;
+	{
+		SMCPTelemetryColumnExporter csvExporter(csv, SMCPTelemetryColumnExporter::CSVFormat);
+		csvExporter.add(view, 1, 0);
+		csvExporter.finish();
+		csvExporter.add(view, 2, 0);
+	}
+	std::string text = csv.str();
+	CHECK(std::count(text.begin(), text.end(), '\n') == 2);
+}
+
+/* ---------------- SMCPFramePacker / SMCPFrameUnpacker ---------------- */
+
+class FrameCollector: public SMCPFrameListener {
+public:
+	std::vector<std::vector<uint8_t> > frames;
+	size_t nMessages;
+
+public:
+	FrameCollector() :
+			nMessages(0) {
+	}
+
+public:
+	void frameCompleted(const uint8_t* frame, size_t length, size_t nMessages) {
+		frames.push_back(std::vector<uint8_t>(frame, frame + length));
+		this->nMessages += nMessages;
+	}
+};
+
+static void testFramePacker() {
+	const size_t frameSize = 256;
+
+	//telemetry
+	std::vector<std::vector<uint8_t> > telemetries;
+	for (size_t i = 0; i < 100; i++) {
+		telemetries.push_back(createRandomTelemetryBytes(i % 6, (uint8_t) i, (uint16_t) (i * 3), rand() % 120 + 1));
+	}
+	FrameCollector telemetryFrames;
+	SMCPFramePacker telemetryPacker(frameSize, SMCPMessageType::TelemetryMessage, 300, &telemetryFrames);
+	uint64_t now = 0;
+	for (size_t i = 0; i < telemetries.size(); i++) {
+		telemetryPacker.add(&telemetries[i][0], telemetries[i].size(), now);
+		now += 100;
+		telemetryPacker.poll(now);
+	}
+	telemetryPacker.flush();
+	CHECK(telemetryFrames.nMessages == telemetries.size());
+	CHECK(telemetryPacker.getNMessages() == telemetries.size());
+	CHECK(0 < telemetryPacker.getNDeadlineFlushes());
+
+	SMCPFrameUnpacker telemetryUnpacker(SMCPMessageType::TelemetryMessage);
+	SMCPTelemetryMessageView telemetryView;
+	size_t index = 0;
+	bool equal = true;
+	for (size_t f = 0; f < telemetryFrames.frames.size(); f++) {
+		CHECK(telemetryFrames.frames[f].size() <= frameSize);
+		telemetryUnpacker.setFrame(&telemetryFrames.frames[f][0], telemetryFrames.frames[f].size());
+		while (telemetryUnpacker.next(telemetryView)) {
+			equal = equal && index < telemetries.size() && telemetryView.getLength() == telemetries[index].size()
+					&& memcmp(telemetryView.getAsPointer(), &telemetries[index][0], telemetryView.getLength()) == 0;
+			index++;
+		}
+		CHECK(!telemetryUnpacker.hasError());
+	}
+	CHECK(equal && index == telemetries.size());
+
+	//commands
+	std::vector<std::vector<uint8_t> > commands;
+	for (size_t i = 0; i < 100; i++) {
+		if (i % 2 == 0) {
+			commands.push_back(createCommandBytes(SMCPCommandTypeID::GetCommand, 2));
+		} else {
+			commands.push_back(createCommandBytes(SMCPCommandTypeID::MemoryLoadCommand, 5 + rand() % 100));
+		}
+	}
+	FrameCollector commandFrames;
+	SMCPFramePacker commandPacker(frameSize, SMCPMessageType::CommandMessage, 1000, &commandFrames);
+	for (size_t i = 0; i < commands.size(); i++) {
+		commandPacker.add(&commands[i][0], commands[i].size(), 0);
+	}
+	commandPacker.flush();
+	CHECK(commandFrames.nMessages == commands.size());
+
+	SMCPFrameUnpacker commandUnpacker(SMCPMessageType::CommandMessage);
+	SMCPCommandMessageView commandView;
+	index = 0;
+	equal = true;
+	for (size_t f = 0; f < commandFrames.frames.size(); f++) {
+		commandUnpacker.setFrame(&commandFrames.frames[f][0], commandFrames.frames[f].size());
+		while (commandUnpacker.next(commandView)) {
+			equal = equal && index < commands.size() && commandView.getLength() == commands[index].size()
+					&& memcmp(commandView.getAsPointer(), &commands[index][0], commandView.getLength()) == 0;
+			index++;
+		}
+		CHECK(!commandUnpacker.hasError());
+	}
+	CHECK(equal && index == commands.size());
+
+	//a truncated frame is reported as an error
+	std::vector<uint8_t> truncated = telemetryFrames.frames[0];
+	truncated.pop_back();
+	telemetryUnpacker.setFrame(&truncated[0], truncated.size());
+	while (telemetryUnpacker.next(telemetryView)) {
+	}
+	CHECK(telemetryUnpacker.hasError());
+
+	std::vector<uint8_t> large = createRandomTelemetryBytes(1, 0, 0, frameSize);
+	CHECK_THROWS(telemetryPacker.add(&large[0], large.size(), 0));
+
+	//messages which do not match the packer's kind or their Message Length are rejected
+	uint64_t nMessages = telemetryPacker.getNMessages();
+	std::vector<uint8_t> message = createRandomTelemetryBytes(1, 0, 0, 4);
+	CHECK_THROWS(telemetryPacker.add(&message[0], message.size() - 1, 0));
+	message.push_back(0);
+	CHECK_THROWS(telemetryPacker.add(&message[0], message.size(), 0));
+	CHECK_THROWS(telemetryPacker.add(&message[0], 6, 0));
+	std::vector<uint8_t> memoryLoad = createCommandBytes(SMCPCommandTypeID::MemoryLoadCommand, 4);
+	CHECK_THROWS(commandPacker.add(&memoryLoad[0], memoryLoad.size(), 0));
+	SMCPGetCommandMessage getCommand;
+	SMCPValueTelemetryMessage valueTelemetry;
+	CHECK_THROWS(telemetryPacker.add(getCommand, 0));
+	CHECK_THROWS(commandPacker.add(valueTelemetry, 0));
+	//a telemetry message whose Message Length has not been set
+	valueTelemetry.getMessageData()->setAttributeID(0x0100);
+	uint8_t value[4] = { 1, 2, 3, 4 };
+	valueTelemetry.getMessageData()->setAttributeValues(value, 4);
+	CHECK_THROWS(telemetryPacker.add(valueTelemetry, 0));
+	valueTelemetry.setMessageLengthAuto();
+	telemetryPacker.add(valueTelemetry, 0);
+	commandPacker.add(getCommand, 0);
+	CHECK(telemetryPacker.getNMessages() == nMessages + 1);
+}
+
+/* ---------------- SMCPShardedPipeline ---------------- */
+
+/** Returns a telemetry message whose Attribute Value starts with a sequence number followed by bytes (sequence + i). */
+static std::vector<uint8_t> createSequencedTelemetryBytes(uint8_t lowerFOID, uint32_t sequence, size_t valueLength) {
+	std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, lowerFOID, 0x0100,
+			valueLength);
+	memcpy(&bytes[7], &sequence, 4);
+	for (size_t i = 11; i < bytes.size(); i++) {
+		bytes[i] = (uint8_t) (sequence + i);
+	}
+	return bytes;
+}
+
+/** A handler which checks that the sequence numbers of each Lower FOID increase by one. */
+class SequenceCheckingHandler: public SMCPShardHandler {
+public:
+	size_t shardIndex;
+	size_t nShards;
+	std::atomic<bool>* released;
+	uint32_t lastSequences[256];
+	uint64_t nHandled;
+	uint64_t nOutOfOrder;
+	uint64_t nCorrupted;
+	bool finished;
+
+public:
+	SequenceCheckingHandler(size_t shardIndex, size_t nShards, std::atomic<bool>* released) :
+			shardIndex(shardIndex), nShards(nShards), released(released), nHandled(0), nOutOfOrder(0), nCorrupted(0),
+			finished(false) {
+		memset(lastSequences, 0, sizeof(lastSequences));
+	}
+
+public:
+	void handle(const SMCPTelemetryMessageView& message, uint64_t receiveTime) {
+		while (!released->load()) {
+			std::this_thread::yield();
+		}
+		uint8_t lowerFOID = message.getLowerFOID();
+		uint32_t sequence;
+		memcpy(&sequence, message.getAttributeValuesAsPointer(), 4);
+		if (sequence != lastSequences[lowerFOID] + 1 || lowerFOID % nShards != shardIndex) {
+			nOutOfOrder++;
+		}
+		lastSequences[lowerFOID] = sequence;
+		const uint8_t* data = message.getAsPointer();
+		for (size_t i = 11; i < message.getLength(); i++) {
+			if (data[i] != (uint8_t) (sequence + i)) {
+				nCorrupted++;
+				break;
+			}
+		}
+		//messages queued by submitStream() may carry a later time than their sequence number
+		if (receiveTime < sequence) {
+			nCorrupted++;
+		}
+		nHandled++;
+	}
+
+public:
+	void finish() {
+		finished = true;
+	}
+};
+
+class SequenceCheckingHandlerFactory: public SMCPShardHandlerFactory {
+public:
+	size_t nShards;
+	std::atomic<bool> released;
+
+public:
+	SequenceCheckingHandlerFactory(size_t nShards) :
+			nShards(nShards), released(true) {
+	}
+
+public:
+	SMCPShardHandler* createHandler(size_t shardIndex) {
+		return new SequenceCheckingHandler(shardIndex, nShards, &released);
+	}
+};
+
+static void testShardedPipeline() {
+	const size_t nShards = 2;
+	const size_t ringCapacity = 4096;
+
+	//messages of one Lower FOID are handled in order, across many wraps of a small ring
+	{
+		SequenceCheckingHandlerFactory factory(nShards);
+		SMCPShardedPipeline pipeline(nShards, &factory, NULL, std::vector<int>(), ringCapacity);
+		pipeline.start();
+		const uint32_t nMessages = 3000;
+		uint32_t nRejected = 0;
+		std::vector<uint8_t> stream;
+		for (uint32_t sequence = 1; sequence <= nMessages; sequence++) {
+			for (uint8_t lowerFOID = 0; lowerFOID < 4; lowerFOID++) {
+				std::vector<uint8_t> bytes = createSequencedTelemetryBytes(lowerFOID, sequence,
+						4 + (sequence * 7 + lowerFOID) % 300);
+				if (lowerFOID < 2) {
+					nRejected += pipeline.submit(&bytes[0], bytes.size(), sequence) != bytes.size();
+				} else {
+					//via submitStream() in pieces; an incomplete trailing message is passed again
+					stream.insert(stream.end(), bytes.begin(), bytes.end());
+					size_t end = rand() % stream.size() + 1;
+					size_t consumed = pipeline.submitStream(&stream[0], end, sequence);
+					stream.erase(stream.begin(), stream.begin() + consumed);
+				}
+			}
+		}
+		CHECK(pipeline.submitStream(&stream[0], stream.size(), nMessages) == stream.size());
+		CHECK(nRejected == 0);
+		pipeline.stop();
+		CHECK(pipeline.getNInvalid() == 0);
+		uint64_t nHandled = 0;
+		for (size_t i = 0; i < nShards; i++) {
+			SequenceCheckingHandler* handler = (SequenceCheckingHandler*) pipeline.getHandler(i);
+			CHECK(handler->nOutOfOrder == 0 && handler->nCorrupted == 0 && handler->finished);
+			SMCPShardStatistics statistics = pipeline.getStatistics(i);
+			CHECK(statistics.nSubmitted == handler->nHandled && statistics.nProcessed == handler->nHandled);
+			CHECK(ringCapacity * 10 < statistics.nSubmittedBytes);
+			nHandled += handler->nHandled;
+		}
+		CHECK(nHandled == nMessages * 4);
+	}
+
+	//trySubmit() fails on a full ring while submit() would wait; stop() drains the queued messages
+	{
+		SequenceCheckingHandlerFactory factory(1);
+		factory.released = false;
+		SMCPShardedPipeline pipeline(1, &factory, NULL, std::vector<int>(), ringCapacity);
+		pipeline.start();
+		uint32_t nAccepted = 0;
+		while (nAccepted < ringCapacity) {
+			std::vector<uint8_t> bytes = createSequencedTelemetryBytes(0, nAccepted + 1, 100);
+			if (pipeline.trySubmit(&bytes[0], bytes.size(), nAccepted + 1) == 0) {
+				break;
+			}
+			nAccepted++;
+		}
+		CHECK(0 < nAccepted && nAccepted < ringCapacity / 100);
+		factory.released = true;
+		pipeline.stop();
+		SequenceCheckingHandler* handler = (SequenceCheckingHandler*) pipeline.getHandler(0);
+		CHECK(handler->nHandled == nAccepted && handler->nOutOfOrder == 0 && handler->finished);
+		CHECK(pipeline.getStatistics(0).nProcessed == nAccepted);
+	}
+
+	//an invalid Message Length throws instead of stalling the stream; incomplete messages are not invalid
+	{
+		SequenceCheckingHandlerFactory factory(1);
+		SMCPShardedPipeline pipeline(1, &factory, NULL, std::vector<int>(), ringCapacity);
+		pipeline.start();
+		std::vector<uint8_t> good = createSequencedTelemetryBytes(0, 1, 4);
+		CHECK(pipeline.submitStream(&good[0], good.size() - 1, 1) == 0);
+		CHECK(pipeline.submit(&good[0], 3, 1) == 0);
+		CHECK(pipeline.getNInvalid() == 0);
+		std::vector<uint8_t> stream = good;
+		uint8_t invalid[8] = { 0x10, 0x00, 0x00, 0x05, 0x00, 0x01, 0x00, 0x00 };
+		stream.insert(stream.end(), invalid, invalid + sizeof(invalid));
+		std::vector<uint8_t> next = createSequencedTelemetryBytes(0, 2, 4);
+		stream.insert(stream.end(), next.begin(), next.end());
+		CHECK_THROWS(pipeline.submitStream(&stream[0], stream.size(), 1));
+		CHECK(pipeline.getNInvalid() == 1);
+		CHECK_THROWS(pipeline.trySubmit(invalid, sizeof(invalid), 0));
+		CHECK(pipeline.getNInvalid() == 2);
+		CHECK(pipeline.submit(&next[0], next.size(), 2) == next.size());
+		pipeline.stop();
+		SequenceCheckingHandler* handler = (SequenceCheckingHandler*) pipeline.getHandler(0);
+		CHECK(handler->nHandled == 2 && handler->nOutOfOrder == 0);
+	}
+}
+
+/* ---------------- SMCPTelemetryStreamDecoder ---------------- */
+
+class MessageCollector: public SMCPTelemetryStreamSink {
+public:
+	std::vector<std::vector<uint8_t> > messages;
+	std::vector<uint8_t> current;
+	bool inMessage;
+	int nSequenceErrors;
+
+public:
+	MessageCollector() :
+			inMessage(false), nSequenceErrors(0) {
+	}
+
+public:
+	void onMessageBegin(uint8_t telemetryTypeID, uint8_t lowerFOID, uint16_t attributeID, size_t messageLength) {
+		if (inMessage) {
+			nSequenceErrors++;
+		}
+		inMessage = true;
+		current.clear();
+		current.push_back(0x10 | telemetryTypeID);
+		current.push_back((uint8_t) (messageLength >> 16));
+		current.push_back((uint8_t) (messageLength >> 8));
+		current.push_back((uint8_t) messageLength);
+		current.push_back(lowerFOID);
+		current.push_back((uint8_t) (attributeID >> 8));
+		current.push_back((uint8_t) attributeID);
+	}
+
+public:
+	void onAttributeValue(const uint8_t* data, size_t length, size_t offset) {
+		if (!inMessage || offset != current.size() - SMCPTelemetryStreamDecoder::StagingLength) {
+			nSequenceErrors++;
+		}
+		current.insert(current.end(), data, data + length);
+	}
+
+public:
+	void onMessageEnd() {
+		if (!inMessage) {
+			nSequenceErrors++;
+		}
+		inMessage = false;
+		messages.push_back(current);
+	}
+};
+
+/** A sink which throws from onAttributeValue() while armed. */
+class ThrowingSink: public SMCPTelemetryStreamSink {
+public:
+	bool armed;
+
+public:
+	ThrowingSink() :
+			armed(true) {
+	}
+
+public:
+	void onMessageBegin(uint8_t, uint8_t, uint16_t, size_t) {
+	}
+
+public:
+	void onAttributeValue(const uint8_t*, size_t, size_t) {
+		if (armed) {
+			throw SMCPException("sink error");
+		}
+	}
+
+public:
+	void onMessageEnd() {
+	}
+};
+
+/** Fills messages with random telemetry messages (a few of them large) and stream with their concatenation. */
+static void createRandomTelemetryStream(std::vector<std::vector<uint8_t> >& messages, std::vector<uint8_t>& stream) {
+	for (size_t i = 0; i < 300; i++) {
+		size_t valueLength = (i % 50 == 0) ? rand() % 100000 + 1 : rand() % 60 + 1;
+		messages.push_back(createRandomTelemetryBytes(i % 6, (uint8_t) rand(), (uint16_t) rand(), valueLength));
+		stream.insert(stream.end(), messages.back().begin(), messages.back().end());
+	}
+}
+
+static void testStreamDecoder() {
+	std::vector<std::vector<uint8_t> > messages;
+	std::vector<uint8_t> stream;
+	createRandomTelemetryStream(messages, stream);
+
+	//stream decoder with random fragment sizes
+	for (int trial = 0; trial < 20; trial++) {
+		MessageCollector collector;
+		SMCPTelemetryStreamDecoder decoder(&collector);
+		size_t maximumFragment = (trial < 10) ? 10 : 5000;
+		size_t offset = 0;
+		bool consumedAll = true;
+		while (offset < stream.size()) {
+			size_t n = rand() % maximumFragment + 1;
+			if (stream.size() - offset < n) {
+				n = stream.size() - offset;
+			}
+			consumedAll = consumedAll && decoder.feed(&stream[offset], n) == n;
+			offset += n;
+		}
+		CHECK(consumedAll);
+		CHECK(collector.messages == messages);
+		CHECK(collector.nSequenceErrors == 0);
+		CHECK(!decoder.isInMessage() && !decoder.hasError());
+		CHECK(decoder.getNMessages() == messages.size() && decoder.getNBytes() == stream.size());
+	}
+
+	//a Message Length shorter than the minimum stops the decoder until reset()
+	MessageCollector collector;
+	SMCPTelemetryStreamDecoder decoder(&collector);
+	uint8_t invalid[10] = { 0x10, 0x00, 0x00, 0x05, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00 };
+	CHECK(decoder.feed(invalid, sizeof(invalid)) == SMCPTelemetryStreamDecoder::StagingLength);
+	CHECK(decoder.hasError());
+	decoder.reset();
+	CHECK(decoder.feed(&stream[0], stream.size()) == stream.size());
+	CHECK(collector.messages == messages);
+
+	//bytes are counted as they are consumed, also when the sink throws
+	ThrowingSink throwingSink;
+	SMCPTelemetryStreamDecoder throwingDecoder(&throwingSink);
+	std::vector<uint8_t> message = createRandomTelemetryBytes(1, 0x12, 0x0100, 13);
+	CHECK_THROWS(throwingDecoder.feed(&message[0], message.size()));
+	CHECK(throwingDecoder.getNBytes() == SMCPTelemetryStreamDecoder::StagingLength);
+	throwingDecoder.reset();
+	throwingSink.armed = false;
+	CHECK(throwingDecoder.feed(&message[0], message.size()) == message.size());
+	CHECK(throwingDecoder.getNBytes() == SMCPTelemetryStreamDecoder::StagingLength + message.size());
+	CHECK(throwingDecoder.getNMessages() == 1);
+}
+
+/* ---------------- SMCPTelemetryHeaderBatch ---------------- */
+
+static void testHeaderBatch() {
+	std::vector<std::vector<uint8_t> > messages;
+	std::vector<uint8_t> stream;
+	createRandomTelemetryStream(messages, stream);
+
+	SMCPTelemetryHeaderBatch batch;
+	//appended in random pieces
+	size_t offset = 0;
+	size_t end = 0;
+	while (end < stream.size()) {
+		end += rand() % 20000 + 1;
+		if (stream.size() < end) {
+			end = stream.size();
+		}
+		//an incomplete trailing message is fed again with the next piece
+		offset += batch.append(&stream[offset], end - offset, offset);
+		CHECK(!batch.hasError());
+	}
+	CHECK(offset == stream.size());
+	CHECK(batch.size() == messages.size());
+	bool equal = batch.size() == messages.size();
+	uint64_t messageOffset = 0;
+	for (size_t i = 0; equal && i < batch.size(); i++) {
+		const std::vector<uint8_t>& m = messages[i];
+		equal = batch.getTypeIDs()[i] == (m[0] & 0x0F) && batch.getLengths()[i] == m.size()
+				&& batch.getLowerFOIDs()[i] == m[4] && batch.getAttributeIDs()[i] == ((m[5] << 8) | m[6])
+				&& batch.getMessageOffset(i) == messageOffset && batch.getAttributeValuesLength(i) == m.size() - 7
+				&& stream[batch.getPayloadOffsets()[i]] == m[7 % m.size()];
+		messageOffset += m.size();
+	}
+	CHECK(equal);
+
+	//a Message Length shorter than the minimum is reported by hasError()
+	uint8_t invalid[10] = { 0x10, 0x00, 0x00, 0x05, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00 };
+	CHECK(batch.decode(invalid, sizeof(invalid)) == 0);
+	CHECK(batch.size() == 0 && batch.hasError());
+}
+
+/* ---------------- SMCPMemoryImageDiff ---------------- */
+
+static std::vector<SMCPMemoryDifference> diffNaively(const uint8_t* reference, const uint8_t* image, size_t length,
+		uint64_t baseAddress, uint64_t mergeGap) {
+	std::vector<SMCPMemoryDifference> result;
+	size_t i = 0;
+	while (i < length) {
+		while (i < length && reference[i] == image[i]) {
+			i++;
+		}
+		if (i == length) {
+			break;
+		}
+		size_t j = i;
+		while (j < length && reference[j] != image[j]) {
+			j++;
+		}
+		if (!result.empty() && baseAddress + i - (result.back().address + result.back().length) <= mergeGap) {
+			result.back().length = baseAddress + j - result.back().address;
+		} else {
+			result.push_back(SMCPMemoryDifference(baseAddress + i, j - i));
+		}
+		i = j;
+	}
+	return result;
+}
+
+static bool isEqual(const std::vector<SMCPMemoryDifference>& a, const std::vector<SMCPMemoryDifference>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].address != b[i].address || a[i].length != b[i].length) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testMemoryImageDiff() {
+	const uint64_t baseAddress = 0x1000;
+	int nMismatches = 0;
+	for (int trial = 0; trial < 300; trial++) {
+		size_t length = rand() % 5000 + 1;
+		std::vector<uint8_t> reference(length);
+		for (size_t i = 0; i < length; i++) {
+			reference[i] = (uint8_t) rand();
+		}
+		std::vector<uint8_t> image = reference;
+		int nDifferences = rand() % 20;
+		for (int k = 0; k < nDifferences; k++) {
+			size_t position = rand() % length;
+			size_t differenceLength = rand() % 40 + 1;
+			for (size_t i = position; i < position + differenceLength && i < length; i++) {
+				image[i] ^= (uint8_t) (rand() % 255 + 1);
+			}
+		}
+		uint64_t mergeGap = rand() % 5;
+		std::vector<SMCPMemoryDifference> expected = diffNaively(&reference[0], &image[0], length, baseAddress,
+				mergeGap);
+
+		SMCPMemoryImageDiff diff(&reference[0], length, baseAddress, mergeGap);
+		diff.begin(baseAddress);
+		size_t offset = 0;
+		while (offset < length) {
+			size_t n = rand() % 300 + 1;
+			if (length - offset < n) {
+				n = length - offset;
+			}
+			diff.feed(&image[offset], n);
+			offset += n;
+		}
+		if (!isEqual(diff.getDifferences(), expected) || diff.getNComparedBytes() != length) {
+			nMismatches++;
+		}
+		if (!isEqual(SMCPMemoryImageDiff::diff(&reference[0], &image[0], length, baseAddress, mergeGap), expected)) {
+			nMismatches++;
+		}
+	}
+	CHECK(nMismatches == 0);
+
+	//bytes outside the reference image are counted but not compared
+	std::vector<uint8_t> reference(256, 0x5A);
+	std::vector<uint8_t> image(64, 0x00);
+	SMCPMemoryImageDiff diff(&reference[0], reference.size(), baseAddress);
+	diff.begin(baseAddress + 224);
+	diff.feed(&image[0], image.size());
+	CHECK(diff.getNOutOfRangeBytes() == 32 && diff.getNComparedBytes() == 32);
+	CHECK(diff.getDifferences().size() == 1 && diff.getDifferences()[0].address == baseAddress + 224);
+	CHECK(diff.toString() == "0x000010e0 32\n");
+
+	//a region dumped 3 times (nOfDumps = 10) in chunks spanning the repetitions
+	std::vector<uint8_t> region(reference.begin() + 16, reference.begin() + 48);
+	region[4] = 0x00;
+	std::vector<uint8_t> dumps;
+	for (int i = 0; i < 3; i++) {
+		dumps.insert(dumps.end(), region.begin(), region.end());
+	}
+	diff.begin(baseAddress + 16, region.size());
+	for (size_t offset = 0; offset < dumps.size(); offset += 20) {
+		diff.feed(&dumps[offset], std::min((size_t) 20, dumps.size() - offset));
+	}
+	CHECK(diff.getNComparedBytes() == 96 && diff.getNOutOfRangeBytes() == 0);
+	CHECK(diff.getNDifferentBytes() == 3 && diff.getDifferences().size() == 3);
+	CHECK(diff.getDifferences()[2].address == baseAddress + 20 && diff.getDifferences()[2].length == 1);
+	CHECK(diff.getCurrentAddress() == baseAddress + 16);
+}
+
+/* ---------------- SMCPStagePipeline ---------------- */
+
+class PolicyResult {
+public:
+	std::vector<uint32_t> processed;
+	SMCPStageMetrics metrics;
+};
+
+/** Pushes nItems items into a single stage whose queue holds 4 items, while
+ * the stage is held on its first item when hold is true.
+ */
+static PolicyResult runPipeline(int policy, uint32_t nItems, bool hold) {
+	PolicyResult result;
+	std::atomic<bool> released(!hold);
+	SMCPFunctionStage stage([&](const SMCPPipelineItem& item, SMCPPipelineOutput&) {
+		while (!released.load()) {
+			std::this_thread::yield();
+		}
+		uint32_t number;
+		memcpy(&number, &item.bytes[0], 4);
+		result.processed.push_back(number);
+	});
+	SMCPStagePipeline pipeline;
+	size_t index = pipeline.addStage("stage", &stage, SMCPQueueConfiguration(4, 1024 * 1024, policy));
+	pipeline.start();
+	for (uint32_t i = 0; i < nItems; i++) {
+		pipeline.push(index, (const uint8_t*) &i, 4, i);
+	}
+	released = true;
+	pipeline.stop();
+	result.metrics = pipeline.getMetrics(index);
+	return result;
+}
+
+static bool isIncreasing(const std::vector<uint32_t>& numbers) {
+	for (size_t i = 1; i < numbers.size(); i++) {
+		if (numbers[i] <= numbers[i - 1]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testStagePipeline() {
+	const uint32_t nItems = 100;
+
+	PolicyResult block = runPipeline(SMCPQueuePolicy::Block, nItems, false);
+	CHECK(block.processed.size() == nItems && isIncreasing(block.processed));
+	CHECK(block.metrics.nDropped == 0 && block.metrics.nProcessed == nItems && block.metrics.nReceived == nItems);
+	CHECK(block.metrics.maximumQueueItems <= 4);
+
+	PolicyResult dropNewest = runPipeline(SMCPQueuePolicy::DropNewest, nItems, true);
+	CHECK(isIncreasing(dropNewest.processed));
+	CHECK(dropNewest.processed.size() <= 5 && dropNewest.processed[0] == 0);
+	CHECK(dropNewest.metrics.nProcessed + dropNewest.metrics.nDropped == nItems);
+	CHECK(dropNewest.metrics.nReceived == nItems);
+
+	PolicyResult dropOldest = runPipeline(SMCPQueuePolicy::DropOldest, nItems, true);
+	CHECK(isIncreasing(dropOldest.processed));
+	CHECK(dropOldest.processed.size() <= 5 && dropOldest.processed.back() == nItems - 1);
+	CHECK(dropOldest.metrics.nProcessed + dropOldest.metrics.nDropped == nItems);
+	CHECK(dropOldest.metrics.nReceived == nItems);
+
+	PolicyResult spill = runPipeline(SMCPQueuePolicy::SpillToDisk, nItems, true);
+	CHECK(spill.processed.size() == nItems && isIncreasing(spill.processed));
+	CHECK(spill.metrics.nDropped == 0 && 0 < spill.metrics.nSpilled && spill.metrics.nReceived == nItems);
+	CHECK(spill.metrics.spilledItems == 0 && spill.metrics.queueItems == 0);
+}
+
+/* ---------------- SMCPSharedMemoryBus ---------------- */
+
+#if defined(__linux__)
+/** Publishes a message whose Attribute ID and receive time are the sequence number. */
+static void publishSequenced(SMCPSharedMemoryBusWriter& writer, size_t messageLength) {
+	uint64_t sequence = writer.getNPublished();
+	std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x01,
+			(uint16_t) sequence, messageLength - 7);
+	writer.publish(&bytes[0], bytes.size(), sequence, 3);
+}
+
+/** Maps the segment of a writer read-only, to inspect the header and the data area. */
+static const uint8_t* mapSharedMemoryBus(const SMCPSharedMemoryBusWriter& writer) {
+	size_t length = SMCPSharedMemoryBus::getHeaderLength() + (size_t) writer.getCapacity();
+	void* p = mmap(NULL, length, PROT_READ, MAP_SHARED, writer.getFileDescriptor(), 0);
+	return (p == MAP_FAILED) ? NULL : (const uint8_t*) p;
+}
+
+static void testSharedMemoryBus() {
+	SMCPTelemetryMessageView message;
+	SMCPSharedMemoryBusRecord record;
+
+	//records of 224 bytes: 18 fit before the end of the ring, then a padding record is left
+	{
+		SMCPSharedMemoryBusWriter writer("", 4096);
+		SMCPSharedMemoryBusReader reader(writer.getFileDescriptor(), true);
+		CHECK(writer.getCapacity() == 4096 && SMCPSharedMemoryBus::getRecordLength(200) == 224);
+		bool intact = true;
+		for (int i = 0; i < 19; i++) {
+			publishSequenced(writer, 200);
+			intact = intact && reader.next(message, record) && reader.isValid();
+			intact = intact && record.sequence == (uint64_t) i && record.time == (uint64_t) i && record.source == 3;
+			intact = intact && message.getLength() == 200 && message.getAttributeID() == i;
+		}
+		CHECK(intact);
+		CHECK(!reader.next(message, record));
+		const uint8_t* segment = mapSharedMemoryBus(writer);
+		CHECK(segment != NULL);
+		if (segment != NULL) {
+			const SMCPSharedMemoryBusHeader* header = (const SMCPSharedMemoryBusHeader*) segment;
+			uint32_t length;
+			memcpy(&length, segment + SMCPSharedMemoryBus::getHeaderLength() + 18 * 224, sizeof(length));
+			CHECK(length == SMCPSharedMemoryBus::PaddingLength);
+			CHECK(header->writePosition.load() == 4096 + 224 && header->tailPosition.load() == 224);
+			munmap((void*) segment, SMCPSharedMemoryBus::getHeaderLength() + 4096);
+		}
+		CHECK(reader.getNReceived() == 19 && reader.getNLost() == 0 && reader.getNOverruns() == 0);
+	}
+
+	//records of 128 bytes: the ring holds exactly 32
+	{
+		SMCPSharedMemoryBusWriter writer("", 4096);
+		SMCPSharedMemoryBusReader reader(writer.getFileDescriptor(), true);
+		CHECK(SMCPSharedMemoryBus::getRecordLength(104) == 128);
+		publishSequenced(writer, 104);
+		CHECK(reader.next(message, record) && record.sequence == 0 && reader.isValid());
+
+		//the message stays valid until the writer reserves the bytes it occupies
+		for (int i = 0; i < 31; i++) {
+			publishSequenced(writer, 104);
+		}
+		CHECK(reader.isValid() && message.getAttributeID() == 0);
+		CHECK(reader.getNPendingBytes() == 31 * 128);
+		publishSequenced(writer, 104);
+		CHECK(!reader.isValid());
+
+		//a reader lapped by the writer recovers to the oldest intact record and counts the gap as lost
+		for (int i = 0; i < 67; i++) {
+			publishSequenced(writer, 104);
+		}
+		CHECK(writer.getNPublished() == 100);
+		CHECK(reader.getNPendingBytes() == 0);
+		const uint8_t* segment = mapSharedMemoryBus(writer);
+		CHECK(segment != NULL);
+		if (segment != NULL) {
+			const SMCPSharedMemoryBusHeader* header = (const SMCPSharedMemoryBusHeader*) segment;
+			CHECK(header->tailPosition.load() == (100 - 32) * 128);
+			munmap((void*) segment, SMCPSharedMemoryBus::getHeaderLength() + 4096);
+		}
+		CHECK(reader.next(message, record));
+		CHECK(record.sequence == 100 - 32 && message.getAttributeID() == 100 - 32);
+		CHECK(reader.getNOverruns() == 1 && reader.getNLost() == 100 - 32 - 1);
+		uint64_t nRead = 1;
+		bool contiguous = true;
+		while (reader.next(message, record)) {
+			contiguous = contiguous && record.sequence == 100 - 32 + nRead && reader.isValid();
+			nRead++;
+		}
+		CHECK(contiguous && nRead == 32);
+		CHECK(reader.getNReceived() + reader.getNLost() == writer.getNPublished());
+		CHECK(reader.getNOverruns() == 1 && reader.getNInvalid() == 0);
+	}
+}
+#endif
+
+/* ---------------- SMCPTelemetrySnapshotFile ---------------- */
+
+/** Returns the slot key of a pair as stored in a snapshot file. */
+static uint32_t toSnapshotKey(uint8_t lowerFOID, uint16_t attributeID) {
+	return 0x01000000 | ((uint32_t) lowerFOID << 16) | attributeID;
+}
+
+/** Returns the home slot of a pair; a copy of the hash of SMCPTelemetrySnapshotFile. */
+static size_t getSnapshotHomeSlot(uint32_t key, size_t nSlots) {
+	key ^= key >> 15;
+	key *= 0x2c1b3c6dU;
+	key ^= key >> 12;
+	return key & (nSlots - 1);
+}
+
+/** Makes the sequence number of the slot of a key odd, as left by a crash during an update. */
+static bool tearSnapshotSlot(const std::string& path, uint32_t key) {
+	int fd = open(path.c_str(), O_RDWR);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0) {
+		return false;
+	}
+	void* p = mmap(NULL, (size_t) status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) {
+		return false;
+	}
+	uint8_t* mapping = (uint8_t*) p;
+	uint64_t nSlots, slotLength;
+	memcpy(&nSlots, mapping + 16, sizeof(nSlots));
+	memcpy(&slotLength, mapping + 32, sizeof(slotLength));
+	bool found = false;
+	for (size_t i = 0; i < nSlots; i++) {
+		uint8_t* slot = mapping + SMCPTelemetrySnapshotFile::HeaderLength + i * slotLength;
+		uint32_t slotKey;
+		memcpy(&slotKey, slot, sizeof(slotKey));
+		if (slotKey == key) {
+			slot[4] |= 1;
+			found = true;
+		}
+	}
+	munmap(p, (size_t) status.st_size);
+	return found;
+}
+
+/** Returns true if every entry of a snapshot is in a table with the same receive time and value bytes. */
+static bool containsAll(const SMCPCurrentValueTable& table, const SMCPCurrentValueTable::Snapshot& snapshot) {
+	for (size_t i = 0; i < snapshot.size(); i++) {
+		const SMCPCurrentValueTable::Snapshot::Entry& entry = snapshot.entries[i];
+		SMCPCurrentValueTable::Value value;
+		if (!table.read(entry.lowerFOID, entry.attributeID, value) || value.receiveTime != entry.receiveTime
+				|| value.bytes.size() != entry.storedLength
+				|| memcmp(&value.bytes[0], snapshot.getValueAsPointer(i), entry.storedLength) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void testSnapshotFile() {
+	char pathTemplate[] = "/tmp/test_smcp_snapshot_XXXXXX";
+	int fd = mkstemp(pathTemplate);
+	CHECK(fd >= 0);
+	if (fd < 0) {
+		return;
+	}
+	close(fd);
+	std::string path = pathTemplate;
+
+	//values survive closing and reopening
+	SMCPCurrentValueTable expected(64, 16);
+	{
+		SMCPTelemetrySnapshotFile file(path, 64, 16);
+		CHECK(!file.wasRestored());
+		bool stored = true;
+		for (int i = 0; i < 200; i++) {
+			std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry,
+					(uint8_t) (i % 2), (uint16_t) (i % 25), 1 + i % 20);
+			SMCPTelemetryMessageView message(&bytes[0], bytes.size());
+			expected.update(message.getLowerFOID(), message.getAttributeID(), message.getAttributeValuesAsPointer(),
+					message.getAttributeValuesLength(), 1000 + i);
+			stored = file.update(message, 1000 + i) && stored;
+		}
+		CHECK(stored);
+		std::vector<uint8_t> notification = createRandomTelemetryBytes(SMCPTelemetryTypeID::NotificationTelemetry,
+				0x01, 0x0001, 4);
+		CHECK(!file.update(SMCPTelemetryMessageView(&notification[0], notification.size()), 0));
+		CHECK(file.size() == expected.size() && file.getGeneration() == 200);
+	}
+	{
+		SMCPTelemetrySnapshotFile file(path, 64, 16);
+		CHECK(file.wasRestored() && file.wasCleanlyClosed() && file.getNDiscarded() == 0);
+		CHECK(file.size() == expected.size() && file.getGeneration() == 200);
+		SMCPCurrentValueTable loaded(64, 16);
+		CHECK(file.loadInto(loaded) == expected.size());
+		SMCPCurrentValueTable::Snapshot snapshot;
+		expected.snapshot(snapshot);
+		CHECK(loaded.size() == snapshot.size() && containsAll(loaded, snapshot));
+	}
+
+	//a file of another geometry is reinitialized
+	{
+		SMCPTelemetrySnapshotFile file(path, 64, 8);
+		CHECK(!file.wasRestored() && file.size() == 0 && file.getGeneration() == 0);
+		SMCPCurrentValueTable loaded;
+		CHECK(file.loadInto(loaded) == 0);
+	}
+
+	//a slot left odd is discarded, and its key still leads probes to the following slot
+	const size_t nSlots = 8;
+	uint16_t first = 0, second = 0;
+	for (uint16_t id = 1; second == 0; id++) {
+		for (uint16_t other = 1; other < id; other++) {
+			if (getSnapshotHomeSlot(toSnapshotKey(0x01, other), nSlots)
+					== getSnapshotHomeSlot(toSnapshotKey(0x01, id), nSlots)) {
+				first = other;
+				second = id;
+				break;
+			}
+		}
+	}
+	uint8_t value[4] = { 1, 2, 3, 4 };
+	{
+		SMCPTelemetrySnapshotFile file(path, 4, 8);
+		CHECK(!file.wasRestored());
+		file.update(0x01, first, value, 4, 100);
+		file.update(0x01, second, value + 1, 3, 200);
+		CHECK(file.size() == 2);
+	}
+	CHECK(tearSnapshotSlot(path, toSnapshotKey(0x01, first)));
+	{
+		SMCPTelemetrySnapshotFile file(path, 4, 8);
+		CHECK(file.wasRestored() && file.getNDiscarded() == 1 && file.size() == 2);
+		SMCPCurrentValueTable loaded;
+		CHECK(file.loadInto(loaded) == 1);
+		SMCPCurrentValueTable::Value loadedValue;
+		CHECK(!loaded.read(0x01, first, loadedValue));
+		CHECK(loaded.read(0x01, second, loadedValue));
+		CHECK(loadedValue.receiveTime == 200 && loadedValue.length == 3 && loadedValue.bytes[0] == 2);
+		//both pairs are found in their slots again rather than inserted a second time
+		file.update(0x01, second, value, 2, 300);
+		file.update(0x01, first, value, 1, 400);
+		CHECK(file.size() == 2);
+
+		//the file holds at most capacity pairs
+		file.update(0x02, 0x0001, value, 4, 500);
+		file.update(0x02, 0x0002, value, 4, 600);
+		CHECK(file.size() == 4);
+		CHECK_THROWS(file.update(0x02, 0x0003, value, 4, 700));
+		file.update(0x02, 0x0001, value, 2, 800);
+		CHECK(file.size() == 4);
+	}
+	unlink(path.c_str());
+}
+
+/* ---------------- SMCPSpacePacketEncoder / SMCPSpacePacketView ---------------- */
+
+static void testSpacePacket() {
+	SMCPSpacePacketEncoder encoder;
+	uint8_t buffer[256];
+
+	//telemetry: Packet Type 0, Sequence Flags 11b, Packet Data Length = message length - 1
+	std::vector<uint8_t> telemetryBytes = createTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 10);
+	SMCPTelemetryMessage telemetry;
+	telemetry.interpretAsTelemetryMessage(telemetryBytes);
+	CHECK(encoder.encode(telemetry, 0x123, buffer, sizeof(buffer)) == 6 + 15);
+	const uint8_t expectedTelemetryHeader[6] = { 0x01, 0x23, 0xC0, 0x00, 0x00, 0x0E };
+	CHECK(memcmp(buffer, expectedTelemetryHeader, 6) == 0);
+	uint8_t serialized[64];
+	telemetry.getAsByteArray(serialized, sizeof(serialized));
+	CHECK(memcmp(buffer + 6, serialized, 15) == 0);
+
+	//telecommand with the largest APID
+	std::vector<uint8_t> commandBytes = createCommandBytes(SMCPCommandTypeID::ActionCommand, 4);
+	SMCPCommandMessage command;
+	command.interpretAsCommandMessage(commandBytes);
+	CHECK(encoder.encode(command, 0x7FF, buffer, sizeof(buffer)) == 6 + 6);
+	const uint8_t expectedCommandHeader[6] = { 0x17, 0xFF, 0xC0, 0x00, 0x00, 0x05 };
+	CHECK(memcmp(buffer, expectedCommandHeader, 6) == 0);
+
+	//the 14-bit sequence count is kept per APID and wraps to 0
+	CHECK(encoder.getSequenceCount(0x123) == 1 && encoder.getSequenceCount(0x7FF) == 1);
+	encoder.setSequenceCount(0x123, 0x3FFF);
+	encoder.encode(telemetry, 0x123, buffer, sizeof(buffer));
+	CHECK(buffer[2] == 0xFF && buffer[3] == 0xFF);
+	encoder.encode(telemetry, 0x123, buffer, sizeof(buffer));
+	CHECK(buffer[2] == 0xC0 && buffer[3] == 0x00);
+	CHECK(encoder.getSequenceCount(0x123) == 1 && encoder.getSequenceCount(0x7FF) == 1);
+
+	CHECK_THROWS(encoder.encode(telemetry, 2048, buffer, sizeof(buffer)));
+	CHECK_THROWS(encoder.encode(telemetry, 0x123, buffer, 6 + 14));
+
+	//the view decodes the fields written by the encoder
+	encoder.setSequenceCount(0x456, 0x1234);
+	encoder.writePrimaryHeader(buffer, sizeof(buffer), 0x456, SMCPSpacePacketType::Telemetry, telemetryBytes.size());
+	memcpy(buffer + 6, &telemetryBytes[0], telemetryBytes.size());
+	size_t length = 6 + telemetryBytes.size();
+	SMCPSpacePacketView packet;
+	CHECK(packet.tryInterpretAsSpacePacket(buffer, length + 3) && packet.getLength() == length);
+	CHECK(packet.getPacketType() == SMCPSpacePacketType::Telemetry && !packet.getSecondaryHeaderFlag());
+	CHECK(packet.getAPID() == 0x456 && packet.getSequenceFlags() == 3 && packet.getSequenceCount() == 0x1234);
+	CHECK(packet.getPacketDataLength() == 15);
+	SMCPTelemetryMessageView telemetryView;
+	CHECK(packet.tryGetTelemetryMessage(telemetryView) && telemetryView.getLength() == 15);
+	CHECK(!packet.tryInterpretAsSpacePacket(buffer, length - 1) && !packet.isValid());
+
+	//only Packet Version Number 000b is accepted
+	uint8_t versionOne[256];
+	memcpy(versionOne, buffer, length);
+	versionOne[0] |= 0x20;
+	CHECK(!packet.tryInterpretAsSpacePacket(versionOne, length) && !packet.isValid());
+	CHECK_THROWS(packet.interpretAsSpacePacket(versionOne, length));
+
+	//a Secondary Header precedes the SMCP message
+	const uint8_t secondaryHeader[4] = { 0xAA, 0xBB, 0xCC, 0xDD };
+	encoder.writePrimaryHeader(buffer, sizeof(buffer), 0x010, SMCPSpacePacketType::Telemetry,
+			sizeof(secondaryHeader) + telemetryBytes.size());
+	memcpy(buffer + 6, secondaryHeader, sizeof(secondaryHeader));
+	memcpy(buffer + 6 + sizeof(secondaryHeader), &telemetryBytes[0], telemetryBytes.size());
+	CHECK(packet.tryInterpretAsSpacePacket(buffer, sizeof(buffer)) && packet.getPacketDataLength() == 4 + 15);
+	CHECK(!packet.tryGetTelemetryMessage(telemetryView));
+	CHECK(packet.tryGetTelemetryMessage(telemetryView, sizeof(secondaryHeader)));
+	CHECK(telemetryView.getAsPointer() == buffer + 6 + 4 && telemetryView.getLength() == 15);
+	CHECK(!packet.tryGetTelemetryMessage(telemetryView, 4 + 15 + 1));
+}
+
+/* ---------------- SMCPCommandTemplate ---------------- */
+
+/** Returns wire bytes of an Action Command built field by field. */
+static std::vector<uint8_t> serializeActionCommand(uint8_t lowerFOID, uint16_t operationID,
+		std::vector<uint8_t> parameters) {
+	SMCPActionCommandMessage command;
+	command.getMessageHeader()->setLowerFOID(lowerFOID);
+	command.getMessageData()->setOperationID(operationID);
+	command.getMessageData()->setParameters(parameters);
+	std::vector<uint8_t> bytes(command.getLength());
+	command.getAsByteArray(&bytes[0], bytes.size());
+	return bytes;
+}
+
+/** Returns wire bytes of a Memory Load Command built field by field. */
+static std::vector<uint8_t> serializeMemoryLoadCommand(uint8_t lowerFOID, uint32_t startAddress,
+		std::vector<uint8_t> loadData) {
+	SMCPMemoryLoadCommandMessage command;
+	command.getMessageHeader()->setLowerFOID(lowerFOID);
+	uint8_t address[4] = { (uint8_t) (startAddress >> 24), (uint8_t) (startAddress >> 16),
+			(uint8_t) (startAddress >> 8), (uint8_t) startAddress };
+	command.getMessageData()->setStartAddress(address);
+	command.getMessageData()->setLoadData(loadData);
+	std::vector<uint8_t> bytes(command.getLength());
+	command.getAsByteArray(&bytes[0], bytes.size());
+	return bytes;
+}
+
+static void testCommandTemplate() {
+	uint8_t buffer[256];
+
+	//Action Command: a big-endian and a little-endian parameter slot
+	std::vector<uint8_t> actionBytes = serializeActionCommand(0x21, 0x0102, std::vector<uint8_t>(8, 0xEE));
+	SMCPCommandTemplate action(&actionBytes[0], actionBytes.size());
+	CHECK(action.addParameterSlot("angle", 0, 2) == 0);
+	CHECK(action.addParameterSlot("counter", 2, 4, false) == 1);
+	CHECK(action.getSlotIndex("counter") == 1 && action.getSlot(1).offset == 2 + 2 + 2);
+	const uint64_t values[] = { 900, 0x01020304 };
+	CHECK(action.stamp(buffer, sizeof(buffer), values) == actionBytes.size());
+	const uint8_t parameters[] = { 0x03, 0x84, 0x04, 0x03, 0x02, 0x01, 0xEE, 0xEE };
+	std::vector<uint8_t> expected = serializeActionCommand(0x21, 0x0102,
+			std::vector<uint8_t>(parameters, parameters + 8));
+	CHECK(memcmp(buffer, &expected[0], expected.size()) == 0);
+	//the template keeps its own bytes
+	CHECK(action.getAsByteVector() == actionBytes);
+
+	//Memory Load Command in a batch: the start address per command, a NULL column for the load data
+	std::vector<uint8_t> loadData = { 0x10, 0x20, 0x30, 0x40 };
+	std::vector<uint8_t> loadBytes = serializeMemoryLoadCommand(0x33, 0, loadData);
+	SMCPCommandTemplate load(&loadBytes[0], loadBytes.size());
+	CHECK(load.getLength() == 2 + 4 + 4);
+	size_t address = load.addStartAddressSlot();
+	size_t word = load.addLoadDataSlot("word", 0, 4, false);
+	const uint64_t addresses[] = { 0x12345678, 0x9ABCDEF0, 0x00000004 };
+	const uint64_t words[] = { 0xA1A2A3A4, 0xB1B2B3B4, 0xC1C2C3C4 };
+	const uint64_t* columns[2];
+	columns[address] = addresses;
+	columns[word] = NULL;
+	CHECK(load.stampBatch(buffer, sizeof(buffer), columns, 3) == 3 * load.getLength());
+	bool matched = true;
+	for (size_t i = 0; i < 3; i++) {
+		expected = serializeMemoryLoadCommand(0x33, (uint32_t) addresses[i], loadData);
+		matched = matched && memcmp(buffer + i * load.getLength(), &expected[0], expected.size()) == 0;
+	}
+	CHECK(matched);
+	columns[word] = words;
+	load.stampBatch(buffer, sizeof(buffer), columns, 3);
+	matched = true;
+	for (size_t i = 0; i < 3; i++) {
+		uint8_t littleEndian[4];
+		for (size_t j = 0; j < 4; j++) {
+			littleEndian[j] = (uint8_t) (words[i] >> (8 * j));
+		}
+		expected = serializeMemoryLoadCommand(0x33, (uint32_t) addresses[i],
+				std::vector<uint8_t>(littleEndian, littleEndian + 4));
+		matched = matched && memcmp(buffer + i * load.getLength(), &expected[0], expected.size()) == 0;
+	}
+	CHECK(matched);
+	CHECK(buffer[2 + 4] == 0xA4 && buffer[2 + 4 + 3] == 0xA1);
+
+	//slot errors
+	CHECK_THROWS(action.addParameterSlot("angle", 4, 2));
+	CHECK_THROWS(action.addParameterSlot("outside", 7, 2));
+	CHECK_THROWS(action.addSlot("wide", 0, 9));
+	CHECK_THROWS(action.addLoadDataSlot("data", 0, 1));
+	CHECK_THROWS(action.getSlotIndex("undefined"));
+	CHECK_THROWS(load.stampBatch(buffer, 2 * load.getLength(), columns, 3));
+	CHECK(action.getNSlots() == 2 && load.getNSlots() == 2);
+}
+
+/* ---------------- SMCPCommandBuilder ---------------- */
+
+static constexpr std::array<uint8_t, 3> builtParameters = { 0xA0, 0xB0, 0xC0 };
+static constexpr std::array<uint8_t, 2> builtLoadData = { 0xDE, 0xAD };
+static constexpr auto builtAction = SMCPCommandBuilder::action(0x12, 0x0102, builtParameters,
+		SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry);
+static constexpr auto builtGet = SMCPCommandBuilder::get(0x34, 0xBEEF);
+static constexpr auto builtMemoryLoad = SMCPCommandBuilder::memoryLoad(0x56, 0x12345678, builtLoadData);
+static constexpr auto builtMemoryDump = SMCPCommandBuilder::memoryDump(0x78, 0x9ABCDEF0, 0x123456, 0x03);
+
+static_assert(builtAction.size() == 7, "Action Command length");
+static_assert(builtAction[0] == 0x50 && builtAction[1] == 0x12, "Action Command header");
+static_assert(builtAction[2] == 0x01 && builtAction[3] == 0x02 && builtAction[6] == 0xC0, "Action Command data");
+static_assert(builtGet.size() == 4 && builtGet[0] == 0x11 && builtGet[2] == 0xBE && builtGet[3] == 0xEF,
+		"Get Command");
+static_assert(builtMemoryLoad.size() == 8 && builtMemoryLoad[0] == 0x14 && builtMemoryLoad[2] == 0x12
+		&& builtMemoryLoad[5] == 0x78 && builtMemoryLoad[7] == 0xAD, "Memory Load Command");
+static_assert(builtMemoryDump.size() == 10 && builtMemoryDump[0] == 0x15 && builtMemoryDump[2] == 0x03
+		&& builtMemoryDump[3] == 0x9A && builtMemoryDump[6] == 0xF0 && builtMemoryDump[7] == 0x12
+		&& builtMemoryDump[9] == 0x56, "Memory Dump Command");
+
+/** Returns true if bytes interpreted as SMCPCommandMessage serialize back to the same bytes. */
+template<size_t N>
+static bool isRoundTripped(const std::array<uint8_t, N>& built) {
+	std::vector<uint8_t> bytes(built.begin(), built.end());
+	SMCPCommandMessage command;
+	command.interpretAsCommandMessage(bytes);
+	return command.getAsByteVector() == bytes;
+}
+
+static void testCommandBuilder() {
+	CHECK(isRoundTripped(builtAction));
+	CHECK(isRoundTripped(builtGet));
+	CHECK(isRoundTripped(builtMemoryLoad));
+	CHECK(isRoundTripped(builtMemoryDump));
+	CHECK(isRoundTripped(SMCPCommandBuilder::action(0xFF, 0xFFFF)));
+
+	//the fields read back by the message classes
+	std::vector<uint8_t> bytes(builtAction.begin(), builtAction.end());
+	SMCPCommandMessage command;
+	command.interpretAsCommandMessage(bytes);
+	SMCPCommandMessageHeader* header = command.getMessageHeader();
+	CHECK(header->getAcknowledgeRequest().to_ulong() == SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry);
+	CHECK(header->getLowerFOID() == 0x12);
+	CHECK(header->getCommandTypeID().to_ulong() == SMCPCommandTypeID::ActionCommand);
+	SMCPCommandMessageView view(builtMemoryDump.data(), builtMemoryDump.size());
+	CHECK(view.getStartAddress() == 0x9ABCDEF0 && view.getDumpLength() == 0x123456 && view.getNOfDumps() == 3);
+}
+
+/* ---------------- SMCPTelemetryDispatcher ---------------- */
+
+static void testTelemetryVariant() {
+	//decode() picks the alternative of the Telemetry Type ID
+	const uint8_t typeIDs[] = { SMCPTelemetryTypeID::ValueTelemetry, SMCPTelemetryTypeID::NotificationTelemetry,
+			SMCPTelemetryTypeID::AcknowledgeTelemetry, SMCPTelemetryTypeID::MemoryDumpTelemetry, 0x0A };
+	for (size_t i = 0; i < sizeof(typeIDs); i++) {
+		std::vector<uint8_t> bytes = createRandomTelemetryBytes(typeIDs[i], 0x12, (uint16_t) (0x0100 + i), 4);
+		SMCPTelemetryVariant message = SMCPTelemetryDispatcher::decode(&bytes[0], bytes.size());
+		CHECK(message.index() == i);
+		auto toBase = [](const auto& typedView) -> const SMCPTelemetryMessageView& {
+			return typedView;
+		};
+		const SMCPTelemetryMessageView& view = std::visit(toBase, message);
+		CHECK(view.getAsPointer() == &bytes[0] && view.getAttributeID() == 0x0100 + i);
+		CHECK(view.getTelemetryTypeID() == typeIDs[i]);
+	}
+	std::vector<uint8_t> value = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0200, 4);
+	SMCPTelemetryVariant message = SMCPTelemetryDispatcher::decode(&value[0], value.size());
+	CHECK(std::get_if<SMCPValueTelemetryView>(&message) != NULL);
+	CHECK(SMCPValueTelemetryView::TelemetryTypeID == SMCPTelemetryTypeID::ValueTelemetry);
+
+	//tryDecode() leaves the result unchanged when the buffer is short
+	std::vector<uint8_t> dump = createRandomTelemetryBytes(SMCPTelemetryTypeID::MemoryDumpTelemetry, 0x12, 0x0300, 8);
+	CHECK(!SMCPTelemetryDispatcher::tryDecode(&dump[0], dump.size() - 1, message));
+	CHECK(!SMCPTelemetryDispatcher::tryDecode(&dump[0], 3, message));
+	CHECK(message.index() == 0 && std::get<SMCPValueTelemetryView>(message).getAsPointer() == &value[0]);
+	CHECK_THROWS(SMCPTelemetryDispatcher::decode(&dump[0], dump.size() - 1));
+	CHECK(SMCPTelemetryDispatcher::tryDecode(&dump[0], dump.size(), message) && message.index() == 3);
+
+	//visit() returns the value of the handler chosen for the type
+	auto visitor = SMCPOverloaded { [](const SMCPValueTelemetryView& view) {
+		return 1000 + (int) view.getAttributeValuesLength();
+	}, [](const SMCPMemoryDumpTelemetryView& view) {
+		return 2000 + (int) view.getAttributeValuesLength();
+	}, [](const SMCPTelemetryMessageView& view) {
+		return 3000 + (int) view.getTelemetryTypeID();
+	} };
+	CHECK(SMCPTelemetryDispatcher::visit(&value[0], value.size(), visitor) == 1004);
+	CHECK(SMCPTelemetryDispatcher::visit(&dump[0], dump.size(), visitor) == 2008);
+	std::vector<uint8_t> undefined = createRandomTelemetryBytes(0x0A, 0x12, 0x0400, 1);
+	CHECK(SMCPTelemetryDispatcher::visit(&undefined[0], undefined.size(), visitor) == 3000 + 0x0A);
+	CHECK_THROWS(SMCPTelemetryDispatcher::visit(&value[0], 4, visitor));
+}
+
+/* ---------------- SMCPCommandValidator ---------------- */
+
+static void testCommandValidator() {
+	SMCPCommandValidationRules rules;
+	rules.allowCommandType(SMCPCommandTypeID::ActionCommand, SMCPAcknowledgePolicy::Required);
+	rules.allowOperation(0x0010, 4);
+	rules.allowOperations(0x0020, 0x002F);
+	rules.allowCommandType(SMCPCommandTypeID::GetCommand);
+	rules.allowAttribute(0x0100);
+	rules.allowCommandType(SMCPCommandTypeID::MemoryLoadCommand);
+	rules.allowMemoryRange(SMCPCommandTypeID::MemoryLoadCommand, 0x1000, 0x100);
+	rules.allowCommandType(SMCPCommandTypeID::MemoryDumpCommand, SMCPAcknowledgePolicy::Forbidden);
+	rules.allowMemoryRange(SMCPCommandTypeID::MemoryDumpCommand, 0x2000, 0x800);
+	rules.allowMemoryRange(SMCPCommandTypeID::MemoryDumpCommand, 0x2800, 0x800);
+	SMCPCommandValidator validator(rules);
+
+	const uint8_t request = SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry;
+	const std::array<uint8_t, 4> four = { 1, 2, 3, 4 };
+	const std::array<uint8_t, 5> five = { 1, 2, 3, 4, 5 };
+	std::vector<std::vector<uint8_t> > commands;
+	std::vector<uint32_t> expected;
+	auto add = [&](const auto& bytes, uint32_t verdict) {
+		commands.push_back(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+		expected.push_back(verdict);
+	};
+	add(SMCPCommandBuilder::action(0x01, 0x0010, four, request), SMCPCommandVerdict::Valid);
+	add(SMCPCommandBuilder::action(0x01, 0x0011, four, request), SMCPCommandVerdict::IDNotAllowed);
+	add(SMCPCommandBuilder::action(0x01, 0x0010, five, request), SMCPCommandVerdict::ParameterTooLong);
+	add(SMCPCommandBuilder::action(0x01, 0x0025, five, request), SMCPCommandVerdict::Valid);
+	add(SMCPCommandBuilder::action(0x01, 0x0010, four), SMCPCommandVerdict::AcknowledgeRequestViolation);
+	add(SMCPCommandBuilder::action(0x01, 0x0011, five),
+			SMCPCommandVerdict::IDNotAllowed | SMCPCommandVerdict::AcknowledgeRequestViolation);
+	add(SMCPCommandBuilder::get(0x01, 0x0100), SMCPCommandVerdict::Valid);
+	add(SMCPCommandBuilder::get(0x01, 0x0101), SMCPCommandVerdict::IDNotAllowed);
+	add(SMCPCommandBuilder::memoryLoad(0x01, 0x10FC, four), SMCPCommandVerdict::Valid);
+	add(SMCPCommandBuilder::memoryLoad(0x01, 0x10FD, four), SMCPCommandVerdict::AddressOutOfRange);
+	add(SMCPCommandBuilder::memoryLoad(0x01, 0x0FFF, four), SMCPCommandVerdict::AddressOutOfRange);
+	//the two dump ranges are adjacent and merged into one
+	add(SMCPCommandBuilder::memoryDump(0x01, 0x27F0, 0x20), SMCPCommandVerdict::Valid);
+	add(SMCPCommandBuilder::memoryDump(0x01, 0x2FF0, 0x20), SMCPCommandVerdict::AddressOutOfRange);
+	add(SMCPCommandBuilder::memoryDump(0x01, 0x4000, 0x10), SMCPCommandVerdict::AddressOutOfRange);
+	add(SMCPCommandBuilder::memoryDump(0x01, 0x2000, 0x10, 0x00, request),
+			SMCPCommandVerdict::AcknowledgeRequestViolation);
+	const std::array<uint8_t, 3> undefined = { 0x13, 0x01, 0x00 };
+	add(undefined, SMCPCommandVerdict::CommandTypeNotAllowed);
+	size_t nInvalidExpected = 0;
+	for (size_t i = 0; i < expected.size(); i++) {
+		nInvalidExpected += (expected[i] != SMCPCommandVerdict::Valid);
+	}
+
+	//batch of byte arrays, with a malformed message appended
+	const std::array<uint8_t, 3> truncated = { 0x00, 0x01, 0x00 };
+	add(truncated, SMCPCommandVerdict::MalformedMessage);
+	std::vector<const uint8_t*> pointers;
+	std::vector<size_t> lengths;
+	for (size_t i = 0; i < commands.size(); i++) {
+		pointers.push_back(&commands[i][0]);
+		lengths.push_back(commands[i].size());
+	}
+	std::vector<uint32_t> verdicts(commands.size());
+	CHECK(validator.validate(&pointers[0], &lengths[0], commands.size(), &verdicts[0]) == nInvalidExpected + 1);
+	CHECK(std::equal(verdicts.begin(), verdicts.end(), expected.begin()));
+
+	//the same commands as SMCPCommandMessage instances give the same verdicts
+	commands.pop_back();
+	expected.pop_back();
+	std::vector<SMCPCommandMessage> messages(commands.size());
+	std::vector<SMCPCommandMessage*> messagePointers;
+	for (size_t i = 0; i < commands.size(); i++) {
+		messages[i].interpretAsCommandMessage(commands[i]);
+		messagePointers.push_back(&messages[i]);
+	}
+	CHECK(validator.validate(messagePointers, verdicts) == nInvalidExpected);
+	CHECK(verdicts.size() == expected.size() && std::equal(verdicts.begin(), verdicts.end(), expected.begin()));
+}
+
+/* ---------------- SMCPChangeDetectionFilter ---------------- */
+
+static void testChangeDetectionFilter() {
+	SMCPChangeDetectionFilter filter(1000);
+	std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 4);
+	std::vector<uint8_t> other = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0101, 4);
+
+	//unchanged values are suppressed per attribute
+	CHECK(filter.accept(&bytes[0], bytes.size(), 0));
+	CHECK(filter.accept(&other[0], other.size(), 0));
+	CHECK(!filter.accept(&bytes[0], bytes.size(), 100));
+	CHECK(!filter.accept(&other[0], other.size(), 100));
+	bytes[7]++;
+	CHECK(filter.accept(&bytes[0], bytes.size(), 200));
+	CHECK(!filter.accept(&bytes[0], bytes.size(), 300));
+
+	//an unchanged value is forwarded once the keep-alive interval has passed since the last forwarding
+	CHECK(!filter.accept(&bytes[0], bytes.size(), 1199));
+	CHECK(filter.accept(&bytes[0], bytes.size(), 1200));
+	CHECK(!filter.accept(&bytes[0], bytes.size(), 2199));
+	CHECK(filter.accept(&bytes[0], bytes.size(), 2200));
+	CHECK(filter.accept(&other[0], other.size(), 2200));
+	CHECK(filter.getNKeepAlives() == 3);
+	CHECK(filter.getNReceived() == 11 && filter.getNForwarded() == 6 && filter.getNSuppressed() == 5);
+
+	//other telemetry types pass through without examination
+	std::vector<uint8_t> notification = createRandomTelemetryBytes(SMCPTelemetryTypeID::NotificationTelemetry, 0x12,
+			0x0100, 4);
+	CHECK(filter.accept(&notification[0], notification.size(), 2300));
+	CHECK(filter.accept(&notification[0], notification.size(), 2300));
+	CHECK(filter.getNPassedThrough() == 2 && filter.getNReceived() == 11);
+
+	//values up to 256 bytes are compared byte by byte, longer ones through a fingerprint of the whole value
+	SMCPChangeDetectionFilter longValues;
+	CHECK(SMCPChangeDetectionFilter::DefaultMaximumStoredLength == 256);
+	for (size_t length = 255; length <= 258; length++) {
+		std::vector<uint8_t> value = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x01,
+				(uint16_t) length, length);
+		const size_t positions[] = { 7, 7 + length / 2, value.size() - 1 };
+		CHECK(longValues.accept(&value[0], value.size(), 0));
+		for (size_t i = 0; i < 3; i++) {
+			CHECK(!longValues.accept(&value[0], value.size(), 0));
+			value[positions[i]] ^= 0x01;
+			CHECK(longValues.accept(&value[0], value.size(), 0));
+		}
+	}
+	//a change of length is a change
+	std::vector<uint8_t> shorter = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x02, 0x0001, 256);
+	std::vector<uint8_t> longer = shorter;
+	longer.push_back(0x00);
+	longer[3]++;
+	CHECK(longValues.accept(&shorter[0], shorter.size(), 0));
+	CHECK(longValues.accept(&longer[0], longer.size(), 0));
+	CHECK(!longValues.accept(&longer[0], longer.size(), 0));
+	CHECK(longValues.accept(&shorter[0], shorter.size(), 0));
+	CHECK(longValues.getNKeepAlives() == 0);
+}
+
+/* ---------------- SMCPTelemetryAggregator ---------------- */
+
+class SummaryCollector: public SMCPTelemetrySummaryListener {
+public:
+	std::vector<SMCPTelemetrySummary> summaries;
+
+public:
+	void summaryClosed(const SMCPTelemetrySummary& summary) {
+		summaries.push_back(summary);
+	}
+};
+
+/** Minimum, maximum, sum and last of big-endian 16-bit signed elements, computed one by one. */
+class ReferenceSummary {
+public:
+	uint32_t nSamples;
+	uint64_t nElements;
+	double minimum;
+	double maximum;
+	double sum;
+	double last;
+
+public:
+	ReferenceSummary() :
+			nSamples(0), nElements(0), minimum(0), maximum(0), sum(0), last(0) {
+	}
+
+public:
+	void add(const uint8_t* value, size_t length) {
+		for (size_t i = 0; i + 2 <= length; i += 2) {
+			double x = (int16_t) ((value[i] << 8) | value[i + 1]);
+			if (nElements == 0 || x < minimum) {
+				minimum = x;
+			}
+			if (nElements == 0 || maximum < x) {
+				maximum = x;
+			}
+			sum += x;
+			last = x;
+			nElements++;
+		}
+		nSamples++;
+	}
+
+public:
+	bool matches(const SMCPTelemetrySummary& summary) const {
+		double mean = sum / nElements;
+		return summary.nSamples == nSamples && summary.nElements == nElements && summary.minimum == minimum
+				&& summary.maximum == maximum && summary.last == last
+				&& fabs(summary.mean - mean) <= 1e-9 * (fabs(mean) + 1);
+	}
+};
+
+static void testTelemetryAggregator() {
+	SMCPAttributeSchema schema;
+	schema.add(0x12, 0x0100, SMCPAttributeType::Int16, "scalar");
+	schema.add(0x12, 0x0200, SMCPAttributeType::Int16, "waveform");
+	SummaryCollector collector;
+	SMCPTelemetryAggregator aggregator(schema, 1000, &collector);
+
+	//a scalar over 300 samples, and arrays of 603 elements (two chunks of 256 and 91, which is not a
+	//multiple of the 4 lanes) and of 3 elements (remainder only)
+	ReferenceSummary scalar, waveform;
+	bool aggregated = true;
+	for (uint64_t time = 0; time < 300; time++) {
+		std::vector<uint8_t> bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 2);
+		SMCPTelemetryMessage message;
+		message.interpretAsTelemetryMessage(bytes);
+		aggregated = aggregator.add(message, time) && aggregated;
+		scalar.add(&bytes[7], 2);
+		size_t nElements = (time % 2 == 0) ? 603 : 3;
+		bytes = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0200, nElements * 2);
+		aggregated = aggregator.add(0x12, 0x0200, &bytes[7], nElements * 2, time) && aggregated;
+		waveform.add(&bytes[7], nElements * 2);
+	}
+	CHECK(aggregated);
+	std::vector<uint8_t> unknown = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0300, 2);
+	CHECK(!aggregator.add(0x12, 0x0300, &unknown[7], 2, 300));
+	CHECK(aggregator.getNIgnoredSamples() == 1 && collector.summaries.empty());
+
+	//a sample of the next bucket closes the current one
+	std::vector<uint8_t> next = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 2);
+	CHECK(aggregator.add(0x12, 0x0100, &next[7], 2, 1500));
+	CHECK(collector.summaries.size() == 2);
+	for (size_t i = 0; i < collector.summaries.size(); i++) {
+		const SMCPTelemetrySummary& summary = collector.summaries[i];
+		CHECK(summary.bucketStartTime == 0 && summary.bucketWidth == 1000 && summary.lowerFOID == 0x12);
+		CHECK(summary.attributeID == 0x0100 ? scalar.matches(summary) : waveform.matches(summary));
+	}
+
+	//a late sample is dropped, and does not reach the next summary
+	std::vector<uint8_t> late = createRandomTelemetryBytes(SMCPTelemetryTypeID::ValueTelemetry, 0x12, 0x0100, 2);
+	CHECK(!aggregator.add(0x12, 0x0100, &late[7], 2, 999));
+	CHECK(aggregator.getNLateSamples() == 1 && aggregator.getBucketStartTime() == 1000);
+	aggregator.flush();
+	CHECK(collector.summaries.size() == 3);
+	ReferenceSummary second;
+	second.add(&next[7], 2);
+	CHECK(collector.summaries.back().bucketStartTime == 1000 && second.matches(collector.summaries.back()));
+}
+
+/* ---------------- SMCPUtility ---------------- */
+
+/** Returns the index of the first byte where (a[i] == b[i]) equals equal, computed one byte at a time. */
+static size_t findFirstNaively(const uint8_t* a, const uint8_t* b, size_t length, bool equal) {
+	for (size_t i = 0; i < length; i++) {
+		if ((a[i] == b[i]) == equal) {
+			return i;
+		}
+	}
+	return length;
+}
+
+static void testUtility() {
+	//every position in and around the 32-byte (AVX2) and 16-byte (SSE2) blocks, at each alignment
+	uint8_t a[160], b[160], c[160];
+	for (size_t i = 0; i < sizeof(a); i++) {
+		a[i] = (uint8_t) i;
+		c[i] = (uint8_t) ~i;
+	}
+	int nMismatches = 0;
+	for (size_t offset = 0; offset < 32; offset++) {
+		for (size_t length = 0; offset + length <= 128; length++) {
+			for (size_t position = 0; position <= length; position++) {
+				memcpy(b, a, sizeof(a));
+				if (position < length) {
+					b[offset + position] ^= 0x80;
+				}
+				nMismatches += SMCPUtility::findFirstDifference(a + offset, b + offset, length)
+						!= findFirstNaively(a + offset, b + offset, length, false);
+				uint8_t saved = c[offset + position];
+				c[offset + position] = a[offset + position];
+				nMismatches += SMCPUtility::findFirstEqual(a + offset, c + offset, length)
+						!= findFirstNaively(a + offset, c + offset, length, true);
+				c[offset + position] = saved;
+			}
+		}
+	}
+	CHECK(nMismatches == 0);
+	CHECK(SMCPUtility::findFirstDifference(a, a, 100) == 100 && SMCPUtility::findFirstEqual(a, c, 100) == 100);
+}
+
+/* ---------------- main ---------------- */
+
+int main() {
+	srand(1);
+	testCurrentValueTable();
+	testInstrumentation();
+	testTrafficStatistics();
+	testPredicateFilter();
+	testFormatter();
+	testColumnExporter();
+	testFramePacker();
+	testShardedPipeline();
+	testStreamDecoder();
+	testHeaderBatch();
+	testMemoryImageDiff();
+	testStagePipeline();
+#if defined(__linux__)
+	testSharedMemoryBus();
+#endif
+	testSnapshotFile();
+	testSpacePacket();
+	testCommandTemplate();
+	testCommandBuilder();
+	testTelemetryVariant();
+	testCommandValidator();
+	testChangeDetectionFilter();
+	testTelemetryAggregator();
+	testUtility();
+	printf("%d checks, %d failures\n", nChecks, nFailures);
+	return (nFailures == 0) ? 0 : 1;
+}
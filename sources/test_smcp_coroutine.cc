@@ -0,0 +1,266 @@
+/*
+ * test_smcp_coroutine.cc
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+/* Behavioral tests of SMCPCommandCoroutine.hh, which requires C++20.
+ *
+ * The event loop is driven with explicit times through receive(data, length,
+ * now) and poll(now), so that timeouts and sleeps are deterministic. The
+ * program prints each failed check and exits with a non-zero status if any
+ * check failed.
+ *
+ * Usage:
+ *   make test
+ */
+
+#include "SMCPCommandCoroutine.hh"
+#include "SMCPCommandBuilder.hh"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/* ---------------- check helpers ---------------- */
+
+static int nChecks = 0;
+static int nFailures = 0;
+
+#define CHECK(condition) \
+	do { \
+		nChecks++; \
+		if (!(condition)) { \
+			nFailures++; \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+/* ---------------- helpers ---------------- */
+
+/** A transport which records the sent commands and can acknowledge them from send(). */
+class RecordingTransport: public SMCPCommandTransport {
+public:
+	std::vector<std::vector<uint8_t> > sent;
+	SMCPCommandEventLoop* synchronousLoop;
+	uint64_t now;
+
+public:
+	RecordingTransport() :
+			synchronousLoop(NULL), now(0) {
+	}
+
+public:
+	void send(const uint8_t* data, size_t length);
+};
+
+/** Returns an Acknowledge Telemetry message whose Attribute Value is one byte. */
+static std::vector<uint8_t> createAcknowledgeBytes(uint8_t lowerFOID, uint8_t value) {
+	std::vector<uint8_t> bytes = { (uint8_t) (0x10 | SMCPTelemetryTypeID::AcknowledgeTelemetry), 0x00, 0x00, 0x08,
+			lowerFOID, 0x00, 0x01, value };
+	return bytes;
+}
+
+void RecordingTransport::send(const uint8_t* data, size_t length) {
+	sent.push_back(std::vector<uint8_t>(data, data + length));
+	if (synchronousLoop != NULL) {
+		std::vector<uint8_t> acknowledge = createAcknowledgeBytes(data[1], (uint8_t) sent.size());
+		synchronousLoop->receive(&acknowledge[0], acknowledge.size(), now);
+	}
+}
+
+static const auto acknowledgedAction = SMCPCommandBuilder::action(0x05, 0x0001,
+		SMCPAcknowledgeRequest::RequestAcknowledgeTelemetry);
+static const auto unacknowledgedAction = SMCPCommandBuilder::action(0x05, 0x0002);
+
+/** Counts the destruction of coroutine frames which hold an instance. */
+class FrameGuard {
+public:
+	int* nDestroyed;
+
+public:
+	FrameGuard(int* nDestroyed) :
+			nDestroyed(nDestroyed) {
+	}
+
+public:
+	~FrameGuard() {
+		(*nDestroyed)++;
+	}
+};
+
+/* ---------------- procedures ---------------- */
+
+static SMCPProcedure sendAndRecord(SMCPCommandEventLoop& loop, const uint8_t* command, size_t length,
+		uint64_t timeout, std::vector<SMCPAcknowledgeResult>* results) {
+	SMCPAcknowledgeResult result = co_await loop.sendCommand(command, length, timeout);
+	results->push_back(result);
+}
+
+static SMCPProcedure sleepAndSet(SMCPCommandEventLoop& loop, uint64_t duration, bool* done) {
+	co_await loop.sleep(duration);
+	*done = true;
+}
+
+static SMCPProcedure throwAfterSleep(SMCPCommandEventLoop& loop) {
+	co_await loop.sleep(10);
+	throw SMCPException("sub-procedure failed");
+}
+
+static SMCPProcedure catchSubProcedure(SMCPCommandEventLoop& loop, std::string* caught) {
+	try {
+		co_await throwAfterSleep(loop);
+	} catch (SMCPException& e) {
+		*caught = e.what();
+	}
+}
+
+static SMCPProcedure propagateSubProcedure(SMCPCommandEventLoop& loop) {
+	co_await throwAfterSleep(loop);
+}
+
+static SMCPProcedure sendTwice(SMCPCommandEventLoop& loop, std::vector<SMCPAcknowledgeResult>* results) {
+	for (int i = 0; i < 2; i++) {
+		SMCPAcknowledgeResult result = co_await loop.sendCommand(acknowledgedAction.data(), acknowledgedAction.size(),
+				1000);
+		results->push_back(result);
+	}
+}
+
+static SMCPProcedure waitInSubProcedure(SMCPCommandEventLoop& loop, int* nDestroyed) {
+	FrameGuard guard(nDestroyed);
+	bool done = false;
+	co_await sleepAndSet(loop, 1000, &done);
+}
+
+static SMCPProcedure waitForAcknowledge(SMCPCommandEventLoop& loop, int* nDestroyed) {
+	FrameGuard guard(nDestroyed);
+	co_await loop.sendCommand(acknowledgedAction.data(), acknowledgedAction.size(), 1000);
+}
+
+static SMCPProcedure waitForSleep(SMCPCommandEventLoop& loop, int* nDestroyed) {
+	FrameGuard guard(nDestroyed);
+	co_await loop.sleep(1000);
+}
+
+/* ---------------- tests ---------------- */
+
+static void testAcknowledgeMatching() {
+	RecordingTransport transport;
+	SMCPCommandEventLoop loop(&transport);
+	loop.poll(1000);
+	std::vector<SMCPAcknowledgeResult> results;
+	for (int i = 0; i < 3; i++) {
+		loop.spawn(sendAndRecord(loop, acknowledgedAction.data(), acknowledgedAction.size(), 500, &results));
+	}
+	CHECK(transport.sent.size() == 3 && loop.getNPendingCommands() == 3 && loop.getNProcedures() == 3);
+
+	//an acknowledge of another Lower FOID matches nothing
+	std::vector<uint8_t> other = createAcknowledgeBytes(0x06, 0xFF);
+	CHECK(!loop.receive(&other[0], other.size(), 1010));
+	CHECK(loop.getNUnmatchedAcknowledges() == 1);
+
+	//acknowledges of one Lower FOID are matched in the order the commands were sent
+	for (uint8_t i = 1; i <= 3; i++) {
+		std::vector<uint8_t> acknowledge = createAcknowledgeBytes(0x05, i);
+		CHECK(loop.receive(&acknowledge[0], acknowledge.size(), 1000 + i * 100));
+	}
+	CHECK(results.size() == 3 && loop.getNProcedures() == 0 && loop.getNPendingCommands() == 0);
+	for (size_t i = 0; i < results.size(); i++) {
+		CHECK(results[i].acknowledgeRequested && results[i].acknowledged && !results[i].isTimedOut());
+		CHECK(results[i].acknowledgeTelemetry.size() == 8 && results[i].acknowledgeTelemetry[7] == i + 1);
+		CHECK(results[i].roundTripTime == (i + 1) * 100);
+	}
+	CHECK(loop.getNAcknowledged() == 3 && loop.getNCommands() == 3);
+
+	//a command without acknowledge request completes on sending
+	loop.spawn(sendAndRecord(loop, unacknowledgedAction.data(), unacknowledgedAction.size(), 500, &results));
+	CHECK(results.size() == 4 && !results[3].acknowledgeRequested && !results[3].isTimedOut());
+	CHECK(loop.getNProcedures() == 0 && loop.getNCommands() == 4);
+}
+
+static void testTimeoutAndSleep() {
+	RecordingTransport transport;
+	SMCPCommandEventLoop loop(&transport);
+	loop.poll(1000);
+	std::vector<SMCPAcknowledgeResult> results;
+	loop.spawn(sendAndRecord(loop, acknowledgedAction.data(), acknowledgedAction.size(), 500, &results));
+	bool slept = false;
+	loop.spawn(sleepAndSet(loop, 300, &slept));
+	CHECK(loop.getNextDeadline() == 1300);
+
+	CHECK(loop.poll(1299) == 0 && !slept);
+	CHECK(loop.poll(1300) == 1 && slept);
+	CHECK(loop.getNextDeadline() == 1500);
+	CHECK(loop.poll(1499) == 0 && results.empty());
+	CHECK(loop.poll(1500) == 1);
+	CHECK(results.size() == 1 && results[0].isTimedOut() && results[0].acknowledgeTelemetry.empty());
+	CHECK(results[0].roundTripTime == 500);
+	CHECK(loop.getNTimeouts() == 1 && loop.getNPendingCommands() == 0 && loop.getNProcedures() == 0);
+	CHECK(loop.getNextDeadline() == UINT64_MAX);
+
+	//a late acknowledge is not matched
+	std::vector<uint8_t> acknowledge = createAcknowledgeBytes(0x05, 1);
+	CHECK(!loop.receive(&acknowledge[0], acknowledge.size(), 1600));
+	CHECK(loop.getNUnmatchedAcknowledges() == 1);
+
+	//sleep(0) does not suspend
+	bool done = false;
+	loop.spawn(sleepAndSet(loop, 0, &done));
+	CHECK(done && loop.getNProcedures() == 0);
+}
+
+static void testSubProcedureException() {
+	RecordingTransport transport;
+	SMCPCommandEventLoop loop(&transport);
+	loop.poll(0);
+	std::string caught;
+	loop.spawn(catchSubProcedure(loop, &caught));
+	loop.spawn(propagateSubProcedure(loop));
+	CHECK(loop.getNProcedures() == 2);
+	loop.poll(10);
+	CHECK(caught == "sub-procedure failed");
+	CHECK(loop.getNProcedures() == 0 && loop.getNFailedProcedures() == 1);
+	CHECK(loop.getLastFailure() == "sub-procedure failed");
+}
+
+static void testSynchronousAcknowledge() {
+	RecordingTransport transport;
+	SMCPCommandEventLoop loop(&transport);
+	transport.synchronousLoop = &loop;
+	transport.now = 2000;
+	loop.poll(2000);
+	std::vector<SMCPAcknowledgeResult> results;
+	loop.spawn(sendTwice(loop, &results));
+	CHECK(results.size() == 2 && loop.getNProcedures() == 0 && loop.getNPendingCommands() == 0);
+	CHECK(results.size() == 2 && results[0].acknowledged && results[0].acknowledgeTelemetry[7] == 1);
+	CHECK(results.size() == 2 && results[1].acknowledged && results[1].acknowledgeTelemetry[7] == 2);
+	CHECK(results.size() == 2 && results[1].roundTripTime == 0);
+	CHECK(loop.getNAcknowledged() == 2 && loop.getNUnmatchedAcknowledges() == 0);
+}
+
+static void testDestruction() {
+	int nDestroyed = 0;
+	{
+		RecordingTransport transport;
+		SMCPCommandEventLoop loop(&transport);
+		loop.spawn(waitForAcknowledge(loop, &nDestroyed));
+		loop.spawn(waitForSleep(loop, &nDestroyed));
+		loop.spawn(waitInSubProcedure(loop, &nDestroyed));
+		CHECK(loop.getNProcedures() == 3 && nDestroyed == 0);
+	}
+	//the frames of unfinished procedures are destroyed with the loop
+	CHECK(nDestroyed == 3);
+}
+
+/* ---------------- main ---------------- */
+
+int main() {
+	testAcknowledgeMatching();
+	testTimeoutAndSleep();
+	testSubProcedureException();
+	testSynchronousAcknowledge();
+	testDestruction();
+	printf("%d checks, %d failures\n", nChecks, nFailures);
+	return (nFailures == 0) ? 0 : 1;
+}